@@ -87,6 +87,54 @@ void L4_KDB_PMN_Write(word_t, word_t);
 word_t L4_KDB_PMN_Ofl_Read(word_t);
 void L4_KDB_PMN_Ofl_Write(word_t, word_t);
 
+/*
+ * PMU overflow driven PC sampling, on XScale and ARMv6 kernels built with
+ * CONFIG_PERF. L4_KDB_PerfSampleStart() samples the current unit every
+ * 'period' occurrences of 'event'. L4_KDB_PerfSampleRead() copies up to
+ * L4_PERF_SAMPLE_READ_MAX samples from a unit's ring into the MRs, four
+ * per sample (pc, lr, space, thread), and returns how many it copied.
+ * Samples taken in the kernel have a space of L4_PERF_SAMPLE_KERNEL.
+ * Only spaces with kernel resource rights may sample. Cycle sampling
+ * takes over CCNT, so it is refused while CCNT is counting cycles for
+ * libcycles or kbench, and cycle counts are meaningless while it runs.
+ */
+#define L4_PERF_SAMPLE_CYCLES           0
+#define L4_PERF_SAMPLE_DCACHE_MISS      1
+#define L4_PERF_SAMPLE_ICACHE_MISS      2
+#define L4_PERF_SAMPLE_BRANCH_MISS      3
+
+#define L4_PERF_SAMPLE_READ_MAX         8
+#define L4_PERF_SAMPLE_KERNEL           (~0UL)
+
+word_t L4_KDB_PerfSampleControl(word_t op, word_t arg0, word_t arg1);
+
+#define L4_KDB_PerfSampleStart(event, period) \
+        L4_KDB_PerfSampleControl(0, (event), (period))
+#define L4_KDB_PerfSampleStop()         L4_KDB_PerfSampleControl(1, 0, 0)
+#define L4_KDB_PerfSampleRead(unit)     L4_KDB_PerfSampleControl(2, (unit), 0)
+#define L4_KDB_PerfSampleDropped(unit)  L4_KDB_PerfSampleControl(3, (unit), 0)
+
+/*
+ * Copy the run queue statistics of the given unit into MR0..MR7:
+ * lock acquisitions, steals, stolen, rebalances, then the total and
+ * maximum lock spin and hold cycles. Returns 0 if the kernel was not
+ * built with per-unit run queues or the unit does not exist.
+ */
+word_t L4_KDB_SchedStatsIntroMRs(word_t unit);
+
+/*
+ * Return the number of timer interrupts the kernel has handled, and copy
+ * the kernel's current time in microseconds into MR0 (low word) and MR1
+ * (high word). The time is zero if the kernel does not keep it.
+ */
+word_t L4_KDB_TimerStatsIntroMRs(void);
+
+/*
+ * Perform a kernel profiling operation. Only available on kernels built
+ * with CONFIG_L4_PROFILING; see <l4/profile.h>.
+ */
+word_t L4_KDB_ProfileControl(word_t op, word_t arg);
+
 #ifndef NDEBUG
 void L4_KDB_Enter(char * s);
 #endif
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2008 Open Kernel Labs, Inc. (Copyright Holder).
+ * All rights reserved.
+ *
+ * 1. Redistribution and use of OKL4 (Software) in source and binary
+ * forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ *     (a) Redistributions of source code must retain this clause 1
+ *         (including paragraphs (a), (b) and (c)), clause 2 and clause 3
+ *         (Licence Terms) and the above copyright notice.
+ *
+ *     (b) Redistributions in binary form must reproduce the above
+ *         copyright notice and the Licence Terms in the documentation and/or
+ *         other materials provided with the distribution.
+ *
+ *     (c) Redistributions in any form must be accompanied by information on
+ *         how to obtain complete source code for:
+ *        (i) the Software; and
+ *        (ii) all accompanying software that uses (or is intended to
+ *        use) the Software whether directly or indirectly.  Such source
+ *        code must:
+ *        (iii) either be included in the distribution or be available
+ *        for no more than the cost of distribution plus a nominal fee;
+ *        and
+ *        (iv) be licensed by each relevant holder of copyright under
+ *        either the Licence Terms (with an appropriate copyright notice)
+ *        or the terms of a licence which is approved by the Open Source
+ *        Initative.  For an executable file, "complete source code"
+ *        means the source code for all modules it contains and includes
+ *        associated build and other files reasonably required to produce
+ *        the executable.
+ *
+ * 2. THIS SOFTWARE IS PROVIDED ``AS IS'' AND, TO THE EXTENT PERMITTED BY
+ * LAW, ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  WHERE ANY WARRANTY IS
+ * IMPLIED AND IS PREVENTED BY LAW FROM BEING DISCLAIMED THEN TO THE
+ * EXTENT PERMISSIBLE BY LAW: (A) THE WARRANTY IS READ DOWN IN FAVOUR OF
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT) AND (B) ANY LIMITATIONS PERMITTED BY LAW (INCLUDING AS TO
+ * THE EXTENT OF THE WARRANTY AND THE REMEDIES AVAILABLE IN THE EVENT OF
+ * BREACH) ARE DEEMED PART OF THIS LICENCE IN A FORM MOST FAVOURABLE TO
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT). IN THE LICENCE TERMS, "PARTICIPANT" INCLUDES EVERY
+ * PERSON WHO HAS CONTRIBUTED TO THE SOFTWARE OR WHO HAS BEEN INVOLVED IN
+ * THE DISTRIBUTION OR DISSEMINATION OF THE SOFTWARE.
+ *
+ * 3. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR ANY OTHER PARTICIPANT BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Description:   ARM kernel profiling interface
+ */
+#ifndef __L4__ARM__PROFILE_H__
+#define __L4__ARM__PROFILE_H__
+
+#include <l4/types.h>
+#include <l4/arch/kdebug.h>
+
+/* Operations of L4_KDB_ProfileControl(), matching the kernel's profile_op_e. */
+#define L4_PROFILE_ENABLE           0
+#define L4_PROFILE_DISABLE          1
+#define L4_PROFILE_RESET            2
+#define L4_PROFILE_PRINT            3
+#define L4_PROFILE_READ_STATS       4
+#define L4_PROFILE_READ_HIST        5
+
+/* Unit number naming the sum over all units on multi-unit kernels. */
+#define L4_PROFILE_ALL_UNITS        0xff
+
+/* Number of histogram buckets returned by each L4_Profiling_ReadHistogram(). */
+#define L4_PROFILE_HIST_READ_BUCKETS    16
+
+#define L4_Profiling_Start()    L4_KDB_ProfileControl(L4_PROFILE_ENABLE, 0)
+#define L4_Profiling_Stop()     L4_KDB_ProfileControl(L4_PROFILE_DISABLE, 0)
+#define L4_Profiling_Reset()    L4_KDB_ProfileControl(L4_PROFILE_RESET, 0)
+#define L4_Profiling_Print()    L4_KDB_ProfileControl(L4_PROFILE_PRINT, 0)
+
+/*
+ * Copy the counters of an event on a unit into MR0..MR7: the number of
+ * events (MR0 low, MR1 high), the total cycles (MR2 low, MR3 high), the
+ * minimum, maximum and 99th percentile latency in cycles, and the number
+ * of thread switches during the event. Returns the number of latency
+ * histogram buckets, or 0 if the event or unit does not exist.
+ */
+INLINE word_t
+L4_Profiling_ReadStats(word_t event, word_t unit)
+{
+    return L4_KDB_ProfileControl(L4_PROFILE_READ_STATS,
+            (event & 0xff) | ((unit & 0xff) << 8));
+}
+
+/*
+ * Copy up to L4_PROFILE_HIST_READ_BUCKETS latency histogram buckets of an
+ * event on a unit, starting at the given bucket, into the message
+ * registers. Each bucket is a pair of MRs: the smallest latency in
+ * cycles counted by the bucket, then the number of events counted.
+ * Returns the number of buckets copied.
+ */
+INLINE word_t
+L4_Profiling_ReadHistogram(word_t event, word_t unit, word_t first)
+{
+    return L4_KDB_ProfileControl(L4_PROFILE_READ_HIST,
+            (event & 0xff) | ((unit & 0xff) << 8) | (first << 16));
+}
+
+#endif /* !__L4__ARM__PROFILE_H__ */
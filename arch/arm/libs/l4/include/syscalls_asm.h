@@ -96,11 +96,16 @@
 #define L4_TRAP_PMN_OFL_WRITE       0xd8
 
 #define L4_TRAP_GETTICK             0xe0
+#define L4_TRAP_PERF_SAMPLE         0xe8
 #define L4_TRAP_WBTEST              0xec
 
 /* Backwards compatability for iguana interrupts */
 #define L4_TRAP_BOUNCE_INTERRUPT    0xf0
 
+#define L4_TRAP_SCHED_STATS         0xf4
+#define L4_TRAP_TIMER_STATS         0xf8
+#define L4_TRAP_PROFILE             0xfc
+
 #define SYSBASE                     0xffffff00
 #define SWIBASE                     0x1400
 
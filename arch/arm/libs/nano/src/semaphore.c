@@ -128,3 +128,24 @@ okn_semaphore_up(okn_semaphore_t *sem)
     return 0;
 }
 
+/*
+ * Up a semaphore 'count' times, waking all the threads this releases
+ * with a single system call.
+ */
+unsigned long
+okn_semaphore_up_many(okn_semaphore_t *sem, unsigned long count)
+{
+    int result = okl4_atomic_add_return((okl4_atomic_word_t *)&sem->count,
+            count);
+    int waiters = (int)count - result;
+
+    if (waiters <= 0)
+        return result;
+
+    /* Wake up the threads waiting on the semaphore. */
+    if ((unsigned long)waiters > count)
+        waiters = count;
+    okn_syscall_futex_wake((uint32_t)&sem->count, waiters);
+    return result > 0 ? result : 0;
+}
+
@@ -75,4 +75,28 @@
 #define SOC_CACHE_DEVICE 0x4
 #endif
 
+#if !defined(ASSEMBLY) && defined(CONFIG_PERF)
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Give the kernel's PC sampler a chance to handle a PMU interrupt.
+ *
+ * Platforms call this from their PMU interrupt handler, before counting
+ * overflows on behalf of user-level performance counters.
+ *
+ * @param ctx The context passed to soc_handle_interrupt().
+ * @param pmnc The value of the performance monitor control register.
+ *
+ * @return The PMNC overflow flag handled (and cleared) by the sampler,
+ *         or 0 if the sampler did not handle the interrupt.
+ */
+word_t kernel_perf_sample_interrupt(word_t ctx, word_t pmnc);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
 #endif /* __L4__ARCH_SOC_INTERFACE_H__ */
@@ -119,6 +119,13 @@ void soc_handle_interrupt(word_t ctx,
      * @param attrib Instuction or Data side of the cache.
      */
     void soc_cache_full_op(word_t attrib);
+    /*
+     * @brief Decide whether a full outer cache operation is cheaper than
+     * operating on a number of ranges.
+     *
+     * @param size total size of the ranges.
+     */
+    int soc_cache_full_op_cheaper(word_t size);
     /*
      * @brief Drain all write buffers on the outer cache (Outer Memory Barrier).
      *
@@ -123,6 +123,15 @@ INLINE void arch_outer_cache_range_op(addr_t pa, word_t size, enum cacheattr_e a
 #endif
 }
 
+INLINE bool arch_outer_cache_full_op_cheaper(word_t size)
+{
+#ifdef CONFIG_HAS_SOC_CACHE
+    return soc_cache_full_op_cheaper(size);
+#else
+    return false;
+#endif
+}
+
 INLINE void arch_outer_drain_write_buffer(void)
 {
 #ifdef CONFIG_HAS_SOC_CACHE
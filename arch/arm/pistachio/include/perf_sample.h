@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2008 Open Kernel Labs, Inc. (Copyright Holder).
+ * All rights reserved.
+ *
+ * 1. Redistribution and use of OKL4 (Software) in source and binary
+ * forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ *     (a) Redistributions of source code must retain this clause 1
+ *         (including paragraphs (a), (b) and (c)), clause 2 and clause 3
+ *         (Licence Terms) and the above copyright notice.
+ *
+ *     (b) Redistributions in binary form must reproduce the above
+ *         copyright notice and the Licence Terms in the documentation and/or
+ *         other materials provided with the distribution.
+ *
+ *     (c) Redistributions in any form must be accompanied by information on
+ *         how to obtain complete source code for:
+ *        (i) the Software; and
+ *        (ii) all accompanying software that uses (or is intended to
+ *        use) the Software whether directly or indirectly.  Such source
+ *        code must:
+ *        (iii) either be included in the distribution or be available
+ *        for no more than the cost of distribution plus a nominal fee;
+ *        and
+ *        (iv) be licensed by each relevant holder of copyright under
+ *        either the Licence Terms (with an appropriate copyright notice)
+ *        or the terms of a licence which is approved by the Open Source
+ *        Initative.  For an executable file, "complete source code"
+ *        means the source code for all modules it contains and includes
+ *        associated build and other files reasonably required to produce
+ *        the executable.
+ *
+ * 2. THIS SOFTWARE IS PROVIDED ``AS IS'' AND, TO THE EXTENT PERMITTED BY
+ * LAW, ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  WHERE ANY WARRANTY IS
+ * IMPLIED AND IS PREVENTED BY LAW FROM BEING DISCLAIMED THEN TO THE
+ * EXTENT PERMISSIBLE BY LAW: (A) THE WARRANTY IS READ DOWN IN FAVOUR OF
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT) AND (B) ANY LIMITATIONS PERMITTED BY LAW (INCLUDING AS TO
+ * THE EXTENT OF THE WARRANTY AND THE REMEDIES AVAILABLE IN THE EVENT OF
+ * BREACH) ARE DEEMED PART OF THIS LICENCE IN A FORM MOST FAVOURABLE TO
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT). IN THE LICENCE TERMS, "PARTICIPANT" INCLUDES EVERY
+ * PERSON WHO HAS CONTRIBUTED TO THE SOFTWARE OR WHO HAS BEEN INVOLVED IN
+ * THE DISTRIBUTION OR DISSEMINATION OF THE SOFTWARE.
+ *
+ * 3. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR ANY OTHER PARTICIPANT BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Description:   PMU overflow driven PC sampling
+ */
+#ifndef __ARCH__ARM__PERF_SAMPLE_H__
+#define __ARCH__ARM__PERF_SAMPLE_H__
+
+/*
+ * Sampling needs a PMU with overflow interrupts, which the kernel only
+ * drives on XScale and ARMv6 cores, and only in CONFIG_PERF builds.
+ */
+#if defined(CONFIG_PERF) && \
+    (defined(CONFIG_CPU_ARM_XSCALE) || (defined(ARCH_ARM) && (ARCH_VER == 6)))
+#define HAVE_PERF_SAMPLING
+#endif
+
+#if defined(HAVE_PERF_SAMPLING)
+
+#include <arch/thread.h>
+
+/* Events that can be sampled. */
+#define PERF_SAMPLE_CYCLES          0
+#define PERF_SAMPLE_DCACHE_MISS     1
+#define PERF_SAMPLE_ICACHE_MISS     2
+#define PERF_SAMPLE_BRANCH_MISS     3
+#define PERF_SAMPLE_NUM_EVENTS      4
+
+/* Operations of the L4_TRAP_PERF_SAMPLE system call. */
+#define PERF_SAMPLE_OP_START        0
+#define PERF_SAMPLE_OP_STOP         1
+#define PERF_SAMPLE_OP_READ         2
+#define PERF_SAMPLE_OP_DROPPED      3
+
+/* Space recorded for samples taken in the kernel. */
+#define PERF_SAMPLE_KERNEL          (~0UL)
+
+/* Number of samples each unit's ring holds; a power of two. */
+#define PERF_SAMPLE_RING_SIZE       1024
+
+/* Number of samples each read copies out, four message registers each. */
+#define PERF_SAMPLE_READ_MAX        8
+
+typedef struct perf_sample
+{
+    word_t pc;
+    /* Link register, the return address of the sampled function if it
+     * has not yet been saved. */
+    word_t lr;
+    word_t space;
+    word_t thread;
+} perf_sample_t;
+
+/*
+ * Single producer (the unit's PMU interrupt), single consumer ring of
+ * samples. 'head' and 'tail' count samples and wrap freely. Each unit
+ * samples its own event with its own period.
+ */
+typedef struct perf_sample_ring
+{
+    word_t head;
+    word_t tail;
+    word_t dropped;
+    /* Event being sampled, and the number of events between samples, or
+     * zero if sampling is off. Only changed by the owning unit. */
+    word_t event;
+    word_t period;
+    perf_sample_t samples[PERF_SAMPLE_RING_SIZE];
+} perf_sample_ring_t;
+
+word_t perf_sample_start(word_t event, word_t period);
+void perf_sample_stop(void);
+word_t perf_sample_read(word_t unit);
+word_t perf_sample_dropped(word_t unit);
+
+/*
+ * Called by the platform's PMU interrupt handler with the PMNC value it
+ * read. Records a sample if the sampling counter overflowed, and returns
+ * the PMNC overflow flag it handled, or 0.
+ */
+word_t perf_sample_interrupt(arm_irq_context_t *context, word_t pmnc);
+
+#endif /* HAVE_PERF_SAMPLING */
+
+#endif /* !__ARCH__ARM__PERF_SAMPLE_H__ */
@@ -134,6 +134,9 @@ INLINE bool thread_resources_t::control(tcb_t * tcb, tc_resources_t resources,
 
 INLINE void thread_resources_t::dump(tcb_t * tcb)
 {
+#if defined(CONFIG_IPC_WINDOWS)
+    printf("%c", tcb->resource_bits.have_resource(IPC_WINDOW) ? 'W' : 'w');
+#endif
 #if defined(CONFIG_ARM_VFP)
     printf("%c", tcb->resource_bits.have_resource(VFP) ? 'V' : 'v');
 #endif
@@ -76,6 +76,9 @@ enum resource_type_e {
 #if defined(CONFIG_ARM_VFP)
     VFP,
 #endif
+#if defined(CONFIG_IPC_WINDOWS)
+    IPC_WINDOW,         /* Keeps window IPC off the fastpath */
+#endif
 };
 
 
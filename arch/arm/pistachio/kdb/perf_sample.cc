@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2008 Open Kernel Labs, Inc. (Copyright Holder).
+ * All rights reserved.
+ *
+ * 1. Redistribution and use of OKL4 (Software) in source and binary
+ * forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ *     (a) Redistributions of source code must retain this clause 1
+ *         (including paragraphs (a), (b) and (c)), clause 2 and clause 3
+ *         (Licence Terms) and the above copyright notice.
+ *
+ *     (b) Redistributions in binary form must reproduce the above
+ *         copyright notice and the Licence Terms in the documentation and/or
+ *         other materials provided with the distribution.
+ *
+ *     (c) Redistributions in any form must be accompanied by information on
+ *         how to obtain complete source code for:
+ *        (i) the Software; and
+ *        (ii) all accompanying software that uses (or is intended to
+ *        use) the Software whether directly or indirectly.  Such source
+ *        code must:
+ *        (iii) either be included in the distribution or be available
+ *        for no more than the cost of distribution plus a nominal fee;
+ *        and
+ *        (iv) be licensed by each relevant holder of copyright under
+ *        either the Licence Terms (with an appropriate copyright notice)
+ *        or the terms of a licence which is approved by the Open Source
+ *        Initative.  For an executable file, "complete source code"
+ *        means the source code for all modules it contains and includes
+ *        associated build and other files reasonably required to produce
+ *        the executable.
+ *
+ * 2. THIS SOFTWARE IS PROVIDED ``AS IS'' AND, TO THE EXTENT PERMITTED BY
+ * LAW, ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  WHERE ANY WARRANTY IS
+ * IMPLIED AND IS PREVENTED BY LAW FROM BEING DISCLAIMED THEN TO THE
+ * EXTENT PERMISSIBLE BY LAW: (A) THE WARRANTY IS READ DOWN IN FAVOUR OF
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT) AND (B) ANY LIMITATIONS PERMITTED BY LAW (INCLUDING AS TO
+ * THE EXTENT OF THE WARRANTY AND THE REMEDIES AVAILABLE IN THE EVENT OF
+ * BREACH) ARE DEEMED PART OF THIS LICENCE IN A FORM MOST FAVOURABLE TO
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT). IN THE LICENCE TERMS, "PARTICIPANT" INCLUDES EVERY
+ * PERSON WHO HAS CONTRIBUTED TO THE SOFTWARE OR WHO HAS BEEN INVOLVED IN
+ * THE DISTRIBUTION OR DISSEMINATION OF THE SOFTWARE.
+ *
+ * 3. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR ANY OTHER PARTICIPANT BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Description:   PMU PC sampling control and dump
+ */
+#include <l4.h>
+#include <debug.h>
+#include <kdb/kdb.h>
+#include <kdb/cmd.h>
+#include <kdb/input.h>
+#include <arch/perf_sample.h>
+
+#if defined(CONFIG_KDB_CONS) && defined(HAVE_PERF_SAMPLING)
+
+extern perf_sample_ring_t perf_sample_rings[CONFIG_NUM_UNITS];
+
+DECLARE_CMD(cmd_perf_sample_start, arch, 'P', "perfsample",
+            "start/stop PMU PC sampling");
+DECLARE_CMD(cmd_perf_sample_dump, arch, 'S', "perfsampledump",
+            "dump and drain PMU PC samples");
+
+CMD(cmd_perf_sample_start, cg)
+{
+    word_t event, period;
+
+    event = get_dec("Event (0=cycles 1=dcache miss 2=icache miss "
+                    "3=branch miss)", 0, "cycles");
+    if (event == ABORT_MAGIC) {
+        return CMD_NOQUIT;
+    }
+    period = get_dec("Period (0 to stop)", 100000, "100000");
+    if (period == ABORT_MAGIC) {
+        return CMD_NOQUIT;
+    }
+
+    if (period == 0) {
+        perf_sample_stop();
+    } else if (!perf_sample_start(event, period)) {
+        printf("Invalid event\n");
+    }
+    return CMD_NOQUIT;
+}
+
+/*
+ * Print each sample on a line of its own, in the form parsed by
+ * tools/pmu-profile.
+ */
+CMD(cmd_perf_sample_dump, cg)
+{
+    for (word_t unit = 0; unit < CONFIG_NUM_UNITS; unit++) {
+        perf_sample_ring_t *ring = &perf_sample_rings[unit];
+
+        while (ring->tail != ring->head) {
+            perf_sample_t *sample =
+                &ring->samples[ring->tail & (PERF_SAMPLE_RING_SIZE - 1)];
+
+            printf("pmusample %d %08lx %08lx %lx %lx\n", (int)unit,
+                   sample->pc, sample->lr, sample->space, sample->thread);
+            ring->tail++;
+        }
+        if (ring->dropped) {
+            printf("pmudropped %d %ld\n", (int)unit, ring->dropped);
+        }
+    }
+    return CMD_NOQUIT;
+}
+
+#endif
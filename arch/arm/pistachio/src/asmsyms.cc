@@ -130,8 +130,10 @@ MKASMSYM( EXCEPTIONFP_RESOURCE_BIT, (word_t) (1ul << EXCEPTIONFP));
 MKASMSYM( OFS_TCB_ARCH_CONTEXT, cpp_offsetof(tcb_t, arch.context));
 MKASMSYM( OFS_TCB_ARCH_EXC_NUM, cpp_offsetof(tcb_t, arch.exc_num));
 
+#if !defined(CONFIG_PERCPU_RUNQUEUES)
 MKASMSYM( OFS_SCHED_INDEX_BITMAP, cpp_offsetof(scheduler_t, prio_queue.index_bitmap));
 MKASMSYM( OFS_SCHED_PRIO_BITMAP, cpp_offsetof(scheduler_t, prio_queue.prio_bitmap));
+#endif
 
 /* Syncpoints */
 MKASMSYM( OFS_SYNCPOINT_DONATEE,      cpp_offsetof(syncpoint_t, donatee));
@@ -161,6 +163,7 @@ MKASMSYM( LOG2_SIZEOF_CAP_T,          (word_t) 3); /* log2(sizeof(cap_t)) */
 /* capid constants */
 MKASMSYM( ASM_ANYTHREAD_RAW,        (word_t) ANYTHREAD_RAW);
 MKASMSYM( ASM_NILTHREAD_RAW,        (word_t) NILTHREAD_RAW);
+MKASMSYM( ASM_WAITNOTIFY_RAW,       (word_t) WAITNOTIFY_RAW);
 MKASMSYM( ASM_MYSELF_RAW,           (word_t) MYSELF_RAW);
 MKASMSYM( ASM_INVALID_CAP_RAW,      (word_t) INVALID_RAW);
 MKASMSYM( ASM_CAP_TYPE_IPC,         (word_t) cap_type_ipc);
@@ -188,12 +191,11 @@ MKASMSYM( ASM_CAP_OBJ_INDEX_MASK,   (word_t) CAP_OBJ_INDEX_MASK);
 
 #if defined(CONFIG_TRACEBUFFER)
 MKASMSYM( TBUF_LOGMASK,     cpp_offsetof(trace_buffer_t, log_mask ));
-MKASMSYM( TBUF_ACTIVEBUF,   cpp_offsetof(trace_buffer_t, active_buffer));
-MKASMSYM( TBUF_BUFSIZE,     cpp_offsetof(trace_buffer_t, buffer_size));
-MKASMSYM( TBUF_BUFHEAD0,    cpp_offsetof(trace_buffer_t, buffer_head[0]));
-MKASMSYM( TBUF_BUFHEAD1,    cpp_offsetof(trace_buffer_t, buffer_head[1]));
-MKASMSYM( TBUF_BUFOFF0,     cpp_offsetof(trace_buffer_t, buffer_offset[0]));
-MKASMSYM( TBUF_BUFOFF1,     cpp_offsetof(trace_buffer_t, buffer_offset[1]));
+MKASMSYM( TBUF_RING0_OFFSET,  cpp_offsetof(trace_buffer_t, ring[0].offset));
+MKASMSYM( TBUF_RING0_SIZE,    cpp_offsetof(trace_buffer_t, ring[0].size));
+MKASMSYM( TBUF_RING0_RESERVE, cpp_offsetof(trace_buffer_t, ring[0].reserve));
+MKASMSYM( TBUF_RING0_HEAD,    cpp_offsetof(trace_buffer_t, ring[0].head));
+MKASMSYM( TBUF_RING0_TAIL,    cpp_offsetof(trace_buffer_t, ring[0].tail));
 #endif
 
 #undef cpp_offsetof
@@ -78,6 +78,7 @@
 #include <kdb/names.h>
 #include <soc/arch/soc.h>
 #include <arch/intctrl.h>
+#include <arch/perf_sample.h>
 
 DECLARE_TRACEPOINT(EXCEPTION_IPC_SYSCALL);
 DECLARE_TRACEPOINT(EXCEPTION_IPC_GENERAL);
@@ -609,6 +610,79 @@ extern "C" void sys_arm_misc(arm_irq_context_t *context)
                 return;
             }
 #endif
+    case L4_TRAP_TIMER_STATS:
+            {
+                word_t *mr = &get_current_tcb()->get_utcb()->mr[0];
+                u64_t now = get_current_time();
+                mr[0] = (word_t)now;
+                mr[1] = (word_t)(now >> 32);
+                context->r0 = get_current_scheduler()->timer_interrupts;
+                return;
+            }
+    case L4_TRAP_SCHED_STATS:
+            {
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+                if (context->r0 < CONFIG_NUM_UNITS) {
+                    run_queue_stats_t *stats =
+                        &get_current_scheduler()->get_run_queue(context->r0)->stats;
+                    word_t *mr = &get_current_tcb()->get_utcb()->mr[0];
+
+                    mr[0] = stats->acquisitions;
+                    mr[1] = stats->steals;
+                    mr[2] = stats->stolen;
+                    mr[3] = stats->rebalances;
+#if defined(CONFIG_L4_PROFILING)
+                    mr[4] = (word_t)stats->spin_cycles;
+                    mr[5] = (word_t)stats->max_spin_cycles;
+                    mr[6] = (word_t)stats->hold_cycles;
+                    mr[7] = (word_t)stats->max_hold_cycles;
+#else
+                    mr[4] = mr[5] = mr[6] = mr[7] = 0;
+#endif
+                    context->r0 = 1;
+                    return;
+                }
+#endif
+                context->r0 = 0;
+                return;
+            }
+#if defined(HAVE_PERF_SAMPLING)
+    case L4_TRAP_PERF_SAMPLE:
+            {
+                /* The PMU and the samples are system wide state. */
+                if (EXPECT_FALSE(!is_kresourced_space(get_current_space()))) {
+                    get_current_tcb()->set_error_code(EINVALID_SPACE);
+                    context->r0 = 0;
+                    return;
+                }
+                switch (context->r0) {
+                case PERF_SAMPLE_OP_START:
+                    context->r0 = perf_sample_start(context->r1, context->r2);
+                    break;
+                case PERF_SAMPLE_OP_STOP:
+                    perf_sample_stop();
+                    context->r0 = 1;
+                    break;
+                case PERF_SAMPLE_OP_READ:
+                    context->r0 = perf_sample_read(context->r1);
+                    break;
+                case PERF_SAMPLE_OP_DROPPED:
+                    context->r0 = perf_sample_dropped(context->r1);
+                    break;
+                default:
+                    context->r0 = 0;
+                    break;
+                }
+                return;
+            }
+#endif
+#if defined(CONFIG_L4_PROFILING)
+    case L4_TRAP_PROFILE:
+            {
+                context->r0 = profile_handler(context->r0, context->r1);
+                return;
+            }
+#endif
     default:
         break;
     }
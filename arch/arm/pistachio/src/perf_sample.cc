@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2008 Open Kernel Labs, Inc. (Copyright Holder).
+ * All rights reserved.
+ *
+ * 1. Redistribution and use of OKL4 (Software) in source and binary
+ * forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ *     (a) Redistributions of source code must retain this clause 1
+ *         (including paragraphs (a), (b) and (c)), clause 2 and clause 3
+ *         (Licence Terms) and the above copyright notice.
+ *
+ *     (b) Redistributions in binary form must reproduce the above
+ *         copyright notice and the Licence Terms in the documentation and/or
+ *         other materials provided with the distribution.
+ *
+ *     (c) Redistributions in any form must be accompanied by information on
+ *         how to obtain complete source code for:
+ *        (i) the Software; and
+ *        (ii) all accompanying software that uses (or is intended to
+ *        use) the Software whether directly or indirectly.  Such source
+ *        code must:
+ *        (iii) either be included in the distribution or be available
+ *        for no more than the cost of distribution plus a nominal fee;
+ *        and
+ *        (iv) be licensed by each relevant holder of copyright under
+ *        either the Licence Terms (with an appropriate copyright notice)
+ *        or the terms of a licence which is approved by the Open Source
+ *        Initative.  For an executable file, "complete source code"
+ *        means the source code for all modules it contains and includes
+ *        associated build and other files reasonably required to produce
+ *        the executable.
+ *
+ * 2. THIS SOFTWARE IS PROVIDED ``AS IS'' AND, TO THE EXTENT PERMITTED BY
+ * LAW, ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  WHERE ANY WARRANTY IS
+ * IMPLIED AND IS PREVENTED BY LAW FROM BEING DISCLAIMED THEN TO THE
+ * EXTENT PERMISSIBLE BY LAW: (A) THE WARRANTY IS READ DOWN IN FAVOUR OF
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT) AND (B) ANY LIMITATIONS PERMITTED BY LAW (INCLUDING AS TO
+ * THE EXTENT OF THE WARRANTY AND THE REMEDIES AVAILABLE IN THE EVENT OF
+ * BREACH) ARE DEEMED PART OF THIS LICENCE IN A FORM MOST FAVOURABLE TO
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT). IN THE LICENCE TERMS, "PARTICIPANT" INCLUDES EVERY
+ * PERSON WHO HAS CONTRIBUTED TO THE SOFTWARE OR WHO HAS BEEN INVOLVED IN
+ * THE DISTRIBUTION OR DISSEMINATION OF THE SOFTWARE.
+ *
+ * 3. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR ANY OTHER PARTICIPANT BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Description:   PMU overflow driven PC sampling
+ */
+
+#include <l4.h>
+#include <debug.h>
+#include <tcb.h>
+#include <schedule.h>
+#include <arch/perf_sample.h>
+#include <soc/arch/soc.h>
+
+#if defined(HAVE_PERF_SAMPLING)
+
+/* PMNC bits common to XScale and ARM11 */
+#define PMNC_ENABLE             (1UL << 0)
+#define PMNC_PMN0_IRQ           (1UL << 4)
+#define PMNC_PMN1_IRQ           (1UL << 5)
+#define PMNC_CCNT_IRQ           (1UL << 6)
+#define PMNC_PMN0_OVERFLOW      (1UL << 8)
+#define PMNC_PMN1_OVERFLOW      (1UL << 9)
+#define PMNC_CCNT_OVERFLOW      (1UL << 10)
+#define PMNC_OVERFLOWS          (PMNC_PMN0_OVERFLOW | PMNC_PMN1_OVERFLOW | \
+                                 PMNC_CCNT_OVERFLOW)
+
+#if defined(CONFIG_CPU_ARM_XSCALE)
+#define PMNC_EVT0_SHIFT         12
+
+INLINE word_t read_pmnc(void)
+{
+    word_t reg;
+    __asm__ __volatile__ ("   mrc     p14, 0, %0, c0, c0, 0   \n" : "=r" (reg));
+    return reg;
+}
+
+INLINE void write_pmnc(word_t reg)
+{
+    __asm__ __volatile__ ("   mcr     p14, 0, %0, c0, c0, 0   \n" : : "r" (reg));
+}
+
+INLINE void write_ccnt(word_t reg)
+{
+    __asm__ __volatile__ ("   mcr     p14, 0, %0, c1, c0, 0   \n" : : "r" (reg));
+}
+
+INLINE void write_pmn0(word_t reg)
+{
+    __asm__ __volatile__ ("   mcr     p14, 0, %0, c2, c0, 0   \n" : : "r" (reg));
+}
+#else
+#define PMNC_EVT0_SHIFT         20
+
+INLINE word_t read_pmnc(void)
+{
+    word_t reg;
+    __asm__ __volatile__ ("   mrc     p15, 0, %0, c15, c12, 0 \n" : "=r" (reg));
+    return reg;
+}
+
+INLINE void write_pmnc(word_t reg)
+{
+    __asm__ __volatile__ ("   mcr     p15, 0, %0, c15, c12, 0 \n" : : "r" (reg));
+}
+
+INLINE void write_ccnt(word_t reg)
+{
+    __asm__ __volatile__ ("   mcr     p15, 0, %0, c15, c12, 1 \n" : : "r" (reg));
+}
+
+INLINE void write_pmn0(word_t reg)
+{
+    __asm__ __volatile__ ("   mcr     p15, 0, %0, c15, c12, 2 \n" : : "r" (reg));
+}
+#endif
+
+#define PMNC_EVT0_MASK          (0xffUL << PMNC_EVT0_SHIFT)
+
+/* PMN0 event numbers, the same on XScale and ARM11 */
+static const word_t perf_sample_pmn_event[PERF_SAMPLE_NUM_EVENTS] = {
+    0,          /* PERF_SAMPLE_CYCLES: counted by CCNT */
+    0x0b,       /* data cache miss */
+    0x00,       /* instruction cache miss */
+    0x06,       /* branch mispredicted */
+};
+
+perf_sample_ring_t perf_sample_rings[CONFIG_NUM_UNITS];
+
+static inline perf_sample_ring_t *
+perf_sample_current_ring(void)
+{
+#if defined(CONFIG_MUNITS)
+    return &perf_sample_rings[get_current_context().unit];
+#else
+    return &perf_sample_rings[0];
+#endif
+}
+
+/* Set the sampling counter to overflow after another period. */
+static inline void
+perf_sample_reload(perf_sample_ring_t *ring)
+{
+    if (ring->event == PERF_SAMPLE_CYCLES) {
+        write_ccnt(-ring->period);
+    } else {
+        write_pmn0(-ring->period);
+    }
+}
+
+static inline word_t
+perf_sample_flag(perf_sample_ring_t *ring)
+{
+    return ring->event == PERF_SAMPLE_CYCLES ?
+        PMNC_CCNT_OVERFLOW : PMNC_PMN0_OVERFLOW;
+}
+
+/*
+ * Start sampling 'event' every 'period' events on the current unit. The
+ * sampling counter takes over the PMU's overflow interrupt; the other
+ * counters keep counting. Returns 0 if the arguments are invalid.
+ *
+ * Cycle sampling rewrites CCNT on every sample, so it cannot share CCNT
+ * with cycle counting through L4_KDB_PMN_Write(), as done by libcycles
+ * and kbench. Counting enables the CCNT overflow interrupt to extend the
+ * counter, so cycle sampling is refused while that interrupt is on.
+ * Conversely, cycle counts read while cycle sampling is running are
+ * meaningless.
+ */
+word_t
+perf_sample_start(word_t event, word_t period)
+{
+    perf_sample_ring_t *ring = perf_sample_current_ring();
+    word_t pmnc;
+
+    if (event >= PERF_SAMPLE_NUM_EVENTS || period == 0) {
+        return 0;
+    }
+
+    perf_sample_stop();
+
+    pmnc = read_pmnc();
+    if (event == PERF_SAMPLE_CYCLES && (pmnc & PMNC_CCNT_IRQ)) {
+        return 0;
+    }
+
+    ring->event = event;
+    ring->period = period;
+    perf_sample_reload(ring);
+
+    pmnc &= ~(PMNC_PMN0_IRQ | PMNC_PMN1_IRQ | PMNC_CCNT_IRQ | PMNC_OVERFLOWS);
+    if (event == PERF_SAMPLE_CYCLES) {
+        pmnc |= PMNC_CCNT_IRQ;
+    } else {
+        pmnc &= ~PMNC_EVT0_MASK;
+        pmnc |= (perf_sample_pmn_event[event] << PMNC_EVT0_SHIFT) |
+            PMNC_PMN0_IRQ;
+    }
+    /* Clear stale overflows, which are write one to clear. */
+    write_pmnc(pmnc | PMNC_OVERFLOWS | PMNC_ENABLE);
+    soc_perf_counter_unmask();
+
+    return 1;
+}
+
+void
+perf_sample_stop(void)
+{
+    perf_sample_ring_t *ring = perf_sample_current_ring();
+    word_t pmnc;
+
+    if (ring->period == 0) {
+        return;
+    }
+    ring->period = 0;
+
+    /* On ARM11 the PMU interrupt can only be deasserted while the PMU is
+     * enabled, so clear our overflow before masking its interrupt. */
+    pmnc = read_pmnc() & ~PMNC_OVERFLOWS;
+    write_pmnc(pmnc | perf_sample_flag(ring));
+    write_pmnc(pmnc & ~(PMNC_PMN0_IRQ | PMNC_CCNT_IRQ));
+}
+
+word_t
+perf_sample_interrupt(arm_irq_context_t *context, word_t pmnc)
+{
+    perf_sample_ring_t *ring = perf_sample_current_ring();
+    perf_sample_t *sample;
+    word_t flag;
+
+    if (ring->period == 0) {
+        return 0;
+    }
+    flag = perf_sample_flag(ring);
+    if (!(pmnc & flag)) {
+        return 0;
+    }
+
+    if (ring->head - ring->tail >= PERF_SAMPLE_RING_SIZE) {
+        ring->dropped++;
+    } else {
+        tcb_t *current = get_current_tcb();
+
+        sample = &ring->samples[ring->head & (PERF_SAMPLE_RING_SIZE - 1)];
+        sample->pc = context->pc;
+        if ((context->cpsr & CPSR_MODE_MASK) == CPSR_USER_MODE) {
+            sample->lr = context->lr;
+            sample->space = current->get_space_id().get_raw();
+        } else {
+            sample->lr = context->klr;
+            sample->space = PERF_SAMPLE_KERNEL;
+        }
+        sample->thread = threadhandle(current->tcb_idx).get_raw();
+
+        okl4_atomic_barrier_write_smp();
+        ring->head++;
+    }
+
+    /* Rearm, then acknowledge only our own overflow. */
+    perf_sample_reload(ring);
+    write_pmnc((pmnc & ~PMNC_OVERFLOWS) | flag);
+
+    return flag;
+}
+
+/*
+ * Copy up to PERF_SAMPLE_READ_MAX samples from a unit's ring into the
+ * current thread's message registers, four per sample: pc, lr, space and
+ * thread. Returns the number of samples copied.
+ */
+word_t
+perf_sample_read(word_t unit)
+{
+    tcb_t *current = get_current_tcb();
+    perf_sample_ring_t *ring;
+    word_t i, head;
+
+    if (unit >= CONFIG_NUM_UNITS) {
+        return 0;
+    }
+    ring = &perf_sample_rings[unit];
+    head = ring->head;
+    okl4_atomic_barrier_read_smp();
+
+    for (i = 0; i < PERF_SAMPLE_READ_MAX && ring->tail != head; i++) {
+        perf_sample_t *sample =
+            &ring->samples[ring->tail & (PERF_SAMPLE_RING_SIZE - 1)];
+
+        current->set_mr(4 * i + 0, sample->pc);
+        current->set_mr(4 * i + 1, sample->lr);
+        current->set_mr(4 * i + 2, sample->space);
+        current->set_mr(4 * i + 3, sample->thread);
+        ring->tail++;
+    }
+    return i;
+}
+
+word_t
+perf_sample_dropped(word_t unit)
+{
+    if (unit >= CONFIG_NUM_UNITS) {
+        return 0;
+    }
+    return perf_sample_rings[unit].dropped;
+}
+
+#endif /* HAVE_PERF_SAMPLING */
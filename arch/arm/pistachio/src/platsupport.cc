@@ -67,6 +67,7 @@
 #include <space.h>
 #include <arch/pgent.h>
 #include <arch/page.h>
+#include <arch/perf_sample.h>
 
 
 int do_printf(const char* format_p, va_list args);
@@ -97,6 +98,17 @@ extern "C" int kernel_printf(const char * format, ...)
 }
 #endif
 
+#if defined(CONFIG_PERF)
+extern "C" word_t kernel_perf_sample_interrupt(word_t ctx, word_t pmnc)
+{
+#if defined(HAVE_PERF_SAMPLING)
+    return perf_sample_interrupt((arm_irq_context_t *)ctx, pmnc);
+#else
+    return 0;
+#endif
+}
+#endif
+
 #define MAX_IO_AREAS 16
 
 
@@ -367,12 +367,31 @@ void generic_space_t::flush_tlb(space_t *curspace)
 }
 
 void generic_space_t::flush_tlbent_local(space_t *curspace, addr_t vaddr, word_t log2size)
+{
+    flush_tlbent(vaddr, log2size);
+}
+
+/* Entries are flushed by virtual address; no space switch is needed. */
+void generic_space_t::begin_tlbent_flush(space_t *curspace)
+{
+}
+
+void generic_space_t::flush_tlbent(addr_t vaddr, word_t log2size)
 {
     vaddr = addr_align(vaddr, 1 << log2size);
     arm_cache::cache_flush_ent(vaddr, log2size);
     arm_cache::tlb_flush_ent(vaddr, log2size);
 }
 
+/* flush_tlb() flushes the whole cache as well. */
+void generic_space_t::flush_cacheent(addr_t vaddr, word_t log2size)
+{
+}
+
+void generic_space_t::end_tlbent_flush(space_t *curspace)
+{
+}
+
 bool generic_space_t::allocate_page_directory(kmem_resource_t *kresource)
 {
 #if (ARM_L0_SIZE < KMEM_CHUNKSIZE)
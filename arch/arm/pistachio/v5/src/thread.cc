@@ -131,6 +131,11 @@ void switch_to(tcb_t * dest, tcb_t * schedule)
     ASSERT(ALWAYS, dest->ready_list.next == NULL);
     space_t *dest_space = dest->get_space();
 
+#if defined(CONFIG_TICKLESS)
+    /* Charge the outgoing schedule and time the incoming one. */
+    get_current_scheduler()->switch_schedule_timer(schedule);
+#endif
+
     /* Update the global schedule variable. */
     set_active_schedule(schedule);
 
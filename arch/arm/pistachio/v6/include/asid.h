@@ -79,4 +79,12 @@ INLINE void flush_asid (word_t asid)
     arm_cache::tlb_flush_asid(asid);
 }
 
+/**
+ * Flush TLB entries of all asids
+ */
+INLINE void flush_all_asids (void)
+{
+    arm_cache::tlb_flush();
+}
+
 #endif /* __ARCH__ARMV6__ASID_H__ */
@@ -310,17 +310,51 @@ void generic_space_t::flush_tlb(space_t *curspace)
 }
 
 void generic_space_t::flush_tlbent_local(space_t *curspace, addr_t vaddr, word_t log2size)
+{
+    begin_tlbent_flush(curspace);
+    flush_tlbent(vaddr, log2size);
+    end_tlbent_flush(curspace);
+}
+
+/*
+ * Flushing entries by MVA needs the space active.  A space without an ASID
+ * has no TLB entries, so there is nothing to do for it.
+ */
+void generic_space_t::begin_tlbent_flush(space_t *curspace)
+{
+    if (((space_t *)this)->get_asid()->is_valid()) {
+        this->activate(get_current_tcb());
+    }
+}
+
+void generic_space_t::flush_tlbent(addr_t vaddr, word_t log2size)
 {
     asid_t *asid = ((space_t *)this)->get_asid();
 
     vaddr = addr_align(vaddr, 1 << log2size);
 
     if (asid->is_valid()) {
-        this->activate(get_current_tcb());
-
         arm_cache::cache_flush_ent_mva(vaddr, log2size);
         arm_cache::tlb_flush_ent(asid->value(), vaddr, log2size);
+    }
+}
+
+/*
+ * flush_tlb() only drops the ASID, so entries left to it still need
+ * their cache lines cleaned.
+ */
+void generic_space_t::flush_cacheent(addr_t vaddr, word_t log2size)
+{
+    vaddr = addr_align(vaddr, 1 << log2size);
+
+    if (((space_t *)this)->get_asid()->is_valid()) {
+        arm_cache::cache_flush_ent_mva(vaddr, log2size);
+    }
+}
 
+void generic_space_t::end_tlbent_flush(space_t *curspace)
+{
+    if (((space_t *)this)->get_asid()->is_valid()) {
         curspace->activate(get_current_tcb());
     }
 }
@@ -123,6 +123,11 @@ void switch_from(tcb_t * current, continuation_t continuation)
 
 void switch_to(tcb_t * dest, tcb_t * schedule)
 {
+#if defined(CONFIG_TICKLESS)
+    /* Charge the outgoing schedule and time the incoming one. */
+    get_current_scheduler()->switch_schedule_timer(schedule);
+#endif
+
     /* Update the global schedule variable. */
     set_active_schedule(schedule);
 
@@ -143,8 +143,13 @@ __clzl(size_t x)
 struct mem_pool *internal_physpool;
 struct mem_pool *internal_virtpool;
 
+/*
+ * Releasing a slab adds its pages back to the pools, which allocates from
+ * mem_cache, so mem_cache itself keeps its slabs.
+ */
 static struct slab_cache mem_cache =
-SLAB_CACHE_INITIALIZER(sizeof(struct memory), &mem_cache);
+SLAB_CACHE_INITIALIZER_FLAGS(sizeof(struct memory), &mem_cache,
+                             SLAB_CACHE_NORECLAIM);
 
 static inline size_t
 idx_to_size(unsigned idx)
@@ -212,7 +217,7 @@ trim_mem(struct mem_pool *pool, struct memory *mem, addr_t addr, size_t size)
         mem->size = addr - mem->addr;
         mem_free(pool, mem);
         tmp = mem;
-        mem = slab_cache_alloc(&mem_cache);
+        mem = slab_cache_alloc_nozero(&mem_cache);
         if (mem == NULL) {
             mem_unfree(pool, tmp);
             tmp->size += rest;
@@ -227,7 +232,7 @@ trim_mem(struct mem_pool *pool, struct memory *mem, addr_t addr, size_t size)
         mem->size = mem->size - size;
         mem_free(pool, mem);
         tmp = mem;
-        mem = slab_cache_alloc(&mem_cache);
+        mem = slab_cache_alloc_nozero(&mem_cache);
         if (mem == NULL) {
             mem_unfree(pool, tmp);
             tmp->size += size;
@@ -353,7 +358,7 @@ mem_add_and_alloc(struct mem_pool *pool, addr_t addr, size_t size)
      * needs to be fixed so that it rounds up small sizes to added. */
     size = ALIGN_UP(size, MEM_MIN_SIZE);
 
-    ent = slab_cache_alloc(&mem_cache);
+    ent = slab_cache_alloc_nozero(&mem_cache);
     if (ent == NULL) {
         return NULL;
     }
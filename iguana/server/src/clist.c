@@ -62,6 +62,9 @@
 #include "clist.h"
 
 #define MIN_CLIST_SLOTS         16
+
+uintptr_t clist_generation = 1;
+
 static int clist_grow(struct clist *clist);
 static int clist_shrink(struct clist *clist);
 
@@ -104,6 +107,7 @@ server_clist_delete(struct clist *clist)
     TAILQ_REMOVE(&clist->owner->owned_clists, clist, clist_list);
     free(clist->cap);
     free(clist);
+    clist_generation++;
 }
 
 int
@@ -126,6 +130,7 @@ server_clist_insert(struct clist *clist, cap_t cap)
         clist->cap[i + 1] = clist->cap[i];
     }
     clist->cap[i + 1] = cap;
+    clist_generation++;
     return 0;
 }
 
@@ -160,6 +165,7 @@ server_clist_remove(struct clist *clist, cap_t cap)
     if (clist->used < clist->size / 4) {
         (void)clist_shrink(clist);
     }
+    clist_generation++;
     return 0;
 }
 
@@ -78,6 +78,12 @@ struct clist {
     cap_t *cap;
 };
 
+/*
+ * Bumped whenever a clist changes or is added to or removed from a pd, so
+ * that cached security checks can be discarded.
+ */
+extern uintptr_t clist_generation;
+
 struct clist *server_clist_create(struct pd *pd);
 void server_clist_delete(struct clist *clist);
 int server_clist_insert(struct clist *clist, cap_t cap);
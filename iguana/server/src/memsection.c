@@ -66,6 +66,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <hash/hash.h>
 #include <l4/space.h>
 #include <l4e/map.h>
 #include <l4e/misc.h>
@@ -487,6 +488,22 @@ memsection_flush(struct memsection *ms)
 struct slab_cache pd_ent_cache =
 SLAB_CACHE_INITIALIZER(sizeof(struct pd_entry), &pd_ent_cache);
 
+/*
+ * Reverse map entries are indexed by (memsection, pd), mirroring the
+ * attach table in pd.c.  The per-memsection list keeps attach order.
+ */
+#define RMAP_HASHSIZE 1024
+
+static struct pd_entry *rmap_hash[RMAP_HASHSIZE];
+
+static inline struct pd_entry **
+rmap_bucket(struct memsection *ms, struct pd *pd)
+{
+    uintptr_t key = (uintptr_t)ms ^ hash_hash((uintptr_t)pd);
+
+    return &rmap_hash[hash_hash(key) & (RMAP_HASHSIZE - 1)];
+}
+
 int
 memsection_list_is_valid(struct memsection_list *list)
 {
@@ -518,10 +535,11 @@ iguana_memsection_create(size_t size, uintptr_t *ret_base, uintptr_t *ret_size)
 int
 memsection_rmap_insert(struct memsection *ms, struct pd *pd, int rwx)
 {
+    struct pd_entry **bucket = rmap_bucket(ms, pd);
     struct pd_entry *ent;
 
-    TAILQ_FOREACH(ent, &ms->pd_list, pd_list) {
-        if (ent->pd == pd) {
+    for (ent = *bucket; ent != NULL; ent = ent->hash_next) {
+        if (ent->ms == ms && ent->pd == pd) {
             ent->rwx = rwx;
             return 0;
         }
@@ -530,8 +548,11 @@ memsection_rmap_insert(struct memsection *ms, struct pd *pd, int rwx)
     if (ent == NULL) {
         return -1;
     }
+    ent->ms = ms;
     ent->pd = pd;
     ent->rwx = rwx;
+    ent->hash_next = *bucket;
+    *bucket = ent;
     TAILQ_INSERT_TAIL(&ms->pd_list, ent, pd_list);
     return 0;
 }
@@ -539,13 +560,15 @@ memsection_rmap_insert(struct memsection *ms, struct pd *pd, int rwx)
 void
 memsection_rmap_remove(struct memsection *ms, struct pd *pd)
 {
+    struct pd_entry **prev = rmap_bucket(ms, pd);
     struct pd_entry *ent;
 
-    TAILQ_FOREACH(ent, &ms->pd_list, pd_list) {
-        if (ent->pd == pd)
+    for (ent = *prev; ent != NULL; prev = &ent->hash_next, ent = *prev) {
+        if (ent->ms == ms && ent->pd == pd)
             break;
     }
     if (ent != NULL) {
+        *prev = ent->hash_next;
         TAILQ_REMOVE(&ms->pd_list, ent, pd_list);
         slab_cache_free(&pd_ent_cache, ent);
     }
@@ -70,6 +70,7 @@
 
 #include <stdint.h>
 #include <bit_fl/bit_fl.h>
+#include <interval_tree/interval_tree.h>
 #include <l4/types.h>
 #include <ll/ll.h>
 #include <queue/tailq.h>
@@ -98,6 +99,8 @@ extern const uintptr_t memsection_magic;
 
 struct pd_entry {
     TAILQ_ENTRY(pd_entry) pd_list;
+    struct pd_entry *hash_next; /* Chain in the memsection reverse map */
+    struct memsection *ms;      /* Unused by zone reverse maps */
     struct pd *pd;
     int rwx;
 };
@@ -127,9 +130,8 @@ struct memsection {
 #endif
     struct zone *zone;
     TAILQ_ENTRY(memsection) zone_list;
-    /* Binary tree pointers */
-    struct memsection *left;
-    struct memsection *right;
+    /* Object table linkage */
+    struct itree_node objtable_node;
 };
 
 static inline int
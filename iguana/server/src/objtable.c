@@ -60,213 +60,55 @@
  */
 /*
  * Authors: Ben Leslie, Alex Webster
+ *
+ * Memsections are kept in a balanced interval tree keyed by base address,
+ * so lookups stay O(log n) however the memsections were allocated.
  */
 #include <assert.h>
 #include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <interval_tree/interval_tree.h>
 #include "util.h"
 #include "memsection.h"
 #include "objtable.h"
 
-static struct memsection *root;
-
-static inline uintptr_t
-objtable_key(const struct memsection *memsection)
-{
-    return memsection->base;
-}
-
-static inline uintptr_t
-objtable_end(const struct memsection *memsection)
-{
-    return memsection->end;
-}
-
-static int
-objtable_node_compare(struct memsection * node, uintptr_t key)
-{
-    if (key < node->base)
-    {
-        return -1;
-    }
-    else if (key > node->end)
-    {
-        return 1;
-    }
-    else
-    {
-        return 0;
-    }
-}
+static struct itree objtable;
 
-static struct memsection *
-find_node(struct memsection *root, uintptr_t key, int *cmp_p, struct memsection **parent)
+static inline struct memsection *
+objtable_entry(struct itree_node *node)
 {
-    int     cmp = 0;
-    struct  memsection *second_last_root = root;
-    struct  memsection *last_root = root;
-
-    while (root != NULL)
-    {
-
-        second_last_root = last_root;
-        last_root = root;
-
-        cmp = objtable_node_compare(root, key);
-
-        if (cmp < 0)
-        {
-            root = root->left;
-        }
-        else if (cmp > 0)
-        {
-            root = root->right;
-        }
-        else if (cmp == 0)
-        {
-            break;
-        }
+    if (node == NULL) {
+        return NULL;
     }
-
-    *cmp_p = cmp;
-
-    if (parent)
-    {
-        *parent = second_last_root;
-    }
-
-    return last_root;
+    return itree_entry(node, struct memsection, objtable_node);
 }
 
 int
 objtable_insert(struct memsection *memsection)
 {
-    int     cmp;
-    struct  memsection *closest;
-
-    if (root == NULL)
-    {
-        root = memsection;
-    }
-    else
-    {
-        closest = find_node(root, objtable_key(memsection), &cmp, NULL);
-
-        if (cmp == 0)
-        {
-            ERROR_PRINT
-            (
-                 "Failed to insert object into objtable (ms_base: %" PRIxPTR ")\n",
-                 objtable_key(memsection)
-            );
-            return -1;          /* Key clash */
-        }
-        else if (cmp < 0)
-        {
-            closest->left = memsection;
-        }
-        else
-        {
-            closest->right = memsection;
-        }
+    if (itree_insert(&objtable, &memsection->objtable_node,
+                     memsection->base, memsection->end) != 0) {
+        ERROR_PRINT
+        (
+             "Failed to insert object into objtable (ms_base: %" PRIxPTR ")\n",
+             memsection->base
+        );
+        return -1;          /* Overlaps an existing memsection */
     }
 
     return 0;
 }
 
-static struct memsection *
-largest_node(struct memsection *root, struct memsection **parent)
-{
-    struct memsection *last_root = NULL;
-
-    while (root->right != NULL)
-    {
-        last_root = root;
-        root = root->right;
-    }
-
-    if (parent)
-    {
-        *parent = last_root;
-    }
-    return root;
-}
-
 int
 objtable_delete(const struct memsection *memsection)
 {
-    int     cmp;
-    struct  memsection *dead_node, *deads_parent;
-    struct  memsection *replacement_node, *replacements_parent;
+    struct itree_node *node;
 
-    if (root == NULL)
-    {
-        return 0;
-    }
-
-    dead_node = find_node(root, objtable_key(memsection), &cmp, &deads_parent);
-
-    /* Found a match, need to delete */
-    if (cmp == 0)
-    {
-        /* Two children... promotion becomes difficult!  */
-        if (dead_node->left != NULL && dead_node->right != NULL)
-        {
-            /*
-             * We'll take the largest on the left, could also take the smallest
-             * on the right. Ideally we'd take whichever was the longest path,
-             * but I don't want to calculate that... We should really use
-             * something better than a binary tree.
-             */
-            replacement_node = largest_node(dead_node->left, &replacements_parent);
-
-            /*
-             * If the dead node only has one child on the left, no need to mess
-             * around with replacements_parent, which happens to be the dead node!
-             *
-             * We know that the replacement node is always on the right of its own
-             * parent, unless it is the direct left child of the dead node.
-             */
-            if (replacements_parent != NULL)
-            {
-                replacements_parent->right = replacement_node->left;
-            }
-
-            replacement_node->left  = replacements_parent;
-            replacement_node->right = dead_node->right;
-        }
-
-        else if (dead_node->left != NULL)
-        {
-            replacement_node    = dead_node->left;
-        }
-        else if (dead_node->right != NULL)
-        {
-            replacement_node    = dead_node->right;
-        }
-        else
-        {
-            replacement_node    = NULL;
-        }
-
-        if (dead_node == deads_parent->left)
-        {
-            deads_parent->left = replacement_node;
-        }
-        else if (dead_node == deads_parent->right)
-        {
-            deads_parent->right = replacement_node;
-        }
-
-        /* If the dead node was root, update the root */
-        if (dead_node == root)
-        {
-            root = replacement_node;
-        }
-
-        return 0;
+    node = itree_lookup(&objtable, memsection->base);
+    if (node == &memsection->objtable_node) {
+        itree_remove(&objtable, node);
     }
 
     return 0;
@@ -275,42 +117,41 @@ objtable_delete(const struct memsection *memsection)
 void
 objtable_init(void)
 {
-    root = NULL;
+    itree_init(&objtable);
 }
 
 struct memsection *
 objtable_lookup(void * addr)
 {
-    int     cmp;
-    struct  memsection * memsection;
-
-    if (root == NULL)
-    {
-        return 0;
-    }
-
-    memsection = find_node(root, (uintptr_t)addr, &cmp, NULL);
+    struct memsection *memsection;
+    struct memsection_node *ms, *first_ms;
 
-    if (cmp == 0)
-    {
+    memsection = objtable_entry(itree_lookup(&objtable, (uintptr_t)addr));
+    if (memsection != NULL) {
         return memsection;
     }
-    else
-    {
-        /*
-         * XXX: for bootstrapping
-         */
-        struct memsection_node *ms, *first_ms = internal_memsections.first;
 
-        for (ms = first_ms; ms->next != first_ms; ms = ms->next)
-        {
-            if ((uintptr_t)addr >= ms->data.base && (uintptr_t)addr <= ms->data.end)
-            {
-                return &ms->data;
-            }
+    /*
+     * XXX: for bootstrapping
+     */
+    first_ms = internal_memsections.first;
+    for (ms = first_ms; ms->next != first_ms; ms = ms->next) {
+        if ((uintptr_t)addr >= ms->data.base && (uintptr_t)addr <= ms->data.end) {
+            return &ms->data;
         }
     }
 
     return NULL;
 }
 
+struct memsection *
+objtable_first_overlap(uintptr_t base, uintptr_t end)
+{
+    return objtable_entry(itree_first_overlap(&objtable, base, end));
+}
+
+struct memsection *
+objtable_next(const struct memsection *memsection)
+{
+    return objtable_entry(itree_next(&objtable, &memsection->objtable_node));
+}
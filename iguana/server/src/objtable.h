@@ -68,4 +68,12 @@ int objtable_insert(struct memsection *memsection);
 int objtable_delete(const struct memsection *memsection);
 struct memsection *objtable_lookup(void *addr);
 
+/*
+ * Lowest-addressed memsection overlapping [base, end], and the memsection
+ * following a given one in address order.  Bootstrap memsections that
+ * are not yet in the table are not returned.
+ */
+struct memsection *objtable_first_overlap(uintptr_t base, uintptr_t end);
+struct memsection *objtable_next(const struct memsection *memsection);
+
 #endif /* _IGUANA_OBJTABLE_H_ */
@@ -73,6 +73,7 @@
 #include <l4/ipc.h>
 #include <l4/kdebug.h>
 #include <l4/map.h>
+#include <l4/space.h>
 #include <l4/config.h>
 #include "clist.h"
 #include "util.h"
@@ -102,6 +103,22 @@ static struct hashtable *l4spaceid_to_pd;
 struct slab_cache ms_ent_cache =
 SLAB_CACHE_INITIALIZER(sizeof(struct ms_entry), &ms_ent_cache);
 
+/*
+ * Attachments are indexed by (pd, memsection) so that the fault path does
+ * not have to walk a pd's ms_list.  The list is kept for ordered iteration.
+ */
+#define MS_MAP_HASHSIZE         1024
+
+static struct ms_entry *ms_map_hash[MS_MAP_HASHSIZE];
+
+static inline struct ms_entry **
+ms_map_bucket(struct pd *pd, struct memsection *ms)
+{
+    uintptr_t key = (uintptr_t)pd ^ hash_hash((uintptr_t)ms);
+
+    return &ms_map_hash[hash_hash(key) & (MS_MAP_HASHSIZE - 1)];
+}
+
 /*
  * Utcb information 
  */
@@ -266,6 +283,7 @@ pd_setup(struct pd *self, struct pd *parent, unsigned int max_threads)
     eas_list_init(&self->eass);
 #endif
     clist_list_init(&self->clists);
+    memset(self->security_cache, 0, sizeof(self->security_cache));
     TAILQ_INIT(&self->pm_list);
     TAILQ_INIT(&self->ms_list);
     TAILQ_INIT(&self->owned_clists);
@@ -868,6 +886,7 @@ pd_add_clist(struct pd *self, struct clist *clist)
         return 0;
     }
     clist_info->clist = clist;
+    clist_generation++;
     return (uintptr_t)clist_info;
 }
 
@@ -882,6 +901,7 @@ pd_release_clist(const struct pd *self, const struct clist *clist)
          clists->next != self->clists.first; clists = clists->next) {
         if (clist == clists->data.clist) {
             clist_list_delete(&clists->data);
+            clist_generation++;
             break;
         }
     }
@@ -1009,110 +1029,213 @@ pd_detach(struct pd *pd, struct memsection *ms)
     pd_map_remove(pd, ms);
 }
 
-int
-pd_sync_range(struct pd *pd, uintptr_t base, uintptr_t end,
-              struct memsection *ms, int rwx)
-{
-    uintptr_t attr;
-    uintptr_t phys;
-    int r;
-    size_t size;
+/*
+ * Map items produced by pd_sync_range() are collected here and handed to
+ * the kernel up to L4_MAX_MAP_ITEMS at a time.
+ */
+struct sync_batch {
     L4_SpaceId_t space;
-#if defined(CONFIG_MEM_PROTECTED)
-    L4_SpaceId_t ext_space;
+    L4_Word_t num;
+    L4_MapItem_t items[L4_MAX_MAP_ITEMS];
+};
+
+#if defined(CONFIG_STATS)
+size_t pd_sync_syscalls;
+size_t pd_sync_bytes;
 #endif
-    uintptr_t virt;
 
-    /* If a valid memsection wasn't passed in, we look it up. */
-    if (!ms) {
-        ms = objtable_lookup((void *)base);
-        if (!ms) {
-            return -1;
-        }
+static int
+sync_batch_flush(struct sync_batch *batch)
+{
+    L4_Word_t r;
+
+    if (batch->num == 0) {
+        return 0;
     }
+    r = L4_ProcessMapItems(batch->space, batch->num, batch->items);
+    batch->num = 0;
+#if defined(CONFIG_STATS)
+    pd_sync_syscalls++;
+#endif
+    return r == 1 ? 0 : -1;
+}
 
-    /* Ditto for the access rights. */
-    if (!rwx) {
-        rwx = pd_map_lookup(pd, ms);
-        if (!rwx) {
+/*
+ * Queue a run of base pages, as items of at most L4_MAX_MAP_RUN_PAGES
+ * pages.  The kernel splits each item into the largest pages that the
+ * virtual and physical alignment allow.
+ */
+static int
+sync_batch_add(struct sync_batch *batch, uintptr_t virt, uintptr_t size,
+               uintptr_t phys, int present, int rwx, uintptr_t attr)
+{
+    L4_MapItem_t *item;
+    uintptr_t run;
+
+    while (size != 0) {
+        run = size;
+        if ((run >> BASE_LOG2_PAGESIZE) > L4_MAX_MAP_RUN_PAGES) {
+            run = (uintptr_t)L4_MAX_MAP_RUN_PAGES << BASE_LOG2_PAGESIZE;
+        }
+        if (batch->num == L4_MAX_MAP_ITEMS && sync_batch_flush(batch) != 0) {
             return -1;
         }
+        item = &batch->items[batch->num++];
+        if (present) {
+            L4_MapItem_Map(item, 0, phys, virt, BASE_LOG2_PAGESIZE, attr, rwx);
+        } else {
+            L4_MapItem_Unmap(item, virt, BASE_LOG2_PAGESIZE);
+        }
+        L4_MapItem_SetMultiplePages(item, run >> BASE_LOG2_PAGESIZE);
+#if defined(CONFIG_STATS)
+        pd_sync_bytes += run;
+#endif
+        virt += run;
+        phys += run;
+        size -= run;
     }
+    return 0;
+}
 
-    /* Walk the address range and update any mappings. */
-    attr = ms->attributes;
-    space = pd_l4_space(pd);
+/* Apply one run of present or absent pages to the pd's spaces. */
+static int
+sync_run(struct sync_batch *batch, struct pd *pd, struct memsection *ms,
+         uintptr_t virt, uintptr_t size, uintptr_t phys, int present,
+         int rwx)
+{
+    uintptr_t attr = ms->attributes;
+    int r;
 #if defined(CONFIG_MEM_PROTECTED)
-    ext_space = pd_ext_l4_space(pd);
+    L4_SpaceId_t ext_space = pd_ext_l4_space(pd);
 #endif
-    for (virt = base; virt <= end; virt += size) {
-        r = memsection_lookup_phys(ms, virt, &phys, &size, pd);
-        if (!r) {
-            /* XXX: We should coalesce adjacent gaps. */
-            size = BASE_PAGESIZE;
-            l4e_unmap(space, virt, virt + size - 1);
-            continue;
-        }
 
-        /* XXX: We allow mappings that lie partially outside the range. */
-        virt = round_down(virt, size);
+    if (!present) {
+        return sync_batch_add(batch, virt, size, 0, 0, rwx, attr);
+    }
+
 #if defined(CONFIG_MEM_PROTECTED)
-        if ((ms->flags & MEM_PROTECTED) == 0) {
+    if ((ms->flags & MEM_PROTECTED) == 0) {
 #endif
-            r = l4e_map(space, virt, virt + size - 1, phys, rwx, attr);
-            if (r != 1) {
-                return -1;
-            }
-#if defined(CONFIG_MEM_PROTECTED)
+        r = sync_batch_add(batch, virt, size, phys, 1, rwx, attr);
+        if (r != 0) {
+            return -1;
         }
+#if defined(CONFIG_MEM_PROTECTED)
+    }
 #endif
 #if defined(CONFIG_MEM_PROTECTED)
 #if defined(ARM_SHARED_DOMAINS)
-        /* FIXME: resync mappings in extension space? */
-        if (!L4_IsNilSpace(ext_space)) {
-            if (ms->flags & MEM_PROTECTED) {
-                if (ms != protected_memsection) {
-                    /* Only one protected memsection supported. */
-                    return -1;
-                }
-                r = l4e_map(ext_space, virt, virt + size - 1, phys, rwx, attr);
-                if (r != 1) {
+    /* FIXME: resync mappings in extension space? */
+    if (!L4_IsNilSpace(ext_space)) {
+        if (ms->flags & MEM_PROTECTED) {
+            if (ms != protected_memsection) {
+                /* Only one protected memsection supported. */
+                return -1;
+            }
+            r = l4e_map(ext_space, virt, virt + size - 1, phys, rwx, attr);
+            if (r != 1) {
+                assert(0);
+                return -1;
+            }
+        }
+        else {
+            uintptr_t addr, limit;
+
+            addr = round_down(virt, MIN_WINDOW);
+            limit = round_up(virt + size - 1, MIN_WINDOW) - 1;
+            for (; addr <= limit; addr += MIN_WINDOW) {
+                r = !l4_map_window(ext_space, batch->space,
+                                   L4_Fpage(addr, MIN_WINDOW));
+                /* XXX: We don't trap which regions are already mapped so
+                 * we can end up trying to map over the top of a perfectly
+                 * useful window.
+                 */
+                if (r != 0 && L4_ErrorCode() != L4_ErrDomainConflict) {
                     assert(0);
                     return -1;
                 }
             }
-            else {
-                uintptr_t addr, limit;
-
-                addr = round_down(virt, MIN_WINDOW);
-                limit = round_up(virt + size - 1, MIN_WINDOW) - 1;
-                for (; addr <= limit; addr += MIN_WINDOW) {
-                    r = !l4_map_window(ext_space, space,
-                                       L4_Fpage(addr, MIN_WINDOW));
-                    /* XXX: We don't trap which regions are already mapped so
-                     * we can end up trying to map over the top of a perfectly
-                     * useful window.
-                     */
-                    if (r != 0 && L4_ErrorCode() != L4_ErrDomainConflict) {
-                        assert(0);
-                        return -1;
-                    }
-                }
-            }
         }
+    }
 #else
-        if (!L4_IsNilSpace(ext_space)) {
-            r = l4e_map(ext_space, virt, virt + size - 1, phys, rwx, attr);
-            if (r != 1) {
-                return -1;
-            }
+    if (!L4_IsNilSpace(ext_space)) {
+        r = l4e_map(ext_space, virt, virt + size - 1, phys, rwx, attr);
+        if (r != 1) {
+            return -1;
         }
+    }
 #endif
 #endif
-    }
     return 0;
 }
 
+int
+pd_sync_range(struct pd *pd, uintptr_t base, uintptr_t end,
+              struct memsection *ms, int rwx)
+{
+    struct sync_batch batch;
+    uintptr_t phys = 0, run_phys = 0;
+    uintptr_t virt, run_virt = 0;
+    size_t size, run_size = 0;
+    int present, run_present = 0;
+
+    /* If a valid memsection wasn't passed in, we look it up. */
+    if (!ms) {
+        ms = objtable_lookup((void *)base);
+        if (!ms) {
+            return -1;
+        }
+    }
+
+    /* Ditto for the access rights. */
+    if (!rwx) {
+        rwx = pd_map_lookup(pd, ms);
+        if (!rwx) {
+            return -1;
+        }
+    }
+
+    /*
+     * Walk the address range, coalescing it into runs of unmapped pages
+     * and of pages that are contiguous in physical memory.  Each run
+     * becomes a single map item.
+     */
+    batch.space = pd_l4_space(pd);
+    batch.num = 0;
+    for (virt = base; virt <= end; virt += size) {
+        present = memsection_lookup_phys(ms, virt, &phys, &size, pd) != 0;
+        if (!present) {
+            size = BASE_PAGESIZE;
+        } else {
+            /* XXX: We allow mappings that lie partially outside the range. */
+            virt = round_down(virt, size);
+        }
+
+        if (run_size != 0 && present == run_present &&
+                virt == run_virt + run_size &&
+                (!present || phys == run_phys + run_size)) {
+            run_size += size;
+            continue;
+        }
+        if (run_size != 0 &&
+                sync_run(&batch, pd, ms, run_virt, run_size, run_phys,
+                         run_present, rwx) != 0) {
+            return -1;
+        }
+        run_virt = virt;
+        run_phys = phys;
+        run_size = size;
+        run_present = present;
+    }
+    if (run_size != 0 &&
+            sync_run(&batch, pd, ms, run_virt, run_size, run_phys,
+                     run_present, rwx) != 0) {
+        return -1;
+    }
+
+    return sync_batch_flush(&batch);
+}
+
 void
 pd_flush_range(struct pd *pd, uintptr_t base, uintptr_t end)
 {
@@ -1129,10 +1252,11 @@ pd_flush_range(struct pd *pd, uintptr_t base, uintptr_t end)
 int
 pd_map_insert(struct pd *pd, struct memsection *ms, int rwx)
 {
+    struct ms_entry **bucket = ms_map_bucket(pd, ms);
     struct ms_entry *ent;
 
-    TAILQ_FOREACH(ent, &pd->ms_list, ms_list) {
-        if (ent->ms == ms) {
+    for (ent = *bucket; ent != NULL; ent = ent->hash_next) {
+        if (ent->pd == pd && ent->ms == ms) {
             ent->rwx = rwx;
             return 0;
         }
@@ -1141,8 +1265,11 @@ pd_map_insert(struct pd *pd, struct memsection *ms, int rwx)
     if (ent == NULL) {
         return -1;
     }
+    ent->pd = pd;
     ent->ms = ms;
     ent->rwx = rwx;
+    ent->hash_next = *bucket;
+    *bucket = ent;
     TAILQ_INSERT_TAIL(&pd->ms_list, ent, ms_list);
     return 0;
 }
@@ -1152,8 +1279,8 @@ pd_map_lookup(struct pd *pd, struct memsection *ms)
 {
     struct ms_entry *ent;
 
-    TAILQ_FOREACH(ent, &pd->ms_list, ms_list) {
-        if (ent->ms == ms) {
+    for (ent = *ms_map_bucket(pd, ms); ent != NULL; ent = ent->hash_next) {
+        if (ent->pd == pd && ent->ms == ms) {
             return ent->rwx;
         }
     }
@@ -1163,13 +1290,15 @@ pd_map_lookup(struct pd *pd, struct memsection *ms)
 void
 pd_map_remove(struct pd *pd, struct memsection *ms)
 {
+    struct ms_entry **prev = ms_map_bucket(pd, ms);
     struct ms_entry *ent;
 
-    TAILQ_FOREACH(ent, &pd->ms_list, ms_list) {
-        if (ent->ms == ms)
+    for (ent = *prev; ent != NULL; prev = &ent->hash_next, ent = *prev) {
+        if (ent->pd == pd && ent->ms == ms)
             break;
     }
     if (ent != NULL) {
+        *prev = ent->hash_next;
         TAILQ_REMOVE(&pd->ms_list, ent, ms_list);
         slab_cache_free(&ms_ent_cache, ent);
     }
@@ -107,6 +107,18 @@ struct pd_list {
     struct pd_node *last;
 };
 
+/*
+ * Recent security_check() results for a pd.  An entry is only valid while
+ * its generation matches clist_generation.
+ */
+#define SECURITY_CACHE_SIZE 8
+
+struct security_cache_entry {
+    uintptr_t ref;
+    uintptr_t interfaces;
+    uintptr_t generation;
+};
+
 struct clist_list {
     struct clist_node *first;
     struct clist_node *last;
@@ -158,6 +170,8 @@ clist_list_clear(struct clist_list *list)
 
 struct ms_entry {
     TAILQ_ENTRY(ms_entry) ms_list;
+    struct ms_entry *hash_next; /* Chain in the (pd, ms) attach table */
+    struct pd *pd;
     struct memsection *ms;
     int rwx;
 };
@@ -198,6 +212,7 @@ struct pd {
      * Clist info 
      */
     struct clist_list clists;
+    struct security_cache_entry security_cache[SECURITY_CACHE_SIZE];
 
     /*
      * Explicitly allocated PhysMem objects.
@@ -381,6 +396,12 @@ int pd_sync_range(struct pd *pd, uintptr_t base, uintptr_t end,
                   struct memsection *ms, int rwx);
 void pd_flush_range(struct pd *pd, uintptr_t base, uintptr_t end);
 
+#if defined(CONFIG_STATS)
+/* MapControl calls made by pd_sync_range() and the bytes they covered. */
+extern size_t pd_sync_syscalls;
+extern size_t pd_sync_bytes;
+#endif
+
 int pd_map_insert(struct pd *pd, struct memsection *ms, int rwx);
 int pd_map_lookup(struct pd *pd, struct memsection *ms);
 void pd_map_remove(struct pd *pd, struct memsection *ms);
@@ -254,7 +254,7 @@ virtpool_alloc_fixed(struct virtpool *pool, size_t size, uintptr_t addr)
 
     mem = mem_alloc_fixed(&pool->alloc, size, addr);
     if (mem != NULL) {
-        vm = slab_cache_alloc(&pm_cache);
+        vm = slab_cache_alloc(&vm_cache);
         if (vm == NULL) {
             mem_free(&pool->alloc, mem);
             return NULL;
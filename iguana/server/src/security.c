@@ -66,6 +66,7 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <hash/hash.h>
 #include "clist.h"
 #include "util.h"
 #include "memsection.h"
@@ -75,6 +76,7 @@
 #include "thread.h"
 #include "vm.h"
 
+#ifdef ENABLE_CAPS
 static int
 refcmp(const void *x, const void *y)
 {
@@ -103,11 +105,16 @@ __clist_print(struct clist *clist)
 }
 #endif
 
+#if defined(CONFIG_STATS)
+size_t security_cache_hits;
+size_t security_cache_misses;
+#endif
+
 /*
- * Returns a bitmap of valid interface numbers.
+ * Collect the interfaces granted to ref by every clist attached to pd.
  */
-uintptr_t
-security_check(struct pd *pd, uintptr_t ref)
+static uintptr_t
+security_scan(struct pd *pd, uintptr_t ref)
 {
     cap_t cap;
     struct clist *clist;
@@ -115,10 +122,6 @@ security_check(struct pd *pd, uintptr_t ref)
     int i;
     uintptr_t interfaces = 0;
     cap_t *p;
-    
-    if (pd == NULL) {
-        return 0;
-    }
 
     cap.ref.obj = ref;
     for (clists = pd->clists.first; clists->next != pd->clists.first; clists = clists->next) {
@@ -150,9 +153,49 @@ security_check(struct pd *pd, uintptr_t ref)
             interfaces |= (1UL << (clist->cap[i].ref.obj & IID_MASK));
         }
     }
+    return interfaces;
+}
+#endif
+
+/*
+ * Returns a bitmap of valid interface numbers.
+ */
+uintptr_t
+security_check(struct pd *pd, uintptr_t ref)
+{
+#ifdef ENABLE_CAPS
+    struct security_cache_entry *entry;
+    uintptr_t interfaces;
+    uintptr_t obj;
+#endif
+
+    if (pd == NULL) {
+        return 0;
+    }
+
 #ifdef ENABLE_CAPS
+    /* The interface bits of ref don't affect the result. */
+    obj = ref & ~IID_MASK;
+    entry = &pd->security_cache[hash_hash(obj >> 3) &
+                                (SECURITY_CACHE_SIZE - 1)];
+    if (entry->generation == clist_generation && entry->ref == obj) {
+#if defined(CONFIG_STATS)
+        security_cache_hits++;
+#endif
+        interfaces = entry->interfaces;
+    } else {
+#if defined(CONFIG_STATS)
+        security_cache_misses++;
+#endif
+        interfaces = security_scan(pd, obj);
+        entry->ref = obj;
+        entry->interfaces = interfaces;
+        entry->generation = clist_generation;
+    }
     return interfaces;
 #else
+    /* Every check passes, so there is nothing to scan or cache. */
+    (void)ref;
     return ~0UL;
 #endif
 }
@@ -78,4 +78,9 @@
 uintptr_t security_check(struct pd *pd, uintptr_t ref);
 cap_t security_create_capability(uintptr_t reference);
 
+#if defined(CONFIG_STATS)
+extern size_t security_cache_hits;
+extern size_t security_cache_misses;
+#endif
+
 #endif /* _IGUANA_SECURITY_H_ */
@@ -76,6 +76,8 @@
 #include "slab_cache.h"
 #include "tools.h"
 
+#define SLAB_SIZE 0x1000
+
 struct chunk {
     TAILQ_ENTRY(chunk) chunk_list;
 };
@@ -83,17 +85,121 @@ struct chunk {
 struct slab {
     TAILQ_HEAD(chunk_head, chunk) chunks;
     TAILQ_ENTRY(slab) slab_list;
+    struct slab_head *head;     /* List of the cache the slab is on. */
+    uintptr_t pbase;
+    uintptr_t size;
+    uintptr_t nchunks;
+    uintptr_t inuse;
 };
 
+#if defined(CONFIG_STATS)
+size_t slab_cache_pages;
+size_t slab_cache_reclaims;
+#endif
+
+static struct slab_head *
+slab_list_for(struct slab_cache *cache, struct slab *slab)
+{
+    if (slab->inuse == 0) {
+        return &cache->empty;
+    }
+    if (slab->inuse == slab->nchunks) {
+        return &cache->full;
+    }
+    return &cache->partial;
+}
+
+/*
+ * Move a slab to the list matching its current number of used chunks.
+ */
+static void
+slab_relist(struct slab_cache *cache, struct slab *slab)
+{
+    struct slab_head *head = slab_list_for(cache, slab);
+
+    if (head == slab->head) {
+        return;
+    }
+    if (slab->head != NULL) {
+        TAILQ_REMOVE(slab->head, slab, slab_list);
+        if (slab->head == &cache->empty) {
+            cache->nempty--;
+        }
+    }
+    TAILQ_INSERT_HEAD(head, slab, slab_list);
+    if (head == &cache->empty) {
+        cache->nempty++;
+    }
+    slab->head = head;
+}
+
+static int
+slab_reclaimable(struct slab_cache *cache, struct slab *slab)
+{
+    return !(cache->flags & SLAB_CACHE_NORECLAIM) && slab->size == SLAB_SIZE;
+}
+
+/*
+ * Unmap an empty slab and give its pages back to the internal pools.
+ * Adding the pages may itself allocate from mem_cache, so the slab is taken
+ * off the cache and unmapped before either pool can hand the pages out.
+ */
+static void
+slab_release(struct slab_cache *cache, struct slab *slab)
+{
+    uintptr_t vbase = (uintptr_t)slab;
+    uintptr_t pbase = slab->pbase;
+
+    assert(slab->inuse == 0 && slab->head == &cache->empty);
+    TAILQ_REMOVE(&cache->empty, slab, slab_list);
+    cache->nempty--;
+    cache->nslabs--;
+    l4e_unmap(pd_l4_space(&iguana_pd), vbase, vbase + SLAB_SIZE - 1);
+
+    if (mem_add(internal_physpool, pbase, SLAB_SIZE) != 0) {
+        /* Nowhere to record the page, so keep it as a slab. */
+#if defined(CONFIG_STATS)
+        slab_cache_pages--;
+#endif
+        (void)__slab_cache_add(cache, vbase, pbase, SLAB_SIZE);
+        return;
+    }
+    if (mem_add(internal_virtpool, vbase, SLAB_SIZE) != 0) {
+        /* Only the address range is lost; the frame is already back. */
+        DEBUG_PRINT("slab_release: lost virtual page 0x%lx\n",
+                    (unsigned long)vbase);
+    }
+#if defined(CONFIG_STATS)
+    cache->reclaims++;
+    slab_cache_pages--;
+    slab_cache_reclaims++;
+#endif
+}
+
+/*
+ * Return every empty slab of the cache to the internal pools.
+ */
+void
+slab_cache_reclaim(struct slab_cache *cache)
+{
+    struct slab *slab, *tmp;
+
+    TAILQ_FOREACH_SAFE(slab, &cache->empty, slab_list, tmp) {
+        if (slab_reclaimable(cache, slab)) {
+            slab_release(cache, slab);
+        }
+    }
+}
+
 void *
-slab_cache_alloc(struct slab_cache *cache)
+slab_cache_alloc_nozero(struct slab_cache *cache)
 {
     struct chunk *chunk;
     struct slab *slab;
 
-    TAILQ_FOREACH(slab, &cache->slabs, slab_list) {
-        if (!TAILQ_EMPTY(&slab->chunks))
-            break;
+    slab = TAILQ_FIRST(&cache->partial);
+    if (slab == NULL) {
+        slab = TAILQ_FIRST(&cache->empty);
     }
 
     if (slab == NULL) {
@@ -104,9 +210,9 @@ slab_cache_alloc(struct slab_cache *cache)
             return NULL;
         }
         slab = __slab_cache_add(cache, 
-                                mem_alloc_unboxed(internal_virtpool, 0x1000),
-                                mem_alloc_unboxed(internal_physpool, 0x1000),
-                                0x1000);
+                                mem_alloc_unboxed(internal_virtpool, SLAB_SIZE),
+                                mem_alloc_unboxed(internal_physpool, SLAB_SIZE),
+                                SLAB_SIZE);
     }
 
     if (slab == NULL) {
@@ -116,10 +222,26 @@ slab_cache_alloc(struct slab_cache *cache)
 
     chunk = TAILQ_FIRST(&slab->chunks);
     TAILQ_REMOVE(&slab->chunks, chunk, chunk_list);
-    memzero(chunk, cache->size);
+    slab->inuse++;
+    slab_relist(cache, slab);
+#if defined(CONFIG_STATS)
+    cache->allocs++;
+#endif
     return chunk;
 }
 
+void *
+slab_cache_alloc(struct slab_cache *cache)
+{
+    void *ptr;
+
+    ptr = slab_cache_alloc_nozero(cache);
+    if (ptr != NULL) {
+        memzero(ptr, cache->size);
+    }
+    return ptr;
+}
+
 void
 slab_cache_free(struct slab_cache *cache, void *ptr)
 {
@@ -128,7 +250,18 @@ slab_cache_free(struct slab_cache *cache, void *ptr)
 
     chunk = ptr;
     slab = (struct slab *)((uintptr_t)ptr >> 12 << 12);
-    TAILQ_INSERT_TAIL(&slab->chunks, chunk, chunk_list);
+    assert(slab->inuse > 0);
+    TAILQ_INSERT_HEAD(&slab->chunks, chunk, chunk_list);
+    slab->inuse--;
+    slab_relist(cache, slab);
+#if defined(CONFIG_STATS)
+    cache->frees++;
+#endif
+
+    if (slab->inuse == 0 && cache->nempty > SLAB_CACHE_MAX_EMPTY &&
+            slab_reclaimable(cache, slab)) {
+        slab_release(cache, slab);
+    }
 }
 
 /* 8-byte align the size. */
@@ -150,23 +283,33 @@ __slab_cache_add(struct slab_cache *cache, uintptr_t vbase, uintptr_t pbase,
     int i, n, r;
     struct chunk *chunk;
     struct slab *slab;
-    /* Align objects on an 8-byte boundary. */
-    uintptr_t aligned_size = align8(cache->size);
+    /* Align objects on an 8-byte boundary, with room for the free list. */
+    uintptr_t aligned_size = align8(max(cache->size, sizeof(struct chunk)));
 
     r = l4e_map(pd_l4_space(&iguana_pd), vbase, vbase + size - 1, pbase, 
                 L4_ReadWriteOnly, L4_DefaultMemory);
 
     slab = (struct slab *)vbase;
-    chunk = (struct chunk *)(vbase + max(sizeof(struct slab), aligned_size));
+    chunk = (struct chunk *)(vbase + max(align8(sizeof(struct slab)),
+                                               aligned_size));
 
     n = (vbase + size - (uintptr_t)chunk) / aligned_size;
     TAILQ_INIT(&slab->chunks);
+    slab->head = NULL;
+    slab->pbase = pbase;
+    slab->size = size;
+    slab->nchunks = n;
+    slab->inuse = 0;
 
     assert(n > 0);
     for (i = 0; i < n; i++) {
         TAILQ_INSERT_TAIL(&slab->chunks, chunk, chunk_list);
         chunk = (struct chunk *)((uintptr_t)chunk + aligned_size);
     }
-    TAILQ_INSERT_TAIL(&cache->slabs, slab, slab_list);
+    slab_relist(cache, slab);
+    cache->nslabs++;
+#if defined(CONFIG_STATS)
+    slab_cache_pages += size / SLAB_SIZE;
+#endif
     return slab;
 }
@@ -70,18 +70,53 @@
 
 struct slab;
 
+TAILQ_HEAD(slab_head, slab);
+
+/*
+ * Slabs live on one of three lists depending on how many of their chunks
+ * are in use.  Allocation is served from the partial list first so that
+ * full slabs are never scanned, and empty slabs beyond SLAB_CACHE_MAX_EMPTY
+ * are handed back to the internal pools.
+ */
 struct slab_cache {
     uintptr_t size;     /* Size of blocks allocated out of cache. */
-    TAILQ_HEAD(slab_head, slab) slabs;
+    struct slab_head partial;
+    struct slab_head full;
+    struct slab_head empty;
+    int flags;
+    uintptr_t nslabs;   /* Slabs currently owned by the cache. */
+    uintptr_t nempty;   /* Slabs on the empty list. */
+#if defined(CONFIG_STATS)
+    uintptr_t allocs;
+    uintptr_t frees;
+    uintptr_t reclaims;
+#endif
 };
 
-#define SLAB_CACHE_INITIALIZER(sz,sc) \
-                { (sz), TAILQ_HEAD_INITIALIZER((sc)->slabs) }
+/* Never return this cache's slabs to the internal pools. */
+#define SLAB_CACHE_NORECLAIM    0x1
+
+/* Number of empty slabs a cache keeps before reclaiming. */
+#define SLAB_CACHE_MAX_EMPTY    1
+
+#define SLAB_CACHE_INITIALIZER_FLAGS(sz,sc,fl) \
+                { (sz), TAILQ_HEAD_INITIALIZER((sc)->partial), \
+                  TAILQ_HEAD_INITIALIZER((sc)->full), \
+                  TAILQ_HEAD_INITIALIZER((sc)->empty), (fl) }
+
+#define SLAB_CACHE_INITIALIZER(sz,sc) SLAB_CACHE_INITIALIZER_FLAGS(sz, sc, 0)
 
 void *slab_cache_alloc(struct slab_cache *cache);
+void *slab_cache_alloc_nozero(struct slab_cache *cache);
 void slab_cache_free(struct slab_cache *cache, void *ptr);
+void slab_cache_reclaim(struct slab_cache *cache);
 struct slab *__slab_cache_add(struct slab_cache *cache, uintptr_t vbase,
                               uintptr_t pbase, size_t size);
 
+#if defined(CONFIG_STATS)
+/* Totals over all caches. */
+extern size_t slab_cache_pages;
+extern size_t slab_cache_reclaims;
+#endif
 
 #endif
@@ -72,6 +72,8 @@
 #include "pgtable.h"
 #include "pool.h"
 #include "objtable.h"
+#include "security.h"
+#include "slab_cache.h"
 
 enum {
     MALLOC_OVERHEAD = sizeof(void*) + sizeof(unsigned)
@@ -104,9 +106,27 @@ const iguana_stats_t iguana_stats =
     (size_t) 0,
     (size_t) 0,
 #endif
-    sizeof(struct thread_node) + MALLOC_OVERHEAD /* thread_size */
+    sizeof(struct thread_node) + MALLOC_OVERHEAD, /* thread_size */
+    (size_t) 0, /* sync_syscalls */
+    (size_t) 0, /* sync_bytes */
+    (size_t) 0, /* security_cache_hits */
+    (size_t) 0, /* security_cache_misses */
+    (size_t) 0, /* slab_pages */
+    (size_t) 0  /* slab_reclaims */
 };
 
+void
+stats_fill(iguana_stats_t *stats)
+{
+    memcpy(stats, &iguana_stats, sizeof(iguana_stats_t));
+    stats->sync_syscalls = pd_sync_syscalls;
+    stats->sync_bytes = pd_sync_bytes;
+    stats->security_cache_hits = security_cache_hits;
+    stats->security_cache_misses = security_cache_misses;
+    stats->slab_pages = slab_cache_pages;
+    stats->slab_reclaims = slab_cache_reclaims;
+}
+
 #else
 /* This is only here because ADS is silly. */
 #if defined (__RVCT__) || defined(__RVCT_GNU__) || defined (__ADS__)
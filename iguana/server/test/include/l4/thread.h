@@ -0,0 +1 @@
+/* Host stub for the slab cache test; slab_cache.c needs nothing from it. */
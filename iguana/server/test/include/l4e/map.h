@@ -0,0 +1,11 @@
+/* Host stub for the slab cache test. */
+#include <stdint.h>
+
+typedef uintptr_t L4_SpaceId_t;
+
+#define L4_ReadWriteOnly        0
+#define L4_DefaultMemory        0
+
+int l4e_map(L4_SpaceId_t space, uintptr_t start, uintptr_t end,
+            uintptr_t pbase, int rwx, int attr);
+void l4e_unmap(L4_SpaceId_t space, uintptr_t start, uintptr_t end);
@@ -0,0 +1,2 @@
+/* Host stub for the slab cache test, using the real queue library. */
+#include "../../../../../libs/queue/include/tailq.h"
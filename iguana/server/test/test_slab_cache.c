@@ -0,0 +1,425 @@
+/*
+ * Copyright (c) 2007 Open Kernel Labs, Inc. (Copyright Holder).
+ * All rights reserved.
+ *
+ * 1. Redistribution and use of OKL4 (Software) in source and binary
+ * forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ *     (a) Redistributions of source code must retain this clause 1
+ *         (including paragraphs (a), (b) and (c)), clause 2 and clause 3
+ *         (Licence Terms) and the above copyright notice.
+ *
+ *     (b) Redistributions in binary form must reproduce the above
+ *         copyright notice and the Licence Terms in the documentation and/or
+ *         other materials provided with the distribution.
+ *
+ *     (c) Redistributions in any form must be accompanied by information on
+ *         how to obtain complete source code for:
+ *        (i) the Software; and
+ *        (ii) all accompanying software that uses (or is intended to
+ *        use) the Software whether directly or indirectly.  Such source
+ *        code must:
+ *        (iii) either be included in the distribution or be available
+ *        for no more than the cost of distribution plus a nominal fee;
+ *        and
+ *        (iv) be licensed by each relevant holder of copyright under
+ *        either the Licence Terms (with an appropriate copyright notice)
+ *        or the terms of a licence which is approved by the Open Source
+ *        Initative.  For an executable file, "complete source code"
+ *        means the source code for all modules it contains and includes
+ *        associated build and other files reasonably required to produce
+ *        the executable.
+ *
+ * 2. THIS SOFTWARE IS PROVIDED ``AS IS'' AND, TO THE EXTENT PERMITTED BY
+ * LAW, ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  WHERE ANY WARRANTY IS
+ * IMPLIED AND IS PREVENTED BY LAW FROM BEING DISCLAIMED THEN TO THE
+ * EXTENT PERMISSIBLE BY LAW: (A) THE WARRANTY IS READ DOWN IN FAVOUR OF
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT) AND (B) ANY LIMITATIONS PERMITTED BY LAW (INCLUDING AS TO
+ * THE EXTENT OF THE WARRANTY AND THE REMEDIES AVAILABLE IN THE EVENT OF
+ * BREACH) ARE DEEMED PART OF THIS LICENCE IN A FORM MOST FAVOURABLE TO
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT). IN THE LICENCE TERMS, "PARTICIPANT" INCLUDES EVERY
+ * PERSON WHO HAS CONTRIBUTED TO THE SOFTWARE OR WHO HAS BEEN INVOLVED IN
+ * THE DISTRIBUTION OR DISSEMINATION OF THE SOFTWARE.
+ *
+ * 3. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR ANY OTHER PARTICIPANT BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Description:   Host unit test for the Iguana server slab cache
+ *
+ * slab_cache.c is built on the host against the stubs below, which
+ * stand in for the server headers it includes (by defining their include
+ * guards first) and for the internal memory pools and l4e_map(). The
+ * library headers it includes are stubbed in include/. Pages come from
+ * the host heap and are poisoned when unmapped.
+ *
+ * Build and run from this directory with:
+ *
+ *   cc -Iinclude -o test_slab_cache test_slab_cache.c && ./test_slab_cache
+ */
+
+/* The tests check the slab counters. */
+#define CONFIG_STATS
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <l4e/map.h>
+
+/* Stubs for the server headers slab_cache.c includes. */
+#define MEM_POOL_H
+#define _IG_UTIL_H_
+#define _IGUANA_MEMSECTION_H_
+#define _IGUANA_PD_H_
+#define _IGUANA_OBJTABLE_H_
+#define IGUANA__SERVER__TOOLS_H
+
+struct pd {
+    int unused;
+};
+struct mem_pool {
+    int unused;
+};
+
+#define pd_l4_space(pd)         ((L4_SpaceId_t)0)
+#define max(a,b)                (a > b ? a : b)
+#define DEBUG_PRINT(...)
+#define memzero(ptr, size)      memset((ptr), 0, (size))
+
+static struct mem_pool virtpool, physpool;
+struct mem_pool *internal_virtpool = &virtpool;
+struct mem_pool *internal_physpool = &physpool;
+struct pd iguana_pd;
+
+int mem_empty(struct mem_pool *pool);
+uintptr_t mem_alloc_unboxed(struct mem_pool *pool, uintptr_t size);
+int mem_add(struct mem_pool *pool, uintptr_t base, uintptr_t size);
+
+#include "../src/slab_cache.c"
+
+#define PAGE_SIZE       SLAB_SIZE
+
+/* Pages handed out by the pools and not yet given back. */
+static int virt_pages, phys_pages;
+/* Pages currently mapped. */
+static int mapped_pages;
+/* Fail the next mem_add() to this pool. */
+static struct mem_pool *fail_add;
+
+int
+l4e_map(L4_SpaceId_t space, uintptr_t start, uintptr_t end,
+        uintptr_t pbase, int rwx, int attr)
+{
+    mapped_pages += (end + 1 - start) / PAGE_SIZE;
+    return 0;
+}
+
+void
+l4e_unmap(L4_SpaceId_t space, uintptr_t start, uintptr_t end)
+{
+    mapped_pages -= (end + 1 - start) / PAGE_SIZE;
+    memset((void *)start, 0xaa, end + 1 - start);
+}
+
+int
+mem_empty(struct mem_pool *pool)
+{
+    return 0;
+}
+
+uintptr_t
+mem_alloc_unboxed(struct mem_pool *pool, uintptr_t size)
+{
+    static uintptr_t next_phys = 0x80000000;
+    void *page;
+
+    assert(size == PAGE_SIZE);
+    if (pool == internal_physpool) {
+        phys_pages++;
+        next_phys += PAGE_SIZE;
+        return next_phys;
+    }
+    page = aligned_alloc(PAGE_SIZE, PAGE_SIZE);
+    assert(page != NULL);
+    virt_pages++;
+    return (uintptr_t)page;
+}
+
+int
+mem_add(struct mem_pool *pool, uintptr_t base, uintptr_t size)
+{
+    assert(size == PAGE_SIZE);
+    if (pool == fail_add) {
+        fail_add = NULL;
+        return -1;
+    }
+    if (pool == internal_physpool) {
+        phys_pages--;
+    } else {
+        virt_pages--;
+        free((void *)base);
+    }
+    return 0;
+}
+
+static struct slab *
+slab_of(void *ptr)
+{
+    return (struct slab *)((uintptr_t)ptr & ~(uintptr_t)(PAGE_SIZE - 1));
+}
+
+static int
+on_list(struct slab_head *head, struct slab *slab)
+{
+    struct slab *s;
+
+    TAILQ_FOREACH(s, head, slab_list) {
+        if (s == slab) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Check the cache's counters against its lists. */
+static void
+check_cache(struct slab_cache *cache)
+{
+    struct slab *s;
+    uintptr_t n = 0, empty = 0;
+
+    TAILQ_FOREACH(s, &cache->partial, slab_list) {
+        assert(s->head == &cache->partial);
+        assert(s->inuse > 0 && s->inuse < s->nchunks);
+        n++;
+    }
+    TAILQ_FOREACH(s, &cache->full, slab_list) {
+        assert(s->head == &cache->full);
+        assert(s->inuse == s->nchunks);
+        n++;
+    }
+    TAILQ_FOREACH(s, &cache->empty, slab_list) {
+        assert(s->head == &cache->empty);
+        assert(s->inuse == 0);
+        n++;
+        empty++;
+    }
+    assert(n == cache->nslabs);
+    assert(empty == cache->nempty);
+    assert(mapped_pages == virt_pages);
+}
+
+struct obj {
+    char data[200];
+};
+
+/*
+ * A slab moves from the partial list to the full list as it fills up, back
+ * to the partial list when a chunk is freed and to the empty list once all
+ * its chunks are free.
+ */
+static void
+test_lists(void)
+{
+    static struct slab_cache cache =
+        SLAB_CACHE_INITIALIZER(sizeof(struct obj), &cache);
+    void *objs[PAGE_SIZE / sizeof(struct obj)];
+    struct slab *slab;
+    uintptr_t i, n;
+
+    objs[0] = slab_cache_alloc(&cache);
+    assert(objs[0] != NULL);
+    slab = slab_of(objs[0]);
+    n = slab->nchunks;
+    assert(n > 1 && n <= PAGE_SIZE / sizeof(struct obj));
+    assert(on_list(&cache.partial, slab));
+    check_cache(&cache);
+
+    for (i = 1; i < n; i++) {
+        objs[i] = slab_cache_alloc(&cache);
+        assert(slab_of(objs[i]) == slab);
+    }
+    assert(on_list(&cache.full, slab));
+    assert(TAILQ_EMPTY(&cache.partial));
+    check_cache(&cache);
+
+    slab_cache_free(&cache, objs[0]);
+    assert(on_list(&cache.partial, slab));
+    check_cache(&cache);
+
+    /* The partial slab is used before a new one is added. */
+    objs[0] = slab_cache_alloc(&cache);
+    assert(slab_of(objs[0]) == slab);
+    assert(cache.nslabs == 1);
+
+    for (i = 0; i < n; i++) {
+        slab_cache_free(&cache, objs[i]);
+    }
+    assert(on_list(&cache.empty, slab));
+    assert(cache.nslabs == 1 && cache.nempty == 1);
+    check_cache(&cache);
+
+    /* The empty slab is reused, and the chunk is zeroed. */
+    memset(objs[0], 0x55, sizeof(struct obj));
+    objs[0] = slab_cache_alloc(&cache);
+    assert(slab_of(objs[0]) == slab);
+    for (i = 0; i < sizeof(struct obj); i++) {
+        assert(((char *)objs[0])[i] == 0);
+    }
+    assert(cache.allocs == n + 2 && cache.frees == n + 1);
+    slab_cache_free(&cache, objs[0]);
+    slab_cache_reclaim(&cache);
+    assert(cache.nslabs == 0);
+    check_cache(&cache);
+}
+
+/*
+ * Freeing keeps SLAB_CACHE_MAX_EMPTY empty slabs and gives the pages of
+ * any others back to the pools; slab_cache_reclaim() gives back the rest.
+ * A SLAB_CACHE_NORECLAIM cache keeps all its slabs.
+ */
+static void
+test_reclaim(void)
+{
+    static struct slab_cache cache =
+        SLAB_CACHE_INITIALIZER(sizeof(struct obj), &cache);
+    static struct slab_cache keep =
+        SLAB_CACHE_INITIALIZER_FLAGS(sizeof(struct obj), &keep,
+                                     SLAB_CACHE_NORECLAIM);
+    static void *objs[8 * PAGE_SIZE / sizeof(struct obj)];
+    uintptr_t i, n;
+    size_t pages, reclaims;
+    int virt = virt_pages, phys = phys_pages;
+
+    pages = slab_cache_pages;
+    reclaims = slab_cache_reclaims;
+    n = sizeof(objs) / sizeof(objs[0]);
+    for (i = 0; i < n; i++) {
+        objs[i] = slab_cache_alloc(&cache);
+        assert(objs[i] != NULL);
+    }
+    assert(cache.nslabs >= 8);
+    assert(slab_cache_pages == pages + cache.nslabs);
+    assert(virt_pages == virt + (int)cache.nslabs);
+    check_cache(&cache);
+
+    for (i = 0; i < n; i++) {
+        slab_cache_free(&cache, objs[i]);
+        assert(cache.nempty <= SLAB_CACHE_MAX_EMPTY);
+    }
+    assert(cache.nslabs == SLAB_CACHE_MAX_EMPTY);
+    assert(cache.reclaims == slab_cache_reclaims - reclaims);
+    assert(virt_pages == virt + SLAB_CACHE_MAX_EMPTY);
+    assert(phys_pages == phys + SLAB_CACHE_MAX_EMPTY);
+    check_cache(&cache);
+
+    slab_cache_reclaim(&cache);
+    assert(cache.nslabs == 0 && cache.nempty == 0);
+    assert(virt_pages == virt && phys_pages == phys);
+    assert(slab_cache_pages == pages);
+    check_cache(&cache);
+
+    for (i = 0; i < n; i++) {
+        objs[i] = slab_cache_alloc(&keep);
+    }
+    pages = keep.nslabs;
+    for (i = 0; i < n; i++) {
+        slab_cache_free(&keep, objs[i]);
+    }
+    slab_cache_reclaim(&keep);
+    assert(keep.nslabs == pages && keep.nempty == pages);
+    check_cache(&keep);
+}
+
+/*
+ * If the physical pool cannot take a reclaimed page back, the slab is
+ * rebuilt and stays in the cache as an empty slab.
+ */
+static void
+test_release_failure(void)
+{
+    static struct slab_cache cache =
+        SLAB_CACHE_INITIALIZER(sizeof(struct obj), &cache);
+    void *obj;
+    size_t pages, reclaims;
+    int phys = phys_pages;
+
+    obj = slab_cache_alloc(&cache);
+    assert(obj != NULL);
+    pages = slab_cache_pages;
+    reclaims = slab_cache_reclaims;
+    slab_cache_free(&cache, obj);
+
+    fail_add = internal_physpool;
+    slab_cache_reclaim(&cache);
+    assert(fail_add == NULL);
+    assert(cache.nslabs == 1 && cache.nempty == 1);
+    assert(slab_cache_pages == pages && slab_cache_reclaims == reclaims);
+    assert(phys_pages == phys + 1);
+    check_cache(&cache);
+
+    /* The rebuilt slab is usable. */
+    obj = slab_cache_alloc(&cache);
+    assert(obj != NULL && cache.nslabs == 1);
+    slab_cache_free(&cache, obj);
+    slab_cache_reclaim(&cache);
+    assert(cache.nslabs == 0 && phys_pages == phys);
+    check_cache(&cache);
+}
+
+/* Objects of every size are 8-byte aligned and do not overlap. */
+static void
+test_alignment(void)
+{
+    static struct slab_cache caches[40];
+    void *a, *b;
+    uintptr_t size;
+
+    for (size = 1; size < 40; size++) {
+        struct slab_cache *cache = &caches[size];
+
+        cache->size = size;
+        TAILQ_INIT(&cache->partial);
+        TAILQ_INIT(&cache->full);
+        TAILQ_INIT(&cache->empty);
+
+        a = slab_cache_alloc(cache);
+        b = slab_cache_alloc(cache);
+        assert(a != NULL && b != NULL);
+        assert((uintptr_t)a % 8 == 0 && (uintptr_t)b % 8 == 0);
+        assert((uintptr_t)a >= (uintptr_t)slab_of(a) + sizeof(struct slab));
+        assert((uintptr_t)b - (uintptr_t)a >= size ||
+               (uintptr_t)a - (uintptr_t)b >= size);
+
+        slab_cache_free(cache, a);
+        slab_cache_free(cache, b);
+        slab_cache_reclaim(cache);
+        check_cache(cache);
+    }
+}
+
+int
+main(void)
+{
+    test_lists();
+    test_reclaim();
+    test_release_failure();
+    test_alignment();
+
+    printf("slab_cache: all tests passed\n");
+    return 0;
+}
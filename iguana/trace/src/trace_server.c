@@ -65,6 +65,7 @@
 #include <stdlib.h>
 #include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <l4/config.h>
 #include <l4/ipc.h>
@@ -77,6 +78,7 @@
 #include <iguana/thread.h>
 #include <iguana/trace.h>
 #include <trace/tracebuffer.h>
+#include <circular_buffer/cb.h>
 /* FIXME See Mothra bug #2106 
 #include <timer/timer.h>
 */
@@ -89,9 +91,24 @@
 #define TXT_BRIGHT              "\e[1m"
 #define TXT_FG_GREEN            "\e[32m"
 
+#define TRACE_STREAM_SIZE       (64 * 1024)
+#define TRACE_MAX_RINGS         32
+
 L4_Word_t kernel_trace_irq = 0;
 trace_buffer_t *kernel_tracebuffer;
 
+/* Binary stream of kernel trace entries, in kernel wire format */
+struct cb_alloc_handle *trace_stream;
+uintptr_t stream_drops = 0;
+
+struct ring_stats {
+    uintptr_t logs, ipcs, bytes;
+    uint64_t start, end;
+    uintptr_t overflows;        /* ring overflows already reported */
+};
+
+static struct ring_stats ring_stats[TRACE_MAX_RINGS];
+
 /* FIXME See Mothra bug #2106
 timer_t timer;
 */
@@ -127,6 +144,20 @@ setup(void)
     }
 
     kernel_tracebuffer = (trace_buffer_t *)addr;
+    if (kernel_tracebuffer->version != TBUF_VERSION ||
+            kernel_tracebuffer->buffers > TRACE_MAX_RINGS) {
+        DEBUG_TRACE(1, "Unsupported trace buffer version %" PRIuPTR "\n",
+                    kernel_tracebuffer->version);
+        kernel_tracebuffer = NULL;
+        return 0;
+    }
+
+    trace_stream = cb_new(TRACE_STREAM_SIZE);
+    if (trace_stream == NULL) {
+        DEBUG_TRACE(1, "Unable to allocate the trace stream\n");
+        kernel_tracebuffer = NULL;
+        return 0;
+    }
     DEBUG_TRACE(1, "kernel tracebuffer %p(%" PRIdPTR ") at %p\n", (void *)phys, size,
            kernel_tracebuffer);
 
@@ -149,118 +180,86 @@ l4e_cache_flush(void)
 }
 #endif
 
+/*
+ * Drain the unread entries of one ring into the trace stream. Entries are
+ * copied verbatim; once copied, the ring's tail is advanced so the kernel
+ * can reuse the space.
+ */
+static void
+drain_ring(trace_buffer_t *tb, trace_ring_t *ring, struct ring_stats *stats)
+{
+    uintptr_t head = ring->head;
+    uintptr_t tail = ring->tail;
+    uint64_t total;
+
+    while (tail != head) {
+        trace_entry_t *tbe = trace_ring_entry(tb, ring, tail);
+        uintptr_t len;
+        void *dst;
+
+        if (tbe == NULL) {
+            tail = 0;
+            continue;
+        }
+        len = tbe->hdr.x.reclen * sizeof(uintptr_t);
+
+        /* Do statistics on ring */
+        stats->end = trace_entry_timestamp(tbe);
+        if (stats->logs == 0)
+            stats->start = stats->end;
+        /*
+         * XXX kernel hard coded here
+         */
+        if (tbe->hdr.x.id > 2 && tbe->hdr.x.major == 3)
+            stats->ipcs++;
+        stats->logs++;
+        stats->bytes += len;
+
+        dst = cb_alloc(trace_stream, len);
+        if (dst != NULL)
+            memcpy(dst, tbe, len);
+        else
+            stream_drops++;
+
+        tail += len;
+    }
+    cb_sync_alloc(trace_stream);
+
+    /* hand the space back to the kernel */
+    ring->tail = tail;
+
+    /* report about as often as a full half of the ring has been drained */
+    if (stats->bytes >= ring->size / 2) {
+        total = stats->end - stats->start;
+        DEBUG_TRACE(1, TXT_BRIGHT TXT_FG_GREEN
+               "TRACE: %" PRId64 " logs/s, %" PRId64 " ipc/s "
+               TXT_NORMAL "\n",
+               total ? (uint64_t)stats->logs * 1000000 / (total) : -1,
+               total ? (uint64_t)stats->ipcs * 1000000 / (total) : -1);
+        stats->logs = stats->ipcs = stats->bytes = 0;
+    }
+}
+
 static void
 dump_kernel_trace(trace_buffer_t *tb)
 {
-    uintptr_t buffer, count;
-    uintptr_t buffer_mask;
+    uintptr_t i;
 
 #if 0
     DEBUG_TRACE(1, "trace_buffer magic: %" PRIxPTR ", version: %" PRIxPTR ", bufid: %"
            PRIxPTR "\n", tb->magic, tb->version, tb->bufid);
 #endif
 
-    buffer = tb->active_buffer;
-    buffer_mask = tb->buffer_empty;
-
-    if (buffer == ~(0ul))       /* Trace inactive/blocked */
-        buffer = 0;
-
-    count = tb->buffers;
-    while (count--) {
-        /* Data to be read in this buffer?  */
-        if ((buffer != tb->active_buffer) && ((~buffer_mask) & (1ul << buffer))) {
-            uintptr_t head = tb->buffer_head[buffer];
-            uintptr_t entry = 0;
-
-            // DEBUG_TRACE(1, "Data in %d\n", buffer);
-
-            /* Do statistics on buffer */
-            {
-                uintptr_t logs = 0, ipcs = 0;
-                uint64_t start = 0, end = 0, total;
-
-                while (entry < head) {
-                    trace_entry_t *tbe = (trace_entry_t *)((uintptr_t)tb +
-                                                           tb->
-                                                           buffer_offset[buffer]
-                                                           + entry);
-                    end = trace_entry_timestamp(tbe);
-                    if (logs == 0)
-                        start = end;
-
-                    /*
-                     * XXX kernel hard coded here 
-                     */
-                    switch (tbe->hdr.x.id) {
-                    case 1:
-                        logs++;
-                        break;
-                    case 2:
-                        logs++;
-                        break;
-                    default:
-                        if (tbe->hdr.x.major == 3)
-                            ipcs++;
-                        logs++;
-                        break;
-                    }
-
-                    entry = entry + (tbe->hdr.x.reclen * sizeof(uintptr_t));
-                }
-
-                total = end - start;
-                DEBUG_TRACE(1, TXT_BRIGHT TXT_FG_GREEN
-                       "TRACE: %" PRId64 " logs/s, %" PRId64 " ipc/s "
-                       TXT_NORMAL "\n",
-                       total ? (uint64_t)logs * 1000000 / (total) : -1,
-                       total ? (uint64_t)ipcs * 1000000 / (total) : -1);
-            }
-            /* mark this buffer as clear */
-            tb->buffer_empty |= (1ul << buffer);
-#if 0
-            /* Dump trace buffer to console */
-            while (entry < head) {
-                trace_entry_t *tbe = (trace_entry_t *)((uintptr_t)tb +
-                                                       tb->
-                                                       buffer_offset[buffer] +
-                                                       entry);
-
-                DEBUG_TRACE(1, "%6d: %9" PRIx64 " ", entry, tbe->timestamp);
-
-                /*
-                 * XXX kernel hard coded here 
-                 */
-                switch (tbe->hdr.x.id) {
-                case 1:
-                    DEBUG_TRACE(1, "(%d, %d, %d) evt: %d", tbe->hdr.x.major,
-                           tbe->hdr.x.minor, tbe->hdr.x.user, tbe->data[0]);
-                    break;
-                case 2:
-                    DEBUG_TRACE(1, "(%d, %d, %d) \"%s\"", tbe->hdr.x.major,
-                           tbe->hdr.x.minor, tbe->hdr.x.user,
-                           (char *)tbe->data);
-                    break;
-                default:
-                    DEBUG_TRACE(1, "(%d, %d, %d) %d: ",
-                           tbe->hdr.x.major, tbe->hdr.x.minor, tbe->hdr.x.user,
-                           tbe->hdr.x.id);
-
-                    for (int i = 0; i < (int)tbe->hdr.x.args; i++)
-                        DEBUG_TRACE(1, "%08" PRIxPTR ", ", tbe->data[i]);
-                    break;
-                }
-
-                DEBUG_TRACE(1, "\n");
-
-                entry = entry + (tbe->hdr.x.reclen * sizeof(uintptr_t));
-            }
-#endif
-        }
+    for (i = 0; i < tb->buffers; i++) {
+        trace_ring_t *ring = &tb->ring[i];
 
-        buffer++;
-        if (buffer >= tb->buffers)
-            buffer = 0;
+        if (ring->overflows != ring_stats[i].overflows) {
+            DEBUG_TRACE(1, "TRACE: ring %" PRIuPTR " dropped %" PRIuPTR
+                        " entries\n", i,
+                        ring->overflows - ring_stats[i].overflows);
+            ring_stats[i].overflows = ring->overflows;
+        }
+        drain_ring(tb, ring, &ring_stats[i]);
     }
 }
 
@@ -277,6 +276,7 @@ main(void)
         L4_Yield();
         l4e_cache_flush();
         dump_kernel_trace(kernel_tracebuffer);
+        l4e_cache_flush();
     }
 
     return 0;
@@ -86,6 +86,7 @@ extern struct bench_test bench_ipc_intra_rpc;
 extern struct bench_test bench_ipc_intra_ovh;
 extern struct bench_test bench_ipc_intra_async;
 extern struct bench_test bench_ipc_intra_async_ovh;
+extern struct bench_test bench_ipc_intra_async_wait;
 
 #define UTCB_ADDRESS    (0x80000000UL)
 #define FASS_UTCB_ADDRESS (0x81000000UL)
@@ -111,6 +112,7 @@ bool intra_rpc;
 bool intra_ovh;
 bool intra_async;
 bool intra_async_ovh;
+bool intra_async_wait;
 
 L4_Word_t ping_stack[2048] __attribute__ ((aligned (16)));
 L4_Word_t pong_stack[2048] __attribute__ ((aligned (16)));
@@ -482,6 +484,35 @@ ping_thread_async (void)
     /* NOTREACHED */
 }
 
+/*
+ * Notify ourselves and then wait for the notification, so that every
+ * wait finds its bits already pending.
+ */
+static void
+ping_thread_async_wait (void)
+{
+    L4_Word_t mask;
+
+    L4_Set_NotifyBits(0);
+    L4_Set_NotifyMask(0xffff1234UL);
+    L4_Accept(L4_NotifyMsgAcceptor);
+
+    for (int i=0; i < num_iterations; i++)
+    {
+        (void)L4_Notify(L4_Myself(), 0xffff1234UL);
+        (void)L4_WaitNotify(&mask);
+    }
+
+    /* Tell master that we're finished */
+    L4_Set_MsgTag (L4_Niltag);
+    L4_Send (master_tid);
+
+    for (;;)
+        L4_WaitForever();
+
+    /* NOTREACHED */
+}
+
 static void
 ping_thread_async_ovh (void)
 {
@@ -632,6 +663,8 @@ pager (void)
                     start_addr = ping_thread_async;
                 } else if (intra_async_ovh) {
                     start_addr = ping_thread_async_ovh;
+                } else if (intra_async_wait) {
+                    start_addr = ping_thread_async_wait;
                 } else {
                     start_addr = ping_thread;
                 }
@@ -667,6 +700,8 @@ pager (void)
                     pong_start_addr = pong_thread_async;
                 } else if (intra_async_ovh) {
                     pong_start_addr = pong_thread_async_ovh;
+                } else if (intra_async_wait) {
+                    pong_start_addr = pong_thread_async;
                 } else {
                     pong_start_addr = pong_thread;
                 }
@@ -768,6 +803,7 @@ ipc_setup(struct bench_test *test, int args[])
     intra_ovh = (test == &bench_ipc_intra_ovh);
     intra_async = (test == &bench_ipc_intra_async);
     intra_async_ovh = (test == &bench_ipc_intra_async_ovh);
+    intra_async_wait = (test == &bench_ipc_intra_async_wait);
 
     num_iterations = args[0];
     num_mrs = args[1];
@@ -1098,3 +1134,15 @@ struct bench_test bench_ipc_intra_async_ovh = {
         { NULL, 0, 0, 0 }
     }
 };
+
+/*
+ * Notify to a running thread plus wait for notify with bits pending,
+ * both of which are handled on the fastpath where available.
+ */
+struct bench_test bench_ipc_intra_async_wait = {
+    "ipc - async send and wait", ipc_setup, ipc_test, ipc_teardown,
+    {
+        { &iterations, 10000, 10000, 1000, add_fn },
+        { NULL, 0, 0, 0 }
+    }
+};
@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2008 Open Kernel Labs, Inc. (Copyright Holder).
+ * All rights reserved.
+ *
+ * 1. Redistribution and use of OKL4 (Software) in source and binary
+ * forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ *     (a) Redistributions of source code must retain this clause 1
+ *         (including paragraphs (a), (b) and (c)), clause 2 and clause 3
+ *         (Licence Terms) and the above copyright notice.
+ *
+ *     (b) Redistributions in binary form must reproduce the above
+ *         copyright notice and the Licence Terms in the documentation and/or
+ *         other materials provided with the distribution.
+ *
+ *     (c) Redistributions in any form must be accompanied by information on
+ *         how to obtain complete source code for:
+ *        (i) the Software; and
+ *        (ii) all accompanying software that uses (or is intended to
+ *        use) the Software whether directly or indirectly.  Such source
+ *        code must:
+ *        (iii) either be included in the distribution or be available
+ *        for no more than the cost of distribution plus a nominal fee;
+ *        and
+ *        (iv) be licensed by each relevant holder of copyright under
+ *        either the Licence Terms (with an appropriate copyright notice)
+ *        or the terms of a licence which is approved by the Open Source
+ *        Initative.  For an executable file, "complete source code"
+ *        means the source code for all modules it contains and includes
+ *        associated build and other files reasonably required to produce
+ *        the executable.
+ *
+ * 2. THIS SOFTWARE IS PROVIDED ``AS IS'' AND, TO THE EXTENT PERMITTED BY
+ * LAW, ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  WHERE ANY WARRANTY IS
+ * IMPLIED AND IS PREVENTED BY LAW FROM BEING DISCLAIMED THEN TO THE
+ * EXTENT PERMISSIBLE BY LAW: (A) THE WARRANTY IS READ DOWN IN FAVOUR OF
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT) AND (B) ANY LIMITATIONS PERMITTED BY LAW (INCLUDING AS TO
+ * THE EXTENT OF THE WARRANTY AND THE REMEDIES AVAILABLE IN THE EVENT OF
+ * BREACH) ARE DEEMED PART OF THIS LICENCE IN A FORM MOST FAVOURABLE TO
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT). IN THE LICENCE TERMS, "PARTICIPANT" INCLUDES EVERY
+ * PERSON WHO HAS CONTRIBUTED TO THE SOFTWARE OR WHO HAS BEEN INVOLVED IN
+ * THE DISTRIBUTION OR DISSEMINATION OF THE SOFTWARE.
+ *
+ * 3. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR ANY OTHER PARTICIPANT BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Compare zero-copy IPC windows against remote memory copy for moving a
+ * buffer from the benchmark server into another address space.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <bench/bench.h>
+#include <l4/ipc.h>
+#include <l4/config.h>
+#include <stdio.h>
+#include <assert.h>
+#include <l4/kdebug.h>
+
+#include <l4/schedule.h>
+#include <l4/space.h>
+#include <l4/thread.h>
+#include <okl4/kspaceid_pool.h>
+
+#define UTCB_ADDRESS    16 * 1024 * 1024
+#define START_ADDR(func)    ((L4_Word_t) func)
+
+#define WINDOW_MAX_SIZE     0x100000
+/* Receive window of the client, never touched by the server image */
+#define WINDOW_ADDRESS      0x20000000
+#define WINDOW_PATTERN      0x5a
+
+static char window_server_buffer[WINDOW_MAX_SIZE]
+    __attribute__ ((aligned (WINDOW_MAX_SIZE)));
+static char window_client_buffer[WINDOW_MAX_SIZE]
+    __attribute__ ((aligned (16)));
+
+static L4_Word_t client_stack[2*1024] __attribute__ ((aligned (16)));
+static L4_Word_t window_pager_stack[2*1024] __attribute__ ((aligned (16)));
+
+static L4_SpaceId_t window_space_id;
+static L4_ThreadId_t window_pager_tid;
+static L4_ThreadId_t client_tid;
+
+static L4_Word_t window_size;
+static L4_Word_t window_iterations;
+static L4_Word_t window_checksum;
+static int use_window;
+
+/*
+ * Sum one word of every page of a buffer, so that the receiver has to
+ * reach each page that was lent to it.
+ */
+static L4_Word_t
+checksum(volatile L4_Word_t *buf, L4_Word_t size)
+{
+    L4_Word_t i, sum = 0;
+
+    for (i = 0; i < size / sizeof(L4_Word_t); i += 0x1000 / sizeof(L4_Word_t)) {
+        sum += buf[i];
+    }
+    return sum;
+}
+
+static void
+client_thread(void)
+{
+    L4_MsgTag_t tag;
+    L4_ThreadId_t from;
+    L4_Fpage_t window;
+
+    ARCH_THREAD_INIT
+
+    if (!use_window) {
+        /* Expose our buffer and let the server copy into it */
+        memset(window_client_buffer, 0, window_size);
+
+        tag = L4_Niltag;
+        L4_Set_MemoryCopy(&tag);
+
+        L4_LoadMR(0, tag.raw);
+        L4_LoadMR(1, (L4_Word_t)window_client_buffer);
+        L4_LoadMR(2, window_size);
+        L4_LoadMR(3, L4_MemoryCopyBoth);
+
+        tag = L4_Call(KBENCH_SERVER);
+        assert(L4_IpcSucceeded(tag));
+        return;
+    }
+
+    L4_Accept(L4_WindowAcceptor(L4_Fpage(WINDOW_ADDRESS, WINDOW_MAX_SIZE)));
+    tag = L4_Receive(KBENCH_SERVER);
+
+    for (;;) {
+        assert(L4_IpcSucceeded(tag) && L4_IpcWindow(tag));
+
+        L4_StoreMR(L4_UntypedWords(tag) + 1, &window.raw);
+        L4_LoadMR(1, checksum((L4_Word_t *)L4_Address(window),
+                              L4_Size(window)));
+
+        tag = L4_Niltag;
+        tag.X.u = 1;
+        L4_Set_SendBlock(&tag);
+        L4_Set_ReceiveBlock(&tag);
+        tag = L4_Ipc(KBENCH_SERVER, KBENCH_SERVER, tag, &from);
+    }
+}
+
+extern word_t get_seg(L4_SpaceId_t spaceid, word_t vaddr, word_t *offset, word_t *cache, word_t *rwx);
+
+static void
+window_pager(void)
+{
+    L4_ThreadId_t tid;
+    L4_MsgTag_t tag;
+    L4_Msg_t msg;
+
+    for (;;) {
+        tag = L4_Wait(&tid);
+
+        for (;;) {
+            L4_Word_t faddr;
+            L4_MapItem_t map;
+            L4_SpaceId_t space;
+            L4_Word_t seg, offset, cache, rwx, size;
+            int r;
+
+            L4_MsgStore(tag, &msg);
+
+            if (L4_UntypedWords(tag) != 2 ||
+                !L4_IpcSucceeded(tag)) {
+                printf("Malformed pagefault IPC from %p (tag=%p)\n",
+                       (void *) tid.raw, (void *) tag.raw);
+                L4_KDB_Enter("malformed pf");
+                break;
+            }
+
+            faddr = L4_MsgWord(&msg, 0);
+            L4_MsgClear(&msg);
+
+            seg = get_seg(KBENCH_SPACE, faddr, &offset, &cache, &rwx);
+            assert(seg != ~0UL);
+
+            size = L4_GetMinPageBits();
+            faddr &= ~((1ul << size)-1);
+            offset &= ~((1ul << size)-1);
+
+            space.raw = __L4_TCR_SenderSpace();
+
+            L4_MapItem_Map(&map, seg, offset, faddr, size, cache, rwx);
+            r = L4_ProcessMapItem(space, map);
+            assert(r == 1);
+
+            L4_MsgLoad(&msg);
+            tag = L4_MsgTag();
+            L4_Set_SendBlock(&tag);
+            L4_Set_ReceiveBlock(&tag);
+            tag = L4_Ipc(tid, L4_anythread, tag, &tid);
+        }
+    }
+}
+
+extern okl4_kspaceid_pool_t *spaceid_pool;
+
+static void
+init(struct bench_test *test, int args[])
+{
+    L4_Word_t utcb, utcb_size;
+    L4_Fpage_t utcb_area;
+    L4_ThreadId_t from;
+    L4_Word_t i;
+    int r;
+
+    window_iterations = args[0];
+    window_size = args[1];
+
+    /* The payload is lent page by page, so fault it in here */
+    for (i = 0; i < window_size; i++) {
+        window_server_buffer[i] = (char)(WINDOW_PATTERN + i);
+    }
+    window_checksum = checksum((L4_Word_t *)window_server_buffer, window_size);
+
+    utcb_size = L4_GetUtcbSize();
+#ifdef NO_UTCB_RELOCATE
+    utcb_area = L4_Nilpage;
+#else
+    utcb_area = L4_Fpage((L4_Word_t) UTCB_ADDRESS,
+                         L4_GetUtcbAreaSize());
+#endif
+
+    /* Create pager */
+    window_pager_tid = L4_GlobalId(KBENCH_SERVER.X.index + 1, 2);
+#ifdef NO_UTCB_RELOCATE
+    utcb = -1UL;
+#else
+    utcb = (L4_Word_t) (L4_PtrSize_t)L4_GetUtcbBase() + (2)*utcb_size;
+#endif
+    r = L4_ThreadControl(window_pager_tid, KBENCH_SPACE, KBENCH_SERVER,
+                         KBENCH_SERVER, KBENCH_SERVER, 0, (void*)utcb);
+    assert(r == 1);
+    L4_Set_Priority(window_pager_tid, 254);
+    L4_Start_SpIp(window_pager_tid,
+                  (L4_Word_t) window_pager_stack + sizeof(window_pager_stack) - 32,
+                  START_ADDR(window_pager));
+
+    /* Create space */
+    r = okl4_kspaceid_allocany(spaceid_pool, &window_space_id);
+    assert(r == OKL4_OK);
+    r = L4_SpaceControl(window_space_id, L4_SpaceCtrl_new, KBENCH_CLIST,
+                        utcb_area, 0, NULL);
+    assert(r == 1);
+
+    /* Create client thread */
+    client_tid = L4_GlobalId(KBENCH_SERVER.X.index + 2, 2);
+#ifdef NO_UTCB_RELOCATE
+    utcb = -1UL;
+#else
+    utcb = (L4_Word_t) ((L4_PtrSize_t) UTCB_ADDRESS + utcb_size);
+#endif
+    r = L4_ThreadControl(client_tid, window_space_id, KBENCH_SERVER,
+                         window_pager_tid, window_pager_tid, 0, (void *)utcb);
+    assert(r == 1);
+    L4_Start_SpIp(client_tid,
+                  (L4_Word_t) client_stack + sizeof(client_stack) - 32,
+                  START_ADDR(client_thread));
+
+    L4_ThreadSwitch(client_tid);
+
+    if (!use_window) {
+        L4_Wait(&from);
+    }
+}
+
+static void
+init_window(struct bench_test *test, int args[])
+{
+    use_window = 1;
+    init(test, args);
+}
+
+static void
+init_memcpy(struct bench_test *test, int args[])
+{
+    use_window = 0;
+    init(test, args);
+}
+
+static void
+ipc_window_test(struct bench_test *test, int args[])
+{
+    L4_MsgTag_t tag;
+    L4_Fpage_t buffer;
+    L4_Word_t i, sum;
+
+    buffer = L4_Fpage((L4_Word_t)window_server_buffer, window_size);
+    L4_Set_Rights(&buffer, L4_Readable);
+
+    for (i = 0; i < window_iterations; i++) {
+        tag = L4_Niltag;
+        L4_Set_Window(&tag);
+        L4_LoadMR(0, tag.raw);
+        L4_LoadMR(1, buffer.raw);
+
+        tag = L4_Call(client_tid);
+        assert(L4_IpcSucceeded(tag));
+    }
+    L4_StoreMR(1, &sum);
+    assert(sum == window_checksum);
+}
+
+static void
+ipc_window_memcpy_test(struct bench_test *test, int args[])
+{
+    L4_Word_t i, size;
+    int r = 1;
+
+    for (i = 0; i < window_iterations; i++) {
+        size = window_size;
+        r &= L4_MemoryCopy(client_tid, (L4_Word_t)window_server_buffer,
+                           &size, L4_MemoryCopyFrom);
+    }
+    assert(r == 1);
+    assert(size == window_size);
+}
+
+static void
+teardown(struct bench_test *test, int args[])
+{
+    int r;
+
+    r = L4_ThreadControl(window_pager_tid, L4_nilspace, L4_nilthread,
+                         L4_nilthread, L4_nilthread, 0, (void *) 0);
+    assert(r == 1);
+
+    r = L4_ThreadControl(client_tid, L4_nilspace, L4_nilthread,
+                         L4_nilthread, L4_nilthread, 0, (void *) 0);
+    assert(r == 1);
+
+    r = L4_SpaceControl(window_space_id, L4_SpaceCtrl_delete, KBENCH_CLIST,
+                        L4_Nilpage, 0, NULL);
+    assert(r == 1);
+    okl4_kspaceid_free(spaceid_pool, window_space_id);
+}
+
+struct bench_test bench_ipc_window = {
+    .name = "ipc_window",
+    .init = init_window,
+    .test = ipc_window_test,
+    .teardown = teardown,
+    .indices = {
+        { &iterations, 1000, 1000, 500, add_fn },
+        { &mem_size, 4096, 1024*1024, 4, mul_fn },
+        { NULL, 0, 0, 0 }
+    }
+};
+
+struct bench_test bench_ipc_window_memcpy = {
+    .name = "ipc_window_memcpy",
+    .init = init_memcpy,
+    .test = ipc_window_memcpy_test,
+    .teardown = teardown,
+    .indices = {
+        { &iterations, 1000, 1000, 500, add_fn },
+        { &mem_size, 4096, 1024*1024, 4, mul_fn },
+        { NULL, 0, 0, 0 }
+    }
+};
@@ -106,6 +106,7 @@ static  L4_SpaceId_t    test_space;
 L4_Fpage_t kip_area, utcb_area;
 
 
+extern word_t kernel_test_segment_id;
 extern word_t kernel_test_segment_size;
 extern word_t kernel_test_segment_vbase;
 extern word_t get_seg(L4_SpaceId_t spaceid, word_t vaddr, word_t *offset, word_t *cache, word_t *rwx);
@@ -305,6 +306,100 @@ mapcontrol_teardown(struct bench_test *test, int args[])
     okl4_kspaceid_free(spaceid_pool, test_space);
 }
 
+/*
+ * Region benchmarks: map and unmap a region of args[1] bytes, either with
+ * one item per page (filling the message registers on each syscall) or
+ * with a single multi-page item.  Regions larger than the test segment
+ * alias it repeatedly.
+ */
+#define REGION_VBASE    (512 * 1024 * 1024)
+
+static L4_Word_t region_chunk;
+
+static void
+mapcontrol_region_setup(struct bench_test *test, int args[])
+{
+    mapcontrol_setup(test, args);
+
+    /* Largest power of two run the test segment and a map item can back. */
+    region_chunk = 1UL << L4_GetMinPageBits();
+    while (region_chunk * 2 <= kernel_test_segment_size &&
+            region_chunk * 2 <= (L4_Word_t)args[1] &&
+            ((region_chunk * 2) >> L4_GetMinPageBits()) <=
+                L4_MAX_MAP_RUN_PAGES) {
+        region_chunk *= 2;
+    }
+}
+
+static void
+mapcontrol_region_unmap(L4_Word_t size)
+{
+    L4_MapItem_t map;
+    L4_Word_t min_pgbits = L4_GetMinPageBits();
+    L4_Word_t run = (L4_Word_t)L4_MAX_MAP_RUN_PAGES << min_pgbits;
+    L4_Word_t vaddr;
+    int rv;
+
+    for (vaddr = 0; vaddr < size; vaddr += run) {
+        L4_MapItem_Unmap(&map, REGION_VBASE + vaddr, min_pgbits);
+        L4_MapItem_SetMultiplePages(&map,
+                (size - vaddr < run ? size - vaddr : run) >> min_pgbits);
+        rv = L4_ProcessMapItem(test_space, map);
+        assert(rv == 1);
+    }
+}
+
+static void
+mapcontrol_test_region_pages(struct bench_test *test, int args[])
+{
+    L4_MapItem_t items[L4_MAX_MAP_ITEMS];
+    L4_Word_t min_pgbits = L4_GetMinPageBits();
+    L4_Word_t size = args[1];
+    L4_Word_t vaddr, n;
+    int i, rv;
+
+    for (i = 0; i < args[0]; i++) {
+        n = 0;
+        for (vaddr = 0; vaddr < size; vaddr += 1UL << min_pgbits) {
+            L4_MapItem_Map(&items[n++], kernel_test_segment_id,
+                           vaddr % region_chunk, REGION_VBASE + vaddr,
+                           min_pgbits, L4_DefaultMemory, L4_Readable);
+            if (n == L4_MAX_MAP_ITEMS) {
+                rv = L4_ProcessMapItems(test_space, n, items);
+                assert(rv == 1);
+                n = 0;
+            }
+        }
+        if (n != 0) {
+            rv = L4_ProcessMapItems(test_space, n, items);
+            assert(rv == 1);
+        }
+        mapcontrol_region_unmap(size);
+    }
+}
+
+static void
+mapcontrol_test_region_run(struct bench_test *test, int args[])
+{
+    L4_MapItem_t map;
+    L4_Word_t min_pgbits = L4_GetMinPageBits();
+    L4_Word_t size = args[1];
+    L4_Word_t vaddr;
+    int i, rv;
+
+    for (i = 0; i < args[0]; i++) {
+        for (vaddr = 0; vaddr < size; vaddr += region_chunk) {
+            L4_MapItem_Map(&map, kernel_test_segment_id, 0,
+                           REGION_VBASE + vaddr, min_pgbits,
+                           L4_DefaultMemory, L4_Readable);
+            L4_MapItem_SetMultiplePages(&map, region_chunk >> min_pgbits);
+            rv = L4_ProcessMapItem(test_space, map);
+            assert(rv == 1);
+        }
+        mapcontrol_region_unmap(size);
+    }
+}
+
 /*
  * From bench_mapcontrol_*, we can get:
  * Latency of mapcontrol of insert 1 fpage = (bench of bench_mapcontrol_insert_m2m -
@@ -384,3 +479,27 @@ struct bench_test bench_mapcontrol_ovh2 = {
         { NULL }
     }
 };
+
+struct bench_test bench_mapcontrol_region_pages = {
+    "mapcontrol map region (1 page per item)",
+    mapcontrol_region_setup,
+    mapcontrol_test_region_pages,
+    mapcontrol_teardown,
+    {
+        { &iterations, 10, 10, 10, add_fn },
+        { &mem_size, 1024*1024, 64*1024*1024, 4, mul_fn },
+        { NULL }
+    }
+};
+
+struct bench_test bench_mapcontrol_region_run = {
+    "mapcontrol map region (multi-page items)",
+    mapcontrol_region_setup,
+    mapcontrol_test_region_run,
+    mapcontrol_teardown,
+    {
+        { &iterations, 10, 10, 10, add_fn },
+        { &mem_size, 1024*1024, 64*1024*1024, 4, mul_fn },
+        { NULL }
+    }
+};
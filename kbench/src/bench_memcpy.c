@@ -87,6 +87,32 @@ memcpy_test(struct bench_test *test, int args[])
     }
 }
 
+/* Source and destination not mutually word aligned. */
+static void
+memcpy_unaligned_test(struct bench_test *test, int args[])
+{
+    char *t = foo + 1;
+    const char *f = bar + 3;
+    const size_t size = args[1];
+    const int count = args[0];
+
+    for(int i=0; i < count; i++) {
+        memcpy(t, f, size);
+    }
+}
+
+static void
+memset_test(struct bench_test *test, int args[])
+{
+    char *t = foo;
+    const size_t size = args[1];
+    const int count = args[0];
+
+    for(int i=0; i < count; i++) {
+        memset(t, i, size);
+    }
+}
+
 static void
 teardown(struct bench_test *test, int args[])
 {
@@ -98,8 +124,32 @@ struct bench_test bench_memcpy = {
     .test = memcpy_test, 
     .teardown = teardown, 
     .indices = { 
-        { &iterations, 500, 3000, 500, add_fn }, 
-        { &mem_size, 32*1024, 32*1024, 2, mul_fn }, 
+        { &iterations, 1000, 1000, 500, add_fn }, 
+        { &mem_size, 16, 64*1024, 4, mul_fn }, 
+        { NULL, 0, 0, 0 }
+    }
+};
+
+struct bench_test bench_memcpy_unaligned = {
+    .name = "memcpy_unaligned", 
+    .init = init, 
+    .test = memcpy_unaligned_test, 
+    .teardown = teardown, 
+    .indices = { 
+        { &iterations, 1000, 1000, 500, add_fn }, 
+        { &mem_size, 16, 64*1024, 4, mul_fn }, 
+        { NULL, 0, 0, 0 }
+    }
+};
+
+struct bench_test bench_memset = {
+    .name = "memset", 
+    .init = init, 
+    .test = memset_test, 
+    .teardown = teardown, 
+    .indices = { 
+        { &iterations, 1000, 1000, 500, add_fn }, 
+        { &mem_size, 16, 64*1024, 4, mul_fn }, 
         { NULL, 0, 0, 0 }
     }
 };
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2007 Open Kernel Labs, Inc. (Copyright Holder).
+ * All rights reserved.
+ *
+ * 1. Redistribution and use of OKL4 (Software) in source and binary
+ * forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ *     (a) Redistributions of source code must retain this clause 1
+ *         (including paragraphs (a), (b) and (c)), clause 2 and clause 3
+ *         (Licence Terms) and the above copyright notice.
+ *
+ *     (b) Redistributions in binary form must reproduce the above
+ *         copyright notice and the Licence Terms in the documentation and/or
+ *         other materials provided with the distribution.
+ *
+ *     (c) Redistributions in any form must be accompanied by information on
+ *         how to obtain complete source code for:
+ *        (i) the Software; and
+ *        (ii) all accompanying software that uses (or is intended to
+ *        use) the Software whether directly or indirectly.  Such source
+ *        code must:
+ *        (iii) either be included in the distribution or be available
+ *        for no more than the cost of distribution plus a nominal fee;
+ *        and
+ *        (iv) be licensed by each relevant holder of copyright under
+ *        either the Licence Terms (with an appropriate copyright notice)
+ *        or the terms of a licence which is approved by the Open Source
+ *        Initative.  For an executable file, "complete source code"
+ *        means the source code for all modules it contains and includes
+ *        associated build and other files reasonably required to produce
+ *        the executable.
+ *
+ * 2. THIS SOFTWARE IS PROVIDED ``AS IS'' AND, TO THE EXTENT PERMITTED BY
+ * LAW, ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  WHERE ANY WARRANTY IS
+ * IMPLIED AND IS PREVENTED BY LAW FROM BEING DISCLAIMED THEN TO THE
+ * EXTENT PERMISSIBLE BY LAW: (A) THE WARRANTY IS READ DOWN IN FAVOUR OF
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT) AND (B) ANY LIMITATIONS PERMITTED BY LAW (INCLUDING AS TO
+ * THE EXTENT OF THE WARRANTY AND THE REMEDIES AVAILABLE IN THE EVENT OF
+ * BREACH) ARE DEEMED PART OF THIS LICENCE IN A FORM MOST FAVOURABLE TO
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT). IN THE LICENCE TERMS, "PARTICIPANT" INCLUDES EVERY
+ * PERSON WHO HAS CONTRIBUTED TO THE SOFTWARE OR WHO HAS BEEN INVOLVED IN
+ * THE DISTRIBUTION OR DISSEMINATION OF THE SOFTWARE.
+ *
+ * 3. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR ANY OTHER PARTICIPANT BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/*
+ * Description: kernel mutex contention benchmarks.
+ */
+#include <bench/bench.h>
+#include <l4/types.h>
+#include <l4/config.h>
+#include <l4/thread.h>
+#include <l4/schedule.h>
+#include <l4/mutex.h>
+#include <l4/ipc.h>
+#include <okl4/kmutexid_pool.h>
+#include <stdio.h>
+#include <assert.h>
+
+#define MAX_CONTENDERS      256
+#define STACK_SIZE          0x100
+#define FIRST_THREAD        64
+/* Priority kbench's main thread runs at by default. */
+#define MAIN_PRIORITY       100
+/* Number of distinct priorities the contending threads are spread over. */
+#define CONTENDER_BANDS     8
+
+extern struct okl4_bitmap_allocator *mutexid_pool;
+
+static L4_Word_t contender_stacks[MAX_CONTENDERS][STACK_SIZE];
+static L4_ThreadId_t contender_tids[MAX_CONTENDERS];
+static L4_MutexId_t contended_mutex;
+
+/*
+ * Wait to be told to contend, then block on the mutex and release it
+ * as soon as it is handed to us.
+ */
+static void
+contender_thread(void)
+{
+    while (1) {
+        L4_Receive(KBENCH_SERVER);
+        L4_Lock(contended_mutex);
+        L4_Unlock(contended_mutex);
+    }
+}
+
+static void
+mutex_contention_setup(struct bench_test *test, int args[])
+{
+    L4_Word_t utcb_size = L4_GetUtcbSize();
+    L4_Word_t dummy;
+    int r;
+
+    assert(args[1] <= MAX_CONTENDERS);
+
+    r = okl4_kmutexid_allocany(mutexid_pool, &contended_mutex);
+    assert(r == OKL4_OK);
+    r = L4_CreateMutex(contended_mutex);
+    assert(r == 1);
+
+    /* Contenders run above us, spread over several priorities, so that
+     * each one blocks on the mutex as soon as we prod it. */
+    for (int i = 0; i < args[1]; i++) {
+        L4_Word_t utcb;
+#ifdef NO_UTCB_RELOCATE
+        utcb = -1UL;
+#else
+        utcb = (L4_Word_t)(L4_PtrSize_t)L4_GetUtcbBase() +
+            (FIRST_THREAD + i) * utcb_size;
+#endif
+        contender_tids[i].raw = KBENCH_SERVER.raw + FIRST_THREAD + i;
+        r = L4_ThreadControl(contender_tids[i], KBENCH_SPACE, KBENCH_SERVER,
+                KBENCH_SERVER, KBENCH_SERVER, 0, (void *)(L4_PtrSize_t)utcb);
+        assert(r == 1);
+        L4_Schedule(contender_tids[i], -1, 1, -1, -1, 0, &dummy);
+        L4_Set_Priority(contender_tids[i],
+                MAIN_PRIORITY + 1 + (i % CONTENDER_BANDS));
+        L4_Start_SpIp(contender_tids[i],
+                (L4_Word_t)(L4_PtrSize_t)&contender_stacks[i][STACK_SIZE],
+                (L4_Word_t)(L4_PtrSize_t)contender_thread);
+    }
+}
+
+static void
+mutex_contention_test(struct bench_test *test, int args[])
+{
+    for (int i = 0; i < args[0]; i++) {
+        L4_Lock(contended_mutex);
+
+        /* Queue every contender up behind us. */
+        for (int j = 0; j < args[1]; j++) {
+            L4_Send(contender_tids[j]);
+        }
+
+        /* Hand the mutex down the queue; each contender passes it on
+         * before we get to run again. */
+        L4_Unlock(contended_mutex);
+    }
+}
+
+static void
+mutex_contention_teardown(struct bench_test *test, int args[])
+{
+    int r;
+
+    for (int i = 0; i < args[1]; i++) {
+        r = L4_ThreadControl(contender_tids[i], L4_nilspace, L4_nilthread,
+                L4_nilthread, L4_nilthread, 0, (void *)0);
+        assert(r == 1);
+    }
+
+    r = L4_DeleteMutex(contended_mutex);
+    assert(r == 1);
+    okl4_kmutexid_free(mutexid_pool, contended_mutex);
+}
+
+static struct index_type contenders = { "contenders", "" };
+
+/*
+ * Block a number of threads of mixed priority on a single kernel mutex
+ * and then hand it to each of them in turn. The cost of every block and
+ * hand-off depends on how quickly the kernel can find a thread's place
+ * in the mutex's wait queue.
+ */
+struct bench_test bench_mutex_contention = {
+    "mutex contention",
+    mutex_contention_setup,
+    mutex_contention_test,
+    mutex_contention_teardown,
+    {
+        { &iterations, 100, 100, 100, add_fn },
+        { &contenders, 1, MAX_CONTENDERS, 4, mul_fn },
+        { NULL }
+    }
+};
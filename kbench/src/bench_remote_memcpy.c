@@ -88,6 +88,11 @@
 #define COPYING_THREAD_BUFSIZE 0x8000
 #define COPYING_THREAD_PATTERN 0x10
 
+/* Concurrent copiers in the multi-threaded benchmark */
+#define MAX_COPIERS     4
+#define FIRST_COPIER    3
+#define FIRST_CLIENT    (FIRST_COPIER + MAX_COPIERS)
+
 
 static char copying_thread_buffer[0x100000] __attribute__ ((aligned (16)));
 char *walrus;
@@ -194,18 +199,18 @@ pager (void)
 
 extern okl4_kspaceid_pool_t *spaceid_pool;
 
+/*
+ * Create the pager thread and the address space that the copy partners
+ * of the benchmark run in.
+ */
 static void
-init(struct bench_test *test, int args[])
+create_copy_space(void)
 {
     int r;
 
-    copy_size = args[1];
-    iteration = args[0];
-
     /* Size for one UTCB */
     utcb_size = L4_GetUtcbSize();
 
-    /* We need a maximum of two threads per task */
 #ifdef NO_UTCB_RELOCATE
     utcb_area = L4_Nilpage;
 #else
@@ -240,24 +245,28 @@ init(struct bench_test *test, int args[])
         printf("Couldn't create space - error is %ld\n", L4_ErrorCode());
 
     assert(r == 1);
+}
 
-    test_tid = L4_GlobalId (KBENCH_SERVER.X.index + 2, 2);
-
-    walrus = malloc(COPYING_THREAD_BUFSIZE);
-
-    memset(walrus, 0x0, COPYING_THREAD_BUFSIZE);
+/*
+ * Create a thread in the copy space running 'func'. 'slot' selects its
+ * thread number and UTCB.
+ */
+static void
+create_copy_thread(L4_ThreadId_t tid, int slot, L4_Word_t *stack,
+                   L4_Word_t stack_size, void (*func)(void))
+{
+    int r;
 
-    /* Create test thread for remote memcopy */
 #ifdef NO_UTCB_RELOCATE
     utcb = -1UL;
 #else
-    utcb = (L4_Word_t) ((L4_PtrSize_t) UTCB_ADDRESS + utcb_size);
+    utcb = (L4_Word_t) ((L4_PtrSize_t) UTCB_ADDRESS + slot * utcb_size);
 #endif
 #ifdef NO_UTCB_RELOCATE
-    r = L4_ThreadControl(test_tid, space_id, KBENCH_SERVER,
+    r = L4_ThreadControl(tid, space_id, KBENCH_SERVER,
                          pager_tid, pager_tid, 0, (void *) ~0UL);
 #else
-    r = L4_ThreadControl(test_tid, space_id, KBENCH_SERVER,
+    r = L4_ThreadControl(tid, space_id, KBENCH_SERVER,
                          pager_tid, pager_tid, 0, (void *)utcb);
 #endif
     if (r == 0)
@@ -266,7 +275,42 @@ init(struct bench_test *test, int args[])
     }
     assert(r == 1);
 
-    L4_Start_SpIp(test_tid, (L4_Word_t) dummy_stack + sizeof(dummy_stack) - 32, START_ADDR(dummy_thread));
+    L4_Start_SpIp(tid, (L4_Word_t) stack + stack_size - 32, START_ADDR(func));
+}
+
+static void
+delete_copy_space(void)
+{
+    int r;
+
+    /* Delete pager */
+    r = L4_ThreadControl(pager_tid, L4_nilspace, L4_nilthread,
+                            L4_nilthread, L4_nilthread, 0, (void *) 0);
+    assert(r == 1);
+
+    //Delete space
+    r = L4_SpaceControl(space_id, L4_SpaceCtrl_delete, KBENCH_CLIST, L4_Nilpage, 0, NULL);
+    assert(r == 1);
+    okl4_kspaceid_free(spaceid_pool, space_id);
+}
+
+static void
+init(struct bench_test *test, int args[])
+{
+    copy_size = args[1];
+    iteration = args[0];
+
+    create_copy_space();
+
+    test_tid = L4_GlobalId (KBENCH_SERVER.X.index + 2, 2);
+
+    walrus = malloc(COPYING_THREAD_BUFSIZE);
+
+    memset(walrus, 0x0, COPYING_THREAD_BUFSIZE);
+
+    /* Create test thread for remote memcopy */
+    create_copy_thread(test_tid, 1, dummy_stack, sizeof(dummy_stack),
+                       dummy_thread);
 
     L4_ThreadSwitch(test_tid);
 
@@ -303,20 +347,12 @@ teardown(struct bench_test *test, int args[])
 
         free(walrus);
 
-        /* Delete pager */
-        r = L4_ThreadControl(pager_tid, L4_nilspace, L4_nilthread,
-                                L4_nilthread, L4_nilthread, 0, (void *) 0);
-        assert(r == 1);
-
         //Delete test thread
         r = L4_ThreadControl(test_tid, L4_nilspace, L4_nilthread, L4_nilthread,
                                         L4_nilthread, 0, (void *)0);
         assert(r == 1);
 
-        //Delete space
-        r = L4_SpaceControl(space_id, L4_SpaceCtrl_delete, KBENCH_CLIST, L4_Nilpage, 0, NULL);
-        assert(r == 1);
-        okl4_kspaceid_free(spaceid_pool, space_id);
+        delete_copy_space();
 }
 
 struct bench_test bench_remote_memcpy = {
@@ -330,3 +366,175 @@ struct bench_test bench_remote_memcpy = {
         { NULL, 0, 0, 0 }
     }
 };
+
+/*
+ * Multi-threaded remote memory copy. Each copier thread in the benchmark
+ * space repeatedly copies from its own client in the copy space. On a
+ * multi-unit kernel the copiers run concurrently on different units.
+ */
+static char copier_buffer[MAX_COPIERS][COPYING_THREAD_BUFSIZE]
+    __attribute__ ((aligned (16)));
+static L4_Word_t copier_stack[MAX_COPIERS][2*1024] __attribute__ ((aligned (16)));
+static L4_Word_t client_stack[MAX_COPIERS][2*1024] __attribute__ ((aligned (16)));
+
+static L4_ThreadId_t copier_tids[MAX_COPIERS];
+static L4_ThreadId_t client_tids[MAX_COPIERS];
+static int num_copiers;
+
+/*
+ * Wait to be started by a copier, then expose our buffer to it for the
+ * rest of the benchmark.
+ */
+static void
+mt_client_thread(void)
+{
+    L4_ThreadId_t copier;
+    L4_MsgTag_t tag;
+
+    ARCH_THREAD_INIT
+
+    memset(copying_thread_buffer, COPYING_THREAD_PATTERN,
+           COPYING_THREAD_BUFSIZE);
+
+    L4_Wait(&copier);
+
+    tag = L4_Niltag;
+    L4_Set_MemoryCopy(&tag);
+
+    L4_LoadMR(0, tag.raw);
+    L4_LoadMR(1, (word_t)copying_thread_buffer);
+    L4_LoadMR(2, COPYING_THREAD_BUFSIZE);
+    L4_LoadMR(3, L4_MemoryCopyBoth);
+
+    tag = L4_Call(copier);
+    assert(L4_IpcSucceeded(tag));
+}
+
+static void
+copier_thread(void)
+{
+    L4_ThreadId_t from, client;
+    L4_Word_t index, size;
+    int i, r;
+
+    L4_Wait(&from);
+    L4_StoreMR(1, &index);
+    client = client_tids[index];
+
+    /* Start our client and pick up its call */
+    L4_LoadMR(0, 0);
+    L4_Send(client);
+    L4_Receive(client);
+
+    for (;;) {
+        /* Report done, then wait for the next round */
+        L4_LoadMR(0, 0);
+        L4_Send(KBENCH_SERVER);
+        L4_Receive(KBENCH_SERVER);
+
+        r = 1;
+        for (i = 0; i < iteration; i++) {
+            size = COPYING_THREAD_BUFSIZE;
+            r &= L4_MemoryCopy(client, (word_t)copier_buffer[index], &size,
+                               L4_MemoryCopyTo);
+        }
+        assert(r == 1);
+    }
+}
+
+static void
+init_mt(struct bench_test *test, int args[])
+{
+    L4_Word_t copier_utcb;
+    int i, r;
+
+    iteration = args[0];
+    num_copiers = args[1];
+    assert(num_copiers <= MAX_COPIERS);
+
+    create_copy_space();
+
+    for (i = 0; i < num_copiers; i++) {
+        copier_tids[i] = L4_GlobalId(KBENCH_SERVER.X.index + FIRST_COPIER + i, 2);
+        client_tids[i] = L4_GlobalId(KBENCH_SERVER.X.index + FIRST_CLIENT + i, 2);
+
+        create_copy_thread(client_tids[i], 1 + i, client_stack[i],
+                           sizeof(client_stack[i]), mt_client_thread);
+
+#ifdef NO_UTCB_RELOCATE
+        copier_utcb = -1UL;
+#else
+        copier_utcb = (L4_Word_t) (L4_PtrSize_t)L4_GetUtcbBase() +
+            (FIRST_COPIER + i) * utcb_size;
+#endif
+        r = L4_ThreadControl(copier_tids[i], KBENCH_SPACE, KBENCH_SERVER,
+                             KBENCH_SERVER, KBENCH_SERVER, 0,
+                             (void *)copier_utcb);
+        assert(r == 1);
+        L4_Start_SpIp(copier_tids[i],
+                      (L4_Word_t) copier_stack[i] + sizeof(copier_stack[i]) - 32,
+                      START_ADDR(copier_thread));
+
+        /* Tell the copier which client it serves and wait until it is ready */
+        tag = L4_Niltag;
+        tag.X.u = 1;
+        L4_Set_MsgTag(tag);
+        L4_LoadMR(1, i);
+        L4_Send(copier_tids[i]);
+        L4_Receive(copier_tids[i]);
+    }
+}
+
+static void
+remote_memcpy_mt_test(struct bench_test *test, int args[])
+{
+    int i;
+
+    for (i = 0; i < num_copiers; i++) {
+        L4_LoadMR(0, 0);
+        L4_Send(copier_tids[i]);
+    }
+    for (i = 0; i < num_copiers; i++) {
+        L4_Receive(copier_tids[i]);
+    }
+}
+
+static void
+teardown_mt(struct bench_test *test, int args[])
+{
+    int i, j, r;
+
+    for (i = 0; i < num_copiers; i++) {
+        for (j = 0; j < COPYING_THREAD_BUFSIZE; j++) {
+            if (copier_buffer[i][j] != COPYING_THREAD_PATTERN) {
+                printf("INCORRECT PATTERN: copier %d buffer[%d] = 0x%x !!!!\n",
+                       i, j, copier_buffer[i][j]);
+                break;
+            }
+        }
+        memset(copier_buffer[i], 0, COPYING_THREAD_BUFSIZE);
+
+        r = L4_ThreadControl(copier_tids[i], L4_nilspace, L4_nilthread,
+                             L4_nilthread, L4_nilthread, 0, (void *)0);
+        assert(r == 1);
+        r = L4_ThreadControl(client_tids[i], L4_nilspace, L4_nilthread,
+                             L4_nilthread, L4_nilthread, 0, (void *)0);
+        assert(r == 1);
+    }
+
+    delete_copy_space();
+}
+
+static struct index_type copier_threads = { "threads", "" };
+
+struct bench_test bench_remote_memcpy_mt = {
+    .name = "remote_memcpy_mt",
+    .init = init_mt,
+    .test = remote_memcpy_mt_test,
+    .teardown = teardown_mt,
+    .indices = {
+        { &iterations, 1000, 1000, 500, add_fn },
+        { &copier_threads, 1, MAX_COPIERS, 2, mul_fn },
+        { NULL, 0, 0, 0 }
+    }
+};
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2007 Open Kernel Labs, Inc. (Copyright Holder).
+ * All rights reserved.
+ *
+ * 1. Redistribution and use of OKL4 (Software) in source and binary
+ * forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ *     (a) Redistributions of source code must retain this clause 1
+ *         (including paragraphs (a), (b) and (c)), clause 2 and clause 3
+ *         (Licence Terms) and the above copyright notice.
+ *
+ *     (b) Redistributions in binary form must reproduce the above
+ *         copyright notice and the Licence Terms in the documentation and/or
+ *         other materials provided with the distribution.
+ *
+ *     (c) Redistributions in any form must be accompanied by information on
+ *         how to obtain complete source code for:
+ *        (i) the Software; and
+ *        (ii) all accompanying software that uses (or is intended to
+ *        use) the Software whether directly or indirectly.  Such source
+ *        code must:
+ *        (iii) either be included in the distribution or be available
+ *        for no more than the cost of distribution plus a nominal fee;
+ *        and
+ *        (iv) be licensed by each relevant holder of copyright under
+ *        either the Licence Terms (with an appropriate copyright notice)
+ *        or the terms of a licence which is approved by the Open Source
+ *        Initative.  For an executable file, "complete source code"
+ *        means the source code for all modules it contains and includes
+ *        associated build and other files reasonably required to produce
+ *        the executable.
+ *
+ * 2. THIS SOFTWARE IS PROVIDED ``AS IS'' AND, TO THE EXTENT PERMITTED BY
+ * LAW, ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  WHERE ANY WARRANTY IS
+ * IMPLIED AND IS PREVENTED BY LAW FROM BEING DISCLAIMED THEN TO THE
+ * EXTENT PERMISSIBLE BY LAW: (A) THE WARRANTY IS READ DOWN IN FAVOUR OF
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT) AND (B) ANY LIMITATIONS PERMITTED BY LAW (INCLUDING AS TO
+ * THE EXTENT OF THE WARRANTY AND THE REMEDIES AVAILABLE IN THE EVENT OF
+ * BREACH) ARE DEEMED PART OF THIS LICENCE IN A FORM MOST FAVOURABLE TO
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT). IN THE LICENCE TERMS, "PARTICIPANT" INCLUDES EVERY
+ * PERSON WHO HAS CONTRIBUTED TO THE SOFTWARE OR WHO HAS BEEN INVOLVED IN
+ * THE DISTRIBUTION OR DISSEMINATION OF THE SOFTWARE.
+ *
+ * 3. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR ANY OTHER PARTICIPANT BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Description: scheduler run queue and timer benchmarks.
+ */
+#include <bench/bench.h>
+#include <l4/types.h>
+#include <l4/config.h>
+#include <l4/thread.h>
+#include <l4/schedule.h>
+#include <l4/kdebug.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#define MAX_YIELD_THREADS   16
+#define STACK_SIZE          0x200
+#define FIRST_THREAD        32
+/* Priority kbench's main thread runs at by default. */
+#define YIELD_PRIORITY      100
+
+static L4_Word_t yield_stacks[MAX_YIELD_THREADS][STACK_SIZE];
+static L4_ThreadId_t yield_tids[MAX_YIELD_THREADS];
+
+static void
+yield_thread(void)
+{
+    while (1) {
+        L4_Yield();
+    }
+}
+
+static void
+spin_thread(void)
+{
+    while (1)
+        ;
+}
+
+/*
+ * Print the run queue statistics of each unit, if the kernel keeps them.
+ */
+static void
+print_sched_stats(void)
+{
+    L4_Word_t unit;
+    L4_Word_t mr[8];
+
+    for (unit = 0; L4_KDB_SchedStatsIntroMRs(unit); unit++) {
+        for (int i = 0; i < 8; i++) {
+            L4_StoreMR(i, &mr[i]);
+        }
+        printf("  <runqueue unit=\"%lu\" acquisitions=\"%lu\" steals=\"%lu\" "
+               "stolen=\"%lu\" rebalances=\"%lu\" spin=\"%lu\" max_spin=\"%lu\" "
+               "hold=\"%lu\" max_hold=\"%lu\"/>\n", unit,
+               mr[0], mr[1], mr[2], mr[3], mr[4], mr[5], mr[6], mr[7]);
+    }
+}
+
+/*
+ * Create threads competing for the CPU at our own priority.
+ */
+static void
+create_competing_threads(int num, void (*entry)(void))
+{
+    L4_Word_t utcb_size = L4_GetUtcbSize();
+    L4_Word_t dummy;
+    int r;
+
+    assert(num <= MAX_YIELD_THREADS);
+
+    for (int i = 0; i < num; i++) {
+        L4_Word_t utcb;
+#ifdef NO_UTCB_RELOCATE
+        utcb = -1UL;
+#else
+        utcb = (L4_Word_t)(L4_PtrSize_t)L4_GetUtcbBase() +
+            (FIRST_THREAD + i) * utcb_size;
+#endif
+        yield_tids[i].raw = KBENCH_SERVER.raw + FIRST_THREAD + i;
+        r = L4_ThreadControl(yield_tids[i], KBENCH_SPACE, KBENCH_SERVER,
+                KBENCH_SERVER, KBENCH_SERVER, 0, (void *)(L4_PtrSize_t)utcb);
+        assert(r == 1);
+        L4_Schedule(yield_tids[i], -1, 1, -1, -1, 0, &dummy);
+        L4_Set_Priority(yield_tids[i], YIELD_PRIORITY);
+        L4_Start_SpIp(yield_tids[i],
+                (L4_Word_t)(L4_PtrSize_t)&yield_stacks[i][STACK_SIZE],
+                (L4_Word_t)(L4_PtrSize_t)entry);
+    }
+}
+
+static void
+delete_competing_threads(int num)
+{
+    int r;
+
+    for (int i = 0; i < num; i++) {
+        r = L4_ThreadControl(yield_tids[i], L4_nilspace, L4_nilthread,
+                L4_nilthread, L4_nilthread, 0, (void *)0);
+        assert(r == 1);
+    }
+}
+
+static void
+sched_yield_setup(struct bench_test *test, int args[])
+{
+    create_competing_threads(args[1], yield_thread);
+}
+
+static void
+sched_yield_test(struct bench_test *test, int args[])
+{
+    for (int i = 0; i < args[0]; i++) {
+        L4_Yield();
+    }
+}
+
+static void
+sched_yield_teardown(struct bench_test *test, int args[])
+{
+    delete_competing_threads(args[1]);
+
+    printf("  <!-- run queue statistics after %d yields, %d threads -->\n",
+           args[0], args[1]);
+    print_sched_stats();
+}
+
+static struct index_type yield_threads = { "threads", "" };
+
+/*
+ * Yield between a number of threads of equal priority. With per-unit run
+ * queues on a multi-unit kernel this also reports how often each unit's
+ * queue lock was taken, how often work was stolen and how long the lock
+ * was spun on and held.
+ */
+struct bench_test bench_sched_yield = {
+    "sched yield",
+    sched_yield_setup,
+    sched_yield_test,
+    sched_yield_teardown,
+    {
+        { &iterations, 1000, 1000, 1000, add_fn },
+        { &yield_threads, 1, MAX_YIELD_THREADS, 2, mul_fn },
+        { NULL }
+    }
+};
+
+/*------------------------------------------------------------------------------*/
+
+/* Length of each timer interrupt rate sample in microseconds. */
+#define TIMER_SAMPLE_LENGTH 1000000ULL
+
+static L4_Word_t saved_timeslice;
+
+static L4_Word_t
+read_timer_stats(uint64_t *now)
+{
+    L4_Word_t count, lo, hi;
+
+    count = L4_KDB_TimerStatsIntroMRs();
+    L4_StoreMR(0, &lo);
+    L4_StoreMR(1, &hi);
+    *now = ((uint64_t)hi << 32) | lo;
+
+    return count;
+}
+
+static void
+timer_irq_setup(struct bench_test *test, int args[])
+{
+    L4_Timeslice(L4_Myself(), &saved_timeslice);
+
+    if (args[0] == 0) {
+        /* Nothing to share the CPU with: run with an infinite timeslice,
+         * so a tickless kernel has no reason to take a timer interrupt. */
+        L4_Set_Timeslice(L4_Myself(), 0);
+    } else {
+        create_competing_threads(args[0], spin_thread);
+    }
+}
+
+static void
+timer_irq_test(struct bench_test *test, int args[])
+{
+    uint64_t start, now;
+    L4_Word_t first, last;
+
+    first = read_timer_stats(&start);
+    if (start == 0) {
+        printf("  <!-- kernel does not keep the current time -->\n");
+        return;
+    }
+
+    do {
+        last = read_timer_stats(&now);
+    } while (now - start < TIMER_SAMPLE_LENGTH);
+
+    printf("  <!-- %d spinning threads: %lu timer interrupts/s -->\n",
+           args[0], (unsigned long)((uint64_t)(last - first) *
+               1000000ULL / (now - start)));
+}
+
+static void
+timer_irq_teardown(struct bench_test *test, int args[])
+{
+    delete_competing_threads(args[0]);
+    L4_Set_Timeslice(L4_Myself(), saved_timeslice);
+}
+
+static struct index_type load_threads = { "spinning threads", "" };
+
+/*
+ * Count timer interrupts per second while this thread has the CPU to
+ * itself with an infinite timeslice, and while it shares the CPU with
+ * spinning threads of equal priority. A periodic tick shows the same rate
+ * for both; a tickless kernel only interrupts to end timeslices.
+ */
+struct bench_test bench_timer_irq_rate = {
+    "timer interrupt rate",
+    timer_irq_setup,
+    timer_irq_test,
+    timer_irq_teardown,
+    {
+        { &load_threads, 0, 2, 2, add_fn },
+        { NULL }
+    }
+};
@@ -82,10 +82,20 @@
 /* Misc benchs */
 extern struct bench_test bench_zerosleep;
 extern struct bench_test bench_memcpy;
+extern struct bench_test bench_memcpy_unaligned;
+extern struct bench_test bench_memset;
 extern struct bench_test bench_remote_memcpy;
+extern struct bench_test bench_remote_memcpy_mt;
+#if defined(CONFIG_IPC_WINDOWS)
+extern struct bench_test bench_ipc_window;
+extern struct bench_test bench_ipc_window_memcpy;
+#endif
 extern struct bench_test bench_exreg;
 //extern struct bench_test bench_myself;
 extern struct bench_test bench_switch_myself;
+extern struct bench_test bench_sched_yield;
+extern struct bench_test bench_timer_irq_rate;
+extern struct bench_test bench_mutex_contention;
 
 /* IPC benchs */
 extern struct bench_test bench_ipc_intra;
@@ -102,6 +112,7 @@ extern struct bench_test bench_ipc_intra_rpc;
 extern struct bench_test bench_ipc_intra_ovh;
 extern struct bench_test bench_ipc_intra_async;
 extern struct bench_test bench_ipc_intra_async_ovh;
+extern struct bench_test bench_ipc_intra_async_wait;
 
 /* Map Control benchs */
 extern struct bench_test bench_mapcontrol_insert_m2m;
@@ -110,6 +121,8 @@ extern struct bench_test bench_mapcontrol_delete_m2m;
 extern struct bench_test bench_mapcontrol_delete2_m2m;
 extern struct bench_test bench_mapcontrol_ovh1;
 extern struct bench_test bench_mapcontrol_ovh2;
+extern struct bench_test bench_mapcontrol_region_pages;
+extern struct bench_test bench_mapcontrol_region_run;
 
 /* Thread Control benchs */
 extern struct bench_test bench_threadcontrol;
@@ -117,14 +130,18 @@ extern struct bench_test bench_threadcontrol_ovh;
 
 /* New interface benchs */
 extern struct new_bench_test new_bench_irq_ipc;
+extern struct new_bench_test new_bench_irq_ipc_coalesced;
 extern struct new_bench_test new_bench_spaceswitch_priv;
 extern struct new_bench_test new_bench_spaceswitch_sd;
 extern struct new_bench_test new_bench_spaceswitch_no_sd;
+extern struct new_bench_test new_bench_spaceswitch_asid;
 extern struct new_bench_test new_bench_no_contention_mutex_lock;
 extern struct new_bench_test new_bench_no_contention_mutex_unlock;
 extern struct new_bench_test new_bench_contention_mutex_trylock;
 extern struct new_bench_test new_bench_contention_mutex_lock;
 extern struct new_bench_test new_bench_contention_mutex_unlock;
+extern struct new_bench_test new_bench_cache_flush_range;
+extern struct new_bench_test new_bench_cache_flush_ranges;
 
 /* common counters */
 struct counter cycle_counter;
@@ -198,9 +215,21 @@ static struct bench_test *benchmarks[] = {
     /* misc benchs */
     &bench_empty,
     //&bench_zerosleep,
-    //&bench_memcpy,
+    &bench_memcpy,
+    &bench_memcpy_unaligned,
+    &bench_memset,
     &bench_remote_memcpy,
+    &bench_remote_memcpy_mt,
+#if defined(CONFIG_IPC_WINDOWS)
+    &bench_ipc_window,
+    &bench_ipc_window_memcpy,
+#endif
     &bench_switch_myself,
+    /* scheduler benchs */
+    &bench_sched_yield,
+    &bench_timer_irq_rate,
+    /* mutex benchs */
+    &bench_mutex_contention,
     /* map control benchs */
     &bench_mapcontrol_insert_m2m,
     &bench_mapcontrol_insert2_m2m,
@@ -208,6 +237,8 @@ static struct bench_test *benchmarks[] = {
     &bench_mapcontrol_delete2_m2m,
     &bench_mapcontrol_ovh1,
     &bench_mapcontrol_ovh2,
+    &bench_mapcontrol_region_pages,
+    &bench_mapcontrol_region_run,
     /* exchange register benchs */
     &bench_exreg,
     /* thread control benchs */
@@ -220,6 +251,7 @@ static struct bench_test *benchmarks[] = {
     &bench_ipc_intra_ovh,
     &bench_ipc_intra_async,
     &bench_ipc_intra_async_ovh,
+    &bench_ipc_intra_async_wait,
     /* deprecated ipc tests */
     //&bench_ipc_page_faults,
     //&bench_ipc_pagemap,
@@ -242,17 +274,22 @@ static struct new_bench_test *new_benchmarks[] = {
      */
     /* irq ipc latency benchs */
     &new_bench_irq_ipc,
+    &new_bench_irq_ipc_coalesced,
     /* space switch benchs */
     //&new_bench_spaceswitch_priv,
 #if defined(ARM_SHARED_DOMAINS)
     &new_bench_spaceswitch_sd,
 #endif
     &new_bench_spaceswitch_no_sd,
+    &new_bench_spaceswitch_asid,
     &new_bench_no_contention_mutex_lock,
     &new_bench_no_contention_mutex_unlock,
     &new_bench_contention_mutex_trylock,
     &new_bench_contention_mutex_lock,
     &new_bench_contention_mutex_unlock,
+    /* cache control benchs */
+    &new_bench_cache_flush_range,
+    &new_bench_cache_flush_ranges,
     NULL
 };
 
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2008 Open Kernel Labs, Inc. (Copyright Holder).
+ * All rights reserved.
+ *
+ * 1. Redistribution and use of OKL4 (Software) in source and binary
+ * forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ *     (a) Redistributions of source code must retain this clause 1
+ *         (including paragraphs (a), (b) and (c)), clause 2 and clause 3
+ *         (Licence Terms) and the above copyright notice.
+ *
+ *     (b) Redistributions in binary form must reproduce the above
+ *         copyright notice and the Licence Terms in the documentation and/or
+ *         other materials provided with the distribution.
+ *
+ *     (c) Redistributions in any form must be accompanied by information on
+ *         how to obtain complete source code for:
+ *        (i) the Software; and
+ *        (ii) all accompanying software that uses (or is intended to
+ *        use) the Software whether directly or indirectly.  Such source
+ *        code must:
+ *        (iii) either be included in the distribution or be available
+ *        for no more than the cost of distribution plus a nominal fee;
+ *        and
+ *        (iv) be licensed by each relevant holder of copyright under
+ *        either the Licence Terms (with an appropriate copyright notice)
+ *        or the terms of a licence which is approved by the Open Source
+ *        Initative.  For an executable file, "complete source code"
+ *        means the source code for all modules it contains and includes
+ *        associated build and other files reasonably required to produce
+ *        the executable.
+ *
+ * 2. THIS SOFTWARE IS PROVIDED ``AS IS'' AND, TO THE EXTENT PERMITTED BY
+ * LAW, ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  WHERE ANY WARRANTY IS
+ * IMPLIED AND IS PREVENTED BY LAW FROM BEING DISCLAIMED THEN TO THE
+ * EXTENT PERMISSIBLE BY LAW: (A) THE WARRANTY IS READ DOWN IN FAVOUR OF
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT) AND (B) ANY LIMITATIONS PERMITTED BY LAW (INCLUDING AS TO
+ * THE EXTENT OF THE WARRANTY AND THE REMEDIES AVAILABLE IN THE EVENT OF
+ * BREACH) ARE DEEMED PART OF THIS LICENCE IN A FORM MOST FAVOURABLE TO
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT). IN THE LICENCE TERMS, "PARTICIPANT" INCLUDES EVERY
+ * PERSON WHO HAS CONTRIBUTED TO THE SOFTWARE OR WHO HAS BEEN INVOLVED IN
+ * THE DISTRIBUTION OR DISSEMINATION OF THE SOFTWARE.
+ *
+ * 3. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR ANY OTHER PARTICIPANT BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Description: Cache control benchmarks.
+ */
+#include <l4/types.h>
+#include <l4/config.h>
+#include <l4/cache.h>
+#include <l4/ipc.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <assert.h>
+#include <bench/bench.h>
+
+extern struct counter cycle_counter;
+
+static struct counter *cache_counters[] = {
+    &cycle_counter,
+    NULL
+};
+
+#define CACHE_BUFFER_SIZE   (4 * 1024 * 1024)
+/* Number of pieces a buffer is split into by the multi-range test. */
+#define CACHE_RANGES        8
+/* Overlap between neighbouring pieces, about one cache line. */
+#define CACHE_OVERLAP       32
+
+static char cache_buffer[CACHE_BUFFER_SIZE] __attribute__((aligned(4096)));
+
+#define CACHE_ATTR_CLEAN_INVAL_D    (L4_CacheFlush_AttrD | \
+                                     L4_CacheFlush_AttrClean | \
+                                     L4_CacheFlush_AttrInvalidate)
+
+static void
+cache_setup(struct new_bench_test *test, int args[])
+{
+    assert(args[1] <= CACHE_BUFFER_SIZE);
+}
+
+/*
+ * Load the message registers with the buffer split into pieces that
+ * overlap their neighbours, as a driver flushing the descriptors and
+ * payloads of a DMA transfer would.
+ */
+static L4_Word_t
+cache_load_ranges(L4_Word_t size, int pieces)
+{
+    L4_Word_t piece = size / pieces;
+    L4_Word_t start, end;
+    int i;
+
+    for (i = 0; i < pieces; i++) {
+        start = (L4_Word_t)cache_buffer + i * piece;
+        end = start + piece + CACHE_OVERLAP;
+        if (end > (L4_Word_t)cache_buffer + size) {
+            end = (L4_Word_t)cache_buffer + size;
+        }
+        L4_LoadMR(i * 2, start);
+        L4_LoadMR(i * 2 + 1, (end - start) | CACHE_ATTR_CLEAN_INVAL_D);
+    }
+
+    return L4_CacheCtl_FlushRanges | L4_CacheCtl_MaskL1 | (pieces - 1);
+}
+
+static void
+cache_run(int args[], volatile uint64_t *count, int pieces)
+{
+    L4_Word_t control;
+    int i, r;
+
+    for (i = 0; i < args[0]; i++) {
+        /* Dirty the buffer so that every line needs writing back. */
+        memset(cache_buffer, i, args[1]);
+
+        control = cache_load_ranges(args[1], pieces);
+        cycle_counter.start();
+        r = L4_CacheControl(L4_nilspace, control);
+        cycle_counter.stop();
+        if (r == 0) {
+            printf("Cache control Error: %"PRIxPTR"\n", L4_ErrorCode());
+        }
+        assert(r == 1);
+        count[0] += cycle_counter.get_count(0);
+    }
+}
+
+static void
+cache_range_test(struct new_bench_test *test, int args[],
+                 volatile uint64_t *count)
+{
+    cache_run(args, count, 1);
+}
+
+static void
+cache_ranges_test(struct new_bench_test *test, int args[],
+                  volatile uint64_t *count)
+{
+    cache_run(args, count, CACHE_RANGES);
+}
+
+static void
+cache_teardown(struct new_bench_test *test, int args[])
+{
+}
+
+struct new_bench_test new_bench_cache_flush_range = {
+    "cache flush - single range",
+    cache_counters,
+    cache_setup,
+    cache_range_test,
+    cache_teardown,
+    {
+        {&iterations, 100, 100, 1, add_fn },
+        {&mem_size, 4 * 1024, 4 * 1024 * 1024, 4, mul_fn },
+        {NULL, 0, 0, 0}
+    }
+};
+
+struct new_bench_test new_bench_cache_flush_ranges = {
+    "cache flush - overlapping ranges",
+    cache_counters,
+    cache_setup,
+    cache_ranges_test,
+    cache_teardown,
+    {
+        {&iterations, 100, 100, 1, add_fn },
+        {&mem_size, 4 * 1024, 4 * 1024 * 1024, 4, mul_fn },
+        {NULL, 0, 0, 0}
+    }
+};
@@ -72,6 +72,7 @@
 #include <stdbool.h>
 #include <l4/kdebug.h>
 #include <l4/schedule.h>
+#include <l4/interrupt.h>
 #include <cycles/cycles.h>
 
 
@@ -96,6 +97,7 @@ static L4_ThreadId_t spinner_tid;
 #endif
 static L4_Word_t interrupt;
 static int num_iterations = 0;
+static bool coalesce;
 static volatile uint64_t * results;
 
 
@@ -105,6 +107,11 @@ static L4_Word_t pager_stack[2048] __attribute__ ((aligned (16)));
 static L4_Word_t spinner_stack[1024] __attribute__ ((aligned (16)));
 #endif
 extern struct new_bench_test new_bench_irq_ipc;
+extern struct new_bench_test new_bench_irq_ipc_coalesced;
+
+/* Interrupts batched per wakeup, and the delay bound in microseconds */
+#define COALESCE_EVENTS     16
+#define COALESCE_DELAY      1000
 
 static int
 get_num_counters(struct counter *myself)
@@ -166,6 +173,34 @@ static struct counter *irq_ipc_counters[] = {
     NULL
 };
 
+static const char *
+get_wakeup_name(struct counter *myself, int counter)
+{
+    return "Handler wakeups";
+}
+
+static const char *
+get_wakeup_unit(struct counter *myself, int counter)
+{
+    return "wakeups";
+}
+
+static struct counter dummy_wakeup_counter = {
+    .get_num_counters = get_num_counters,
+    .get_name = get_wakeup_name,
+    .get_unit = get_wakeup_unit,
+    .init = init,
+    .setup = setup,
+    .start = start,
+    .stop = stop,
+    .get_count = get_count
+};
+
+static struct counter *irq_wakeup_counters[] = {
+    &dummy_wakeup_counter,
+    NULL
+};
+
 
 static void
 handler(void)
@@ -244,6 +279,61 @@ handler(void)
     /* NOTREACHED */
 }
 
+/*
+ * Take num_iterations interrupts with coalescing enabled, counting how
+ * many times the handler is woken up to do so.
+ */
+static void
+handler_coalesced(void)
+{
+    L4_Word_t irq, control, events;
+    L4_Word_t total = 0, wakeups = 0;
+    irq = interrupt;
+
+    L4_Call(master_tid);
+
+    /* Accept interrupts */
+    L4_Accept(L4_NotifyMsgAcceptor);
+    L4_Set_NotifyMask(~0UL);
+
+    while (total < (L4_Word_t)num_iterations)
+    {
+#if defined(CONFIG_CPU_ARM_XSCALE) || defined(CONFIG_CPU_ARM_ARM1136JS) || defined(CONFIG_CPU_ARM_ARM1176JZS)
+        //Setup pmu irq
+        L4_KDB_PMN_Write(REG_CCNT, 0xFF800000);
+        L4_Word_t PMNC = L4_KDB_PMN_Read(REG_PMNC) & ~PMNC_CCNT_64DIV;
+        L4_KDB_PMN_Write(REG_PMNC, (PMNC | PMNC_CCNT_OFL | PMNC_CCNT_ENABLE) & ~PMNC_CCNT_RESET);
+        L4_KDB_PMN_Ofl_Write(REG_CCNT, ~0UL);
+#endif
+        // ack/wait IRQ, MR2 holds the number of interrupts delivered
+        control = 0 | (3 << 6);
+        L4_LoadMR(0, irq);
+        (void)L4_InterruptControl(L4_nilthread, control);
+        L4_StoreMR(2, &events);
+
+        irq = __L4_TCR_PlatformReserved(0);
+
+#if defined(CONFIG_CPU_ARM_XSCALE) || defined(CONFIG_CPU_ARM_ARM1136JS) || defined(CONFIG_CPU_ARM_ARM1176JZS)
+        PMNC = L4_KDB_PMN_Read(REG_PMNC);
+        L4_KDB_PMN_Write(REG_PMNC, (PMNC | PMNC_CCNT_OFL) & ~PMNC_CCNT_ENIRQ);
+        L4_KDB_PMN_Write(REG_PMNC, PMNC & ~PMNC_CCNT_ENABLE);
+#endif
+        total += events;
+        wakeups++;
+    }
+
+    results[0] += wakeups;
+
+    /* Tell master that we're finished */
+    L4_Set_MsgTag (L4_Niltag);
+    L4_Send (master_tid);
+
+    for (;;)
+        L4_WaitForever();
+
+    /* NOTREACHED */
+}
+
 #if SPINNER
 static void
 spinner (void)
@@ -365,6 +455,7 @@ ipc_irq_setup(struct new_bench_test *test, int args[])
 
     num_iterations = args[0];
     handler_space = L4_nilspace;
+    coalesce = (test == &new_bench_irq_ipc_coalesced);
 
 
     /* We need a maximum of two threads per task */
@@ -422,7 +513,15 @@ ipc_irq_setup(struct new_bench_test *test, int args[])
         printf("Cannot register interrupt %lu\n", interrupt);
     }
 
-    L4_Start_SpIp (handler_tid, (L4_Word_t) handler_stack + sizeof(handler_stack) - 32, START_ADDR(handler));
+    if (coalesce) {
+        r = L4_SetInterruptCoalescing(handler_tid, COALESCE_EVENTS, COALESCE_DELAY);
+        if (r == 0) {
+            printf("Cannot enable interrupt coalescing\n");
+        }
+        L4_Start_SpIp (handler_tid, (L4_Word_t) handler_stack + sizeof(handler_stack) - 32, START_ADDR(handler_coalesced));
+    } else {
+        L4_Start_SpIp (handler_tid, (L4_Word_t) handler_stack + sizeof(handler_stack) - 32, START_ADDR(handler));
+    }
 
     L4_Receive(handler_tid);
 
@@ -455,3 +554,15 @@ struct new_bench_test new_bench_irq_ipc = {
         {NULL, 0, 0, 0}
     }
 };
+
+/*
+ * From new_bench_irq_ipc_coalesced, we can get:
+ * Handler wakeups per 10000 interrupts with coalescing enabled
+ */
+struct new_bench_test new_bench_irq_ipc_coalesced = {
+    "ipc - irq ipc coalesced wakeups", irq_wakeup_counters, ipc_irq_setup, ipc_irq_test, ipc_irq_teardown,
+    {
+        {&iterations, 10000, 10000, 1000, add_fn },
+        {NULL, 0, 0, 0}
+    }
+};
@@ -73,6 +73,7 @@
 #include <bench/bench.h>
 #include <l4/ipc.h>
 #include <l4/schedule.h>
+#include <okl4/kspaceid_pool.h>
 
 #if defined(ARM_SHARED_DOMAINS)
 #include <l4/arch/ver/space_resources.h>
@@ -636,3 +637,159 @@ spaceswitch_self_setup(struct new_bench_test *test, int args[])
     }
 #endif
 }
+
+/*------------------------------------------------------------------------------*/
+/*
+ * Space switch round robin through twice as many spaces as there are hardware
+ * ASIDs (256 on ARMv6), so that every switch has to allocate an ASID.
+ */
+#define ASID_SPACES         512
+
+extern okl4_kspaceid_pool_t *spaceid_pool;
+static L4_SpaceId_t asid_space_id[ASID_SPACES];
+
+static void switch_asid_thread(void)
+{
+    int i, r;
+    L4_Word_t utcb =
+#ifdef NO_UTCB_RELOCATE
+        -1UL;
+#else
+        (L4_Word_t) ((L4_PtrSize_t) 16 * 1024 * 1024 + utcb_size * (16));
+#endif
+
+    L4_Call(main_tid);
+
+    L4_Word_t ovh = 0;
+    for (i = 0; i < 1000; i++)
+    {
+        cycle_counter.start();
+        cycle_counter.stop();
+        ovh += cycle_counter.get_count(0);
+    }
+    ovh /= 1000;
+
+    /* Visit every space once first, to fault in our code and stack */
+    for (i = 0; i < ASID_SPACES; i++)
+    {
+        r = L4_SpaceSwitch(test_tid, asid_space_id[i], (void *)utcb);
+        assert(r == 1);
+    }
+
+    for (i = 0; i < iteration; i++)
+    {
+        cycle_counter.start();
+        r = L4_SpaceSwitch(test_tid, asid_space_id[i % ASID_SPACES], (void *)utcb);
+        cycle_counter.stop();
+        if (r == 0)
+            printf("Space switch Error: %"PRIxPTR"\n", L4_ErrorCode());
+        assert(r == 1);
+        *result += (cycle_counter.get_count(0) - ovh);
+    }
+    //send ipc to main thread indicate test finished.
+    L4_Send(main_tid);
+}
+
+static void
+spaceswitch_asid_setup(struct new_bench_test *test, int args[])
+{
+    int r, i;
+    pager_tid.raw = KBENCH_SERVER.raw + 1;
+    test_tid.raw = KBENCH_SERVER.raw + 16;
+    main_tid = KBENCH_SERVER;
+    iteration = args[0];
+
+    L4_Fpage_t utcb_area;
+    L4_Word_t  utcb;
+    L4_Word_t  dummy;
+
+    utcb_size = L4_GetUtcbSize();
+
+#ifdef NO_UTCB_RELOCATE
+    utcb_area = L4_Nilpage;
+    utcb = -1UL;
+#else
+    utcb_area = L4_Fpage(16 * 1024 * 1024,
+                         L4_GetUtcbSize() * (1024));
+    utcb = (L4_Word_t) (L4_PtrSize_t)L4_GetUtcbBase() + (2)*utcb_size;
+#endif
+
+    /* create pager */
+    r = L4_ThreadControl(pager_tid, KBENCH_SPACE, KBENCH_SERVER, KBENCH_SERVER, KBENCH_SERVER, 0, (void *)(L4_PtrSize_t)utcb);
+    assert(r == 1);
+    L4_Schedule(pager_tid, -1, 1, -1, -1, 0, &dummy);
+    L4_Set_Priority(pager_tid, 254);
+    L4_Start_SpIp(pager_tid, (L4_Word_t)(L4_PtrSize_t)(&pager_stack[STACK_SIZE]), (L4_Word_t) (L4_PtrSize_t) pager);
+    L4_KDB_SetThreadName(pager_tid, "pager");
+
+    L4_Receive(pager_tid);
+
+    /* create test spaces */
+    for (i = 0; i < ASID_SPACES; i++)
+    {
+        r = okl4_kspaceid_allocany(spaceid_pool, &asid_space_id[i]);
+        assert(r == OKL4_OK);
+        r = L4_SpaceControl(asid_space_id[i], L4_SpaceCtrl_new | L4_SpaceCtrl_kresources_accessible, KBENCH_CLIST, utcb_area, 0, &dummy);
+        if (r == 0)
+        {
+            printf("Create Space(%d) Error: %"PRIxPTR"\n", i, L4_ErrorCode());
+        }
+        assert(r == 1);
+    }
+
+    /* create test thread */
+#ifdef NO_UTCB_RELOCATE
+    utcb = -1UL;
+#else
+    utcb = (L4_Word_t) ((L4_PtrSize_t) 16 * 1024 * 1024 + utcb_size * (16));
+#endif
+    r = L4_ThreadControl(test_tid, asid_space_id[0], pager_tid, pager_tid, pager_tid, 0, (void *)(L4_PtrSize_t)utcb);
+    L4_StoreMR(0, &test_th.raw);
+    assert(r == 1);
+
+    L4_Schedule(test_tid, -1, 1, -1, -1, 0, &dummy);
+
+    L4_Start_SpIp(test_tid, (L4_Word_t)(L4_PtrSize_t)(&test_stack[STACK_SIZE]), (L4_Word_t) (L4_PtrSize_t) switch_asid_thread);
+
+    L4_Receive(test_tid);
+}
+
+static void
+spaceswitch_asid_teardown(struct new_bench_test *test, int args[])
+{
+    int i, r;
+
+    /* Delete test thread and pager */
+    r = L4_ThreadControl(test_tid, L4_nilspace, L4_nilthread, L4_nilthread, L4_nilthread, 0, (void *)0);
+    if (r == 0)
+        printf("Thread Delete failed, ErrorCode = %d\n", (int)L4_ErrorCode());
+    assert(r == 1);
+    r = L4_ThreadControl(pager_tid, L4_nilspace, L4_nilthread, L4_nilthread, L4_nilthread, 0, (void *)0);
+    if (r == 0)
+        printf("Thread Delete failed, ErrorCode = %d\n", (int)L4_ErrorCode());
+    assert(r == 1);
+
+    /* Delete test spaces */
+    for (i = 0; i < ASID_SPACES; i++)
+    {
+        r = L4_SpaceControl(asid_space_id[i], L4_SpaceCtrl_delete, KBENCH_CLIST, L4_Nilpage, 0, NULL);
+        if (r == 0)
+        {
+            printf("Delete Space Error: %"PRIxPTR"\n",  L4_ErrorCode());
+        }
+        assert(r == 1);
+        okl4_kspaceid_free(spaceid_pool, asid_space_id[i]);
+    }
+}
+
+struct new_bench_test new_bench_spaceswitch_asid = {
+    "space switch - more spaces than ASIDs",
+    spaceswitch_counters,
+    spaceswitch_asid_setup,
+    spaceswitch_self_test,
+    spaceswitch_asid_teardown,
+    {
+        {&iterations, 1000, 1000, 5, add_fn },
+        {NULL, 0, 0, 0}
+    }
+};
@@ -268,6 +268,51 @@ START_TEST(IRQ0301)
 }
 END_TEST
 
+/*
+\begin{test}{IRQ0400}
+  \TestDescription{Check interrupt coalescing can be configured and turned off}
+  \TestPostConditions{}
+  \TestImplementationProcess{
+    \begin{enumerate}
+    \item Register interrupt number 1.
+    \item Call \Func{L4\_SetInterruptCoalescing} with a batch of 8 interrupts and no delay.
+    \item Check that the return value is 0 and the error code is \Func{EINVALID\_PARAM}.
+    \item Call \Func{L4\_SetInterruptCoalescing} with a batch of 8 interrupts and a 1ms delay.
+    \item Check that the return value is 1.
+    \item Call \Func{L4\_SetInterruptCoalescing} to turn coalescing off.
+    \item Check that the return value is 1.
+    \item Unregister interrupt number 1.
+    \end{enumerate}
+  }
+  \TestImplementationStatus{Implemented}
+  \TestIsFullyAutomated{Yes}
+  \TestRegressionStatus{In regression test suite}
+\end{test}
+*/
+START_TEST(IRQ0400)
+{
+    L4_Word_t result;
+    L4_Word_t notifybits = 0x1;
+
+    L4_LoadMR(0, VALID_IRQ1);
+    result = L4_RegisterInterrupt(main_tid, notifybits, 0, 0);
+    _fail_unless(result == 1, __FILE__, __LINE__, "InterruptControl failed to register handler: Error=%lu", L4_ErrorCode());
+
+    result = L4_SetInterruptCoalescing(main_tid, 8, 0);
+    fail_unless(result == 0, "Coalescing without a delay did not fail");
+    fail_unless(L4_ErrorCode() == L4_ErrInvalidParam, "Wrong error code");
+
+    result = L4_SetInterruptCoalescing(main_tid, 8, 1000);
+    _fail_unless(result == 1, __FILE__, __LINE__, "Failed to set coalescing: Error=%lu", L4_ErrorCode());
+    result = L4_SetInterruptCoalescing(main_tid, 0, 0);
+    _fail_unless(result == 1, __FILE__, __LINE__, "Failed to clear coalescing: Error=%lu", L4_ErrorCode());
+
+    L4_LoadMR(0, VALID_IRQ1);
+    result = L4_UnregisterInterrupt(main_tid, 0, 0);
+    _fail_unless(result == 1, __FILE__, __LINE__, "InterruptControl failed to unregister handler: Error=%lu", L4_ErrorCode());
+}
+END_TEST
+
 static void test_setup(void)
 {
     main_tid = test_tid;
@@ -300,6 +345,7 @@ make_interrupt_control_tcase(void)
 #endif
     tcase_add_test(tc, IRQ0300);
     tcase_add_test(tc, IRQ0301);
+    tcase_add_test(tc, IRQ0400);
 
     return tc;
 }
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2008 Open Kernel Labs, Inc. (Copyright Holder).
+ * All rights reserved.
+ *
+ * 1. Redistribution and use of OKL4 (Software) in source and binary
+ * forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ *     (a) Redistributions of source code must retain this clause 1
+ *         (including paragraphs (a), (b) and (c)), clause 2 and clause 3
+ *         (Licence Terms) and the above copyright notice.
+ *
+ *     (b) Redistributions in binary form must reproduce the above
+ *         copyright notice and the Licence Terms in the documentation and/or
+ *         other materials provided with the distribution.
+ *
+ *     (c) Redistributions in any form must be accompanied by information on
+ *         how to obtain complete source code for:
+ *        (i) the Software; and
+ *        (ii) all accompanying software that uses (or is intended to
+ *        use) the Software whether directly or indirectly.  Such source
+ *        code must:
+ *        (iii) either be included in the distribution or be available
+ *        for no more than the cost of distribution plus a nominal fee;
+ *        and
+ *        (iv) be licensed by each relevant holder of copyright under
+ *        either the Licence Terms (with an appropriate copyright notice)
+ *        or the terms of a licence which is approved by the Open Source
+ *        Initative.  For an executable file, "complete source code"
+ *        means the source code for all modules it contains and includes
+ *        associated build and other files reasonably required to produce
+ *        the executable.
+ *
+ * 2. THIS SOFTWARE IS PROVIDED ``AS IS'' AND, TO THE EXTENT PERMITTED BY
+ * LAW, ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  WHERE ANY WARRANTY IS
+ * IMPLIED AND IS PREVENTED BY LAW FROM BEING DISCLAIMED THEN TO THE
+ * EXTENT PERMISSIBLE BY LAW: (A) THE WARRANTY IS READ DOWN IN FAVOUR OF
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT) AND (B) ANY LIMITATIONS PERMITTED BY LAW (INCLUDING AS TO
+ * THE EXTENT OF THE WARRANTY AND THE REMEDIES AVAILABLE IN THE EVENT OF
+ * BREACH) ARE DEEMED PART OF THIS LICENCE IN A FORM MOST FAVOURABLE TO
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT). IN THE LICENCE TERMS, "PARTICIPANT" INCLUDES EVERY
+ * PERSON WHO HAS CONTRIBUTED TO THE SOFTWARE OR WHO HAS BEEN INVOLVED IN
+ * THE DISTRIBUTION OR DISSEMINATION OF THE SOFTWARE.
+ *
+ * 3. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR ANY OTHER PARTICIPANT BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Description: IPC window tests
+ */
+
+#include <ktest/ktest.h>
+#include <ktest/utility.h>
+#include <l4/config.h>
+#include <l4/ipc.h>
+#include <l4/map.h>
+#include <l4/message.h>
+#include <l4/space.h>
+#include <l4/thread.h>
+#include <l4/wbtest.h>
+#include <stdio.h>
+#include <ktest/arch/constants.h>
+
+#if defined(CONFIG_IPC_WINDOWS)
+
+extern L4_ThreadId_t test_tid;
+
+#define PAGESIZE        (1 << USER_MIN_PAGE_BITS)
+/* Where the lender maps the buffer it lends */
+#define LEND_ADDRESS    0x76000000
+/* Receive window of the borrower, in its own space */
+#define WINDOW_ADDRESS  0x77000000
+
+ALIGNED(PAGESIZE) static char lend_physmem[2 * PAGESIZE] = {1};
+
+/*
+ * Map page 'page' of lend_physmem at LEND_ADDRESS in our space.
+ */
+static void
+map_lend_page(int page)
+{
+    word_t offset, cache, rwx, size, seg;
+    L4_MapItem_t map;
+    int res;
+
+    seg = get_seg(KTEST_SPACE, (word_t)lend_physmem, &offset, &cache,
+                  &rwx, &size);
+    size = L4_GetMinPageBits();
+    offset = (offset & ~((1UL << size) - 1)) + page * PAGESIZE;
+
+    L4_MapItem_Map(&map, seg, offset, LEND_ADDRESS, size, cache, rwx);
+    res = L4_ProcessMapItem(KTEST_SPACE, map);
+    fail_unless(res == 1, "L4_Map failed");
+}
+
+static void
+unmap_lend_page(void)
+{
+    L4_MapItem_t map;
+
+    L4_MapItem_Unmap(&map, LEND_ADDRESS, L4_GetMinPageBits());
+    L4_ProcessMapItem(KTEST_SPACE, map);
+}
+
+static void
+borrower_thread(void)
+{
+    L4_Accept(L4_WindowAcceptor(L4_Fpage(WINDOW_ADDRESS, PAGESIZE)));
+    L4_Receive(test_tid);
+}
+
+static int
+window_mapped(L4_SpaceId_t space)
+{
+    word_t phys;
+
+    return L4_WBT_GetMapping(space, WINDOW_ADDRESS, kernel_test_segment_id,
+                             &phys, NULL, NULL, NULL);
+}
+
+/*
+ * Lend the page at LEND_ADDRESS to a new thread in its own space and
+ * leave the window open. Returns the borrower.
+ */
+static L4_ThreadId_t
+open_window(L4_SpaceId_t *space)
+{
+    L4_ThreadId_t borrower;
+    L4_MsgTag_t tag;
+    L4_Fpage_t buffer;
+
+    borrower = createThreadInSpace(L4_nilspace, borrower_thread);
+    *space = lookupSpace(borrower);
+    waitReceiving(borrower);
+
+    buffer = L4_Fpage(LEND_ADDRESS, PAGESIZE);
+    L4_Set_Rights(&buffer, L4_Readable);
+
+    tag = L4_Niltag;
+    L4_Set_Window(&tag);
+    L4_LoadMR(0, tag.raw);
+    L4_LoadMR(1, buffer.raw);
+    tag = L4_Send(borrower);
+    fail_unless(L4_IpcSucceeded(tag), "Window IPC failed");
+    fail_unless(window_mapped(*space), "Window not mapped in the borrower");
+
+    return borrower;
+}
+
+/*
+\begin{test}{IPCW0100}
+  \TestDescription{Unmapping a lent buffer closes the IPC window}
+  \TestFunctionalityTested{IPC windows, MapControl() system call}
+  \TestImplementationProcess{
+    \begin{enumerate}
+      \item Map a page and lend it read-only to a thread in another
+            space through an IPC window
+      \item Check that the window is mapped in the borrower's space
+      \item Unmap the page from the lender's space, without the lender
+            receiving a message
+      \item Check that the window is no longer mapped in the borrower's
+            space
+    \end{enumerate}
+  }
+  \TestImplementationStatus{Implemented}
+  \TestRegressionStatus{In regression test suite}
+  \TestIsFullyAutomated{Yes}
+\end{test}
+*/
+START_TEST(IPCW0100)
+{
+    L4_ThreadId_t borrower;
+    L4_SpaceId_t space;
+
+    map_lend_page(0);
+    borrower = open_window(&space);
+
+    unmap_lend_page();
+    fail_unless(!window_mapped(space),
+                "Borrower kept the window after the lender unmapped it");
+
+    deleteThread(borrower);
+}
+END_TEST
+
+/*
+\begin{test}{IPCW0200}
+  \TestDescription{Remapping a lent buffer closes the IPC window}
+  \TestFunctionalityTested{IPC windows, MapControl() system call}
+  \TestImplementationProcess{
+    \begin{enumerate}
+      \item Map a page and lend it read-only to a thread in another
+            space through an IPC window
+      \item Map a different frame over the lent page in the lender's
+            space
+      \item Check that the window is no longer mapped in the borrower's
+            space
+    \end{enumerate}
+  }
+  \TestImplementationStatus{Implemented}
+  \TestRegressionStatus{In regression test suite}
+  \TestIsFullyAutomated{Yes}
+\end{test}
+*/
+START_TEST(IPCW0200)
+{
+    L4_ThreadId_t borrower;
+    L4_SpaceId_t space;
+
+    map_lend_page(0);
+    borrower = open_window(&space);
+
+    map_lend_page(1);
+    fail_unless(!window_mapped(space),
+                "Borrower kept the window after the lender remapped it");
+
+    deleteThread(borrower);
+    unmap_lend_page();
+}
+END_TEST
+
+static void
+test_setup(void)
+{
+    initThreads(1);
+}
+
+static void
+test_teardown(void)
+{
+    initThreads(1);
+}
+
+TCase *
+make_ipc_window_tcase(void)
+{
+    TCase *tc;
+
+    tc = tcase_create("IPC Windows");
+    tcase_add_checked_fixture(tc, test_setup, test_teardown);
+    tcase_add_test(tc, IPCW0100);
+    tcase_add_test(tc, IPCW0200);
+
+    return tc;
+}
+
+#endif /* CONFIG_IPC_WINDOWS */
@@ -466,6 +466,104 @@ START_TEST(KMEM03)
 }
 END_TEST
 
+#define KMEM_CHURN_ROUNDS   256
+#define KMEM_CHURN_BATCH    8
+
+static int
+delete_churn_entry(int i, L4_SpaceId_t space)
+{
+    int res;
+
+    res = L4_ThreadControl(thread_offset(i + 3), L4_nilspace, L4_nilthread,
+            L4_nilthread, L4_nilthread, 0, (void *)0);
+    deleteSpace(space);
+
+    return res == 1 ? 0 : 1;
+}
+
+/*
+ * Create batches of address spaces, each holding a thread, then delete
+ * each batch in an interleaved order so that the freed memory has to be
+ * merged back together. Returns 0 on success.
+ */
+static int
+churn_spaces_and_threads(void)
+{
+    L4_SpaceId_t spaces[KMEM_CHURN_BATCH];
+    L4_Word_t result;
+    void *utcb;
+    int round, i, res;
+
+#ifdef NO_UTCB_RELOCATE
+    utcb = (void *)-1ul;
+#else
+    utcb = (void *)0xb10000;
+#endif
+
+    for (round = 0; round < KMEM_CHURN_ROUNDS; round++) {
+        for (i = 0; i < KMEM_CHURN_BATCH; i++) {
+            result = okl4_kspaceid_allocany(spaceid_pool, &spaces[i]);
+            FAIL_UNLESS(result == OKL4_OK, "Failed to allocate any space id.");
+            res = create_address_space(spaces[i], L4_Fpage(0xb10000, 0x1000));
+            FAIL_UNLESS(res == 1, "Failed to create address space");
+            res = L4_ThreadControl(thread_offset(i + 3), spaces[i],
+                    default_thread_handler, L4_nilthread, L4_nilthread, 0,
+                    utcb);
+            FAIL_UNLESS(res == 1, "Failed to create thread");
+        }
+
+        /* delete odd then even entries */
+        for (i = 1; i < KMEM_CHURN_BATCH; i += 2) {
+            FAIL_UNLESS(delete_churn_entry(i, spaces[i]) == 0,
+                        "Failed to delete thread");
+        }
+        for (i = 0; i < KMEM_CHURN_BATCH; i += 2) {
+            FAIL_UNLESS(delete_churn_entry(i, spaces[i]) == 0,
+                        "Failed to delete thread");
+        }
+    }
+
+    return 0;
+}
+
+/*
+\begin{test}{KMEM04}
+  \TestDescription{Check that repeatedly creating and deleting address spaces and threads does not fragment kernel memory}
+  \TestFunctionalityTested{Kernel memory allocator}
+  \TestImplementationProcess{
+    \begin{enumerate}
+      \item Create threads, then address spaces, until out of memory and delete them all
+      \item Create and delete 2048 address spaces, each with a thread, deleting every batch of 8 in interleaved order
+      \item Create threads, then address spaces, until out of memory and delete them all
+      \item Fail unless the same number of threads and address spaces could be created before and after
+    \end{enumerate}
+  }
+  \TestImplementationStatus{Implemented}
+  \TestIsFullyAutomated{Yes}
+  \TestRegressionStatus{In regression test suite}
+\end{test}
+*/
+START_TEST(KMEM04)
+{
+    int threads, threads2;
+    int spaces, spaces2;
+
+    /* the first call can return an inconsistent number, see KMEM02 */
+    threads = CreateMaxThreads();
+    threads = CreateMaxThreads();
+    spaces = CreateMaxSpaces();
+
+    fail_unless(churn_spaces_and_threads() == 0,
+                "Failed to create and delete spaces and threads\n");
+
+    threads2 = CreateMaxThreads();
+    spaces2 = CreateMaxSpaces();
+
+    fail_unless(threads == threads2, "Kernel memory fragmented, fewer threads could be created\n");
+    fail_unless(spaces == spaces2, "Kernel memory fragmented, fewer spaces could be created\n");
+}
+END_TEST
+
 extern L4_ThreadId_t test_tid;
 
 static void test_setup(void)
@@ -489,6 +587,7 @@ make_kmem_tcase(void)
     tcase_add_test(tc, KMEM01);
     tcase_add_test(tc, KMEM02);
     tcase_add_test(tc, KMEM03);
+    tcase_add_test(tc, KMEM04);
 
     return tc;
 }
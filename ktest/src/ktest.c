@@ -138,6 +138,9 @@ make_suite(void)
     TCASE(interrupt_control);
 #if defined(CONFIG_REMOTE_MEMORY_COPY)
     TCASE(remote_memcpy);
+#endif
+#if defined(CONFIG_IPC_WINDOWS)
+    TCASE(ipc_window);
 #endif
     return suite;
 }
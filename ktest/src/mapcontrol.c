@@ -1753,6 +1753,115 @@ START_TEST(MAP1400)
 }
 END_TEST
 
+/* Multi-page Map Item Tests -----------------------------------------------*/
+
+/*
+\begin{test}{MAP1500}
+   \TestDescription{Verify a map item with multiple pages maps and unmaps a contiguous run}
+   \TestFunctionalityTested{\Func{MapControl}}
+   \TestImplementationProcess{
+      \begin{enumerate}
+         \item Map a run of base pages with a single multi-page \Func{MapItem}
+         \item Check that every page in the run is mapped to the matching segment offset
+         \item Unmap the run with a single multi-page \Func{MapItem}
+         \item Check that no page in the run is mapped
+      \end{enumerate}
+   }
+   \TestImplementationStatus{Implemented}
+   \TestRegressionStatus{In regression test suite}
+   \TestIsFullyAutomated{Yes}
+\end{test}
+*/
+START_TEST(MAP1500)
+{
+    L4_MapItem_t map;
+    L4_Word_t n_pages, i, addr;
+    word_t f_offs, f_size, f_rwx;
+    int res;
+
+    n_pages = 256;
+    while (n_pages * BASE_PAGE_SIZE > kernel_test_segment_size) {
+        n_pages /= 2;
+    }
+
+    L4_MapItem_Map(&map, kernel_test_segment_id, 0, vbase, BASE_PAGE_BITS,
+                   L4_DefaultMemory, L4_FullyAccessible);
+    L4_MapItem_SetMultiplePages(&map, n_pages);
+    res = L4_ProcessMapItem(test_space, map);
+    fail_unless(res == 1, "Multi-page map failed");
+
+    for (i = 0; i < n_pages; i++) {
+        addr = vbase + i * BASE_PAGE_SIZE;
+        res = L4_WBT_GetMapping(test_space, addr, kernel_test_segment_id,
+                                &f_offs, &f_size, NULL, &f_rwx);
+        fail_unless(res == 1, "Page in run not mapped");
+        /* The run may have been mapped with larger pages. */
+        fail_unless(f_size >= BASE_PAGE_BITS, "Incorrect mapping size");
+        fail_unless(f_offs == ((i * BASE_PAGE_SIZE) & ~((1UL << f_size) - 1)),
+                    "Incorrect phys base read");
+        fail_unless(f_rwx == L4_FullyAccessible, "Incorrect permissions read");
+    }
+
+    L4_MapItem_Unmap(&map, vbase, BASE_PAGE_BITS);
+    L4_MapItem_SetMultiplePages(&map, n_pages);
+    res = L4_ProcessMapItem(test_space, map);
+    fail_unless(res == 1, "Multi-page unmap failed");
+
+    for (i = 0; i < n_pages; i++) {
+        check_no_mapping(test_space,
+                         L4_Fpage(vbase + i * BASE_PAGE_SIZE, BASE_PAGE_SIZE));
+    }
+}
+END_TEST
+
+/*
+\begin{test}{MAP1501}
+   \TestDescription{Verify MapControl rejects invalid multi-page runs}
+   \TestFunctionalityTested{\Func{MapControl}}
+   \TestImplementationProcess{
+      \begin{enumerate}
+         \item Call \Func{MapControl} with a \Func{MapItem} of zero pages
+         \item Call \Func{MapControl} with a run extending past the end of the segment
+         \item Call \Func{MapControl} with a run longer than \Func{L4\_MAX\_MAP\_RUN\_PAGES}
+         \item Check that all calls fail with an invalid parameter error and map nothing
+      \end{enumerate}
+   }
+   \TestImplementationStatus{Implemented}
+   \TestRegressionStatus{In regression test suite}
+   \TestIsFullyAutomated{Yes}
+\end{test}
+*/
+START_TEST(MAP1501)
+{
+    L4_MapItem_t map;
+    int res;
+
+    L4_MapItem_Map(&map, kernel_test_segment_id, 0, vbase, BASE_PAGE_BITS,
+                   L4_DefaultMemory, L4_FullyAccessible);
+    L4_MapItem_SetMultiplePages(&map, 0);
+    res = L4_ProcessMapItem(test_space, map);
+    fail_unless(res == 0, "Map of zero pages succeeded");
+    fail_unless(__L4_TCR_ErrorCode() == 5, "L4 error code is incorrect");
+
+    L4_MapItem_Map(&map, kernel_test_segment_id, 0, vbase, BASE_PAGE_BITS,
+                   L4_DefaultMemory, L4_FullyAccessible);
+    L4_MapItem_SetMultiplePages(&map,
+                                kernel_test_segment_size / BASE_PAGE_SIZE + 1);
+    res = L4_ProcessMapItem(test_space, map);
+    fail_unless(res == 0, "Map past the end of the segment succeeded");
+    fail_unless(__L4_TCR_ErrorCode() == 5, "L4 error code is incorrect");
+
+    L4_MapItem_Unmap(&map, vbase, BASE_PAGE_BITS);
+    L4_MapItem_SetMultiplePages(&map, L4_MAX_MAP_RUN_PAGES + 1);
+    res = L4_ProcessMapItem(test_space, map);
+    fail_unless(res == 0, "Overlong run succeeded");
+    fail_unless(__L4_TCR_ErrorCode() == 5, "L4 error code is incorrect");
+
+    check_no_mapping(test_space, L4_Fpage(vbase, BASE_PAGE_SIZE));
+    CLEAR_ERROR_CODE;
+}
+END_TEST
+
 /* -------------------------------------------------------------------------*/
 extern L4_ThreadId_t test_tid;
 
@@ -1821,5 +1930,8 @@ make_mapcontrol_tcase(void)
     tcase_add_test(tc, MAP1300);
     tcase_add_test(tc, MAP1400);
 
+    tcase_add_test(tc, MAP1500);
+    tcase_add_test(tc, MAP1501);
+
     return tc;
 }
@@ -1078,6 +1078,82 @@ START_TEST(MUTEX0700)
 }
 END_TEST
 
+#define NUM_BANDED_CHILDREN 24
+#define NUM_BANDS           4
+
+/*
+\begin{test}{MUTEX0710}
+  \TestDescription{Ensure threads of equal priority acquire a contended
+          mutex in the order they blocked on it.}
+  \TestFunctionalityTested{\Func{L4\_Lock} and \Func{L4\_Unlock}}
+  \TestImplementationProcess{
+    \begin{enumerate}
+        \item Create and lock a mutex.
+        \item Create 24 threads spread over 4 priorities, each which
+              attempt to lock that mutex.
+        \item Ensure that when the mutex is unlocked, threads acquire it
+              in priority order, and in blocking order within each
+              priority.
+    \end{enumerate}
+  }
+  \TestPassStatus{pass}
+  \TestImplementationStatus{Implemented}
+  \TestRegressionStatus{In regression test suite}
+\end{test}
+*/
+START_TEST(MUTEX0710)
+{
+    L4_Word_t res;
+    L4_ThreadId_t children[NUM_BANDED_CHILDREN];
+    L4_ThreadId_t from_thread;
+    int band, i;
+
+    res = okl4_kmutexid_allocany(mutexid_pool, &m);
+    fail_unless(res == OKL4_OK, "Failed to allocate any mutex id.");
+    /* Create a mutex. */
+    res = L4_CreateMutex(m);
+    fail_unless(res == 1, "L4_CreateMutex() failed");
+
+    /* Lock the mutex. */
+    res = L4_Lock(m);
+    fail_unless(res == 1, "L4_Lock() failed");
+
+    /* Create our contesting children, interleaving their priorities. */
+    for (i = 0; i < NUM_BANDED_CHILDREN; i++) {
+        L4_ThreadId_t child;
+        child = children[i] = createThread(mutex0700_child_thread);
+
+        /* Let our child run until they hit the lock. */
+        L4_Set_Priority(child, 255);
+        L4_ThreadSwitch(child);
+
+        /* Give the child a low priority. */
+        L4_Set_Priority(child, (i % NUM_BANDS) + 1);
+    }
+
+    /* Allow children to access the lock. */
+    L4_Unlock(m);
+
+    /* Ensure children get the mutex in priority order, and FIFO within
+     * each priority. */
+    for (band = NUM_BANDS - 1; band >= 0; band--) {
+        for (i = band; i < NUM_BANDED_CHILDREN; i += NUM_BANDS) {
+            L4_Wait(&from_thread);
+            fail_unless(from_thread.raw == lookupReplyHandle(children[i]).raw,
+                    "Threads not released in priority and FIFO order.");
+        }
+    }
+
+    /* Delete our children. */
+    for (i = 0; i < NUM_BANDED_CHILDREN; i++) {
+        deleteThread(children[i]);
+    }
+
+    L4_DeleteMutex(m);
+    okl4_kmutexid_free(mutexid_pool, m);
+}
+END_TEST
+
 static void mutex0705_low_thread(void)
 {
     /* Acquire the mutex. */
@@ -1217,6 +1293,7 @@ make_mutex_tcase(void)
     tcase_add_test(tc, MUTEX0501);
     tcase_add_test(tc, MUTEX0600);
     tcase_add_test(tc, MUTEX0700);
+    tcase_add_test(tc, MUTEX0710);
     tcase_add_test(tc, MUTEX0705);
 
     return tc;
@@ -1049,6 +1049,91 @@ START_TEST(SCHED1400)
     }
 }
 END_TEST
+/* Run queue tests --------------------------------------------*/
+
+#define NUM_QUEUED_THREADS  8
+
+static volatile L4_ThreadId_t g_queued_threads[NUM_QUEUED_THREADS];
+static volatile L4_Word_t g_queued_runs[NUM_QUEUED_THREADS];
+
+/*
+ * A thread that records that it has run once released, then halts.
+ */
+static void
+queued_thread(L4_ThreadId_t me)
+{
+    int i;
+
+    while (!g_started)
+        ;
+
+    for (i = 0; i < NUM_QUEUED_THREADS; i++) {
+        if (g_queued_threads[i].raw == me.raw) {
+            g_queued_runs[i]++;
+        }
+    }
+
+    /* Halt */
+    L4_Send(me);
+}
+
+/*
+\begin{test}{SCHED1500}
+  \TestDescription{Verify every queued thread is scheduled exactly once}
+  \TestFunctionalityTested{Ready queue management, work stealing between hardware units}
+  \TestImplementationProcess{
+    \begin{enumerate}
+      \item Raise the priority of the main thread
+      \item Create several threads, each with a distinct priority lower than the main thread
+      \item Release the threads and drop the priority of the main thread below theirs
+      \item Wait for the threads to run, yielding in between
+      \item Check that each thread ran exactly once
+    \end{enumerate}
+  }
+  \TestImplementationStatus{Implemented}
+  \TestRegressionStatus{In regression test suite}
+  \TestIsFullyAutomated{Yes}
+\end{test}
+*/
+START_TEST(SCHED1500)
+{
+    L4_Word_t result;
+    int i, tries;
+
+    g_started = 0;
+    result = L4_Set_Priority(main_thread, 160);
+    fail_unless(result != L4_SCHEDRESULT_ERROR,
+                "L4_Set_Priority() failed to set the new priority");
+
+    for (i = 0; i < NUM_QUEUED_THREADS; i++) {
+        g_queued_runs[i] = 0;
+        g_queued_threads[i] = createThread((void (*)(void))queued_thread);
+        result = L4_Set_Priority(g_queued_threads[i], 150 + i);
+        fail_unless(result != L4_SCHEDRESULT_ERROR,
+                    "L4_Set_Priority() failed to set the new priority");
+    }
+
+    /* Let the threads go, and get out of their way. */
+    g_started = 1;
+    result = L4_Set_Priority(main_thread, 149);
+    fail_unless(result != L4_SCHEDRESULT_ERROR,
+                "L4_Set_Priority() failed to set the new priority");
+
+    for (i = 0; i < NUM_QUEUED_THREADS; i++) {
+        for (tries = 0; g_queued_runs[i] == 0 && tries < 1000; tries++) {
+            L4_Yield();
+        }
+        _fail_unless(g_queued_runs[i] == 1, __FILE__, __LINE__,
+                     "Thread at priority %d ran %d times", 150 + i,
+                     (int)g_queued_runs[i]);
+    }
+
+    for (i = 0; i < NUM_QUEUED_THREADS; i++) {
+        deleteThread(g_queued_threads[i]);
+    }
+}
+END_TEST
+
 /* -------------------------------------------------------------------------*/
 
 extern L4_ThreadId_t test_tid;
@@ -1095,6 +1180,7 @@ make_schedule_tcase(void)
     }
     tcase_add_test(tc, SCHED1300);
     tcase_add_test(tc, SCHED1400);
+    tcase_add_test(tc, SCHED1500);
     
     return tc;
 }
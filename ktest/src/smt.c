@@ -725,6 +725,216 @@ START_TEST(SMT0600)
 }
 END_TEST
 
+#define CAP_LOOKUP_THREADS      3
+#define CAP_LOOKUP_ITERATIONS   2000
+
+static volatile L4_ThreadId_t cap_lookup_victim;
+static volatile int cap_lookup_cleanup;
+
+static void
+cap_lookup_victim_thread (void)
+{
+    L4_WaitForever();
+}
+
+static void
+cap_lookup_thread (void)
+{
+    int thrd_num = get_thread_num(L4_Myself());
+    L4_ThreadId_t victim;
+    L4_Word_t dummy;
+
+    while(cap_lookup_cleanup == 0) {
+        victim = cap_lookup_victim;
+
+        /* Lookup via the IPC cap path. */
+        (void)L4_Send_Nonblocking(victim);
+        /* Lookup via the thread cap path. */
+        (void)L4_ExchangeRegisters(victim, L4_ExReg_Deliver,
+                                   0, 0, 0, 0, L4_nilthread,
+                                   &dummy, &dummy, &dummy, &dummy, &dummy);
+        counter[thrd_num]++;
+    }
+
+    L4_Call(L4_Myself());
+}
+
+/*
+\begin{test}{SMT0700}
+  \TestDescription{Capability lookups racing capability insertion and removal}
+  \TestFunctionalityTested{Clist lookups, Thread locks, SMT}
+  \TestImplementationProcess{
+    Three threads are constrained to different hardware threads. Each
+    repeatedly sends to and exchanges registers with a victim thread, which
+    looks up its cap on the IPC and thread cap paths. Meanwhile the main
+    thread repeatedly deletes and recreates the victim, which inserts and
+    removes its cap and reuses its TCB.
+    This test passes if the kernel survives and the lookup threads make
+    progress.
+}
+  \TestImplementationStatus{Implemented}
+  \TestIsFullyAutomated{Yes}
+  \TestRegressionStatus{In regression test suite}
+  \TestNotes{Hardware constraint specification is only used on supported
+    architectures. For others, the threads will execute round robin.}
+    \TestSeeAlso{See document \emph{L4 SMT Support} 10020:2005}
+\end{test}
+*/
+START_TEST(SMT0700)
+{
+    L4_ThreadId_t rthread[CAP_LOOKUP_THREADS];
+    L4_ThreadId_t victim;
+    int i;
+
+    cap_lookup_cleanup = 0;
+    clear_counters(MAX_THREADS);
+
+    changeThreadCreationSMTBitmask(1);
+    cap_lookup_victim = createThreadInSpace(L4_nilthread,
+                                            cap_lookup_victim_thread);
+
+    for (i = 0; i < CAP_LOOKUP_THREADS; i++) {
+        changeThreadCreationSMTBitmask(2 << i);
+        rthread[i] = createThreadInSpace(L4_nilthread, cap_lookup_thread);
+    }
+
+    changeThreadCreationSMTBitmask(1);
+    for (i = 0; i < CAP_LOOKUP_ITERATIONS; i++) {
+        victim = cap_lookup_victim;
+        deleteThread(victim);
+        /* The freed slot is reused, so the lookups hit the same cap id. */
+        cap_lookup_victim = createThreadInSpace(L4_nilthread,
+                                                cap_lookup_victim_thread);
+    }
+
+    cap_lookup_cleanup = 1;
+    L4_ThreadSwitch(main_thread);
+    sleep_a_bit();
+
+    for (i = 0; i < CAP_LOOKUP_THREADS; i++) {
+        fail_unless(counter[get_thread_num(rthread[i])] > 0,
+                    "cap lookup thread made no progress");
+        deleteThread(rthread[i]);
+    }
+    deleteThread(cap_lookup_victim);
+}
+END_TEST
+
+#define RESCHED_FLOODERS        3
+#define RESCHED_TARGETS         2
+#define RESCHED_ITERATIONS      10000
+
+static volatile L4_ThreadId_t resched_target[RESCHED_TARGETS];
+static volatile int resched_cleanup;
+
+static void
+resched_target_thread (void)
+{
+    int thrd_num = get_thread_num(L4_Myself());
+    L4_Word_t mask;
+
+    L4_Set_NotifyMask(~0UL);
+    L4_Accept(L4_NotifyMsgAcceptor);
+
+    while(resched_cleanup == 0) {
+        (void)L4_WaitNotify(&mask);
+        counter[thrd_num]++;
+    }
+
+    L4_Call(L4_Myself());
+}
+
+static void
+resched_flood_thread (void)
+{
+    int thrd_num = get_thread_num(L4_Myself());
+    int i;
+
+    for (i = 0; i < RESCHED_ITERATIONS; i++) {
+        /* Each wakeup of a target asks its unit to reschedule. */
+        (void)L4_Notify(resched_target[i % RESCHED_TARGETS], 1);
+        counter[thrd_num]++;
+    }
+
+    L4_Call(L4_Myself());
+}
+
+/*
+\begin{test}{SMT0800}
+  \TestDescription{Flood a hardware thread with remote reschedule requests}
+  \TestFunctionalityTested{Global scheduler, Cross-unit requests, SMT}
+  \TestImplementationProcess{
+    Two target threads constrained to one hardware thread wait for
+    notifications. Three threads constrained to other hardware threads
+    notify the targets as fast as they can, so that every wakeup is a
+    request to reschedule the targets' hardware thread.
+    This test passes if all requests are sent and the targets keep being
+    woken up.
+}
+  \TestImplementationStatus{Implemented}
+  \TestIsFullyAutomated{Yes}
+  \TestRegressionStatus{In regression test suite}
+  \TestNotes{Hardware constraint specification is only used on supported
+    architectures. For others, the threads will execute round robin.}
+    \TestSeeAlso{See document \emph{L4 SMT Support} 10020:2005}
+\end{test}
+*/
+START_TEST(SMT0800)
+{
+    L4_ThreadId_t target[RESCHED_TARGETS];
+    L4_ThreadId_t flooder[RESCHED_FLOODERS];
+    int i, tries;
+    int done;
+
+    resched_cleanup = 0;
+    clear_counters(MAX_THREADS);
+
+    changeThreadCreationSMTBitmask(1);
+    for (i = 0; i < RESCHED_TARGETS; i++) {
+        target[i] = createThreadInSpace(L4_nilthread, resched_target_thread);
+        resched_target[i] = target[i];
+    }
+
+    for (i = 0; i < RESCHED_FLOODERS; i++) {
+        changeThreadCreationSMTBitmask(2 << i);
+        flooder[i] = createThreadInSpace(L4_nilthread, resched_flood_thread);
+    }
+
+    /* Wait for the flooders to send all their requests. */
+    for (tries = 0; tries < 100; tries++) {
+        L4_ThreadSwitch(main_thread);
+        sleep_a_bit();
+
+        done = 1;
+        for (i = 0; i < RESCHED_FLOODERS; i++) {
+            if (counter[get_thread_num(flooder[i])] < RESCHED_ITERATIONS) {
+                done = 0;
+            }
+        }
+        if (done) {
+            break;
+        }
+    }
+
+    /* Let the targets see the cleanup flag. */
+    resched_cleanup = 1;
+    for (i = 0; i < RESCHED_TARGETS; i++) {
+        (void)L4_Notify(target[i], 1);
+    }
+    sleep_a_bit();
+
+    fail_unless(done, "reschedule flood did not complete");
+    for (i = 0; i < RESCHED_TARGETS; i++) {
+        fail_unless(counter[get_thread_num(target[i])] > 0,
+                    "reschedule target was never woken up");
+        deleteThread(target[i]);
+    }
+    for (i = 0; i < RESCHED_FLOODERS; i++) {
+        deleteThread(flooder[i]);
+    }
+}
+END_TEST
+
 
 extern L4_ThreadId_t test_tid;
 
@@ -758,6 +968,8 @@ make_smt_tcase(void)
     tcase_add_test(tc, SMT0304);
     tcase_add_test(tc, SMT0500);
     tcase_add_test(tc, SMT0600);
+    tcase_add_test(tc, SMT0700);
+    tcase_add_test(tc, SMT0800);
 
     return tc;
 }
@@ -63,6 +63,7 @@
 #define _STRING_H_
 
 #include <stddef.h>
+#include <arch/string.h>
 
 /* 7.21.2 Copying functions */
 void *memcpy(void *s1, const void *s2, size_t n);
@@ -89,7 +89,9 @@
 
 /* copy n bytes from s to d; the regions must not overlap */
 /* THREAD SAFE */
-#if !defined(CONFIG_SPEED)
+#if defined(__ARCH_HAS_MEMCPY)
+/* Provided by the architecture */
+#elif !defined(CONFIG_SPEED)
 void *
 memcpy(void *d, const void *s, size_t n)
 {
@@ -104,24 +106,47 @@ memcpy(void *d, const void *s, size_t n)
 void *
 memcpy(void *d, const void *s, size_t n)
 {
-    size_t i;
     uintptr_t align = sizeof(uintptr_t) - 1;
+    unsigned char *bd = (unsigned char *)d;
+    const unsigned char *bs = (const unsigned char *)s;
 
-    if (((uintptr_t)d & align) || ((uintptr_t)s & align) || (n & align)) {
-        char *bs = (char *)s;
-        char *bd = (char *)d;
+    /*
+     * Word copies are only possible when source and destination share the
+     * same alignment; copy bytes up to the first word boundary first.
+     */
+    if ((((uintptr_t)bd ^ (uintptr_t)bs) & align) == 0) {
+        uintptr_t *wd;
+        const uintptr_t *ws;
 
-        /* XXX - optimize this */
-        for (i = 0; i < n; i++)
+        while (n && ((uintptr_t)bd & align)) {
             *bd++ = *bs++;
-    } else {                    /* memcpy - word aligned */
-        uintptr_t *ws = (uintptr_t *)s;
-        uintptr_t *wd = (uintptr_t *)d;
+            n--;
+        }
 
-        n /= sizeof(uintptr_t);
+        wd = (uintptr_t *)bd;
+        ws = (const uintptr_t *)bs;
 
-        for (i = 0; i < n; i++)
+        /* simple hand unrolled loop */
+        while (n >= 4 * sizeof(uintptr_t)) {
+            wd[0] = ws[0];
+            wd[1] = ws[1];
+            wd[2] = ws[2];
+            wd[3] = ws[3];
+            wd += 4;
+            ws += 4;
+            n -= 4 * sizeof(uintptr_t);
+        }
+        while (n >= sizeof(uintptr_t)) {
             *wd++ = *ws++;
+            n -= sizeof(uintptr_t);
+        }
+
+        bd = (unsigned char *)wd;
+        bs = (const unsigned char *)ws;
+    }
+
+    while (n--) {
+        *bd++ = *bs++;
     }
     return d;
 }
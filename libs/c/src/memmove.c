@@ -88,6 +88,7 @@
 
 /* copy n bytes from s to d, even if the regions overlap */
 /* THREAD SAFE */
+#if !defined(__ARCH_HAS_MEMMOVE)
 void *
 memmove(void *d, const void *s, size_t n)
 {
@@ -103,3 +104,4 @@ memmove(void *d, const void *s, size_t n)
         return d;
     }
 }
+#endif
@@ -91,7 +91,9 @@
 /*
  * Fill memory at s with (n) * byte value 'c'
  */
-#if !defined(CONFIG_SPEED)
+#if defined(__ARCH_HAS_MEMSET)
+/* Provided by the architecture */
+#elif !defined(CONFIG_SPEED)
 void *
 memset(void *s, int c, size_t n)
 {
@@ -1752,6 +1752,152 @@ START_TEST(strxfrm_test)
 }
 END_TEST
 
+/*
+ * Randomised checks of the block memory functions against a byte-at-a-time
+ * reference, over every combination of source and destination alignment.
+ * Guard bytes either side of the destination catch over-runs.
+ */
+#define MEMTEST_BUF     320
+#define MEMTEST_GUARD   16
+#define MEMTEST_ROUNDS  2000
+
+static unsigned char memtest_src[MEMTEST_BUF + 2 * MEMTEST_GUARD];
+static unsigned char memtest_dst[MEMTEST_BUF + 2 * MEMTEST_GUARD];
+static unsigned char memtest_ref[MEMTEST_BUF + 2 * MEMTEST_GUARD];
+static unsigned long memtest_seed;
+
+static unsigned long
+memtest_rand(void)
+{
+    memtest_seed = memtest_seed * 1103515245UL + 12345UL;
+    return (memtest_seed >> 8) & 0xffffff;
+}
+
+static void
+memtest_fill(unsigned char *buf, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        buf[i] = (unsigned char)memtest_rand();
+    }
+}
+
+/* Pick an offset and length that fit in the test buffer. */
+static void
+memtest_pick(size_t *dst_off, size_t *src_off, size_t *n)
+{
+    *dst_off = memtest_rand() % 8;
+    *src_off = memtest_rand() % 8;
+    if (memtest_rand() & 1) {
+        *n = memtest_rand() % 64;
+    } else {
+        *n = memtest_rand() % (MEMTEST_BUF - 8);
+    }
+}
+
+START_TEST(memcpy_fuzz)
+{
+    size_t i, j, dst_off, src_off, n;
+    void *ret;
+
+    memtest_seed = 1;
+    for (i = 0; i < MEMTEST_ROUNDS; i++) {
+        memtest_pick(&dst_off, &src_off, &n);
+        memtest_fill(memtest_src, sizeof(memtest_src));
+        memtest_fill(memtest_dst, sizeof(memtest_dst));
+        for (j = 0; j < sizeof(memtest_dst); j++) {
+            memtest_ref[j] = memtest_dst[j];
+        }
+        for (j = 0; j < n; j++) {
+            memtest_ref[MEMTEST_GUARD + dst_off + j] =
+                memtest_src[MEMTEST_GUARD + src_off + j];
+        }
+
+        ret = memcpy(memtest_dst + MEMTEST_GUARD + dst_off,
+                     memtest_src + MEMTEST_GUARD + src_off, n);
+
+        fail_unless(ret == memtest_dst + MEMTEST_GUARD + dst_off,
+                    "memcpy returns the destination");
+        for (j = 0; j < sizeof(memtest_dst); j++) {
+            fail_unless(memtest_dst[j] == memtest_ref[j],
+                        "memcpy result matches the reference copy");
+        }
+    }
+}
+END_TEST
+
+START_TEST(memmove_fuzz)
+{
+    size_t i, j, dst_off, src_off, n;
+    void *ret;
+
+    memtest_seed = 2;
+    for (i = 0; i < MEMTEST_ROUNDS; i++) {
+        /* Overlapping regions within the one buffer, in both directions. */
+        memtest_pick(&dst_off, &src_off, &n);
+        if (n > MEMTEST_BUF - 64) {
+            n = MEMTEST_BUF - 64;
+        }
+        if (memtest_rand() & 1) {
+            dst_off += memtest_rand() % 56;
+        } else {
+            src_off += memtest_rand() % 56;
+        }
+        memtest_fill(memtest_dst, sizeof(memtest_dst));
+        for (j = 0; j < sizeof(memtest_dst); j++) {
+            memtest_ref[j] = memtest_dst[j];
+        }
+        for (j = 0; j < n; j++) {
+            memtest_src[j] = memtest_dst[MEMTEST_GUARD + src_off + j];
+        }
+        for (j = 0; j < n; j++) {
+            memtest_ref[MEMTEST_GUARD + dst_off + j] = memtest_src[j];
+        }
+
+        ret = memmove(memtest_dst + MEMTEST_GUARD + dst_off,
+                      memtest_dst + MEMTEST_GUARD + src_off, n);
+
+        fail_unless(ret == memtest_dst + MEMTEST_GUARD + dst_off,
+                    "memmove returns the destination");
+        for (j = 0; j < sizeof(memtest_dst); j++) {
+            fail_unless(memtest_dst[j] == memtest_ref[j],
+                        "memmove result matches the reference copy");
+        }
+    }
+}
+END_TEST
+
+START_TEST(memset_fuzz)
+{
+    size_t i, j, dst_off, src_off, n;
+    int c;
+    void *ret;
+
+    memtest_seed = 3;
+    for (i = 0; i < MEMTEST_ROUNDS; i++) {
+        memtest_pick(&dst_off, &src_off, &n);
+        c = (int)memtest_rand();
+        memtest_fill(memtest_dst, sizeof(memtest_dst));
+        for (j = 0; j < sizeof(memtest_dst); j++) {
+            memtest_ref[j] = memtest_dst[j];
+        }
+        for (j = 0; j < n; j++) {
+            memtest_ref[MEMTEST_GUARD + dst_off + j] = (unsigned char)c;
+        }
+
+        ret = memset(memtest_dst + MEMTEST_GUARD + dst_off, c, n);
+
+        fail_unless(ret == memtest_dst + MEMTEST_GUARD + dst_off,
+                    "memset returns the destination");
+        for (j = 0; j < sizeof(memtest_dst); j++) {
+            fail_unless(memtest_dst[j] == memtest_ref[j],
+                        "memset result matches the reference fill");
+        }
+    }
+}
+END_TEST
+
 Suite *
 make_test_libs_c_suite(void)
 {
@@ -1991,6 +2137,12 @@ make_test_libs_c_suite(void)
     tcase_add_test(tc, strxfrm_test);
     suite_add_tcase(suite, tc);
 
+    tc = tcase_create("memops");
+    tcase_add_test(tc, memcpy_fuzz);
+    tcase_add_test(tc, memmove_fuzz);
+    tcase_add_test(tc, memset_fuzz);
+    suite_add_tcase(suite, tc);
+
     tc = tcase_create("environment");
     tcase_add_test(tc, environment);
     suite_add_tcase(suite, tc);
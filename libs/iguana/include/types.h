@@ -142,6 +142,14 @@ typedef struct iguana_stats
     size_t session_node_size;
 //#endif
     size_t thread_size;
+
+    /* Counters, sampled when the statistics are requested. */
+    size_t sync_syscalls;
+    size_t sync_bytes;
+    size_t security_cache_hits;
+    size_t security_cache_misses;
+    size_t slab_pages;
+    size_t slab_reclaims;
 } iguana_stats_t;
 
 #endif /* _IGUANA_TYPES_H_ */
@@ -72,6 +72,7 @@
 #include <iguana/cap.h>
 #include <iguana/eas.h>
 #include <iguana/object.h>
+#include <iguana/stats.h>
 #include "test_libs_iguana.h"
 
 #include <interfaces/iguana_client.h>
@@ -191,6 +192,114 @@ START_TEST(CAP0500)
 }
 END_TEST
 
+#if defined(CONFIG_STATS)
+/*
+ * Capability check cache: make repeated RPCs that check a cap while
+ * several clists are attached to our pd, and report the cache hit rate.
+ * Changing a clist must invalidate the cached result, so repeating the
+ * calls with a clist change before each one times the uncached path.
+ */
+#define CAP0600_CLISTS 4
+#define CAP0600_CALLS 1000
+
+/* Remove and re-insert a cap, which invalidates every cached check. */
+static void
+cap0600_change_clist(clist_ref_t clist, cap_t cap)
+{
+    int status;
+
+    status = clist_remove(clist, cap);
+    fail_unless(status == 0, "clist_remove failed");
+    status = clist_insert(clist, cap);
+    fail_unless(status == 0, "clist_insert failed");
+}
+
+START_TEST(CAP0600)
+{
+    clist_ref_t clist[CAP0600_CLISTS];
+    memsection_ref_t ref, other[CAP0600_CLISTS];
+    struct stats_snapshot before, after, changed, final;
+    uintptr_t base, other_base, paddr;
+    size_t size, hits, misses;
+    cap_t cap;
+    int i, status;
+
+    ref = memsection_create(MEM_SIZE, &base);
+    fail_if(ref == 0, "reference not zero");
+    for (i = 0; i < CAP0600_CLISTS; i++) {
+        clist[i] = clist_create();
+        fail_if(clist[i] == 0, "reference not zero");
+        other[i] = memsection_create(MEM_SIZE, &other_base);
+        fail_if(other[i] == 0, "reference not zero");
+        status = clist_insert(clist[i], iguana_get_cap(other[i], READ_IID));
+        fail_unless(status == 0, "clist_insert failed");
+        pd_add_clist(pd_myself(), clist[i]);
+    }
+    cap = iguana_get_cap(other[0], READ_IID);
+
+    fail_unless(stats_snapshot_take(&before) == 0,
+                "Failed to get statistics");
+    for (i = 0; i < CAP0600_CALLS; i++) {
+        paddr = memsection_virt_to_phys(base, &size);
+        fail_if(paddr == (uintptr_t)-2, "security check failed");
+    }
+    fail_unless(stats_snapshot_take(&after) == 0,
+                "Failed to get statistics");
+
+    /* The cost of changing the clist alone, to subtract from below. */
+    for (i = 0; i < CAP0600_CALLS; i++) {
+        cap0600_change_clist(clist[0], cap);
+    }
+    fail_unless(stats_snapshot_take(&changed) == 0,
+                "Failed to get statistics");
+    for (i = 0; i < CAP0600_CALLS; i++) {
+        cap0600_change_clist(clist[0], cap);
+        paddr = memsection_virt_to_phys(base, &size);
+        fail_if(paddr == (uintptr_t)-2, "security check failed");
+    }
+    fail_unless(stats_snapshot_take(&final) == 0,
+                "Failed to get statistics");
+
+    if (before.ms != 0 && after.ms != 0 && changed.ms != 0 &&
+            final.ms != 0) {
+        hits = STATS_DELTA(&before, &after, security_cache_hits);
+        misses = STATS_DELTA(&before, &after, security_cache_misses);
+        if (hits + misses == 0) {
+            printf("CAP0600: capability checks are disabled\n");
+        } else {
+            printf("CAP0600: %lu security checks, %lu hits, %lu misses\n",
+                   (unsigned long)(hits + misses), (unsigned long)hits,
+                   (unsigned long)misses);
+            fail_unless(hits >= CAP0600_CALLS - CAP0600_CLISTS,
+                        "Security checks were not cached");
+            fail_unless(STATS_DELTA(&changed, &final,
+                                    security_cache_misses) >=
+                        CAP0600_CALLS,
+                        "Cached check survived a clist change");
+        }
+        if (before.time != 0) {
+            printf("CAP0600: %d calls in %lu us cached, %lu us uncached; "
+                   "the clist changes alone took %lu us\n", CAP0600_CALLS,
+                   (unsigned long)(after.time - before.time),
+                   (unsigned long)(final.time - changed.time),
+                   (unsigned long)(changed.time - after.time));
+        }
+    }
+
+    stats_snapshot_release(&before);
+    stats_snapshot_release(&after);
+    stats_snapshot_release(&changed);
+    stats_snapshot_release(&final);
+    for (i = 0; i < CAP0600_CLISTS; i++) {
+        pd_release_clist(pd_myself(), clist[i], 0);
+        clist_delete(clist[i]);
+        memsection_delete(other[i]);
+    }
+    memsection_delete(ref);
+}
+END_TEST
+#endif
+
 TCase *
 cap_tests()
 {
@@ -202,6 +311,9 @@ cap_tests()
     tcase_add_test(tc, CAP0300);
     tcase_add_test(tc, CAP0400);
     tcase_add_test(tc, CAP0500);
+#if defined(CONFIG_STATS)
+    tcase_add_test(tc, CAP0600);
+#endif
 
     return tc;
 }
@@ -76,6 +76,7 @@
 #include <iguana/cap.h>
 #include <iguana/eas.h>
 #include <iguana/object.h>
+#include <iguana/stats.h>
 #include "test_libs_iguana.h"
 
 #include <interfaces/iguana_client.h>
@@ -1245,6 +1246,162 @@ START_TEST(MEMS2900)
 }
 END_TEST
 
+/*
+ * Fault path with a large object table.  Memsections are handed out in
+ * ascending address order, which is the worst case for an unbalanced
+ * table; every lookup and fault below must still resolve correctly.
+ * The fault loop is timed against the kernel clock for comparison
+ * between builds.
+ */
+#define MANY_MEMSECTIONS 10000
+#define FAULT_PAGES 16
+
+START_TEST(MEMS3000)
+{
+    static memsection_ref_t refs[MANY_MEMSECTIONS];
+    static uintptr_t bases[MANY_MEMSECTIONS];
+    memsection_ref_t ms;
+    thread_ref_t server;
+    uintptr_t base;
+    uint64_t start, end;
+    int i, n;
+
+    for (n = 0; n < MANY_MEMSECTIONS; n++) {
+        refs[n] = memsection_create_user(PAGE_SIZE, &bases[n]);
+        if (refs[n] == 0) {
+            break;
+        }
+    }
+    fail_unless(n == MANY_MEMSECTIONS, "Failed to create memsections");
+
+    for (i = 0; i < n; i++) {
+        fail_unless(memsection_lookup(bases[i] + PAGE_SIZE / 2, &server) ==
+                    refs[i], "not the right mem section");
+    }
+
+    /* The newest memsection is the deepest one in an unbalanced table. */
+    ms = memsection_create(FAULT_PAGES * PAGE_SIZE, &base);
+    fail_if(ms == 0, "reference not zero");
+    if (ms != 0) {
+        start = test_time_usec();
+        for (i = 0; i < FAULT_PAGES; i++) {
+            *((volatile int *)(base + i * PAGE_SIZE)) = i;
+        }
+        end = test_time_usec();
+        if (start != 0) {
+            printf("MEMS3000: %d faults with %d memsections in %lu us\n",
+                   FAULT_PAGES, n, (unsigned long)(end - start));
+        }
+        for (i = 0; i < FAULT_PAGES; i++) {
+            fail_unless(*((volatile int *)(base + i * PAGE_SIZE)) == i,
+                        "page not mapped correctly");
+        }
+        memsection_delete(ms);
+    }
+
+    for (i = 0; i < n; i++) {
+        memsection_delete(refs[i]);
+    }
+}
+END_TEST
+
+#if defined(CONFIG_STATS)
+/*
+ * Report how many MapControl calls the server makes per megabyte when a
+ * physically contiguous physmem is mapped into a memsection.  The counts
+ * also include attaching the first statistics snapshot.
+ */
+#define SYNC_SIZE (1024 * 1024)
+
+START_TEST(MEMS3100)
+{
+    struct stats_snapshot before, after;
+    memsection_ref_t ms;
+    physmem_ref_t pm;
+    uintptr_t base;
+    size_t syscalls, bytes, per_mb;
+    int res;
+
+    ms = memsection_create_user(SYNC_SIZE, &base);
+    fail_if(ms == 0, "reference not zero");
+    pm = physpool_alloc(default_physpool, SYNC_SIZE);
+    fail_if(pm == INVALID_ADDR, "Failed to create the new Physmem");
+
+    fail_unless(stats_snapshot_take(&before) == 0,
+                "Failed to get statistics");
+    res = memsection_map(ms, 0x0, pm);
+    fail_unless(res == 0, "Failed to map Physmem");
+    fail_unless(stats_snapshot_take(&after) == 0,
+                "Failed to get statistics");
+
+    if (before.ms != 0 && after.ms != 0) {
+        syscalls = STATS_DELTA(&before, &after, sync_syscalls);
+        bytes = STATS_DELTA(&before, &after, sync_bytes);
+        fail_unless(bytes >= SYNC_SIZE, "Mapping was not synced");
+        if (bytes >= SYNC_SIZE) {
+            per_mb = syscalls / (bytes / SYNC_SIZE);
+            printf("MEMS3100: %lu syscalls for %lu bytes "
+                   "(%lu per megabyte)\n", (unsigned long)syscalls,
+                   (unsigned long)bytes, (unsigned long)per_mb);
+            fail_unless(per_mb <= 16, "Mapping sync was not coalesced");
+        }
+    }
+    if (!res) {
+        *((volatile int *)(base + SYNC_SIZE - PAGE_SIZE)) = 1;
+    }
+
+    stats_snapshot_release(&before);
+    stats_snapshot_release(&after);
+    memsection_delete(ms);
+    physmem_delete(pm);
+}
+END_TEST
+
+/*
+ * Churn memsections through the server's slab caches and check that the
+ * slabs emptied by deleting them are handed back to the internal pools.
+ */
+#define CHURN_MEMSECTIONS 2000
+
+START_TEST(MEMS3200)
+{
+    static memsection_ref_t refs[CHURN_MEMSECTIONS];
+    struct stats_snapshot peak, after;
+    uintptr_t base;
+    int i, n;
+
+    for (n = 0; n < CHURN_MEMSECTIONS; n++) {
+        refs[n] = memsection_create_user(PAGE_SIZE, &base);
+        if (refs[n] == 0) {
+            break;
+        }
+    }
+    fail_unless(n == CHURN_MEMSECTIONS, "Failed to create memsections");
+
+    fail_unless(stats_snapshot_take(&peak) == 0,
+                "Failed to get statistics");
+    for (i = 0; i < n; i++) {
+        memsection_delete(refs[i]);
+    }
+    fail_unless(stats_snapshot_take(&after) == 0,
+                "Failed to get statistics");
+
+    if (peak.ms != 0 && after.ms != 0) {
+        printf("MEMS3200: %lu slab pages at peak, %lu after delete, "
+               "%lu reclaimed\n", (unsigned long)peak.stats->slab_pages,
+               (unsigned long)after.stats->slab_pages,
+               (unsigned long)STATS_DELTA(&peak, &after, slab_reclaims));
+        fail_unless(STATS_DELTA(&peak, &after, slab_reclaims) > 0,
+                    "No slabs were reclaimed");
+        fail_unless(after.stats->slab_pages < peak.stats->slab_pages,
+                    "Slab pages were not returned");
+    }
+    stats_snapshot_release(&peak);
+    stats_snapshot_release(&after);
+}
+END_TEST
+#endif
+
 TCase *
 memsect_tests()
 {
@@ -1294,6 +1451,11 @@ memsect_tests()
     tcase_add_test(tc, MEMS2700);
     tcase_add_test(tc, MEMS2800);
     tcase_add_test(tc, MEMS2900);
+    tcase_add_test(tc, MEMS3000);
+#if defined(CONFIG_STATS)
+    tcase_add_test(tc, MEMS3100);
+    tcase_add_test(tc, MEMS3200);
+#endif
 
     return tc;
 }
@@ -845,6 +845,60 @@ START_TEST(PD2100)
 }
 END_TEST
 
+/*
+ * Attach many memsections to 2 pds, detach some of them out of order and
+ * leave the rest for pd_delete() to clean up.
+ */
+#define PD2300_NUM_MEMSECTIONS 64
+START_TEST(PD2300)
+{
+    pd_ref_t newpd1 = 0;
+    pd_ref_t newpd2 = 0;
+    memsection_ref_t memsec[PD2300_NUM_MEMSECTIONS];
+    uintptr_t base;
+    int i, res;
+
+    newpd1 = pd_create();
+    fail_if(newpd1 == 0, "NULL pd returned");
+    newpd2 = pd_create();
+    fail_if(newpd2 == 0, "NULL pd returned");
+
+    if ((newpd1 != 0) && (newpd2 != 0)) {
+        for (i = 0; i < PD2300_NUM_MEMSECTIONS; i++) {
+            memsec[i] = pd_create_memsection(pd_myself(), MEM_SIZE, &base);
+            fail_if(memsec[i] == 0, "NULL memsection returned");
+            res = pd_attach(newpd1, memsec[i], L4_Readable);
+            fail_if(res != 0, "Attaching memsection failed.");
+            res = pd_attach(newpd2, memsec[i], L4_FullyAccessible);
+            fail_if(res != 0, "Attaching memsection failed.");
+        }
+
+        /* Re-attaching updates the rights in place. */
+        for (i = 0; i < PD2300_NUM_MEMSECTIONS; i++) {
+            res = pd_attach(newpd1, memsec[i], L4_FullyAccessible);
+            fail_if(res != 0, "Re-attaching memsection failed.");
+        }
+
+        for (i = PD2300_NUM_MEMSECTIONS - 1; i >= 0; i -= 2) {
+            pd_detach(newpd1, memsec[i]);
+        }
+        for (i = 0; i < PD2300_NUM_MEMSECTIONS; i += 3) {
+            pd_detach(newpd2, memsec[i]);
+        }
+        for (i = PD2300_NUM_MEMSECTIONS - 1; i >= 0; i -= 2) {
+            res = pd_attach(newpd1, memsec[i], L4_FullyAccessible);
+            fail_if(res != 0, "Attaching detached memsection failed.");
+        }
+
+        pd_delete(newpd1);
+        pd_delete(newpd2);
+        for (i = 0; i < PD2300_NUM_MEMSECTIONS; i++) {
+            memsection_delete(memsec[i]);
+        }
+    }
+}
+END_TEST
+
 /*
  * This test triggers the bug #1702 in function refcmp() which causes the security check to fail.
  * It can not be run on MIPS32 as MIPS32 address space ends at 0x80000000.
@@ -977,6 +1031,7 @@ pd_tests(void)
     tcase_add_test(tc, PD1900);
     tcase_add_test(tc, PD2000);
     tcase_add_test(tc, PD2100);
+    tcase_add_test(tc, PD2300);
 #if !(defined(L4_ARCH_MIPS) && defined(L4_32BIT))
     tcase_add_test(tc, PD2200);
 #endif
@@ -81,6 +81,46 @@ extern uintptr_t __malloc_bss;
 extern uintptr_t __malloc_top;
 #endif
 
+/*
+ * Current kernel time in microseconds, or 0 if the kernel does not keep
+ * the time.
+ */
+uint64_t
+test_time_usec(void)
+{
+    L4_Word_t lo, hi;
+
+    (void)L4_KDB_TimerStatsIntroMRs();
+    L4_StoreMR(0, &lo);
+    L4_StoreMR(1, &hi);
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+#if defined(CONFIG_STATS)
+/*
+ * Take a copy of the server statistics along with the current time.
+ * Returns 0 on success; release the copy with stats_snapshot_release().
+ */
+int
+stats_snapshot_take(struct stats_snapshot *snap)
+{
+    snap->ms = iguana_stats(&snap->stats);
+    snap->time = test_time_usec();
+
+    return snap->ms == 0 ? -1 : 0;
+}
+
+void
+stats_snapshot_release(struct stats_snapshot *snap)
+{
+    if (snap->ms != 0) {
+        memsection_delete(snap->ms);
+        snap->ms = 0;
+    }
+}
+#endif
+
 Suite *
 make_test_libs_iguana_suite(void)
 {
@@ -59,6 +59,7 @@
  * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <stdint.h>
 #include <check/check.h>
 
 Suite *make_test_libs_iguana_suite(void);
@@ -74,6 +75,26 @@ TCase *restricted_pd_tests(void);
 TCase *pool_tests(void);
 TCase *seg_info_tests(void);
 
+uint64_t test_time_usec(void);
+
+#if defined(CONFIG_STATS)
+#include <iguana/stats.h>
+
+/* A copy of the Iguana server statistics taken at one point in a test. */
+struct stats_snapshot {
+    memsection_ref_t ms;
+    iguana_stats_t *stats;
+    uint64_t time;
+};
+
+int stats_snapshot_take(struct stats_snapshot *snap);
+void stats_snapshot_release(struct stats_snapshot *snap);
+
+/* Change in a statistics counter between two snapshots. */
+#define STATS_DELTA(before, after, field) \
+    ((after)->stats->field - (before)->stats->field)
+#endif
+
 #define PAGE_SIZE 4096
 #define MEM_SIZE 0x100
 #define MEM_SIZE_LEAST 0x80
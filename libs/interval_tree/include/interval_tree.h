@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2008 Open Kernel Labs, Inc. (Copyright Holder).
+ * All rights reserved.
+ *
+ * 1. Redistribution and use of OKL4 (Software) in source and binary
+ * forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ *     (a) Redistributions of source code must retain this clause 1
+ *         (including paragraphs (a), (b) and (c)), clause 2 and clause 3
+ *         (Licence Terms) and the above copyright notice.
+ *
+ *     (b) Redistributions in binary form must reproduce the above
+ *         copyright notice and the Licence Terms in the documentation and/or
+ *         other materials provided with the distribution.
+ *
+ *     (c) Redistributions in any form must be accompanied by information on
+ *         how to obtain complete source code for:
+ *        (i) the Software; and
+ *        (ii) all accompanying software that uses (or is intended to
+ *        use) the Software whether directly or indirectly.  Such source
+ *        code must:
+ *        (iii) either be included in the distribution or be available
+ *        for no more than the cost of distribution plus a nominal fee;
+ *        and
+ *        (iv) be licensed by each relevant holder of copyright under
+ *        either the Licence Terms (with an appropriate copyright notice)
+ *        or the terms of a licence which is approved by the Open Source
+ *        Initative.  For an executable file, "complete source code"
+ *        means the source code for all modules it contains and includes
+ *        associated build and other files reasonably required to produce
+ *        the executable.
+ *
+ * 2. THIS SOFTWARE IS PROVIDED ``AS IS'' AND, TO THE EXTENT PERMITTED BY
+ * LAW, ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  WHERE ANY WARRANTY IS
+ * IMPLIED AND IS PREVENTED BY LAW FROM BEING DISCLAIMED THEN TO THE
+ * EXTENT PERMISSIBLE BY LAW: (A) THE WARRANTY IS READ DOWN IN FAVOUR OF
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT) AND (B) ANY LIMITATIONS PERMITTED BY LAW (INCLUDING AS TO
+ * THE EXTENT OF THE WARRANTY AND THE REMEDIES AVAILABLE IN THE EVENT OF
+ * BREACH) ARE DEEMED PART OF THIS LICENCE IN A FORM MOST FAVOURABLE TO
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT). IN THE LICENCE TERMS, "PARTICIPANT" INCLUDES EVERY
+ * PERSON WHO HAS CONTRIBUTED TO THE SOFTWARE OR WHO HAS BEEN INVOLVED IN
+ * THE DISTRIBUTION OR DISSEMINATION OF THE SOFTWARE.
+ *
+ * 3. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR ANY OTHER PARTICIPANT BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Description: Balanced interval tree over non-overlapping address ranges.
+ *
+ * Nodes are embedded in the caller's objects and keyed by base address.
+ * The tree is an AVL tree in which each node also records the largest
+ * end address found in its subtree, so point and range queries can prune
+ * whole subtrees.  All operations are O(log n).  Interval ends are
+ * inclusive so that a range may finish at the top of the address space.
+ */
+
+#ifndef _INTERVAL_TREE_H_
+#define _INTERVAL_TREE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct itree_node {
+    struct itree_node *left;
+    struct itree_node *right;
+    uintptr_t base;
+    uintptr_t end;              /* Inclusive */
+    uintptr_t max_end;          /* Largest end in this subtree */
+    int height;
+};
+
+struct itree {
+    struct itree_node *root;
+};
+
+/* Recover the containing object from an embedded node. */
+#define itree_entry(node, type, member) \
+    ((type *)((char *)(node) - offsetof(type, member)))
+
+void itree_init(struct itree *tree);
+
+/*
+ * Insert node covering [base, end].  Returns -1 if the node would overlap
+ * one already in the tree, 0 on success.
+ */
+int itree_insert(struct itree *tree, struct itree_node *node,
+                 uintptr_t base, uintptr_t end);
+void itree_remove(struct itree *tree, struct itree_node *node);
+
+/* Find the node containing addr, or NULL. */
+struct itree_node *itree_lookup(const struct itree *tree, uintptr_t addr);
+/* Find the lowest node overlapping [lo, hi], or NULL. */
+struct itree_node *itree_first_overlap(const struct itree *tree,
+                                       uintptr_t lo, uintptr_t hi);
+
+/* In-order iteration. */
+struct itree_node *itree_first(const struct itree *tree);
+struct itree_node *itree_next(const struct itree *tree,
+                              const struct itree_node *node);
+
+#endif /* _INTERVAL_TREE_H_ */
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2008 Open Kernel Labs, Inc. (Copyright Holder).
+ * All rights reserved.
+ *
+ * 1. Redistribution and use of OKL4 (Software) in source and binary
+ * forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ *     (a) Redistributions of source code must retain this clause 1
+ *         (including paragraphs (a), (b) and (c)), clause 2 and clause 3
+ *         (Licence Terms) and the above copyright notice.
+ *
+ *     (b) Redistributions in binary form must reproduce the above
+ *         copyright notice and the Licence Terms in the documentation and/or
+ *         other materials provided with the distribution.
+ *
+ *     (c) Redistributions in any form must be accompanied by information on
+ *         how to obtain complete source code for:
+ *        (i) the Software; and
+ *        (ii) all accompanying software that uses (or is intended to
+ *        use) the Software whether directly or indirectly.  Such source
+ *        code must:
+ *        (iii) either be included in the distribution or be available
+ *        for no more than the cost of distribution plus a nominal fee;
+ *        and
+ *        (iv) be licensed by each relevant holder of copyright under
+ *        either the Licence Terms (with an appropriate copyright notice)
+ *        or the terms of a licence which is approved by the Open Source
+ *        Initative.  For an executable file, "complete source code"
+ *        means the source code for all modules it contains and includes
+ *        associated build and other files reasonably required to produce
+ *        the executable.
+ *
+ * 2. THIS SOFTWARE IS PROVIDED ``AS IS'' AND, TO THE EXTENT PERMITTED BY
+ * LAW, ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  WHERE ANY WARRANTY IS
+ * IMPLIED AND IS PREVENTED BY LAW FROM BEING DISCLAIMED THEN TO THE
+ * EXTENT PERMISSIBLE BY LAW: (A) THE WARRANTY IS READ DOWN IN FAVOUR OF
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT) AND (B) ANY LIMITATIONS PERMITTED BY LAW (INCLUDING AS TO
+ * THE EXTENT OF THE WARRANTY AND THE REMEDIES AVAILABLE IN THE EVENT OF
+ * BREACH) ARE DEEMED PART OF THIS LICENCE IN A FORM MOST FAVOURABLE TO
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT). IN THE LICENCE TERMS, "PARTICIPANT" INCLUDES EVERY
+ * PERSON WHO HAS CONTRIBUTED TO THE SOFTWARE OR WHO HAS BEEN INVOLVED IN
+ * THE DISTRIBUTION OR DISSEMINATION OF THE SOFTWARE.
+ *
+ * 3. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR ANY OTHER PARTICIPANT BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Description: AVL tree of address intervals, augmented with the largest
+ * end address of each subtree.
+ */
+
+#include <assert.h>
+#include <interval_tree/interval_tree.h>
+
+static inline int
+node_height(const struct itree_node *node)
+{
+    return node == NULL ? 0 : node->height;
+}
+
+static void
+node_update(struct itree_node *node)
+{
+    int lh = node_height(node->left);
+    int rh = node_height(node->right);
+
+    node->height = 1 + (lh > rh ? lh : rh);
+    node->max_end = node->end;
+    if (node->left != NULL && node->left->max_end > node->max_end) {
+        node->max_end = node->left->max_end;
+    }
+    if (node->right != NULL && node->right->max_end > node->max_end) {
+        node->max_end = node->right->max_end;
+    }
+}
+
+static struct itree_node *
+rotate_left(struct itree_node *node)
+{
+    struct itree_node *pivot = node->right;
+
+    node->right = pivot->left;
+    pivot->left = node;
+    node_update(node);
+    node_update(pivot);
+    return pivot;
+}
+
+static struct itree_node *
+rotate_right(struct itree_node *node)
+{
+    struct itree_node *pivot = node->left;
+
+    node->left = pivot->right;
+    pivot->right = node;
+    node_update(node);
+    node_update(pivot);
+    return pivot;
+}
+
+/*
+ * Restore the AVL invariant at node, whose children are already balanced
+ * and differ in height by at most two.  Returns the new subtree root.
+ */
+static struct itree_node *
+rebalance(struct itree_node *node)
+{
+    int balance;
+
+    node_update(node);
+    balance = node_height(node->left) - node_height(node->right);
+
+    if (balance > 1) {
+        if (node_height(node->left->left) < node_height(node->left->right)) {
+            node->left = rotate_left(node->left);
+        }
+        return rotate_right(node);
+    }
+    if (balance < -1) {
+        if (node_height(node->right->right) < node_height(node->right->left)) {
+            node->right = rotate_right(node->right);
+        }
+        return rotate_left(node);
+    }
+    return node;
+}
+
+static struct itree_node *
+insert_node(struct itree_node *root, struct itree_node *node)
+{
+    if (root == NULL) {
+        return node;
+    }
+    if (node->base < root->base) {
+        root->left = insert_node(root->left, node);
+    } else {
+        root->right = insert_node(root->right, node);
+    }
+    return rebalance(root);
+}
+
+static struct itree_node *
+remove_min(struct itree_node *root, struct itree_node **min)
+{
+    if (root->left == NULL) {
+        *min = root;
+        return root->right;
+    }
+    root->left = remove_min(root->left, min);
+    return rebalance(root);
+}
+
+static struct itree_node *
+remove_node(struct itree_node *root, const struct itree_node *node)
+{
+    struct itree_node *succ, *right;
+
+    if (root == NULL) {
+        return NULL;
+    }
+    if (node->base < root->base) {
+        root->left = remove_node(root->left, node);
+    } else if (node->base > root->base) {
+        root->right = remove_node(root->right, node);
+    } else {
+        assert(root == node);
+        if (root->left == NULL) {
+            return root->right;
+        }
+        if (root->right == NULL) {
+            return root->left;
+        }
+        /* Two children: promote the in-order successor. */
+        right = remove_min(root->right, &succ);
+        succ->left = root->left;
+        succ->right = right;
+        root = succ;
+    }
+    return rebalance(root);
+}
+
+void
+itree_init(struct itree *tree)
+{
+    tree->root = NULL;
+}
+
+int
+itree_insert(struct itree *tree, struct itree_node *node,
+             uintptr_t base, uintptr_t end)
+{
+    if (end < base || itree_first_overlap(tree, base, end) != NULL) {
+        return -1;
+    }
+
+    node->left = NULL;
+    node->right = NULL;
+    node->base = base;
+    node->end = end;
+    node->max_end = end;
+    node->height = 1;
+
+    tree->root = insert_node(tree->root, node);
+    return 0;
+}
+
+void
+itree_remove(struct itree *tree, struct itree_node *node)
+{
+    tree->root = remove_node(tree->root, node);
+}
+
+struct itree_node *
+itree_lookup(const struct itree *tree, uintptr_t addr)
+{
+    return itree_first_overlap(tree, addr, addr);
+}
+
+struct itree_node *
+itree_first_overlap(const struct itree *tree, uintptr_t lo, uintptr_t hi)
+{
+    struct itree_node *node = tree->root;
+
+    while (node != NULL) {
+        /*
+         * If anything on the left ends at or after lo, the lowest overlap
+         * (if there is one at all) is on the left: were every such node
+         * to start after hi, so would this node and its right subtree.
+         */
+        if (node->left != NULL && node->left->max_end >= lo) {
+            node = node->left;
+        } else if (node->base > hi) {
+            return NULL;
+        } else if (node->end >= lo) {
+            return node;
+        } else {
+            node = node->right;
+        }
+    }
+    return NULL;
+}
+
+struct itree_node *
+itree_first(const struct itree *tree)
+{
+    struct itree_node *node = tree->root;
+
+    if (node == NULL) {
+        return NULL;
+    }
+    while (node->left != NULL) {
+        node = node->left;
+    }
+    return node;
+}
+
+struct itree_node *
+itree_next(const struct itree *tree, const struct itree_node *node)
+{
+    struct itree_node *cur = tree->root;
+    struct itree_node *next = NULL;
+
+    while (cur != NULL) {
+        if (node->base < cur->base) {
+            next = cur;
+            cur = cur->left;
+        } else {
+            cur = cur->right;
+        }
+    }
+    return next;
+}
@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2008 Open Kernel Labs, Inc. (Copyright Holder).
+ * All rights reserved.
+ *
+ * 1. Redistribution and use of OKL4 (Software) in source and binary
+ * forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ *     (a) Redistributions of source code must retain this clause 1
+ *         (including paragraphs (a), (b) and (c)), clause 2 and clause 3
+ *         (Licence Terms) and the above copyright notice.
+ *
+ *     (b) Redistributions in binary form must reproduce the above
+ *         copyright notice and the Licence Terms in the documentation and/or
+ *         other materials provided with the distribution.
+ *
+ *     (c) Redistributions in any form must be accompanied by information on
+ *         how to obtain complete source code for:
+ *        (i) the Software; and
+ *        (ii) all accompanying software that uses (or is intended to
+ *        use) the Software whether directly or indirectly.  Such source
+ *        code must:
+ *        (iii) either be included in the distribution or be available
+ *        for no more than the cost of distribution plus a nominal fee;
+ *        and
+ *        (iv) be licensed by each relevant holder of copyright under
+ *        either the Licence Terms (with an appropriate copyright notice)
+ *        or the terms of a licence which is approved by the Open Source
+ *        Initative.  For an executable file, "complete source code"
+ *        means the source code for all modules it contains and includes
+ *        associated build and other files reasonably required to produce
+ *        the executable.
+ *
+ * 2. THIS SOFTWARE IS PROVIDED ``AS IS'' AND, TO THE EXTENT PERMITTED BY
+ * LAW, ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  WHERE ANY WARRANTY IS
+ * IMPLIED AND IS PREVENTED BY LAW FROM BEING DISCLAIMED THEN TO THE
+ * EXTENT PERMISSIBLE BY LAW: (A) THE WARRANTY IS READ DOWN IN FAVOUR OF
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT) AND (B) ANY LIMITATIONS PERMITTED BY LAW (INCLUDING AS TO
+ * THE EXTENT OF THE WARRANTY AND THE REMEDIES AVAILABLE IN THE EVENT OF
+ * BREACH) ARE DEEMED PART OF THIS LICENCE IN A FORM MOST FAVOURABLE TO
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT). IN THE LICENCE TERMS, "PARTICIPANT" INCLUDES EVERY
+ * PERSON WHO HAS CONTRIBUTED TO THE SOFTWARE OR WHO HAS BEEN INVOLVED IN
+ * THE DISTRIBUTION OR DISSEMINATION OF THE SOFTWARE.
+ *
+ * 3. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR ANY OTHER PARTICIPANT BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stddef.h>
+#include <check/check.h>
+#include "test_libs_interval_tree.h"
+
+#define NUM_NODES   1024
+#define NODE_SIZE   0x1000
+#define NODE_GAP    0x1000
+
+struct range {
+    int id;
+    struct itree_node node;
+};
+
+static struct range ranges[NUM_NODES];
+
+static uintptr_t
+range_base(int i)
+{
+    return 0x100000 + (uintptr_t)i * (NODE_SIZE + NODE_GAP);
+}
+
+static uintptr_t
+range_end(int i)
+{
+    return range_base(i) + NODE_SIZE - 1;
+}
+
+static void
+insert_ascending(struct itree *tree, int n)
+{
+    int i;
+
+    itree_init(tree);
+    for (i = 0; i < n; i++) {
+        ranges[i].id = i;
+        fail_unless(itree_insert(tree, &ranges[i].node, range_base(i),
+                                 range_end(i)) == 0, "Couldn't insert");
+    }
+}
+
+/* Check AVL balance and max_end at every node; returns subtree height. */
+static int
+check_subtree(const struct itree_node *node)
+{
+    int lh, rh;
+    uintptr_t max_end;
+
+    if (node == NULL) {
+        return 0;
+    }
+    lh = check_subtree(node->left);
+    rh = check_subtree(node->right);
+    fail_unless(lh - rh <= 1 && rh - lh <= 1, "Tree out of balance");
+    fail_unless(node->height == 1 + (lh > rh ? lh : rh), "Bad height");
+
+    max_end = node->end;
+    if (node->left != NULL) {
+        fail_unless(node->left->base < node->base, "Left child out of order");
+        if (node->left->max_end > max_end) {
+            max_end = node->left->max_end;
+        }
+    }
+    if (node->right != NULL) {
+        fail_unless(node->right->base > node->base, "Right child out of order");
+        if (node->right->max_end > max_end) {
+            max_end = node->right->max_end;
+        }
+    }
+    fail_unless(node->max_end == max_end, "Bad max_end");
+
+    return node->height;
+}
+
+START_TEST(test_interval_tree_insert)
+{
+    struct itree tree;
+    int height;
+
+    insert_ascending(&tree, NUM_NODES);
+    height = check_subtree(tree.root);
+
+    /* An AVL tree of 1024 nodes is at most 1.44 * log2(n) high. */
+    fail_unless(height <= 14, "Ascending inserts degraded the tree");
+}
+END_TEST
+
+START_TEST(test_interval_tree_insert_overlap)
+{
+    struct itree tree;
+    struct itree_node extra;
+
+    insert_ascending(&tree, 16);
+
+    fail_unless(itree_insert(&tree, &extra, range_base(3), range_base(3)) == -1,
+                "Inserted duplicate base");
+    fail_unless(itree_insert(&tree, &extra, range_end(3), range_end(3) + 1) == -1,
+                "Inserted range overlapping an end");
+    fail_unless(itree_insert(&tree, &extra, range_base(3) - 1,
+                             range_base(3)) == -1,
+                "Inserted range overlapping a base");
+    fail_unless(itree_insert(&tree, &extra, range_base(2), range_end(5)) == -1,
+                "Inserted range covering several nodes");
+    fail_unless(itree_insert(&tree, &extra, 2, 1) == -1,
+                "Inserted backwards range");
+
+    /* The gap between two ranges is free. */
+    fail_unless(itree_insert(&tree, &extra, range_end(3) + 1,
+                             range_base(4) - 1) == 0, "Couldn't fill gap");
+    check_subtree(tree.root);
+}
+END_TEST
+
+START_TEST(test_interval_tree_lookup)
+{
+    struct itree tree;
+    struct itree_node *node;
+    int i;
+
+    insert_ascending(&tree, NUM_NODES);
+
+    for (i = 0; i < NUM_NODES; i++) {
+        node = itree_lookup(&tree, range_base(i));
+        fail_unless(node == &ranges[i].node, "Didn't find base");
+        node = itree_lookup(&tree, range_end(i));
+        fail_unless(node == &ranges[i].node, "Didn't find end");
+        fail_unless(itree_entry(node, struct range, node)->id == i,
+                    "Bad containing object");
+        fail_unless(itree_lookup(&tree, range_end(i) + 1) == NULL,
+                    "Found address in gap");
+    }
+    fail_unless(itree_lookup(&tree, 0) == NULL, "Found address below tree");
+    fail_unless(itree_lookup(&tree, UINTPTR_MAX) == NULL,
+                "Found address above tree");
+}
+END_TEST
+
+START_TEST(test_interval_tree_overlap)
+{
+    struct itree tree;
+
+    insert_ascending(&tree, NUM_NODES);
+
+    fail_unless(itree_first_overlap(&tree, 0, range_base(0) - 1) == NULL,
+                "Found overlap below tree");
+    fail_unless(itree_first_overlap(&tree, range_end(7) + 1,
+                                    range_base(8) - 1) == NULL,
+                "Found overlap in gap");
+    fail_unless(itree_first_overlap(&tree, range_end(7) + 1,
+                                    range_base(8)) == &ranges[8].node,
+                "Missed overlap at base");
+    fail_unless(itree_first_overlap(&tree, range_end(7),
+                                    range_base(8)) == &ranges[7].node,
+                "Didn't return lowest overlap");
+    fail_unless(itree_first_overlap(&tree, 0, UINTPTR_MAX) == &ranges[0].node,
+                "Didn't return lowest overlap of whole space");
+    fail_unless(itree_first_overlap(&tree, range_base(NUM_NODES - 1) + 1,
+                                    UINTPTR_MAX) ==
+                &ranges[NUM_NODES - 1].node, "Missed overlap at top");
+}
+END_TEST
+
+START_TEST(test_interval_tree_remove)
+{
+    struct itree tree;
+    struct itree_node *node;
+    int i, n;
+
+    insert_ascending(&tree, NUM_NODES);
+
+    /* Remove every odd range, then every even one. */
+    for (i = 1; i < NUM_NODES; i += 2) {
+        itree_remove(&tree, &ranges[i].node);
+    }
+    check_subtree(tree.root);
+    for (i = 0; i < NUM_NODES; i++) {
+        node = itree_lookup(&tree, range_base(i));
+        if (i % 2) {
+            fail_unless(node == NULL, "Found removed range");
+        } else {
+            fail_unless(node == &ranges[i].node, "Lost range");
+        }
+    }
+
+    n = 0;
+    for (node = itree_first(&tree); node != NULL;
+         node = itree_next(&tree, node)) {
+        fail_unless(node == &ranges[n].node, "Iteration out of order");
+        n += 2;
+    }
+    fail_unless(n == NUM_NODES, "Iteration missed ranges");
+
+    for (i = 0; i < NUM_NODES; i += 2) {
+        itree_remove(&tree, &ranges[i].node);
+        check_subtree(tree.root);
+    }
+    fail_unless(tree.root == NULL, "Tree not empty");
+    fail_unless(itree_first(&tree) == NULL, "Iterated over empty tree");
+}
+END_TEST
+
+Suite *
+make_test_libs_interval_tree_suite(void)
+{
+    Suite *suite;
+    TCase *tc;
+
+    suite = suite_create("interval_tree tests");
+    tc = tcase_create("Core");
+    tcase_add_test(tc, test_interval_tree_insert);
+    tcase_add_test(tc, test_interval_tree_insert_overlap);
+    tcase_add_test(tc, test_interval_tree_lookup);
+    tcase_add_test(tc, test_interval_tree_overlap);
+    tcase_add_test(tc, test_interval_tree_remove);
+
+    suite_add_tcase(suite, tc);
+    return suite;
+}
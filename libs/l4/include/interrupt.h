@@ -203,5 +203,38 @@ L4_AcknowledgeWaitInterrupt(L4_Word_t mrs, L4_Word_t request)
         );
 }
 
+/*
+ * L4_SetInterruptCoalescing
+ *
+ * Asks the kernel to batch the interrupt notifications sent to a handler
+ * thread.  Notify bits are held back until either 'max_events' interrupts
+ * have arrived or 'max_delay' microseconds have passed since the first of
+ * them, and are then delivered with a single wakeup.  The number of
+ * interrupts delivered is returned in MR[2] by L4_AcknowledgeWaitInterrupt().
+ *
+ * Arguments
+ *
+ * - target:        the interrupt handler thread.
+ * - max_events:    interrupts to batch; 0 or 1 turns coalescing off.
+ * - max_delay:     upper bound on the delay in microseconds; must be non-zero
+ *                  when coalescing is on.
+ */
+L4_INLINE L4_Word_t
+L4_SetInterruptCoalescing(L4_ThreadId_t target, L4_Word_t max_events,
+                          L4_Word_t max_delay)
+{
+    L4_LoadMR(0, max_events);
+    L4_LoadMR(1, max_delay);
+    return
+        L4_InterruptControl
+        (
+            target,
+            L4_InterruptControl_count(2) |
+            L4_InterruptControl_op(L4_InterruptControl_CoalesceIrq) |
+            L4_InterruptControl_request(0) |
+            L4_InterruptControl_notifybit(0)
+        );
+}
+
 #endif /* !__L4__INTERRUPT_H__ */
 
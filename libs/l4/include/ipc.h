@@ -173,6 +173,33 @@ L4_Clear_MemoryCopy(L4_MsgTag_t *t)
     t->X.flags &= (~1u);
 }
 
+/**
+ * @brief Lend the buffer named by the fpage following the untyped words
+ * to the receiver's window instead of copying it.
+ */
+L4_INLINE void
+L4_Set_Window(L4_MsgTag_t *t)
+{
+    t->X.__res |= 1;
+}
+
+L4_INLINE void
+L4_Clear_Window(L4_MsgTag_t *t)
+{
+    t->X.__res &= (~1u);
+}
+
+/**
+ * @brief Indicates if the received IPC mapped a buffer into our window.
+ *
+ * @return TRUE if the word following the untyped words holds the window.
+ */
+L4_INLINE L4_Bool_t
+L4_IpcWindow(L4_MsgTag_t t)
+{
+    return (t.X.__res & 0x1) != 0;
+}
+
 
 /*
  * Derived functions
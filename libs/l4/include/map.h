@@ -69,6 +69,7 @@
 #include <l4/arch/config.h>
 
 #define L4_MAX_MAP_ITEMS    (__L4_NUM_MRS / 3)
+#define L4_MAX_MAP_RUN_PAGES    __L4_MAX_MAP_RUN_PAGES
 
 /*
  * MapItem and QueryItem
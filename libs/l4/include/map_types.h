@@ -66,6 +66,9 @@
 
 #define __L4_MAP_SHIFT        10
 
+/* Most pages a single map item may map or unmap */
+#define __L4_MAX_MAP_RUN_PAGES  1024
+
 typedef struct {
     BITFIELD4(word_t,
         attr        : 8,
@@ -422,12 +422,38 @@ L4_Acceptor(L4_Bool_t notify)
     return acceptor;
 }
 
+/*
+ * The upper bits of an acceptor hold the size and base of a receive
+ * window for zero-copy IPC, laid out as in an fpage.
+ */
+#define __L4_ACCEPTOR_WINDOW_MASK       (~0xfUL)
+
+L4_INLINE L4_Acceptor_t
+L4_WindowAcceptor(const L4_Fpage_t window)
+{
+    L4_Acceptor_t acceptor;
+
+    acceptor.raw = window.raw & __L4_ACCEPTOR_WINDOW_MASK;
+    return acceptor;
+}
+
+L4_INLINE L4_Fpage_t
+L4_AcceptorWindow(const L4_Acceptor_t a)
+{
+    L4_Fpage_t window;
+
+    window.raw = a.raw & __L4_ACCEPTOR_WINDOW_MASK;
+    return window;
+}
+
 L4_INLINE L4_Acceptor_t
 L4_AddAcceptor(const L4_Acceptor_t l, const L4_Acceptor_t r)
 {
     L4_Acceptor_t a;
 
-    a.raw = 0;
+    a.raw = (r.raw & __L4_ACCEPTOR_WINDOW_MASK) ?
+            (r.raw & __L4_ACCEPTOR_WINDOW_MASK) :
+            (l.raw & __L4_ACCEPTOR_WINDOW_MASK);
     a.X.notify = (l.X.notify | r.X.notify);
     return a;
 }
@@ -435,8 +461,7 @@ L4_AddAcceptor(const L4_Acceptor_t l, const L4_Acceptor_t r)
 L4_INLINE L4_Acceptor_t
 L4_AddAcceptorTo(L4_Acceptor_t l, const L4_Acceptor_t r)
 {
-    l.X.notify = (l.X.notify | r.X.notify);
-    return l;
+    return L4_AddAcceptor(l, r);
 }
 
 L4_INLINE L4_Acceptor_t
@@ -446,15 +471,15 @@ L4_RemoveAcceptor(const L4_Acceptor_t l, const L4_Acceptor_t r)
 
     if (r.X.notify)
         a.X.notify = 0;
+    if (r.raw & __L4_ACCEPTOR_WINDOW_MASK)
+        a.raw &= ~__L4_ACCEPTOR_WINDOW_MASK;
     return a;
 }
 
 L4_INLINE L4_Acceptor_t
 L4_RemoveAcceptorFrom(L4_Acceptor_t l, const L4_Acceptor_t r)
 {
-    if (r.X.notify)
-        l.X.notify = 0;
-    return l;
+    return L4_RemoveAcceptor(l, r);
 }
 
 #if defined(__l4_cplusplus)
@@ -69,6 +69,8 @@
 #define L4_Profiling_Stop()
 #define L4_Profiling_Reset()
 #define L4_Profiling_Print()
+#define L4_Profiling_ReadStats(event, unit)                 0
+#define L4_Profiling_ReadHistogram(event, unit, first)      0
 
 #endif
 
@@ -274,7 +274,7 @@ typedef word_t mutex_info_t;
  * InterruptControl controls
  */
 #define L4_InterruptControl_count(x)        (((x) & ((1UL << 6) - 1)))
-#define L4_InterruptControl_op(x)           (((x) & ((1UL << 2) - 1)) << 6)
+#define L4_InterruptControl_op(x)           (((x) & ((1UL << 3) - 1)) << 6)
 
 /*
  * MemoryCopy direction field
@@ -285,23 +285,25 @@ typedef word_t mutex_info_t;
 
 #if defined(L4_64BIT)
 
-#define L4_InterruptControl_request(x)      (((x) & ((1UL << 50) - 1)) << 8)
+#define L4_InterruptControl_request(x)      (((x) & ((1UL << 49) - 1)) << 9)
 #define L4_InterruptControl_notifybit(x)    (((x) & ((1UL << 6) - 1)) << 58)
 
 #define L4_InterruptControl_RegisterIrq     0ULL
 #define L4_InterruptControl_UnregisterIrq   1ULL
 #define L4_InterruptControl_AcknowledgeIrq  2ULL
 #define L4_InterruptControl_AckWaitIrq      3ULL
+#define L4_InterruptControl_CoalesceIrq     4ULL
 
 #else
 
-#define L4_InterruptControl_request(x)      (((x) & ((1UL << 18) - 1)) << 8)
+#define L4_InterruptControl_request(x)      (((x) & ((1UL << 17) - 1)) << 9)
 #define L4_InterruptControl_notifybit(x)    (((x) & ((1UL << 5) - 1)) << 27)
 
 #define L4_InterruptControl_RegisterIrq     0UL
 #define L4_InterruptControl_UnregisterIrq   1UL
 #define L4_InterruptControl_AcknowledgeIrq  2UL
 #define L4_InterruptControl_AckWaitIrq      3UL
+#define L4_InterruptControl_CoalesceIrq     4UL
 
 #endif /* defined (L4_64BIT) */
 
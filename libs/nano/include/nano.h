@@ -90,12 +90,12 @@ void okn_semaphore_init(okn_semaphore_t *, unsigned long val);
 unsigned long okn_semaphore_down(okn_semaphore_t *);
 unsigned long okn_semaphore_try_down(okn_semaphore_t *);
 unsigned long okn_semaphore_up(okn_semaphore_t *);
+unsigned long okn_semaphore_up_many(okn_semaphore_t *, unsigned long count);
 
 /* Barrier calls. */
 typedef struct okn_barrier {
     unsigned long count;
     unsigned long expected;
-    unsigned long waiters;
     unsigned long version;
 } okn_barrier_t;
 
@@ -106,6 +106,8 @@ void okn_barrier(okn_barrier_t *barrier);
 /* Futex system calls. */
 int okn_syscall_futex_wait(int tag);
 int okn_syscall_futex_signal(int tag);
+int okn_syscall_futex_wake(int tag, unsigned long count);
+int okn_syscall_futex_requeue(int tag, int new_tag, unsigned long count);
 
 /* Thread system calls. */
 int okn_syscall_thread_create(void *pc, void *sp, unsigned long r0, int prio);
@@ -72,7 +72,6 @@ okn_barrier_init(okn_barrier_t *barrier, int num_threads)
     barrier->expected = num_threads;
     barrier->version = 0;
     barrier->count = 0;
-    barrier->waiters = 0;
 }
 
 /*
@@ -93,20 +92,16 @@ okn_barrier(okn_barrier_t *barrier)
         /* Sleep. */
         okn_syscall_futex_wait((int)barrier + version);
 
-        /* Wake up the next thread in line. */
-        barrier->waiters--;
-        if (barrier->waiters > 0) {
-            okn_syscall_futex_signal((int)barrier + version);
-        }
-
         /* Done. */
         return;
     }
 
-    /* Reset the barrier, and start the wake-up process. */
+    /* Reset the barrier, and wake everybody else in one go. Threads that
+     * have not gone to sleep yet find their signal pending. */
     barrier->count = 0;
     barrier->version = 1 - barrier->version;
-    barrier->waiters = barrier->expected - 1;
-    okn_syscall_futex_signal((int)barrier + version);
+    if (barrier->expected > 1) {
+        okn_syscall_futex_wake((int)barrier + version, barrier->expected - 1);
+    }
 }
 
@@ -150,6 +150,8 @@ struct okl4_kspace {
  *
  *  @li The @a page size to be used as the granularity of mapping.
  *
+ *  @li Whether the mapping may be @a coalesced into larger pages.
+ *
  *  The kspace map attribute initialization function encodes the default
  *  values for each parameter with the exception of the virtual
  *  and physical memory regions.
@@ -174,6 +176,9 @@ struct okl4_kspace_map_attr {
 
     /* Page size used to perform the mapping. */
     okl4_word_t page_size;
+
+    /* Non-zero to let the kernel map with larger pages where it can. */
+    okl4_word_t coalesce;
 };
 
 /**
@@ -372,6 +377,14 @@ INLINE void okl4_kspace_attr_init(okl4_kspace_attr_t *attr);
  *  This function invokes the L4_ProcessMapItem() kernel system call
  *  to perform the mapping.
  *
+ *  By default the range is mapped one page at a time with the requested
+ *  page size. If coalescing was enabled with
+ *  okl4_kspace_map_attr_setcoalesce(), the range is mapped with as few
+ *  multi-page map items as possible, and the kernel may use pages larger
+ *  than the requested page size for parts of the range that are suitably
+ *  aligned both virtually and physically. Unmapping part of such a page
+ *  removes the entire larger page.
+ *
  *  This function requires the following arguments:
  *
  *  @param kspace
@@ -553,6 +566,24 @@ INLINE void okl4_kspace_map_attr_setperms(okl4_kspace_map_attr_t *attr,
 INLINE void okl4_kspace_map_attr_setpagesize(okl4_kspace_map_attr_t *attr,
         okl4_word_t pagesize);
 
+/**
+ *  The okl4_kspace_map_attr_setcoalesce() function is used to encode
+ *  whether the mapping described by the kspace map attribute @a attr may
+ *  use pages larger than its page size. Coalescing is disabled by
+ *  default.
+ *
+ *  This function requires the following arguments:
+ *
+ *  @param attr
+ *    Attribute to be encoded.
+ *
+ *  @param coalesce
+ *    Non-zero to allow larger pages.
+ *
+ */
+INLINE void okl4_kspace_map_attr_setcoalesce(okl4_kspace_map_attr_t *attr,
+        okl4_word_t coalesce);
+
 /**
  *  The okl4_kspace_unmap_attr_init() function is used to initialize the
  *  kspace unmap attribute @a attr.  This function must be invoked on the attribute
@@ -692,6 +723,7 @@ okl4_kspace_map_attr_init(okl4_kspace_map_attr_t *attr)
     attr->perms = L4_Readable | L4_Writable;
     attr->attributes = L4_DefaultMemory;
     attr->page_size = OKL4_DEFAULT_PAGESIZE;
+    attr->coalesce = 0;
 }
 
 INLINE void
@@ -744,6 +776,16 @@ okl4_kspace_map_attr_setpagesize(okl4_kspace_map_attr_t *attr,
     attr->page_size = pagesize;
 }
 
+INLINE void
+okl4_kspace_map_attr_setcoalesce(okl4_kspace_map_attr_t *attr,
+        okl4_word_t coalesce)
+{
+    assert(attr != NULL);
+    OKL4_CHECK_MAGIC(attr, OKL4_MAGIC_KSPACE_MAP_ATTR);
+
+    attr->coalesce = coalesce;
+}
+
 INLINE void
 okl4_kspace_unmap_attr_init(okl4_kspace_unmap_attr_t *attr)
 {
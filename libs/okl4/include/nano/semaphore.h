@@ -182,6 +182,18 @@ int okl4_semaphore_trydown(okl4_semaphore_t * semaphore);
  */
 void okl4_semaphore_up(okl4_semaphore_t * semaphore);
 
+/**
+ * Increase the given semaphore's count by the given amount, waking as
+ * many blocked threads as the increase allows with a single system call.
+ *
+ * @param semaphore
+ *     The semaphore to increase.
+ *
+ * @param count
+ *     The amount to increase the count by.
+ */
+void okl4_semaphore_up_many(okl4_semaphore_t * semaphore, okl4_word_t count);
+
 /**
  * Delete the given semaphore object, releasing all kernel resources
  * associated with it.
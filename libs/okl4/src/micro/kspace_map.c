@@ -78,6 +78,7 @@ _okl4_kspace_mapbyid(okl4_kspaceid_t kspaceid, okl4_kspace_map_attr_t *attr)
 {
     okl4_word_t pages_mapped;
     okl4_word_t total_pages;
+    okl4_word_t run_pages;
 
     assert(attr != NULL);
 
@@ -85,17 +86,32 @@ _okl4_kspace_mapbyid(okl4_kspaceid_t kspaceid, okl4_kspace_map_attr_t *attr)
     assert(attr->range->size % attr->page_size == 0);
     total_pages = attr->range->size / attr->page_size;
 
-    /* Perform the mappings. */
-    for (pages_mapped = 0; pages_mapped < total_pages; pages_mapped++) {
+    /*
+     * Perform the mappings. Unless asked to coalesce, map one page per
+     * item so that the kernel uses exactly the requested page size.
+     * Multi-page items let the kernel map aligned parts of each run with
+     * larger pages.
+     */
+    for (pages_mapped = 0; pages_mapped < total_pages;
+            pages_mapped += run_pages) {
         L4_MapItem_t map;
         okl4_word_t success;
 
+        run_pages = 1;
+        if (attr->coalesce) {
+            run_pages = total_pages - pages_mapped;
+            if (run_pages > L4_MAX_MAP_RUN_PAGES) {
+                run_pages = L4_MAX_MAP_RUN_PAGES;
+            }
+        }
+
         /* Setup the map item. */
         L4_MapItem_Map(&map, attr->target->segment_id,
                 attr->target->range.base + pages_mapped * attr->page_size,
                 attr->range->base + pages_mapped * attr->page_size,
                 pagesize_to_bits(attr->page_size),
                 attr->attributes, attr->perms);
+        L4_MapItem_SetMultiplePages(&map, run_pages);
 
         /* Perform the map. */
         success = L4_ProcessMapItem(kspaceid, map);
@@ -76,7 +76,8 @@ int
 _okl4_kspace_unmapbyid(okl4_kspaceid_t kspaceid, okl4_kspace_unmap_attr_t *attr)
 {
     okl4_word_t total_pages;
-    okl4_word_t pages_mapped;
+    okl4_word_t pages_unmapped;
+    okl4_word_t run_pages;
 
     assert(attr != NULL);
 
@@ -84,16 +85,23 @@ _okl4_kspace_unmapbyid(okl4_kspaceid_t kspaceid, okl4_kspace_unmap_attr_t *attr)
     assert(attr->range->size % attr->page_size == 0);
     total_pages = attr->range->size / attr->page_size;
 
-    /* Perform the unmap. */
-    for (pages_mapped = 0; pages_mapped < total_pages; pages_mapped++) {
+    /* Perform the unmap, as few map items as the kernel allows. */
+    for (pages_unmapped = 0; pages_unmapped < total_pages;
+            pages_unmapped += run_pages) {
         L4_MapItem_t map;
 
+        run_pages = total_pages - pages_unmapped;
+        if (run_pages > L4_MAX_MAP_RUN_PAGES) {
+            run_pages = L4_MAX_MAP_RUN_PAGES;
+        }
+
         /* Setup the map item. */
         L4_MapItem_Unmap(&map,
-                attr->range->base + pages_mapped * attr->page_size,
+                attr->range->base + pages_unmapped * attr->page_size,
                 pagesize_to_bits(attr->page_size));
+        L4_MapItem_SetMultiplePages(&map, run_pages);
 
-        /* Perform the map. We allow the map to fail, as the user
+        /* Perform the unmap. We allow the unmap to fail, as the user
          * may wish to unmap a sparse area of the address space. */
         (void)L4_ProcessMapItem(kspaceid, map);
     }
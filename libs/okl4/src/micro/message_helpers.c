@@ -57,6 +57,7 @@
  */
 
 #include <assert.h>
+#include <string.h>
 
 #include <okl4/types.h>
 #include <okl4/message.h>
@@ -68,18 +69,6 @@
 
 #include "message_helpers.h"
 
-static void
-copy_mem(void *RESTRICT dest, const void *RESTRICT src, okl4_word_t bytes)
-{
-    char *RESTRICT d = (char *)dest;
-    char *RESTRICT s = (char *)src;
-
-    /* TODO : have an optimised version of this somewhere. */
-    while (bytes--) {
-        *d++ = *s++;
-    }
-}
-
 void
 _okl4_message_copy_buff_to_mrs(void *buff, okl4_word_t num_bytes)
 {
@@ -89,13 +78,13 @@ _okl4_message_copy_buff_to_mrs(void *buff, okl4_word_t num_bytes)
     }
 
     /* Copy over it. */
-    copy_mem(L4_MRStart() + 1, buff, num_bytes);
+    memcpy(L4_MRStart() + 1, buff, num_bytes);
 }
 
 void
 _okl4_message_copy_mrs_to_buff(void *buff, okl4_word_t num_bytes)
 {
-    copy_mem(buff, L4_MRStart() + 1, num_bytes);
+    memcpy(buff, L4_MRStart() + 1, num_bytes);
 }
 
 int
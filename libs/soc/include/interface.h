@@ -227,6 +227,8 @@ void kernel_schedule(continuation_t cont) NORETURN;
  *                 was called prior to this.
  * @param interval The time in microseconds since the last timer interrupt
  *                 or since reactivation of the timer (whichever is smaller).
+ *                 Ignored by tickless kernels, which read the time from
+ *                 soc_get_system_time().
  * @param cont     The continuation function to activate on function
  *                 completion.
  */
@@ -486,6 +486,24 @@ word_t soc_get_timer_tick_length(void);
  */
 void soc_disable_timer(void);
 
+#if defined(CONFIG_TICKLESS)
+/**
+ * @brief Read the system time from the free-running counter.
+ *
+ * @return Microseconds since the timer was initialised.
+ */
+u64_t soc_get_system_time(void);
+
+/**
+ * @brief Program the timer to interrupt once.
+ *
+ * @param usecs Microseconds until the interrupt.  Zero means no interrupt
+ *              is needed; the platform may still program one when it has
+ *              to keep track of counter wrap-around.
+ */
+void soc_set_timer_oneshot(word_t usecs);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
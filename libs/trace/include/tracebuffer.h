@@ -96,25 +96,35 @@ typedef struct {
 } trace_entry_t;
 
 #define TBUF_MAGIC      0x7b6b5b4b3b2b1b0bull
-#define TBUF_VERSION    1
+#define TBUF_VERSION    2
 #define TBUF_ID         1       /* L4 tracebuffer */
-#define TBUF_BUFFERS    2
+
+/*
+ * The kernel records into one ring per execution unit. Entries between
+ * tail and head are unread; after consuming them the reader advances tail.
+ * If the space left before the end of a ring is smaller than a
+ * trace_entry_t, or starts with a zero header, the next entry is at the
+ * start of the ring.
+ */
+typedef struct {
+    uintptr_t offset;           /* offset of ring from header */
+    uintptr_t size;             /* size of ring (bytes) */
+    volatile uintptr_t reserve; /* end of reserved space (kernel owned) */
+    volatile uintptr_t head;    /* end of last written entry */
+    volatile uintptr_t tail;    /* start of oldest unread entry */
+    volatile uintptr_t overflows;   /* number of dropped entries */
+} trace_ring_t;
 
 typedef struct {
     uintptr_t magic;            /* magic number */
     uintptr_t version;          /* tracebuffer version */
     uintptr_t bufid;            /* tracebuffer id */
-    uintptr_t buffers;          /* number of buffers */
+    uintptr_t buffers;          /* number of rings */
 
     uintptr_t log_mask;         /* mask of major IDs */
-    uintptr_t active_buffer;    /* current active buffer */
-    uintptr_t buffer_empty;     /* bitmask of available buffers */
-    uintptr_t buffer_size;      /* size of each buffer (bytes) */
 
-    /* offset of each buffer */
-    uintptr_t buffer_offset[TBUF_BUFFERS];
-    /* current head pointer of each buffer (past last entry) */
-    uintptr_t buffer_head[TBUF_BUFFERS];
+    /* ring of each execution unit, 'buffers' entries */
+    trace_ring_t ring[1];
 } trace_buffer_t;
 
 static inline uint64_t trace_entry_timestamp(trace_entry_t* tbe)
@@ -126,4 +136,19 @@ static inline uint64_t trace_entry_timestamp(trace_entry_t* tbe)
     return time;
 }
 
+/* Return the entry at 'pos' in a ring, or NULL if the reader must wrap */
+static inline trace_entry_t *
+trace_ring_entry(trace_buffer_t *tb, trace_ring_t *ring, uintptr_t pos)
+{
+    trace_entry_t *tbe;
+
+    if (ring->size - pos < sizeof(trace_entry_t))
+        return NULL;
+    tbe = (trace_entry_t *)((uintptr_t)tb + ring->offset + pos);
+    if (tbe->hdr.raw == 0)
+        return NULL;
+
+    return tbe;
+}
+
 #endif
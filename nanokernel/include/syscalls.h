@@ -64,6 +64,8 @@
  */
 void sys_futex_wait(word_t tag);
 void sys_futex_signal(unsigned int tag);
+void sys_futex_wake(unsigned int tag, word_t count);
+void sys_futex_requeue(unsigned int tag, unsigned int new_tag, word_t count);
 
 /*
  * IPC System Calls
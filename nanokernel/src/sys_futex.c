@@ -87,8 +87,20 @@ typedef struct futex_hash_entry {
 /* Pointer to global hash-entry array. */
 MASHED futex_hash_entry_t * const futex_hash;
 
-/* Pointer to array of pending signals. */
-MASHED word_t * const futex_pending_tags;
+/*
+ * Pending Signal Table.
+ *
+ * Signals sent to a tag nobody is waiting on are counted in an open
+ * addressed table with the same number of slots as the tag hash table,
+ * using linear probing from the tag's hash. A free slot has a zero tag.
+ */
+typedef struct futex_pending_entry {
+    word_t tag;
+    word_t count;
+} futex_pending_entry_t;
+
+/* Pointer to the pending signal table. */
+MASHED futex_pending_entry_t * const futex_pending_tags;
 
 /* Number of pending signals. */
 static word_t num_pending_tags = 0;
@@ -110,6 +122,73 @@ hash_tag(unsigned int tag)
    return h1 & (futex_hash_slots - 1);
 }
 
+/*
+ * Pending signals.
+ */
+
+/* Find the pending table slot of 'tag', or the free slot it would use. */
+static futex_pending_entry_t *
+lookup_pending(word_t tag)
+{
+    int i = hash_tag(tag);
+
+    while (futex_pending_tags[i].tag != 0
+            && futex_pending_tags[i].tag != tag) {
+        i = (i + 1) & (futex_hash_slots - 1);
+    }
+    return &futex_pending_tags[i];
+}
+
+/* Record 'count' pending signals on 'tag'. */
+static int
+add_pending(word_t tag, word_t count)
+{
+    /* The table holds at most one slot per thread, so it always has free
+     * slots and probing terminates. */
+    if (EXPECT_FALSE(count > max_tcbs - num_pending_tags))
+        return 0;
+
+    futex_pending_entry_t *entry = lookup_pending(tag);
+    entry->tag = tag;
+    entry->count += count;
+    num_pending_tags += count;
+    return 1;
+}
+
+/* Consume a pending signal on 'tag', if there is one. */
+static int
+take_pending(word_t tag)
+{
+    futex_pending_entry_t *entry = lookup_pending(tag);
+    if (entry->tag == 0)
+        return 0;
+
+    num_pending_tags--;
+    if (--entry->count > 0)
+        return 1;
+
+    /* Remove the slot, shifting back later entries of the probe
+     * sequence so that lookups never stop early. */
+    int i = entry - futex_pending_tags;
+    int j = i;
+    while (1) {
+        j = (j + 1) & (futex_hash_slots - 1);
+        if (futex_pending_tags[j].tag == 0)
+            break;
+
+        /* Entries whose home slot lies cyclically in (i, j] stay put. */
+        int k = hash_tag(futex_pending_tags[j].tag);
+        if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+
+        futex_pending_tags[i] = futex_pending_tags[j];
+        i = j;
+    }
+    futex_pending_tags[i].tag = 0;
+    futex_pending_tags[i].count = 0;
+    return 1;
+}
+
 /*
  * Futex functionality.
  */
@@ -174,13 +253,9 @@ sys_futex_wait(word_t tag)
 
     /* If there is a pending signal matching our tag, remove it
      * and return early. */
-    for (int i = num_pending_tags - 1; i >= 0; i--) {
-        if (futex_pending_tags[i] == tag) {
-            futex_pending_tags[i] = futex_pending_tags[num_pending_tags - 1];
-            num_pending_tags--;
-            spin_unlock(&futex_lock);
-            syscall_return_success(0);
-        }
+    if (take_pending(tag)) {
+        spin_unlock(&futex_lock);
+        syscall_return_success(0);
     }
 
     /* Otherwise, add us to the wait list. */
@@ -227,6 +302,66 @@ signal_futex(unsigned int tag)
     return NULL;
 }
 
+/*
+ * Wake the threads in 'woken', a list of dequeued futex waiters chained
+ * through 'next', and switch to whoever should run.
+ */
+NORETURN static void
+wake_futex_list(tcb_t *woken, int result)
+{
+    tcb_t *highest = woken;
+
+    for (tcb_t *tcb = woken->next; tcb != NULL; tcb = tcb->next) {
+        if (tcb->priority > highest->priority)
+            highest = tcb;
+    }
+
+    /* All but the highest priority thread are simply made runnable. */
+    for (tcb_t *tcb = woken; tcb != NULL; ) {
+        tcb_t *next = tcb->next;
+        tcb->next = NULL;
+        if (tcb != highest)
+            activate(tcb);
+        tcb = next;
+    }
+
+    tcb_t *next = activate_schedule(highest);
+    spin_unlock(&futex_lock);
+    set_syscall_return_val_success(current_tcb, result);
+    switch_to(next);
+}
+
+/*
+ * Dequeue up to 'count' threads sleeping on 'tag', highest priority first.
+ *
+ * Returns the number of threads dequeued and chains them onto '*list'.
+ */
+static word_t
+dequeue_futex_waiters(unsigned int tag, word_t count, tcb_t **list)
+{
+    futex_hash_entry_t *entry = &futex_hash[hash_tag(tag)];
+    tcb_t **tail = list;
+    tcb_t *previous = NULL;
+    tcb_t *head = entry->head;
+    word_t woken = 0;
+
+    while (head != NULL && woken < count) {
+        tcb_t *next = head->next;
+        if (head->futex_tag == tag) {
+            dequeue_futex(entry, previous, head);
+            *tail = head;
+            tail = &head->next;
+            woken++;
+        } else {
+            previous = head;
+        }
+        head = next;
+    }
+
+    *tail = NULL;
+    return woken;
+}
+
 /*
  * Signal a futex waiting on tag 'tag'.
  */
@@ -256,14 +391,110 @@ sys_futex_signal(unsigned int tag)
      *
      * Ensure that we have space to store the pending signal.
      */
-    if (EXPECT_FALSE(num_pending_tags >= max_tcbs)) {
+    if (EXPECT_FALSE(!add_pending(tag, 1))) {
         spin_unlock(&futex_lock);
         syscall_return_error(1, ENOMEM);
     }
 
-    /* Add the pending signal. */
-    futex_pending_tags[num_pending_tags++] = tag;
     spin_unlock(&futex_lock);
     syscall_return_success(0);
 }
 
+/*
+ * Send 'count' signals to tag 'tag' at once.
+ *
+ * Up to 'count' threads sleeping on the tag are woken; signals that no
+ * thread was sleeping for are left pending, exactly as if
+ * sys_futex_signal() had been called 'count' times.
+ *
+ * Returns the number of threads woken.
+ */
+ATTRIBUTE_NORETURN(sys_futex_wake);
+NORETURN void
+sys_futex_wake(unsigned int tag, word_t count)
+{
+    /* The zero tag is reserved for system use. */
+    if (EXPECT_FALSE(tag == 0))
+        syscall_return_error(-1, EINVAL);
+
+    spin_lock(&futex_lock);
+
+    tcb_t *woken;
+    word_t num_woken = dequeue_futex_waiters(tag, count, &woken);
+
+    /* Store any signals not consumed by a sleeping thread. */
+    if (num_woken < count && EXPECT_FALSE(!add_pending(tag, count - num_woken))) {
+        /* Out of space: put the threads back to sleep so the call has
+         * no effect. */
+        for (tcb_t *tcb = woken; tcb != NULL; ) {
+            tcb_t *next = tcb->next;
+            enqueue_futex(&futex_hash[hash_tag(tag)], tcb);
+            tcb = next;
+        }
+        spin_unlock(&futex_lock);
+        syscall_return_error(-1, ENOMEM);
+    }
+
+    if (num_woken == 0) {
+        spin_unlock(&futex_lock);
+        syscall_return_success(0);
+    }
+
+    wake_futex_list(woken, num_woken);
+}
+
+/*
+ * Wake up to 'count' threads sleeping on 'tag', and move all other
+ * threads sleeping on 'tag' to sleep on 'new_tag' instead.
+ *
+ * No pending signal is stored for 'tag'. A moved thread consumes a
+ * signal pending on 'new_tag' and is woken, as if it had only just
+ * started waiting on it.
+ *
+ * Returns the number of threads woken.
+ */
+ATTRIBUTE_NORETURN(sys_futex_requeue);
+NORETURN void
+sys_futex_requeue(unsigned int tag, unsigned int new_tag, word_t count)
+{
+    /* The zero tag is reserved for system use. */
+    if (EXPECT_FALSE(tag == 0 || new_tag == 0))
+        syscall_return_error(-1, EINVAL);
+
+    spin_lock(&futex_lock);
+
+    tcb_t *woken;
+    word_t num_woken = dequeue_futex_waiters(tag, count, &woken);
+
+    if (tag != new_tag) {
+        tcb_t *moved;
+        tcb_t **tail = &woken;
+
+        while (*tail != NULL) {
+            tail = &(*tail)->next;
+        }
+
+        (void)dequeue_futex_waiters(tag, max_tcbs, &moved);
+        while (moved != NULL) {
+            tcb_t *next = moved->next;
+            if (take_pending(new_tag)) {
+                /* Woken by a signal already pending on the new tag. */
+                *tail = moved;
+                tail = &moved->next;
+                *tail = NULL;
+                num_woken++;
+            } else {
+                moved->futex_tag = new_tag;
+                enqueue_futex(&futex_hash[hash_tag(new_tag)], moved);
+            }
+            moved = next;
+        }
+    }
+
+    if (woken == NULL) {
+        spin_unlock(&futex_lock);
+        syscall_return_success(0);
+    }
+
+    wake_futex_list(woken, num_woken);
+}
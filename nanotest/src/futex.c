@@ -134,6 +134,35 @@ TEST(FUTEX, 1011, "Futex Signal/Wait")
     return 0;
 }
 
+/*
+ * FUTEX1020 : Futex Wake Pending.
+ *
+ * Ensure that waking several threads when nobody is waiting leaves one
+ * pending signal per thread not woken.
+ */
+TEST(FUTEX, 1020, "Futex Wake Pending")
+{
+    int error;
+    int woken;
+
+    woken = okn_syscall_futex_wake(0xdeadbeef, 3);
+    assert(woken == 0);
+    woken = okn_syscall_futex_wake(0xfeedcafe, 1);
+    assert(woken == 0);
+
+    error  = okn_syscall_futex_wait(0xfeedcafe);
+    error |= okn_syscall_futex_wait(0xdeadbeef);
+    error |= okn_syscall_futex_wait(0xdeadbeef);
+    error |= okn_syscall_futex_wait(0xdeadbeef);
+    assert(!error);
+
+    /* The zero tag is reserved. */
+    woken = okn_syscall_futex_wake(0, 1);
+    assert(woken < 0);
+
+    return 0;
+}
+
 /*
  * FUTEX1100 : Futex Wait/Signal.
  *
@@ -341,6 +370,128 @@ TEST(FUTEX, 1200, "Shared variable / Barrier")
 }
 
 
+/*
+ * FUTEX1300 : Futex Wake Many.
+ *
+ * Ensure that a single wake call wakes exactly the requested number of
+ * sleeping threads.
+ */
+
+#define FUTEX1300_CHILDREN 4
+#define FUTEX1300_TAG      0x13000000
+
+static okl4_atomic_word_t futex1300_woken;
+
+static void
+futex1300_child(void *arg)
+{
+    int error;
+
+    (void)error;
+
+    error = okn_syscall_futex_wait((int)arg);
+    assert(!error);
+    okl4_atomic_inc(&futex1300_woken);
+}
+
+TEST(FUTEX, 1300, "Futex Wake Many")
+{
+    int tids[FUTEX1300_CHILDREN];
+    int woken;
+
+    okl4_atomic_set(&futex1300_woken, 0);
+
+    /* Only run this test on a single execution unit. */
+    create_spinners(NUM_EXECUTION_UNITS - 1, ROOT_TASK_PRIORITY + 2);
+
+    /* Create children, which preempt us and go to sleep. */
+    for (int i = 0; i < FUTEX1300_CHILDREN; i++) {
+        tids[i] = create_thread(futex1300_child, ROOT_TASK_PRIORITY + 1,
+                (void *)FUTEX1300_TAG);
+        assert(tids[i] >= 0);
+    }
+
+    /* Wake half of them. */
+    woken = okn_syscall_futex_wake(FUTEX1300_TAG, FUTEX1300_CHILDREN / 2);
+    assert(woken == FUTEX1300_CHILDREN / 2);
+    assert(okl4_atomic_read(&futex1300_woken) == FUTEX1300_CHILDREN / 2);
+
+    /* Wake the rest, asking for more than are sleeping. */
+    woken = okn_syscall_futex_wake(FUTEX1300_TAG, FUTEX1300_CHILDREN);
+    assert(woken == FUTEX1300_CHILDREN / 2);
+    assert(okl4_atomic_read(&futex1300_woken) == FUTEX1300_CHILDREN);
+
+    /* Consume the signals left pending. */
+    for (int i = 0; i < FUTEX1300_CHILDREN / 2; i++) {
+        int error = okn_syscall_futex_wait(FUTEX1300_TAG);
+        assert(!error);
+    }
+
+    for (int i = 0; i < FUTEX1300_CHILDREN; i++) {
+        okn_syscall_thread_join(tids[i]);
+    }
+
+    delete_spinners();
+
+    return 0;
+}
+
+/*
+ * FUTEX1310 : Futex Requeue.
+ *
+ * Ensure that requeue wakes the requested number of threads, moves the
+ * rest to the new tag, and that moved threads pick up signals already
+ * pending on the new tag.
+ */
+
+#define FUTEX1310_CHILDREN 4
+#define FUTEX1310_FROM     0x13100000
+#define FUTEX1310_TO       0x13110000
+
+TEST(FUTEX, 1310, "Futex Requeue")
+{
+    int tids[FUTEX1310_CHILDREN];
+    int woken;
+    int error;
+
+    okl4_atomic_set(&futex1300_woken, 0);
+
+    /* Only run this test on a single execution unit. */
+    create_spinners(NUM_EXECUTION_UNITS - 1, ROOT_TASK_PRIORITY + 2);
+
+    for (int i = 0; i < FUTEX1310_CHILDREN; i++) {
+        tids[i] = create_thread(futex1300_child, ROOT_TASK_PRIORITY + 1,
+                (void *)FUTEX1310_FROM);
+        assert(tids[i] >= 0);
+    }
+
+    /* One signal is already waiting on the destination tag. */
+    error = okn_syscall_futex_signal(FUTEX1310_TO);
+    assert(!error);
+
+    /* Wake one thread; of the three moved, one consumes the signal. */
+    woken = okn_syscall_futex_requeue(FUTEX1310_FROM, FUTEX1310_TO, 1);
+    assert(woken == 2);
+    assert(okl4_atomic_read(&futex1300_woken) == 2);
+
+    /* Nobody is left on the old tag. */
+    woken = okn_syscall_futex_requeue(FUTEX1310_FROM, FUTEX1310_TO, 1);
+    assert(woken == 0);
+
+    /* The remaining two sleep on the new tag. */
+    woken = okn_syscall_futex_wake(FUTEX1310_TO, 2);
+    assert(woken == 2);
+    assert(okl4_atomic_read(&futex1300_woken) == FUTEX1310_CHILDREN);
+
+    for (int i = 0; i < FUTEX1310_CHILDREN; i++) {
+        okn_syscall_thread_join(tids[i]);
+    }
+
+    delete_spinners();
+
+    return 0;
+}
+
 /*
  * Futex Tests
  */
@@ -351,9 +502,12 @@ get_futex_tests(void)
         &FUTEX_1000,
         &FUTEX_1010,
         &FUTEX_1011,
+        &FUTEX_1020,
         &FUTEX_1100,
         &FUTEX_1110,
         &FUTEX_1200,
+        &FUTEX_1300,
+        &FUTEX_1310,
         NULL
         };
     return tests;
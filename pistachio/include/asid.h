@@ -122,6 +122,11 @@ class space_t;
  *
  * CONFIG_ASIDS_RANDR :     Use random replacement algorithm.
  *
+ * CONFIG_ASIDS_GENERATION : Hand out ASIDs in order.  When they run out,
+ *                          start a new generation: take back every ASID
+ *                          and flush the whole TLB once.  A space holding
+ *                          an ASID is switched to without taking the lock.
+ *
  * -- datastructures --
  *
  * CONFIG_ASIDS_DIRECT :    Use direct ASID pointers.
@@ -136,7 +141,8 @@ class space_t;
  *
  */
 
-#if defined(CONFIG_ASIDS_LRU) || defined(CONFIG_ASIDS_ROUNDR) || defined(CONFIG_ASIDS_RANDR)
+#if defined(CONFIG_ASIDS_LRU) || defined(CONFIG_ASIDS_ROUNDR) || \
+    defined(CONFIG_ASIDS_RANDR) || defined(CONFIG_ASIDS_GENERATION)
 
 #if defined(CONFIG_MUNITS)
 #error SMT asid preemption not supported
@@ -198,6 +204,12 @@ public:
         asid = (int)invalid;
     }
 
+    /* Preempt without a flush; the caller flushes the whole TLB. */
+    void revoke(void)
+    {
+        asid = (int)invalid;
+    }
+
 private:
     hw_asid_t asid;
 };
@@ -216,6 +228,11 @@ public:
 #if defined(CONFIG_ASIDS_LRU)
         first_free = lru_head = -1;
 #endif
+#if defined(CONFIG_ASIDS_GENERATION)
+        next_asid = 0;
+        rollovers = 0;
+        preemptions = 0;
+#endif
 
         /* Initialise all asids to invalid */
         for(int i = 0; i < CONFIG_MAX_NUM_ASIDS; i++) {
@@ -260,9 +277,20 @@ public:
 
     asid_t *lookup(hw_asid_t hw_asid);
 
+#if defined(CONFIG_ASIDS_GENERATION)
+    /* Statistics, for kdb */
+    word_t rollovers;           /* Generations started (all ASIDs taken back) */
+    word_t preemptions;         /* ASIDs taken back from live spaces */
+#endif
+
  private:
     void release(asid_t *asid);
 
+#if defined(CONFIG_ASIDS_GENERATION)
+    hw_asid_t find_free(hw_asid_t start);
+    void rollover(void);
+#endif
+
     void move_asid(hw_asid_t idx, bool remove, bool insert);
 
     struct asid_link_t {
@@ -280,6 +308,10 @@ public:
     hw_asid_t first_free;
     hw_asid_t lru_head;
 #endif
+#if defined(CONFIG_ASIDS_GENERATION)
+    /* First ASID not yet handed out in this generation */
+    hw_asid_t next_asid;
+#endif
 
     friend class asid_t;
 };
@@ -304,12 +336,19 @@ INLINE hw_asid_t asid_t::get(space_t *space)
 {
     if (EXPECT_FALSE(!is_valid())) {
         asid = get_asid_cache()->allocate(space, this);
-    } else {
+    }
+#if !defined(CONFIG_ASIDS_GENERATION)
+    /*
+     * With generations there is nothing to reference: a valid ASID always
+     * belongs to the current generation, since a rollover revokes them all.
+     */
+    else {
 #ifdef KERNEL_ASID
         if (this->asid != KERNEL_ASID)
 #endif
             get_asid_cache()->reference(this);
     }
+#endif
 
     return asid;
 }
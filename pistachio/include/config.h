@@ -103,6 +103,11 @@
 #define CONFIG_MUNITS
 #endif
 
+/* Per-unit run queues only make sense with more than one unit. */
+#if !defined(CONFIG_MUNITS)
+#undef CONFIG_PERCPU_RUNQUEUES
+#endif
+
 #if defined(CONFIG_IS_32BIT)
 # define L4_GLOBAL_THREADNO_BITS                18
 # define L4_GLOBAL_INTRNO_BITS                  18
@@ -128,6 +133,16 @@
 #endif
 #endif
 
+/* Tickless kernels read the time from the platform's free-running counter. */
+#if defined(CONFIG_TICKLESS)
+#if !defined(CONFIG_KEEP_CURRENT_TIME)
+#define CONFIG_KEEP_CURRENT_TIME
+#endif
+#if defined(CONFIG_MUNITS)
+#error "CONFIG_TICKLESS does not support multiple units"
+#endif
+#endif
+
 /*
  * root server configuration
  */
@@ -140,7 +155,8 @@
 #endif
 
 /*
- * Size of the bounce buffer for the remote memory copy feature.
+ * Size of the bounce buffer for the remote memory copy feature. There is
+ * one buffer per execution unit.
  *
  * It should be less than or equal the minimum page size. Otherwise, it is a
  * waste of space since the unit of copying is min(REMOTE_MEMCPY_BUFSIZE,
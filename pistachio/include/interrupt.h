@@ -94,7 +94,8 @@ public:
         op_register     = 0,
         op_unregister   = 1,
         op_ack          = 2,
-        op_ack_wait     = 3
+        op_ack_wait     = 3,
+        op_coalesce     = 4
     };
 
     inline word_t get_count() { return x.count; }
@@ -112,15 +113,15 @@ private:
 #if defined(CONFIG_IS_32BIT)
             BITFIELD5(word_t,
                     count   : 6,
-                    op      : 2,
-                    request : BITS_WORD - 14,
+                    op      : 3,
+                    request : BITS_WORD - 15,
                             : 1,
                     notify_bit : 5);
 #else
             BITFIELD4(word_t,
                     count   : 6,
-                    op      : 2,
-                    request : BITS_WORD - 14,
+                    op      : 3,
+                    request : BITS_WORD - 15,
                     notify_bit : 6);
 #endif
         } x;
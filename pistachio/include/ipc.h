@@ -88,6 +88,8 @@
 #ifndef __IPC_H__
 #define __IPC_H__
 
+#include <fpage.h>
+
 class tcb_t;
 
 /**
@@ -134,6 +136,7 @@ public:
     word_t get_label() { return send.label; }
     word_t get_untyped() { return send.untyped; }
     bool get_memcpy() { return send.memcpy; }
+    bool get_window() { return send.window; }
 
     void clear_flags() { raw &= ~(0xf << 12);}
     void clear_receive_flags() { raw &= ~(0xf << 12); }
@@ -210,9 +213,10 @@ public:
     union {
         word_t raw;
         struct {
-            BITFIELD7(word_t,
+            BITFIELD8(word_t,
                       untyped           : 6,
-                      __res             : 6,
+                      window            : 1,
+                      __res             : 5,
                       memcpy            : 1,
                       notify            : 1,
                       rcvblock          : 1,
@@ -220,9 +224,10 @@ public:
                       label             : BITS_WORD - 16);
         } send;
         struct {
-            BITFIELD7(word_t,
+            BITFIELD8(word_t,
                       untyped           : 6,
-                      __res1            : 6,
+                      window            : 1,
+                      __res1            : 5,
                       __res2            : 1,
                       __res             : 1,
                       xcpu              : 1,
@@ -251,6 +256,14 @@ public:
     inline bool accept_notify()
         { return x.notify; }
 
+    /* Receive window for zero-copy IPC, nil if none is offered */
+    inline fpage_t get_window()
+        {
+            fpage_t fp;
+            fp.raw = this->raw & ~0xfUL;
+            return fp;
+        }
+
     static inline acceptor_t untyped_words()
         {
             acceptor_t x;
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2008 Open Kernel Labs, Inc. (Copyright Holder).
+ * All rights reserved.
+ *
+ * 1. Redistribution and use of OKL4 (Software) in source and binary
+ * forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ *     (a) Redistributions of source code must retain this clause 1
+ *         (including paragraphs (a), (b) and (c)), clause 2 and clause 3
+ *         (Licence Terms) and the above copyright notice.
+ *
+ *     (b) Redistributions in binary form must reproduce the above
+ *         copyright notice and the Licence Terms in the documentation and/or
+ *         other materials provided with the distribution.
+ *
+ *     (c) Redistributions in any form must be accompanied by information on
+ *         how to obtain complete source code for:
+ *        (i) the Software; and
+ *        (ii) all accompanying software that uses (or is intended to
+ *        use) the Software whether directly or indirectly.  Such source
+ *        code must:
+ *        (iii) either be included in the distribution or be available
+ *        for no more than the cost of distribution plus a nominal fee;
+ *        and
+ *        (iv) be licensed by each relevant holder of copyright under
+ *        either the Licence Terms (with an appropriate copyright notice)
+ *        or the terms of a licence which is approved by the Open Source
+ *        Initative.  For an executable file, "complete source code"
+ *        means the source code for all modules it contains and includes
+ *        associated build and other files reasonably required to produce
+ *        the executable.
+ *
+ * 2. THIS SOFTWARE IS PROVIDED ``AS IS'' AND, TO THE EXTENT PERMITTED BY
+ * LAW, ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  WHERE ANY WARRANTY IS
+ * IMPLIED AND IS PREVENTED BY LAW FROM BEING DISCLAIMED THEN TO THE
+ * EXTENT PERMISSIBLE BY LAW: (A) THE WARRANTY IS READ DOWN IN FAVOUR OF
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT) AND (B) ANY LIMITATIONS PERMITTED BY LAW (INCLUDING AS TO
+ * THE EXTENT OF THE WARRANTY AND THE REMEDIES AVAILABLE IN THE EVENT OF
+ * BREACH) ARE DEEMED PART OF THIS LICENCE IN A FORM MOST FAVOURABLE TO
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT). IN THE LICENCE TERMS, "PARTICIPANT" INCLUDES EVERY
+ * PERSON WHO HAS CONTRIBUTED TO THE SOFTWARE OR WHO HAS BEEN INVOLVED IN
+ * THE DISTRIBUTION OR DISSEMINATION OF THE SOFTWARE.
+ *
+ * 3. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR ANY OTHER PARTICIPANT BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Description:   interrupt coalescing
+ */
+#ifndef __IRQ_COALESCE_H__
+#define __IRQ_COALESCE_H__
+
+class tcb_t;
+
+/*
+ * An interrupt handler can ask the kernel to batch its interrupts.
+ * Notify bits from interrupts routed to the handler are then held in
+ * the kernel, where the handler cannot see them, until either
+ * max_events interrupts have arrived or max_delay microseconds have
+ * passed since the first of them. The accumulated bits are delivered
+ * with a single wakeup. The number of interrupts delivered is
+ * returned from the next acknowledge-and-wait.
+ *
+ * The delay is checked from the timer interrupt, so it is rounded up
+ * to the timer tick on kernels with a periodic timer.
+ */
+class irq_coalesce_t
+{
+public:
+    void init(void)
+        {
+            max_events = max_delay = 0;
+            held_bits = held_events = held_age = 0;
+            delivered_events = 0;
+            next_held = NULL;
+        }
+
+    bool is_enabled(void)
+        { return max_events > 1; }
+
+    bool is_holding(void)
+        { return held_events != 0; }
+
+public:
+    word_t              max_events; /* release after this many events */
+    word_t              max_delay;  /* release after this many microseconds */
+    word_t              held_bits;  /* notify bits not yet delivered */
+    word_t              held_events;
+    word_t              held_age;   /* microseconds since first held event */
+    word_t              delivered_events;   /* not yet reported */
+    tcb_t *             next_held;  /* next handler holding events */
+};
+
+bool irq_coalesce_hold(tcb_t * handler, word_t * notifybits);
+word_t irq_coalesce_configure(tcb_t * handler, word_t max_events,
+                              word_t max_delay);
+word_t irq_coalesce_take_events(tcb_t * handler);
+void irq_coalesce_cancel(tcb_t * handler);
+void irq_coalesce_age(word_t elapsed);
+bool irq_coalesce_flush(void);
+word_t irq_coalesce_next_expiry(void);
+
+#endif /* !__IRQ_COALESCE_H__ */
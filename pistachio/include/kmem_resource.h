@@ -105,6 +105,39 @@ typedef enum {
 #define MAX_KMEM_GROUP  (word_t) max_kmem_group
 #define MAX_KMEM_SMALL_ALLOC_GROUP kmem_group_clist
 
+/*
+ * Number of free objects each execution unit caches in front of each
+ * small_alloc pool. Cached objects remain allocated as far as the
+ * pool is concerned.
+ */
+#define KMEM_MAGAZINE_SIZE      (8)
+
+/*
+ * When fewer than this many chunks are left in the heap, the magazines
+ * are drained back into their pools so that empty small_alloc blocks
+ * can be returned to the heap. Draining takes every unit's magazine
+ * locks, so it is done at most once until memory is freed back to the
+ * resource under its lock again.
+ */
+#define KMEM_DRAIN_WATERMARK    (16)
+
+/*
+ * Per-unit cache of free objects of one small_alloc pool. The lock is
+ * only contended when another unit drains the magazine.
+ */
+class kmem_magazine_t
+{
+public:
+    spinlock_t  lock;
+    word_t      rounds;
+    void *      objects[KMEM_MAGAZINE_SIZE];
+
+    /* statistics */
+    word_t      hits;
+    word_t      misses;
+    word_t      flushes;
+};
+
 class kmem_resource_t
 {
 private:
@@ -118,6 +151,9 @@ private:
 #endif
     kmem_group_t    kmem_groups[MAX_KMEM_GROUP];
     spinlock_t      lock;
+    kmem_magazine_t * magazines;    /* [unit][small_alloc group] */
+    word_t          drains;
+    bool            drained;        /* nothing freed since last drain */
 
     /* Init functions that may later be removed if this object
      * is initialized by elf-weaver.
@@ -154,6 +190,21 @@ private:
 
     void init_small_alloc_pools(void);
 
+    void init_magazines(void);
+
+    kmem_magazine_t * get_magazine(word_t unit, kmem_group_e group)
+    {
+        return &magazines[unit * MAX_KMEM_SMALL_ALLOC_GROUP + group];
+    }
+
+    void * magazine_alloc(kmem_group_e group, bool zeroed);
+    void magazine_free(kmem_group_e group, void * address);
+    word_t flush_magazine(kmem_group_e group, kmem_magazine_t * mag,
+                          word_t keep);
+    void drain_magazines(void);
+    bool relieve_pressure(void);
+    void check_pressure(void);
+
 public:
     /* Disable copy constructor */
     kmem_resource_t(const kmem_resource_t&);
@@ -178,7 +229,8 @@ public:
     void * alloc_aligned(kmem_group_e group, word_t size,
                          word_t alignment, word_t mask, bool zeroed);
     void free(kmem_group_e group, void * address, word_t size = 0);
-    void add(void * address, word_t size) {heap.add(address, size);}
+    void add(void * address, word_t size)
+        { heap.add(address, size); drained = false; }
 
     friend class small_alloc_t;
     friend class kdb_t;
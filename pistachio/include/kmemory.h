@@ -106,14 +106,71 @@ typedef word_t kmem_group_t;
 
 #define KMEM_CHUNKSIZE  (1024)
 
+/*
+ * Free memory is kept in power-of-two sized, naturally aligned blocks of
+ * chunks, with one free list per block order (buddy allocation). The
+ * largest block is KMEM_CHUNKSIZE << (KMEM_ORDERS - 1).
+ */
+#define KMEM_ORDERS         (20)
+
+/* Maximum number of discontiguous memory regions in a heap */
+#define KMEM_MAX_REGIONS    (4)
+
+/* Marks the first chunk of a free block in a region's order map */
+#define KMEM_MAP_FREE       (0x80)
+
+/* Header stored at the start of each free block */
+class kmem_block_t
+{
+public:
+    kmem_block_t * next;
+    kmem_block_t * prev;
+};
+
+/*
+ * A contiguous range of memory managed by a heap. The order map holds
+ * one byte per chunk: KMEM_MAP_FREE | order if a free block of that
+ * order starts at the chunk, zero otherwise.
+ */
+class kmem_region_t
+{
+public:
+    word_t      start;
+    word_t      end;
+    u8_t *      order_map;
+
+    bool contains (word_t addr)
+        { return addr >= start && addr < end; }
+    u8_t * map_entry (word_t addr)
+        { return &order_map[(addr - start) / KMEM_CHUNKSIZE]; }
+};
+
 class kmem_t
 {
-    word_t *kmem_free_list;
+    kmem_block_t * free_lists[KMEM_ORDERS];
+    word_t free_blocks[KMEM_ORDERS];    /* length of each free list */
+    word_t free_orders;                 /* bitmap of non-empty lists */
+    kmem_region_t regions[KMEM_MAX_REGIONS];
+    word_t num_regions;
     word_t free_chunks;
 
+    /* statistics */
+    word_t splits;
+    word_t merges;
+    word_t failed_allocs;
+
     void free (void * address, word_t size);
     void * alloc (word_t size, bool zeroed);
     void * alloc_aligned (word_t size, word_t alignement, word_t mask, bool zeroed);
+    void add_region (void * start, void * end);
+    kmem_region_t * find_region (word_t addr);
+    void enqueue_block (kmem_region_t * region, word_t addr, word_t order);
+    void dequeue_block (kmem_region_t * region, word_t addr, word_t order);
+    void free_block (kmem_region_t * region, word_t addr, word_t order);
+    void free_range (kmem_region_t * region, word_t addr, word_t size);
+    word_t take_block (kmem_region_t * region, word_t block, word_t order,
+                       word_t target, word_t want);
+    void * finish_alloc (word_t addr, word_t size, bool zeroed);
 #if defined(CONFIG_KMEM_DEBUG)
     void check_free(void * address, word_t size);
 #endif
@@ -126,7 +183,7 @@ public:
                           word_t mask, bool zeroed);
 
     void add (void * address, word_t size)
-        { free (address, size); }
+        { add_region (address, (void *)((word_t)address + size)); }
 
     word_t chunks_left(void)
         { return free_chunks; }
@@ -172,4 +172,149 @@ prio_queue_t::remove_sched_bitmap_bit(word_t prio)
     remove_sched_bitmap_bit(prio / BITS_WORD, prio % BITS_WORD);
 }
 
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+
+#include <sync.h>
+#include <profile.h>
+#include <kernel/arch/special.h>
+
+/**
+ * Lock and stealing statistics of a per-unit run queue.
+ */
+typedef struct run_queue_stats
+{
+    /** Number of times the queue lock was acquired. */
+    word_t acquisitions;
+
+    /** Threads this unit took from other units' queues. */
+    word_t steals;
+
+    /** Threads other units took from this unit's queue. */
+    word_t stolen;
+
+    /** Rebalance requests sent to this unit. */
+    word_t rebalances;
+
+#if defined(CONFIG_L4_PROFILING)
+    /** Total and worst-case time spent spinning for the lock. */
+    u64_t spin_cycles;
+    u64_t max_spin_cycles;
+
+    /** Total and worst-case time the lock was held. */
+    u64_t hold_cycles;
+    u64_t max_hold_cycles;
+#endif
+} run_queue_stats_t;
+
+/**
+ * The ready queue of a single hardware unit.
+ *
+ * Each unit of a scheduling domain owns one of these. A runnable thread is
+ * queued on the run queue of its home unit ('tcb_t::runqueue_unit'), which
+ * only changes while the thread is off the queue and the old home's lock is
+ * held. If both the scheduler's 'schedule_lock' and a run queue lock are
+ * required, 'schedule_lock' must be acquired first. Two run queue locks
+ * are always acquired in ascending unit order.
+ */
+class run_queue_t
+{
+public:
+    void init(word_t unit);
+
+    /** Acquire the queue lock, accounting spin time. */
+    void lock(void);
+
+    /** Release the queue lock, accounting hold time. */
+    void unlock(void);
+
+    /**
+     * Determine the highest priority of a thread on this queue.
+     *
+     * @pre The queue lock is held.
+     * @return The highest priority, or -1 if the queue is empty.
+     */
+    prio_t get_highest_priority(void);
+
+    /**
+     * Determine the highest priority of a thread on this queue without
+     * acquiring the queue lock. The result is only a hint.
+     */
+    prio_t peek_highest_priority(void);
+
+    /** The priority queue of threads homed on this unit. */
+    prio_queue_t queue;
+
+    /** Lock protecting 'queue'. */
+    spinlock_t queue_lock;
+
+    /** The unit owning this queue. */
+    word_t unit;
+
+    run_queue_stats_t stats;
+
+#if defined(CONFIG_L4_PROFILING)
+    /** Time the lock was last acquired. */
+    u64_t lock_start;
+#endif
+} ALIGNED(CACHE_LINE_SIZE);
+
+INLINE void
+run_queue_t::lock(void)
+{
+#if defined(CONFIG_L4_PROFILING)
+    u64_t start = profile_arch_read_timer();
+    queue_lock.lock();
+    lock_start = profile_arch_read_timer();
+
+    u64_t spin = lock_start - start;
+    stats.spin_cycles += spin;
+    if (spin > stats.max_spin_cycles) {
+        stats.max_spin_cycles = spin;
+    }
+#else
+    queue_lock.lock();
+#endif
+    stats.acquisitions++;
+}
+
+INLINE void
+run_queue_t::unlock(void)
+{
+#if defined(CONFIG_L4_PROFILING)
+    u64_t hold = profile_arch_read_timer() - lock_start;
+    stats.hold_cycles += hold;
+    if (hold > stats.max_hold_cycles) {
+        stats.max_hold_cycles = hold;
+    }
+#endif
+    queue_lock.unlock();
+}
+
+INLINE prio_t
+run_queue_t::peek_highest_priority(void)
+{
+    word_t first_level_bitmap = queue.index_bitmap;
+    if (!first_level_bitmap) {
+        return (prio_t)-1;
+    }
+    word_t first_level_index = msb(first_level_bitmap);
+
+    /* The second level may have been cleared under our feet. */
+    word_t second_level_bitmap = queue.prio_bitmap[first_level_index];
+    if (!second_level_bitmap) {
+        return (prio_t)-1;
+    }
+
+    return first_level_index * BITS_WORD + msb(second_level_bitmap);
+}
+
+INLINE prio_t
+run_queue_t::get_highest_priority(void)
+{
+    SMT_ASSERT(ALWAYS, queue_lock.is_locked(true));
+    return peek_highest_priority();
+}
+
+#endif /* CONFIG_PERCPU_RUNQUEUES */
+
 #endif /*__PRIOQUEUE_H__*/
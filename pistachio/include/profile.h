@@ -81,7 +81,7 @@
 #define PROFILE_SWITCH_FROM(from)       profile_switch_from(from)
 #define PROFILE_SWITCH_TO(to)           profile_switch_to(to)
 
-#define NUM_EVENTS  13
+#define NUM_EVENTS  17
 
 enum event_type_e
 {
@@ -98,6 +98,10 @@ enum event_type_e
     sys_interrupt_ctrl      = 10,
     sys_cap_ctrl            = 12,
     sys_remote_memcopy      = 13,
+    /* Individual operations of L4_CacheControl */
+    cache_range_op          = 14,
+    cache_full_op           = 15,
+    cache_outer_op          = 16,
     /* Arch specific events */
 #if defined(ARCH_NUM_EVENTS) && defined(ARCH_EVENT_TYPE) \
                              && defined(ARCH_EVENT_STR)
@@ -117,6 +121,17 @@ typedef struct profile_thread_data_t
     word_t switches;
 };
 
+/*
+ * Latency histograms are log-linear: every power of two of cycles is
+ * split into PROFILE_HIST_SUB linear buckets, giving a relative error
+ * of at most 1/PROFILE_HIST_SUB across the whole range. Samples of
+ * 2^32 cycles or more go in the last bucket.
+ */
+#define PROFILE_HIST_SUB_BITS   2
+#define PROFILE_HIST_SUB        (1UL << PROFILE_HIST_SUB_BITS)
+#define PROFILE_HIST_BUCKETS    \
+        ((32 - PROFILE_HIST_SUB_BITS + 1) * PROFILE_HIST_SUB)
+
 typedef struct profile_stats_t
 {
     u64_t start;
@@ -124,8 +139,33 @@ typedef struct profile_stats_t
     u64_t cycles;
     u64_t switches;
     int errors;
+    word_t min;
+    word_t max;
+    word_t hist[PROFILE_HIST_BUCKETS];
+};
+
+/* Operations understood by profile_handler(). */
+enum profile_op_e
+{
+    profile_op_enable       = 0,
+    profile_op_disable      = 1,
+    profile_op_reset        = 2,
+    profile_op_print        = 3,
+    profile_op_read_stats   = 4,
+    profile_op_read_hist    = 5,
 };
 
+/*
+ * Argument of the read operations: the event in bits 0..7, the unit in
+ * bits 8..15 and, for histograms, the first bucket in bits 16 and up.
+ */
+#define PROFILE_ARG_EVENT(arg)      ((arg) & 0xff)
+#define PROFILE_ARG_UNIT(arg)       (((arg) >> 8) & 0xff)
+#define PROFILE_ARG_BUCKET(arg)     ((arg) >> 16)
+
+/* Number of histogram buckets returned by each read. */
+#define PROFILE_HIST_READ_BUCKETS   16
+
 typedef struct
 {
     u64_t start;
@@ -141,7 +181,7 @@ extern "C" void profile_start(int e);
 extern "C" void profile_stop(int e);
 extern "C" void profile_stop_all(tcb_t *tcb);
 extern "C" void profile_stop_if_running(tcb_t *tcb, int e);
-extern "C" void profile_handler(word_t op);
+extern "C" word_t profile_handler(word_t op, word_t arg);
 extern "C" void profile_tcb_init(tcb_t *tcb);
 extern "C" void profile_switch_to(tcb_t *);
 extern "C" void profile_switch_from(tcb_t *);
@@ -63,8 +63,185 @@
 
 #if defined(CONFIG_MDOMAINS) ||  defined(CONFIG_MUNITS)
 
-/* Include the architecture-specific read/write lock. */
-#include <arch/read_write_lock.h>
+#include <atomic_ops/atomic_ops.h>
+
+/**
+ * Read/Write lock.
+ *
+ * Only a single writer may hold the lock at any time, but an
+ * unlimited number of readers. If a writing thread is waiting
+ * on the lock, they have preference over the reading threads.
+ *
+ * The whole lock state is kept in a single atomic word so that the
+ * read-side fast path (the capability lookups on the IPC path) is a
+ * single compare-and-set on an uncontended cache line:
+ *
+ *   bit 0      : RW_LOCK_WRITER  - a writer holds the lock
+ *   bit 1      : RW_LOCK_WAITING - a writer is waiting for the lock
+ *   bits 2..   : number of readers holding the lock
+ */
+struct read_write_lock_t
+{
+    /** Initialise the read/write lock. */
+    void init();
+
+    /**
+     * Acquire this lock for reading. Other readers may still acquire
+     * the lock.
+     */
+    void lock_read(void);
+
+    /**
+     * Use this function only if the reader already holds this lock
+     * and needs to acquire the same lock for reading a second time.
+     *
+     * Acquire this lock for reading even though there are pending writers.
+     * Other readers may still acquire the lock.
+     */
+    void lock_read_already_held(void);
+
+    /**
+     * Try acquire this lock for reading. Other readers may still acquire
+     * the lock.
+     *
+     * @returns true if lock aquired, false if lock held
+     */
+    bool try_lock_read(void);
+
+    /**
+     * Release this lock for reading.
+     */
+    void unlock_read(void);
+
+    /**
+     * Acquire this lock for writing. The lock will not be acquired
+     * until all other readers or writers have released the lock. No new
+     * readers will be allowed to take the lock until we fully acquire
+     * it and release it.
+     */
+    void lock_write(void);
+
+    /**
+     * Try aquire writer lock
+     *
+     * @returns true if lock aquired, false if lock held
+     */
+    bool try_lock_write(void);
+
+    /**
+     * Release the lock for writing.
+     */
+    void unlock_write(void);
+
+    /** Determine if the lock is currently held by any thread. */
+    bool is_locked(void);
+
+    okl4_atomic_word_t state;
+};
+
+#define RW_LOCK_WRITER          (1UL << 0)
+#define RW_LOCK_WAITING         (1UL << 1)
+#define RW_LOCK_READER          (1UL << 2)
+
+INLINE void
+read_write_lock_t::init()
+{
+    okl4_atomic_set(&state, 0);
+}
+
+INLINE bool
+read_write_lock_t::try_lock_read(void)
+{
+    word_t old = okl4_atomic_read(&state);
+
+    if (old & (RW_LOCK_WRITER | RW_LOCK_WAITING)) {
+        return false;
+    }
+    if (!okl4_atomic_compare_and_set(&state, old, old + RW_LOCK_READER)) {
+        return false;
+    }
+    okl4_atomic_barrier_smp();
+    return true;
+}
+
+INLINE void
+read_write_lock_t::lock_read(void)
+{
+    while (!try_lock_read()) {
+        /* Spin without writing to the lock word until it looks free. */
+        while (okl4_atomic_read(&state) & (RW_LOCK_WRITER | RW_LOCK_WAITING));
+    }
+}
+
+INLINE void
+read_write_lock_t::lock_read_already_held(void)
+{
+    ASSERT(DEBUG, okl4_atomic_read(&state) >= RW_LOCK_READER);
+    okl4_atomic_add(&state, RW_LOCK_READER);
+    okl4_atomic_barrier_smp();
+}
+
+INLINE void
+read_write_lock_t::unlock_read(void)
+{
+    ASSERT(DEBUG, okl4_atomic_read(&state) >= RW_LOCK_READER);
+    okl4_atomic_barrier_smp();
+    okl4_atomic_sub(&state, RW_LOCK_READER);
+}
+
+INLINE bool
+read_write_lock_t::try_lock_write(void)
+{
+    word_t old = okl4_atomic_read(&state);
+
+    /* A waiting writer may be overtaken, but never a reader. */
+    if (old & ~RW_LOCK_WAITING) {
+        return false;
+    }
+    if (!okl4_atomic_compare_and_set(&state, old, RW_LOCK_WRITER)) {
+        return false;
+    }
+    okl4_atomic_barrier_smp();
+    return true;
+}
+
+INLINE void
+read_write_lock_t::lock_write(void)
+{
+    while (true) {
+        /* Hold off new readers, then wait for the current ones to drain. */
+        okl4_atomic_or(&state, RW_LOCK_WAITING);
+        if (okl4_atomic_compare_and_set(&state, RW_LOCK_WAITING,
+                                        RW_LOCK_WRITER)) {
+            break;
+        }
+        while (okl4_atomic_read(&state) & ~RW_LOCK_WAITING);
+    }
+    okl4_atomic_barrier_smp();
+}
+
+INLINE void
+read_write_lock_t::unlock_write(void)
+{
+    ASSERT(DEBUG, okl4_atomic_read(&state) & RW_LOCK_WRITER);
+    okl4_atomic_barrier_smp();
+    /* Drop the writer bit but keep any waiting indication of other writers. */
+    okl4_atomic_and(&state, ~RW_LOCK_WRITER);
+}
+
+INLINE bool
+read_write_lock_t::is_locked(void)
+{
+    return (okl4_atomic_read(&state) & ~RW_LOCK_WAITING) != 0;
+}
+
+/** Import an externally-declared read_write_lock. */
+#define DECLARE_READ_WRITE_LOCK(name) extern read_write_lock_t name
+
+/** Definie a statically-allocated read_write_lock. */
+#define DEFINE_READ_WRITE_LOCK(name) \
+        read_write_lock_t name = \
+                ((read_write_lock_t){{0}})
 
 #else /* !CONFIG_MDOMAINS && !CONFIG_MUNITS */
 
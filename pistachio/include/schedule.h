@@ -322,6 +322,49 @@ private:
      */
     void dequeue(tcb_t * tcb);
 
+    /**
+     * Determine if another thread of the given priority is ready to run on
+     * the current unit.
+     */
+    bool is_ready_at_priority(prio_t prio);
+
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+    /**
+     * Lock the run queue of the given thread's home unit.
+     *
+     * @return The locked run queue.
+     */
+    run_queue_t * lock_run_queue(tcb_t * tcb);
+
+    /** Lock the run queues of two units in ascending unit order. */
+    void lock_run_queues(word_t unit1, word_t unit2);
+
+    /** Unlock the run queues locked by lock_run_queues(). */
+    void unlock_run_queues(word_t unit1, word_t unit2);
+
+    /**
+     * Find the unit whose run queue holds the highest priority thread,
+     * preferring 'unit' on ties. The queues are inspected without locking,
+     * so the result is only a hint.
+     *
+     * @param unit  The unit performing the search.
+     * @param prio  Returns the highest priority found, or -1.
+     * @return      The unit to take the next thread from.
+     */
+    word_t find_busiest_run_queue(word_t unit, prio_t * prio);
+
+public:
+    /**
+     * Ask units running a thread of lower priority than a thread queued
+     * on another unit's run queue to reschedule, so that they steal it.
+     */
+    void rebalance_units();
+
+    /** Get the run queue of the given unit. */
+    run_queue_t * get_run_queue(word_t unit)
+        { return &run_queues[unit]; }
+#endif
+
 public:
 
     /**
@@ -384,6 +427,39 @@ public:
     INLINE u64_t get_current_time(void);
 #endif
 
+#if defined(CONFIG_TICKLESS)
+    /**
+     * Charge the time used since the last charge to the active schedule
+     * and program the one-shot timer for the expiry of the next schedule.
+     * Called on every switch between schedules.
+     *
+     * @param next  The schedule about to become active.
+     */
+    void switch_schedule_timer(tcb_t * next);
+
+    /**
+     * Charge the active schedule and reprogram the one-shot timer, for
+     * when a new deadline may expire before the programmed one.
+     */
+    void rearm_timer(void);
+
+private:
+    /**
+     * Read the system time and return the time elapsed since the active
+     * schedule was last charged.
+     */
+    word_t consume_elapsed_time(void);
+
+    /**
+     * Program the one-shot timer for the end of the given schedule's
+     * timeslice. No timer interrupt is needed for the idle thread or
+     * infinite timeslices.
+     */
+    void program_timer(tcb_t * schedule);
+
+public:
+#endif
+
     /**
      * Main part of schedule system call.
      *
@@ -561,18 +637,33 @@ private:
      */
     void remove_sched_bitmap_bit(word_t level1_index, word_t level2_index);
 
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+    /** Ready queues of each hardware unit. */
+    run_queue_t run_queues[CONFIG_MAX_UNITS_PER_DOMAIN];
+#else
     /** The scheduler's priority queue. */
     prio_queue_t prio_queue;
+#endif
 
     /** Amount of time that has passed since system boot. */
     static volatile u64_t current_time;
 
+#if defined(CONFIG_TICKLESS)
+    /** System time at which the active schedule was last charged. */
+    u64_t last_charge_time;
+#endif
+
+public:
+    /** Number of timer interrupts handled since system boot. */
+    word_t timer_interrupts;
+
 public:
 #if defined(CONFIG_MUNITS)
     /* Bitmap of units to reschedule */
     okl4_atomic_word_t reschedule_unit_requests;
 
-    /* Lock of ipi and prio queue. */
+    /* Lock of ipi and prio queue. With per-unit run queues, the queues
+     * are protected by their own locks instead. */
     fifo_spinlock_t schedule_lock;
 
     /* The hardware unit with the lowest priority in this domain. */
@@ -627,7 +718,13 @@ scheduler_t::enqueue(tcb_t * tcb)
         return;
     }
 
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+    run_queue_t * rq = lock_run_queue(tcb);
+    rq->queue.enqueue(tcb);
+    rq->unlock();
+#else
     prio_queue.enqueue(tcb);
+#endif
 }
 
 INLINE void
@@ -635,9 +732,70 @@ scheduler_t::dequeue(tcb_t * tcb)
 {
     ASSERT(DEBUG, tcb != get_idle_tcb());
 
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+    /* The caller's check of 'ready_list' was done without the queue lock;
+     * another unit may have stolen the thread since. */
+    run_queue_t * rq = lock_run_queue(tcb);
+    if (tcb->ready_list.is_queued()) {
+        rq->queue.dequeue(tcb);
+    }
+    rq->unlock();
+#else
     prio_queue.dequeue(tcb);
+#endif
+}
+
+INLINE bool
+scheduler_t::is_ready_at_priority(prio_t prio)
+{
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+    return run_queues[get_current_context().unit].queue.get(prio) != NULL;
+#else
+    return prio_queue.get(prio) != NULL;
+#endif
+}
+
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+INLINE run_queue_t *
+scheduler_t::lock_run_queue(tcb_t * tcb)
+{
+    while (1) {
+        word_t unit = tcb->runqueue_unit;
+        run_queue_t * rq = &run_queues[unit];
+
+        rq->lock();
+        /* The thread may have been moved while we were spinning. */
+        if (EXPECT_TRUE(tcb->runqueue_unit == unit)) {
+            return rq;
+        }
+        rq->unlock();
+    }
 }
 
+INLINE void
+scheduler_t::lock_run_queues(word_t unit1, word_t unit2)
+{
+    if (unit1 == unit2) {
+        run_queues[unit1].lock();
+    } else if (unit1 < unit2) {
+        run_queues[unit1].lock();
+        run_queues[unit2].lock();
+    } else {
+        run_queues[unit2].lock();
+        run_queues[unit1].lock();
+    }
+}
+
+INLINE void
+scheduler_t::unlock_run_queues(word_t unit1, word_t unit2)
+{
+    run_queues[unit1].unlock();
+    if (unit1 != unit2) {
+        run_queues[unit2].unlock();
+    }
+}
+#endif
+
 INLINE NORETURN void
 scheduler_t::fast_schedule(tcb_t * current, fast_schedule_type_e type,
                            continuation_t continuation,
@@ -767,18 +925,32 @@ scheduler_t::donate(tcb_t * dest_tcb, tcb_t * current,
     ASSERT(ALWAYS, current->get_state().is_runnable());
 
     schedule_lock.lock();
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+    /* Units stealing work from the queue do not hold the schedule lock;
+     * hold the run queue lock so the destination can not be taken between
+     * the check and the grab. */
+    run_queue_t * rq = lock_run_queue(dest_tcb);
+#endif
 
     /* Ensure that the destination is runnable and can be grabbed. */
     if (!dest_tcb->get_state().is_runnable()
             || !dest_tcb->ready_list.is_queued() || !dest_tcb->grab()) {
         /* Can't do a donation, so yield instead. */
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+        rq->unlock();
+#endif
         schedule_lock.unlock();
         yield(current, get_active_schedule(), continuation);
         NOTREACHED();
     }
 
     /* Remove it from the scheduling queue. */
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+    rq->queue.dequeue(dest_tcb);
+    rq->unlock();
+#else
     dequeue(dest_tcb);
+#endif
 
     /* Switch to the destination. */
     switch_from(current, continuation);
@@ -896,7 +1068,13 @@ scheduler_t::set_priority(tcb_t * tcb, prio_t prio)
     schedule_lock.lock();
 
     /* Update the base priority of the thread. */
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+    run_queue_t * rq = lock_run_queue(tcb);
+    rq->queue.set_base_priority(tcb, prio);
+    rq->unlock();
+#else
     prio_queue.set_base_priority(tcb, prio);
+#endif
 
     /* Propagate the priority changes. */
     if (tcb->get_waiting_for() != NULL) {
@@ -914,6 +1092,10 @@ scheduler_t::init_tcb(tcb_t * tcb, prio_t prio = DEFAULT_PRIORITY,
                       word_t timeslice_length = DEFAULT_TIMESLICE_LENGTH,
                       word_t context_bitmask = DEFAULT_CONTEXT_BITMASK)
 {
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+    /* New threads start out homed on the creating unit. */
+    tcb->runqueue_unit = get_current_context().unit;
+#endif
     set_timeslice_length(tcb, timeslice_length);
     set_priority(tcb, prio);
     set_context_bitmask(tcb, context_bitmask);
@@ -923,8 +1105,13 @@ scheduler_t::init_tcb(tcb_t * tcb, prio_t prio = DEFAULT_PRIORITY,
 INLINE u64_t
 scheduler_t::get_current_time(void)
 {
+#if defined(CONFIG_TICKLESS)
+    /* There is no tick to count; read the free-running counter. */
+    return soc_get_system_time();
+#else
     /* no real need to lock here */
     return current_time;
+#endif
 }
 #endif
 
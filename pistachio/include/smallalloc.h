@@ -94,6 +94,20 @@ public:
     /* free an object */
     void free(void * object);
 
+    /* size of the objects in this pool */
+    word_t get_obj_size(void)
+    {
+        return this->obj_size;
+    }
+
+    /**
+      @brief indicate if an object can be allocated without growing the pool.
+     */
+    bool has_free(void)
+    {
+        return this->first_free != NULL && !is_full();
+    }
+
     /* get the ID of the object allocated */
     word_t id(void * object);
 
@@ -112,7 +112,7 @@ void process_xcpu_mailbox(continuation_t continuation);
  *
  **********************************************************************/
 
-// maximum number of outstanding XCPU requests
+// maximum number of outstanding XCPU requests, must be a power of two
 #define MAX_MAILBOX_ENTRIES     32
 
 class cpu_mb_entry_t;
@@ -149,42 +149,75 @@ public:
     xcpu_handler_t handler;
     tcb_t * tcb;
     word_t param[8];
+#if defined(CONFIG_L4_PROFILING)
+    /* time the request was entered */
+    u64_t enter_time;
+#endif
 };
 
+/**
+ * Statistics of an XCPU mailbox.
+ */
+typedef struct cpu_mb_stats
+{
+    /** Requests entered into the mailbox. */
+    okl4_atomic_word_t requests;
+
+    /** IPIs sent to the owner, at most one per burst of requests. */
+    okl4_atomic_word_t ipis;
+
+    /** Times a sender found the mailbox full and had to wait. */
+    okl4_atomic_word_t stalls;
+
+    /** Most requests found outstanding by the owner. */
+    word_t max_depth;
+
+    /** Requests the owner set aside while itself stalled on a full mailbox. */
+    word_t deferred;
+
+#if defined(CONFIG_L4_PROFILING)
+    /** Total and worst-case time from entering a request to handling it. */
+    u64_t latency_cycles;
+    u64_t max_latency_cycles;
+#endif
+} cpu_mb_stats_t;
+
 /**
  * Asynchronous XCPU mailbox
- * currently not very efficient using a spin-lock for the mailbox
+ *
+ * A bounded lock-free queue with many producers, the other units, and
+ * a single consumer, the unit owning the mailbox. A producer claims a
+ * ticket by advancing 'tail'. The ticket selects a slot whose sequence
+ * number tells whether the slot is free for that ticket, and the
+ * sequence is advanced once the entry is filled in. The owner takes
+ * entries in ticket order and frees each slot for the ticket one lap
+ * later.
+ *
+ * Sequence numbers are stored relative to the slot index, so that a
+ * zero-filled mailbox is empty.
+ *
+ * A unit stalled on another unit's full mailbox cannot run handlers,
+ * since they complete through continuations. Instead it moves the
+ * requests in its own mailbox to a private backlog, which frees the
+ * slots a peer stalled on it is waiting for. The backlog is handled
+ * ahead of the mailbox on the next walk. It starts out in the mailbox
+ * and is grown from kernel memory whenever a stall fills it, so that a
+ * stalled unit can always drain its mailbox.
  */
 class cpu_mb_t
 {
 public:
     void walk_mailbox() NORETURN;
-    cpu_mb_entry_t * alloc()
-        {
-            lock.lock();
-            if ( ((first_free + 1) % MAX_MAILBOX_ENTRIES) == first_alloc )
-            {
-                lock.unlock();
-                return NULL;
-            }
-            unsigned idx = first_free;
-            first_free = (first_free + 1) % MAX_MAILBOX_ENTRIES;
-            return &entries[idx];
-        }
-
-    void commit (cpu_mb_entry_t * entry)
-        {
-            lock.unlock();
-        }
 
     bool enter (xcpu_handler_t handler, tcb_t * tcb,
                 word_t param0, word_t param1, word_t param2)
         {
-            cpu_mb_entry_t * entry = alloc();
+            word_t ticket;
+            cpu_mb_entry_t * entry = alloc(&ticket);
             if (!entry) return false;
 
             entry->set(handler, tcb, param0, param1, param2);
-            commit(entry);
+            commit(entry, ticket);
             return true;
         }
 
@@ -192,20 +225,106 @@ public:
                 word_t param0, word_t param1, word_t param2, word_t param3,
                 word_t param4, word_t param5, word_t param6, word_t param7)
         {
-            cpu_mb_entry_t * entry = alloc();
+            word_t ticket;
+            cpu_mb_entry_t * entry = alloc(&ticket);
             if (!entry) return false;
 
             entry->set (handler, tcb,
                         param0, param1, param2, param3,
                         param4, param5, param6, param7);
-            commit(entry);
+            commit(entry, ticket);
+            return true;
+        }
+
+    /**
+     * Called by a sender after entering a request. Returns true if the
+     * sender must interrupt the owner, which is only the case for the
+     * first request since the owner last started walking the mailbox.
+     */
+    bool need_ipi()
+        {
+            if (okl4_atomic_read(&ipi_pending) != 0 ||
+                    !okl4_atomic_compare_and_set(&ipi_pending, 0, 1)) {
+                return false;
+            }
+            okl4_atomic_inc(&stats.ipis);
             return true;
         }
 
+    /** Called by a sender waiting for the owner to drain a full mailbox. */
+    void stall()
+        {
+            okl4_atomic_inc(&stats.stalls);
+            okl4_atomic_barrier_smp();
+        }
+
+    void defer();
+
+public:
+    cpu_mb_stats_t stats;
+
 private:
-    volatile unsigned first_alloc;
-    volatile unsigned first_free;
-    spinlock_t lock;
+    word_t get_sequence(word_t idx)
+        { return okl4_atomic_read(&sequence[idx]) + idx; }
+
+    void set_sequence(word_t idx, word_t seq)
+        { okl4_atomic_set(&sequence[idx], seq - idx); }
+
+    cpu_mb_entry_t * alloc(word_t * ticket)
+        {
+            for (;;) {
+                word_t pos = okl4_atomic_read(&tail);
+                word_t idx = pos % MAX_MAILBOX_ENTRIES;
+                word_t seq = get_sequence(idx);
+
+                if (seq == pos) {
+                    if (okl4_atomic_compare_and_set(&tail, pos, pos + 1)) {
+                        *ticket = pos;
+                        return &entries[idx];
+                    }
+                } else if ((long)(seq - pos) < 0) {
+                    /* The owner has not taken this slot's last entry. */
+                    return NULL;
+                }
+                okl4_atomic_barrier_smp();
+            }
+        }
+
+    void commit (cpu_mb_entry_t * entry, word_t ticket)
+        {
+#if defined(CONFIG_L4_PROFILING)
+            entry->enter_time = profile_arch_read_timer();
+#endif
+            okl4_atomic_barrier_write_smp();
+            set_sequence(ticket % MAX_MAILBOX_ENTRIES, ticket + 1);
+            /* Order the publish against the read of ipi_pending in
+             * need_ipi(), as walk_mailbox() orders its clear of
+             * ipi_pending against take(). */
+            okl4_atomic_barrier_smp();
+            okl4_atomic_inc(&stats.requests);
+        }
+
+    bool take (cpu_mb_entry_t * entry);
+    bool next (cpu_mb_entry_t * entry);
+    bool grow_backlog();
+    void shrink_backlog();
+
+private:
+    /* next ticket handed to a sender */
+    okl4_atomic_word_t tail;
+    /* set while an IPI to the owner is outstanding */
+    okl4_atomic_word_t ipi_pending;
+    /* next ticket taken by the owner, owner only */
+    word_t head ALIGNED(CACHE_LINE_SIZE);
+    /* requests set aside by defer(), owner only */
+    word_t backlog_head;
+    word_t backlog_tail;
+    /* grown backlog ring, NULL while backlog_inline is used */
+    cpu_mb_entry_t * backlog;
+    word_t backlog_size;
+    cpu_mb_entry_t backlog_inline[MAX_MAILBOX_ENTRIES];
+    okl4_atomic_word_t sequence[MAX_MAILBOX_ENTRIES]
+    ALIGNED(CACHE_LINE_SIZE);
     cpu_mb_entry_t entries[MAX_MAILBOX_ENTRIES]
     ALIGNED(CACHE_LINE_SIZE);
 } ALIGNED(CACHE_LINE_SIZE);
@@ -226,21 +345,42 @@ INLINE cpu_mb_t * get_cpu_mailbox (cpu_context_t dst)
     return &cpu_mailboxes[index];
 }
 
+/*
+ * Interrupt the owner of a mailbox after entering requests. Bursts of
+ * requests share a single IPI.
+ */
+INLINE void xcpu_signal(cpu_context_t dstcpu, cpu_mb_t * mailbox)
+{
+#ifndef CONFIG_SMP_IDLE_POLL
+    if (mailbox->need_ipi()) {
+        get_mp()->interrupt_context(dstcpu);
+    }
+#endif
+}
+
+/*
+ * Wait for the owner of a full mailbox, while freeing up our own so
+ * that a unit waiting on us in turn can make progress.
+ */
+INLINE void xcpu_stall(cpu_context_t dstcpu, cpu_mb_t * mailbox)
+{
+    xcpu_signal(dstcpu, mailbox);
+    get_cpu_mailbox(get_current_context())->defer();
+    mailbox->stall();
+}
+
 INLINE void xcpu_request(cpu_context_t dstcpu, xcpu_handler_t handler,
                          tcb_t * tcb = NULL,
                          word_t param0 = 0, word_t param1 = 0,
                          word_t param2 = 0 )
 {
-    if (! get_cpu_mailbox(dstcpu)->enter(handler, tcb,
-                                             param0, param1, param2) )
-    {
-        printf("Mailbox for %x full, attempted to place handler %p\n", dstcpu.raw, handler);
-        UNIMPLEMENTED();
+    cpu_mb_t * mailbox = get_cpu_mailbox(dstcpu);
+
+    /* If the mailbox is full, wait for its owner to drain it. */
+    while (! mailbox->enter(handler, tcb, param0, param1, param2)) {
+        xcpu_stall(dstcpu, mailbox);
     }
-#ifndef CONFIG_SMP_IDLE_POLL
-    /* trigger an IPI */
-    get_mp()->interrupt_context(dstcpu);
-#endif
+    xcpu_signal(dstcpu, mailbox);
 }
 
 INLINE void xcpu_request(cpu_context_t dstcpu, xcpu_handler_t handler, tcb_t * tcb,
@@ -249,15 +389,14 @@ INLINE void xcpu_request(cpu_context_t dstcpu, xcpu_handler_t handler, tcb_t * t
                          word_t param4 = 0, word_t param5 = 0,
                          word_t param6 = 0, word_t param7 = 0)
 {
-    if (! get_cpu_mailbox(dstcpu)->enter(handler, tcb,
-                                             param0, param1, param2, param3,
-                                             param4, param5, param6, param7)) {
-        UNIMPLEMENTED();
+    cpu_mb_t * mailbox = get_cpu_mailbox(dstcpu);
+
+    while (! mailbox->enter(handler, tcb,
+                            param0, param1, param2, param3,
+                            param4, param5, param6, param7)) {
+        xcpu_stall(dstcpu, mailbox);
     }
-#ifndef CONFIG_SMP_IDLE_POLL
-    /* trigger an IPI */
-    get_mp()->interrupt_context(dstcpu);
-#endif
+    xcpu_signal(dstcpu, mailbox);
 }
 
 
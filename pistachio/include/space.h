@@ -230,6 +230,12 @@ public:
     void flush_tlbent_local (space_t * curspace, addr_t vaddr, word_t log2size);
     bool does_tlbflush_pay (word_t log2size);
 
+    /* batched tlb flushing, see tlb_flush_batch.h */
+    void begin_tlbent_flush (space_t * curspace);
+    void flush_tlbent (addr_t vaddr, word_t log2size);
+    void flush_cacheent (addr_t vaddr, word_t log2size);
+    void end_tlbent_flush (space_t * curspace);
+
     /* update hooks */
     static void begin_update() { }
     static void end_update() { }
@@ -274,6 +280,11 @@ public:
     resource_ids_t      space_range;
     resource_ids_t      clist_range;
 
+#if defined(CONFIG_IPC_WINDOWS)
+    /* IPC windows lent by threads of this space */
+    word_t              ipc_windows_lent;
+#endif
+
 #ifdef CONFIG_SPACE_NAMES
     char                debug_name[MAX_DEBUG_NAME_LENGTH];
 #endif
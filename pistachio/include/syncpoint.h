@@ -75,8 +75,14 @@ public:
      *
      *  @param donatee The TCB reference of the initial donatee thread
      *  for this syncpoint.
+     *
+     *  @param indexed Maintain a per-priority index of the blocked
+     *  queue, making enqueues O(number of distinct priorities) instead
+     *  of O(number of blocked threads). Syncpoints whose blocked queue
+     *  is manipulated directly by assembler fastpaths must not be
+     *  indexed.
      */
-    void init(tcb_t * donatee);
+    void init(tcb_t * donatee, bool indexed);
 
     /** Does this sync-point have threads blocked on it? */
     bool has_blocked(void);
@@ -157,6 +163,23 @@ private:
      */
     void enqueue_tcb_sorted(tcb_t * tcb);
 
+    /**
+     * Enqueue the given TCB in effective priority ordering into this
+     * syncpoints blocked list, using the per-priority band index to
+     * find its position. Threads of equal priority are queued FIFO.
+     *
+     * @param tcb ...
+     */
+    void enqueue_tcb_indexed(tcb_t * tcb);
+
+    /**
+     * Remove the given TCB from this syncpoint's per-priority band
+     * index. The TCB remains on the blocked list.
+     *
+     * @param tcb ...
+     */
+    void dequeue_tcb_indexed(tcb_t * tcb);
+
     /**
      * Add a thread to the queue of threads blocked on this
      * synchronisation point.
@@ -252,6 +275,9 @@ private:
     /** First TCB waiting on this syncpoint. */
     tcb_t * blocked_head;
 
+    /** Is the blocked list indexed by priority band? */
+    bool indexed;
+
     friend void mkasmsym(void);
 };
 
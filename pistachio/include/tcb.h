@@ -104,6 +104,8 @@
 #include <mutex.h>
 #include <read_write_lock.h>
 #include <profile.h>
+#include <ipc_window.h>
+#include <irq_coalesce.h>
 
 /* implementation specific functions */
 #include <arch/ktcb.h>
@@ -512,6 +514,16 @@ public:
      */
     ringlist_t<tcb_t>   blocked_list;
 
+    /**
+     * Ring of the first thread of each priority blocked on an indexed
+     * synchronisation point. Only the first thread of each priority is
+     * on this ring; the other threads have a NULL 'next' pointer.
+     */
+    ringlist_t<tcb_t>   blocked_band;
+
+    /** Priority this thread was queued at on an indexed syncpoint. */
+    prio_t              blocked_prio;
+
     /** List of mutexes currently held by this thread. */
     mutex_t *           mutexes_head;
 
@@ -558,6 +570,12 @@ public:
     okl4_atomic_word_t       reserved;
 #endif
 
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+    /* Unit whose run queue this thread is placed on when runnable. Only
+     * modified while holding that unit's run queue lock. */
+    word_t              runqueue_unit;
+#endif
+
 public:
     tcb_t *             saved_partner;
     thread_state_t      saved_state;
@@ -585,6 +603,16 @@ public:
     profile_thread_data_t profile_data;
 #endif
 
+#if defined(CONFIG_IPC_WINDOWS)
+    /* Zero-copy IPC window lent or borrowed by this thread */
+    ipc_window_t        ipc_window;
+#endif
+
+#if defined(CONFIG_IRQ_COALESCING)
+    /* Batching of interrupts delivered to this thread */
+    irq_coalesce_t      irq_coalesce;
+#endif
+
 private:
     /* do not delete this STRUCT_END_MARKER */
 
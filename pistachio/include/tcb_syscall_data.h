@@ -185,6 +185,9 @@ public:
 
         tcb_t *             from_tcb;
         tcb_t *             to_tcb;
+        /* remote thread, revalidated after every preemption point */
+        tcb_t *             remote_tcb;
+        word_t              remote_handle;
         continuation_t      memory_copy_cont;
     } remote_memcpy_data_t;
 
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2008 Open Kernel Labs, Inc. (Copyright Holder).
+ * All rights reserved.
+ *
+ * 1. Redistribution and use of OKL4 (Software) in source and binary
+ * forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ *     (a) Redistributions of source code must retain this clause 1
+ *         (including paragraphs (a), (b) and (c)), clause 2 and clause 3
+ *         (Licence Terms) and the above copyright notice.
+ *
+ *     (b) Redistributions in binary form must reproduce the above
+ *         copyright notice and the Licence Terms in the documentation and/or
+ *         other materials provided with the distribution.
+ *
+ *     (c) Redistributions in any form must be accompanied by information on
+ *         how to obtain complete source code for:
+ *        (i) the Software; and
+ *        (ii) all accompanying software that uses (or is intended to
+ *        use) the Software whether directly or indirectly.  Such source
+ *        code must:
+ *        (iii) either be included in the distribution or be available
+ *        for no more than the cost of distribution plus a nominal fee;
+ *        and
+ *        (iv) be licensed by each relevant holder of copyright under
+ *        either the Licence Terms (with an appropriate copyright notice)
+ *        or the terms of a licence which is approved by the Open Source
+ *        Initative.  For an executable file, "complete source code"
+ *        means the source code for all modules it contains and includes
+ *        associated build and other files reasonably required to produce
+ *        the executable.
+ *
+ * 2. THIS SOFTWARE IS PROVIDED ``AS IS'' AND, TO THE EXTENT PERMITTED BY
+ * LAW, ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  WHERE ANY WARRANTY IS
+ * IMPLIED AND IS PREVENTED BY LAW FROM BEING DISCLAIMED THEN TO THE
+ * EXTENT PERMISSIBLE BY LAW: (A) THE WARRANTY IS READ DOWN IN FAVOUR OF
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT) AND (B) ANY LIMITATIONS PERMITTED BY LAW (INCLUDING AS TO
+ * THE EXTENT OF THE WARRANTY AND THE REMEDIES AVAILABLE IN THE EVENT OF
+ * BREACH) ARE DEEMED PART OF THIS LICENCE IN A FORM MOST FAVOURABLE TO
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT). IN THE LICENCE TERMS, "PARTICIPANT" INCLUDES EVERY
+ * PERSON WHO HAS CONTRIBUTED TO THE SOFTWARE OR WHO HAS BEEN INVOLVED IN
+ * THE DISTRIBUTION OR DISSEMINATION OF THE SOFTWARE.
+ *
+ * 3. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR ANY OTHER PARTICIPANT BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Description:   Batched TLB invalidation for page table walks
+ */
+#ifndef __TLB_FLUSH_BATCH_H__
+#define __TLB_FLUSH_BATCH_H__
+
+#include <space.h>
+
+/*
+ * Number of entries a batch invalidates one by one before it gives up and
+ * flushes the whole space instead.  Architectures may override this.
+ */
+#if !defined(TLB_FLUSH_BATCH_ENTRIES)
+#define TLB_FLUSH_BATCH_ENTRIES     16
+#endif
+
+/**
+ * Collects the TLB invalidations of one page table walk on a space.
+ *
+ * The first entries are invalidated individually, with the space set up
+ * for it only once per batch rather than once per entry.  Once an entry
+ * is too large (see does_tlbflush_pay()) or the batch holds more than
+ * TLB_FLUSH_BATCH_ENTRIES entries, the remaining invalidations are left
+ * to a single flush_tlb() of the space when the batch is flushed; this
+ * is ASID-wide where the architecture has ASIDs, and a full flush
+ * otherwise.  flush_tlb() need not maintain the caches (it does not on
+ * ARMv6), so the small entries left to it still have their cache lines
+ * flushed one by one through flush_cacheent().
+ *
+ * Entries are added before the page table entry is changed, as with
+ * flush_tlbent_local().  flush() must be called before the walk returns.
+ */
+class tlb_flush_batch_t
+{
+public:
+    void init(generic_space_t *space, space_t *curspace)
+    {
+        this->space = space;
+        this->curspace = curspace;
+        this->entries = 0;
+        this->started = false;
+        this->flush_space = false;
+    }
+
+    /* Invalidate the TLB entry mapping vaddr */
+    void add(addr_t vaddr, word_t log2size)
+    {
+        if (space->does_tlbflush_pay(log2size)) {
+            flush_space = true;
+            return;
+        }
+        if (!started) {
+            space->begin_tlbent_flush(curspace);
+            started = true;
+        }
+        if (flush_space || entries == TLB_FLUSH_BATCH_ENTRIES) {
+            flush_space = true;
+            space->flush_cacheent(vaddr, log2size);
+            return;
+        }
+        space->flush_tlbent(vaddr, log2size);
+        entries++;
+    }
+
+    /* Invalidate the whole space, e.g. after removing a subtree */
+    void add_space(void)
+    {
+        flush_space = true;
+    }
+
+    void flush(void)
+    {
+        if (started) {
+            space->end_tlbent_flush(curspace);
+        }
+        if (flush_space) {
+            space->flush_tlb(curspace);
+        }
+        /* XXX flush remote cpus here, once per batch */
+        entries = 0;
+        started = false;
+        flush_space = false;
+    }
+
+private:
+    generic_space_t *space;
+    space_t *curspace;
+    word_t entries;
+    bool started;
+    bool flush_space;
+};
+
+#endif /* !__TLB_FLUSH_BATCH_H__ */
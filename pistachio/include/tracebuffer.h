@@ -64,6 +64,8 @@
 #ifndef __TRACEBUFFER_H__
 #define __TRACEBUFFER_H__
 
+#include <atomic_ops/atomic_ops.h>
+
 #define TBUF_MEMDESC_TYPE   (memdesc_type_t)0xb
 
 class trace_entry_t {
@@ -99,26 +101,48 @@ public:
 };
 
 #define TBUF_MAGIC      0x7b6b5b4b3b2b1b0bULL
-#define TBUF_VERSION    1
+#define TBUF_VERSION    2
 #define TBUF_ID         1       /* L4 tracebuffer */
-#define TBUF_BUFFERS    2
+#if defined(CONFIG_MUNITS)
+#define TBUF_BUFFERS    CONFIG_NUM_UNITS
+#else
+#define TBUF_BUFFERS    1
+#endif
+
+/*
+ * Each execution unit records into its own ring, so recording never
+ * contends with other units. Producers reserve space by advancing
+ * 'reserve' and publish the entry by moving 'head' once it is written.
+ * The reader consumes entries between 'tail' and 'head' and then
+ * advances 'tail'. A ring is full when a new entry would reach 'tail';
+ * such entries are dropped and counted in 'overflows'.
+ *
+ * Entries never straddle the end of a ring. If the space left before the
+ * end is at least sizeof(trace_entry_t), it starts with a padding entry
+ * whose header is zero; otherwise it is too small to hold an entry. In
+ * both cases the reader continues at the start of the ring.
+ */
+class trace_ring_t {
+public:
+    word_t offset;              /* offset of ring from header   */
+    word_t size;                /* size of ring (bytes)         */
+    okl4_atomic_word_t reserve; /* end of reserved space        */
+    word_t head;                /* end of last written entry    */
+    word_t tail;                /* start of oldest unread entry */
+    word_t overflows;           /* number of dropped entries    */
+};
 
 class trace_buffer_t {
 public:
     word_t magic;               /* magic number         */
     word_t version;             /* tracebuffer version  */
     word_t bufid;               /* tracebuffer id       */
-    word_t buffers;             /* number of buffers    */
+    word_t buffers;             /* number of rings      */
 
     word_t log_mask;            /* mask of major IDs    */
-    word_t active_buffer;       /* current active buffer        */
-    word_t buffer_empty;        /* bitmask of available buffers */
-    word_t buffer_size;         /* size of each buffer (bytes)  */
-
-    /* offset of each buffer    */
-    word_t buffer_offset[TBUF_BUFFERS];
-    /* current head pointer of each buffer (past last entry) */
-    word_t buffer_head[TBUF_BUFFERS];
+
+    /* ring of each execution unit */
+    trace_ring_t ring[TBUF_BUFFERS];
 };
 
 extern trace_buffer_t * trace_buffer;
@@ -126,26 +150,27 @@ extern trace_buffer_t * trace_buffer;
 /* Tracebuffer helpper functions */
 void tb_log_event(word_t traceid);
 
-void tb_log_trace(word_t data, const char *str, ...);
+void tb_log_record(word_t major, word_t traceid, word_t nargs,
+        word_t a, word_t b, word_t c, word_t d);
 
 INLINE void tb_log_trace(word_t major, word_t traceid, const char *str, word_t a)
 {
-    tb_log_trace((major << 24) | (traceid << 8) | 1, str, a);
+    tb_log_record(major, traceid, 1, a, 0, 0, 0);
 }
 
 INLINE void tb_log_trace(word_t major, word_t traceid, const char *str, word_t a, word_t b)
 {
-    tb_log_trace((major << 24) | (traceid << 8) | 2, str, a, b);
+    tb_log_record(major, traceid, 2, a, b, 0, 0);
 }
 
 INLINE void tb_log_trace(word_t major, word_t traceid, const char *str, word_t a, word_t b, word_t c)
 {
-    tb_log_trace((major << 24) | (traceid << 8) | 3, str, a, b, c);
+    tb_log_record(major, traceid, 3, a, b, c, 0);
 }
 
 INLINE void tb_log_trace(word_t major, word_t traceid, const char *str, word_t a, word_t b, word_t c, word_t d)
 {
-    tb_log_trace((major << 24) | (traceid << 8) | 4, str, a, b, c, d);
+    tb_log_record(major, traceid, 4, a, b, c, d);
 }
 
 
@@ -91,9 +91,7 @@
 #include <kdb/macro_set.h>
 #include <kernel/kdb/console.h>
 #include <kmem_resource.h>
-
-#define MAX_KMEM_SIZECNT 10
-static word_t num_chunks[MAX_KMEM_SIZECNT+1];
+#include <kernel/arch/special.h>
 
 
 DECLARE_CMD(cmd_kmem_resources, statistics, 'l', "kres",
@@ -119,78 +117,63 @@ DECLARE_CMD (cmd_kmem_stats, statistics, 'k', "kmem",
 
 CMD (cmd_kmem_stats, cg)
 {
-    word_t * kmem_free_list;
-    word_t free_chunks;
-
-    word_t num, *cur, *prev, i, j, idx, max_chunks;
+    kmem_t * heap;
+    word_t i, largest, frag;
 
     kmem_resource_t *resource = get_resource("select resource");
     if (!resource) {
         return CMD_NOQUIT;
     }
 
-    kmem_free_list = resource->heap.kmem_free_list;
-    free_chunks = resource->heap.free_chunks;
-
-    printf("Please wait for a few seconds...\n");
-    // Clear out statistics
-    for (idx = 0; idx <= MAX_KMEM_SIZECNT; idx++)
-        num_chunks[idx] = 0;
-    max_chunks = 0;
-
-    for (num = 1, cur = kmem_free_list, prev = NULL;
-         cur;
-         prev = cur, cur = (word_t *) *cur )
-    {
-        // Are chunks contigous?
-        if ((word_t) prev + KMEM_CHUNKSIZE == (word_t) cur)
-            num++;
-        else
-            num = 1;
-
-        for (i = j = 1, idx = 0; i <= num; i++)
-        {
-            if (i == j)
-            {
-                // Number of chunks is power of 2
-                word_t mask = (j * KMEM_CHUNKSIZE)-1;
-                word_t tmp = (word_t) cur - ((j-1) * KMEM_CHUNKSIZE);
-
-                // Check if chunks are properly aligned
-                if ((tmp & mask) == 0)
-                {
-                    if (idx < MAX_KMEM_SIZECNT)
-                        num_chunks[idx]++;
-                    else
-                        num_chunks[MAX_KMEM_SIZECNT]++;
-                    if (idx > max_chunks)
-                        max_chunks = idx;
-                }
-
-                j <<= 1;
-                idx++;
-            }
-        }
-    }
+    heap = &resource->heap;
 
-    word_t freemem = (free_chunks*KMEM_CHUNKSIZE);
+    word_t freemem = (heap->free_chunks*KMEM_CHUNKSIZE);
     printf ("Kernel memory statistics:\n"
             "  Chunk size  = %d bytes\n"
             "  Free chunks = %d (%d%cB)\n\n",
-            KMEM_CHUNKSIZE, free_chunks,
+            KMEM_CHUNKSIZE, heap->free_chunks,
             freemem >= GB (1) ? freemem >> 30 :
             freemem >= MB (1) ? freemem >> 20 : freemem >> 10,
             freemem >= GB (1) ? 'G' : freemem >= MB (1) ? 'M' : 'K');
 
-    printf ("  Consecutive   Number of\n");
-    printf ("  chunks        matches\n");
-    for (i = 0; i <= MAX_KMEM_SIZECNT; i++)
+    printf ("  Block size    Free\n");
+    printf ("  (chunks)      blocks\n");
+    for (i = 0; i < KMEM_ORDERS; i++)
+    {
+        if (heap->free_blocks[i] == 0 && (1UL << i) > heap->free_chunks)
+            continue;
+        printf ("  %7d       %6d\n", (1 << i), heap->free_blocks[i]);
+    }
+
+    /* Fragmentation: share of free memory outside the largest block */
+    largest = heap->free_orders ? 1UL << msb(heap->free_orders) : 0;
+    frag = heap->free_chunks ?
+        100 - (largest * 100) / heap->free_chunks : 0;
+    printf("\n  Max consecutive chunks: %d\n", largest);
+    printf("  Fragmentation: %d%%\n", frag);
+    printf("  Regions: %d, splits: %d, merges: %d, failed allocs: %d\n",
+            heap->num_regions, heap->splits, heap->merges,
+            heap->failed_allocs);
+
+    if (resource->magazines != NULL)
     {
-        printf ("  %7d%c      %6d\n", (1 << i),
-                i == MAX_KMEM_SIZECNT ? '+' : ' ',
-                num_chunks[i]);
+        printf ("\nSmall object magazines (%d drains):\n", resource->drains);
+        printf ("  unit group  cached      hits    misses  hit%%  flushes\n");
+        for (word_t unit = 0; unit < CONFIG_NUM_UNITS; unit++)
+        {
+            for (i = 0; i < MAX_KMEM_SMALL_ALLOC_GROUP; i++)
+            {
+                kmem_magazine_t * mag =
+                    resource->get_magazine(unit, (kmem_group_e)i);
+                /* Scale down first so that the percentage can't overflow */
+                word_t total = (mag->hits + mag->misses) / 100;
+                printf ("  %4d %5d %7d %9d %9d  %3d%% %8d\n", unit, i,
+                        mag->rounds, mag->hits, mag->misses,
+                        total ? min(mag->hits / total, (word_t)100) : 0,
+                        mag->flushes);
+            }
+        }
     }
-    printf("\n  Max consecutive chunks: %d\n", 1 << max_chunks);
 
 #if defined(CONFIG_KMEM_TRACE)
 
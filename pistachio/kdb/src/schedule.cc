@@ -90,6 +90,7 @@
 
 #include <tcb.h>
 #include <schedule.h>
+#include <smp.h>
 
 tcb_t * global_present_list UNIT("kdebug") = NULL;
 spinlock_t present_list_lock;
@@ -267,6 +268,43 @@ CMD(cmd_show_units, cg)
             (short int)cached_lowest_unit,
             (short int)cached_lowest_prio);
 
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+    /* Print run queue statistics of each execution unit. */
+    printf("Run Queues:\n");
+    printf("  unit  top  acquires    steals    stolen  rebalances\n");
+    for (word_t i = 0; i < CONFIG_NUM_UNITS; i++) {
+        run_queue_t *rq = scheduler->get_run_queue(i);
+        printf("  %4d %4d %9ld %9ld %9ld %11ld\n", i,
+                rq->peek_highest_priority(), rq->stats.acquisitions,
+                rq->stats.steals, rq->stats.stolen, rq->stats.rebalances);
+#if defined(CONFIG_L4_PROFILING)
+        printf("        spin: %lld (max %lld) hold: %lld (max %lld) cycles\n",
+                rq->stats.spin_cycles, rq->stats.max_spin_cycles,
+                rq->stats.hold_cycles, rq->stats.max_hold_cycles);
+#endif
+    }
+    printf("\n");
+#endif
+
+#if defined(CONFIG_MDOMAINS)
+    /* Print XCPU mailbox statistics of each execution unit. */
+    printf("Mailboxes:\n");
+    printf("  unit  requests      ipis    stalls  max depth  deferred\n");
+    for (word_t i = 0; i < CONFIG_NUM_UNITS; i++) {
+        cpu_mb_stats_t *stats = &cpu_mailboxes[i].stats;
+        printf("  %4d %9ld %9ld %9ld %10ld %9ld\n", i,
+                okl4_atomic_read(&stats->requests),
+                okl4_atomic_read(&stats->ipis),
+                okl4_atomic_read(&stats->stalls), stats->max_depth,
+                stats->deferred);
+#if defined(CONFIG_L4_PROFILING)
+        printf("        latency: %lld (max %lld) cycles\n",
+                stats->latency_cycles, stats->max_latency_cycles);
+#endif
+    }
+    printf("\n");
+#endif
+
     scheduler->schedule_lock.unlock();
     return CMD_NOQUIT;
 }
@@ -155,6 +155,11 @@ CMD(cmd_list_spaces, cg)
         walk = walk->get_spaces_list().next;
     } while (walk != global_spaces_list);
 
+#if defined(CONFIG_ASIDS_GENERATION)
+    printf("ASID rollovers: %ld, preemptions: %ld\n",
+            get_asid_cache()->rollovers, get_asid_cache()->preemptions);
+#endif
+
     spaces_list_lock.unlock();
     return CMD_NOQUIT;
 }
@@ -68,6 +68,7 @@
 #include <kdb/kdb.h>
 #include <kdb/input.h>
 #include <kdb/tracepoints.h>
+#include <mp.h>
 
 #if defined(CONFIG_TRACEBUFFER) && defined(CONFIG_KDB_CLI)
 
@@ -92,13 +93,13 @@ CMD(cmd_tb_info, cg)
 {
     printf("=== Tracebuffer @ %p, magic = %p ===\n", trace_buffer, (void*)trace_buffer->magic);
     printf("version: %8x, bufid:         %8x\n", trace_buffer->version, trace_buffer->bufid);
-    printf("buffers: %8d, active_buffer: %8d\n", trace_buffer->buffers, trace_buffer->active_buffer);
-    printf("bufsize: %8d, empty mask     %8x\n", trace_buffer->buffer_size, trace_buffer->buffer_empty);
-    printf("logmask: %8x\n", trace_buffer->log_mask);
+    printf("buffers: %8d, logmask:       %8x\n", trace_buffer->buffers, trace_buffer->log_mask);
     for (int i = 0; i < (int)trace_buffer->buffers; i++)
     {
-        printf("  buffer %d: offset: %8d,  head: %8d\n", i,
-                trace_buffer->buffer_offset[i], trace_buffer->buffer_head[i]);
+        trace_ring_t * ring = &trace_buffer->ring[i];
+        printf("  ring %d: offset: %8d, size: %8d, head: %8d, tail: %8d, overflows: %d\n",
+                i, ring->offset, ring->size, ring->head, ring->tail,
+                ring->overflows);
     }
     return CMD_NOQUIT;
 }
@@ -122,13 +123,22 @@ DECLARE_CMD (cmd_tb_dump, tracebuf, 'D', "dump", "dump buffer");
 
 static void dump_buffer(int buffer)
 {
-    word_t head = trace_buffer->buffer_head[buffer];
-    word_t entry = 0;
+    trace_ring_t * ring = &trace_buffer->ring[buffer];
+    word_t head = ring->head;
+    word_t entry = ring->tail;
 
-    while (entry < head)
+    /* Unread entries are left in place for the trace server */
+    while (entry != head)
     {
         trace_entry_t * tbe = (trace_entry_t*)((word_t)trace_buffer +
-                trace_buffer->buffer_offset[buffer] + entry);
+                ring->offset + entry);
+
+        /* Skip the unused end of the ring */
+        if (ring->size - entry < sizeof(trace_entry_t) || tbe->hdr.raw == 0)
+        {
+            entry = 0;
+            continue;
+        }
 
         printf("%6d: %9m ", entry, ((u64_t)tbe->timestamp_hi << 32) | tbe->timestamp_lo );
 
@@ -164,30 +174,24 @@ static void dump_buffer(int buffer)
 
 CMD(cmd_tb_dump_cur, cg)
 {
-    word_t buffer = trace_buffer->active_buffer;
-
-    if (buffer == ~(0UL))
-    {
-        printf("No current active buffer!\n");
-        return CMD_NOQUIT;
-    }
-
-    dump_buffer(buffer);
+    dump_buffer(get_current_context().unit);
 
     return CMD_NOQUIT;
 }
 
 CMD(cmd_tb_dump, cg)
 {
-    word_t buffer = trace_buffer->active_buffer;
+    word_t buffer = get_dec ("Buffer", get_current_context().unit);
+
+    if (buffer == ABORT_MAGIC)
+        return CMD_NOQUIT;
 
-    if (buffer == ~(0UL))
+    if (buffer >= trace_buffer->buffers)
     {
-        buffer = trace_buffer->buffers-1;
+        printf("No such buffer!\n");
+        return CMD_NOQUIT;
     }
 
-    buffer = get_dec ("Buffer", buffer);
-
     dump_buffer(buffer);
 
     return CMD_NOQUIT;
@@ -199,14 +203,15 @@ CMD(cmd_tb_reset, cg)
 {
     word_t nbufs = trace_buffer->buffers;
 
-    trace_buffer->active_buffer = 0;
-    trace_buffer->buffer_empty = ((1UL << nbufs) - 1) &
-        (~(1UL << trace_buffer->active_buffer));
-
-    /* Setup buffer offsets + head pointers */
+    /* Reset ring pointers */
     for (word_t i = 0; i < nbufs; i ++ )
     {
-        trace_buffer->buffer_head[i] = 0;
+        trace_ring_t * ring = &trace_buffer->ring[i];
+
+        okl4_atomic_init(&ring->reserve, 0);
+        ring->head = 0;
+        ring->tail = 0;
+        ring->overflows = 0;
     }
 
     return CMD_NOQUIT;
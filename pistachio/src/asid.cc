@@ -144,6 +144,20 @@ again:
 #error fixme
 #endif
 
+#ifdef CONFIG_ASIDS_GENERATION
+    idx = find_free(next_asid);
+    if (idx >= CONFIG_MAX_NUM_ASIDS) {
+        rollover();
+        idx = find_free(0);
+        if (idx >= CONFIG_MAX_NUM_ASIDS) {
+            TRACEF("no valid asids\n");
+            asid_lock.unlock();
+            return asid_t::invalid;
+        }
+    }
+    next_asid = idx + 1;
+#endif /* CONFIG_ASIDS_GENERATION */
+
 #ifdef CONFIG_ASIDS_STATIC
     static hw_asid_t next = 0;
     word_t count = 0;
@@ -184,6 +198,49 @@ again:
     return idx;
 }
 
+#if defined(CONFIG_ASIDS_GENERATION)
+/* Note: must be already locked! */
+hw_asid_t asid_cache_t::find_free(hw_asid_t start)
+{
+    hw_asid_t idx = start;
+
+    while (idx < CONFIG_MAX_NUM_ASIDS && asids[idx].asid != FREE_REF) {
+        idx ++;
+    }
+    return idx;
+}
+
+/**
+ * rollover - Start a new ASID generation
+ *
+ * Description: Takes back every allocated ASID and flushes the TLB once,
+ * instead of once per preempted ASID.  Spaces that lost their ASID pick up
+ * a new one on their next switch.  The current space may be among them;
+ * allocation only happens on the way to activating another space, so it
+ * runs on kernel (global) mappings until it is next activated.
+ **/
+/* Note: must be already locked! */
+void asid_cache_t::rollover(void)
+{
+    for (hw_asid_t idx = 0; idx < CONFIG_MAX_NUM_ASIDS; idx++) {
+        if (asids[idx].asid == INVALID_REF || asids[idx].asid == FREE_REF) {
+            continue;
+        }
+
+        asid_t *old = lookup(idx);
+        if (old != (asid_t*)-1) {
+            old->revoke();
+            preemptions++;
+        }
+        asids[idx].asid = FREE_REF;
+    }
+
+    flush_all_asids();
+    next_asid = 0;
+    rollovers++;
+}
+#endif /* CONFIG_ASIDS_GENERATION */
+
 void asid_cache_t::set_valid(hw_asid_t start, hw_asid_t end)
 {
     hw_asid_t idx;
@@ -89,6 +89,127 @@ extern spaceid_lookup_t space_lookup;
 CONTINUATION_FUNCTION(range_flush);
 CONTINUATION_FUNCTION(full_flush);
 CONTINUATION_FUNCTION(range_flush_full);
+CONTINUATION_FUNCTION(range_flush_all);
+
+/* Decode the attribute and size of a range flush item. */
+#define RANGE_ATTR(region)  ((cacheattr_e)((region) >> (BITS_WORD-4)))
+#define RANGE_SIZE(region)  ((region) & ((1UL << (BITS_WORD-4)) - 1))
+
+/**
+ * Merge overlapping or adjacent ranges with the same attribute so that
+ * no cache line is operated on twice in one request. Merged items are
+ * left behind with a size of zero and are skipped when flushing.
+ */
+static void
+coalesce_ranges(tcb_t *current, word_t op_last)
+{
+    bool merged;
+
+    do {
+        merged = false;
+        for (word_t i = 0; i <= op_last; i++) {
+            word_t start = current->get_mr(i*2);
+            word_t region = current->get_mr(i*2 + 1);
+            word_t end = start + RANGE_SIZE(region);
+
+            /* Never merge a range that wraps the address space. */
+            if (RANGE_SIZE(region) == 0 || end < start) {
+                continue;
+            }
+
+            for (word_t j = i + 1; j <= op_last; j++) {
+                word_t start2 = current->get_mr(j*2);
+                word_t region2 = current->get_mr(j*2 + 1);
+                word_t end2 = start2 + RANGE_SIZE(region2);
+
+                if (RANGE_SIZE(region2) == 0 || end2 < start2 ||
+                        RANGE_ATTR(region2) != RANGE_ATTR(region) ||
+                        start2 > end || start > end2) {
+                    continue;
+                }
+                /* The union must still fit the size field of a region. */
+                if (max(end, end2) - min(start, start2) > RANGE_SIZE(~0UL)) {
+                    continue;
+                }
+
+                TRACE_CACHE("Merge range %d into %d\n", j, i);
+                start = min(start, start2);
+                end = max(end, end2);
+                region = (region & ~RANGE_SIZE(region)) | (end - start);
+                current->set_mr(i*2, start);
+                current->set_mr(i*2 + 1, region);
+                current->set_mr(j*2 + 1, region2 & ~RANGE_SIZE(region2));
+                merged = true;
+            }
+        }
+    } while (merged);
+}
+
+/**
+ * Sum up the ranges of a request. Returns false if they do not all
+ * share one attribute, which is returned in attr otherwise.
+ */
+static bool
+ranges_total(tcb_t *current, word_t op_last, word_t *total, cacheattr_e *attr)
+{
+    bool found = false;
+
+    *total = 0;
+    for (word_t i = 0; i <= op_last; i++) {
+        word_t region = current->get_mr(i*2 + 1);
+
+        if (RANGE_SIZE(region) == 0) {
+            continue;
+        }
+        if (!found) {
+            *attr = RANGE_ATTR(region);
+            found = true;
+        } else if (RANGE_ATTR(region) != *attr) {
+            return false;
+        }
+        *total += RANGE_SIZE(region);
+    }
+    return found;
+}
+
+/**
+ * Cost model for the inner cache: decide whether a single set/way flush
+ * of the whole cache is cheaper than walking all ranges of the request
+ * line by line.
+ */
+static bool
+inner_full_flush_cheaper(tcb_t *current, word_t op_last, cacheattr_e *attr)
+{
+    word_t total;
+
+    if (!ranges_total(current, op_last, &total, attr)) {
+        return false;
+    }
+    /* Leave the privilege check of D-cache invalidates to the range path */
+    if (((word_t)*attr & CACHE_ATTRIB_MASK_D_OP) == CACHE_ATTRIB_INVAL_D) {
+        return false;
+    }
+    return cache_t::full_flush_cheaper(total);
+}
+
+/**
+ * Cost model for the outer cache. A full operation is only used for
+ * cleaning requests, as a full invalidate would discard dirty lines
+ * outside of the requested ranges.
+ */
+static bool
+outer_full_flush_cheaper(tcb_t *current, word_t op_last, cacheattr_e *attr)
+{
+    word_t total;
+
+    if (!ranges_total(current, op_last, &total, attr)) {
+        return false;
+    }
+    if (((word_t)*attr & CACHE_ATTRIB_OP_MASK) == CACHE_ATTRIB_OP_INVAL) {
+        return false;
+    }
+    return arch_outer_cache_full_op_cheaper(total);
+}
 
 SYS_CACHE_CONTROL (spaceid_t space_id, word_t control)
 {
@@ -124,6 +245,7 @@ SYS_CACHE_CONTROL (spaceid_t space_id, word_t control)
             return_cache_control(0,
                                  TCB_SYSDATA_CACHE(current)->cache_continuation);
         }
+        coalesce_ranges(current, num_ops - 1);
         ACTIVATE_CONTINUATION(range_flush);
     }
 }
@@ -142,6 +264,7 @@ CONTINUATION_FUNCTION(full_flush)
 
     if (TCB_SYSDATA_CACHE(current)->ctrl.cache_level_mask() & CACHE_CTL_MASKINNER)
     {
+        PROFILE_START(cache_full_op);
         switch (TCB_SYSDATA_CACHE(current)->ctrl.operation())
         {
         case cop_flush_all:
@@ -158,10 +281,12 @@ CONTINUATION_FUNCTION(full_flush)
             current->set_error_code (EINVALID_PARAM);
             retval = 0;
         }
+        PROFILE_STOP(cache_full_op);
     }
 
     if (TCB_SYSDATA_CACHE(current)->ctrl.cache_level_mask() & CACHE_CTL_MASKOUTER)
     {
+        PROFILE_START(cache_outer_op);
         switch (TCB_SYSDATA_CACHE(current)->ctrl.operation())
         {
         case cop_flush_all:
@@ -180,6 +305,7 @@ CONTINUATION_FUNCTION(full_flush)
         }
 
         arch_outer_drain_write_buffer();
+        PROFILE_STOP(cache_outer_op);
     }
 
     preempt_disable();
@@ -202,6 +328,7 @@ CONTINUATION_FUNCTION(range_flush)
 
     word_t op_last = TCB_SYSDATA_CACHE(current)->ctrl.highest_item();
     word_t retval = 1;
+    cacheattr_e attr;
 
     if (TCB_SYSDATA_CACHE(current)->ctrl.cache_level_mask() & CACHE_CTL_MASKINNER)
     {
@@ -221,14 +348,29 @@ CONTINUATION_FUNCTION(range_flush)
             return_cache_control(0, TCB_SYSDATA_CACHE(current)->cache_continuation);
         }
 
+        /* Before starting, see if the request as a whole is better
+         * served by a single flush of the entire cache */
+        if (TCB_SYSDATA_CACHE(current)->op_index == 0 &&
+                TCB_SYSDATA_CACHE(current)->op_offset == 0 &&
+                inner_full_flush_cheaper(current, op_last, &attr)) {
+            TRACE_CACHE("Converting request to full flush\n");
+            ACTIVATE_CONTINUATION(range_flush_all);
+        }
+
         for (word_t i = TCB_SYSDATA_CACHE(current)->op_index; i <= op_last; i++)
         {
             word_t offset = TCB_SYSDATA_CACHE(current)->op_offset;
 
             word_t start = current->get_mr(i*2);
-            word_t region = current->get_mr(i*2 + 1);;
-            cacheattr_e attr = (cacheattr_e)(region >> (BITS_WORD-4));
-            word_t size = region & ((1UL << (BITS_WORD-4)) - 1);
+            word_t region = current->get_mr(i*2 + 1);
+            word_t size = RANGE_SIZE(region);
+            attr = RANGE_ATTR(region);
+
+            if (size == 0) {
+                /* Empty, or merged into another range */
+                TCB_SYSDATA_CACHE(current)->op_index = i + 1;
+                continue;
+            }
 
             if (offset) {
                 TRACE_CACHE("Restart after preemption\n");
@@ -263,6 +405,9 @@ CONTINUATION_FUNCTION(range_flush)
                 TCB_SYSDATA_CACHE(current)->op_offset = 0;
                 ACTIVATE_CONTINUATION(range_flush_full);
             } else {
+                if (!offset) {
+                    PROFILE_START(cache_range_op);
+                }
 #ifdef CACHE_NEED_PGENT
                 pgent_t * r_pg[pgent_t::size_max];
                 pgent_t * pg;
@@ -379,6 +524,7 @@ CONTINUATION_FUNCTION(range_flush)
                     }
 #endif
                 }
+                PROFILE_STOP(cache_range_op);
             }
 
             /*
@@ -396,23 +542,49 @@ CONTINUATION_FUNCTION(range_flush)
          * use space_id and can be performed from another space as long as it is
          * privileged.
          */
-        for (word_t i = TCB_SYSDATA_CACHE(current)->op_index; i <= op_last; i++)
+        word_t *op_index = &TCB_SYSDATA_CACHE(current)->op_index;
+
+        // Check privilege
+        if (! is_kresourced_space(get_current_space())) {
+            current->set_error_code (EINVALID_SPACE);
+            retval = 0;
+            goto error_out_range;
+        }
+
+        /* Outer operations are numbered after the inner ones so that a
+         * restart after preemption does not repeat the inner pass. */
+        if (*op_index <= op_last) {
+            *op_index = op_last + 1;
+        }
+
+        if (*op_index == op_last + 1 &&
+                outer_full_flush_cheaper(current, op_last, &attr)) {
+            TRACE_CACHE("Converting request to full outer flush\n");
+            PROFILE_START(cache_outer_op);
+            preempt_enable(range_flush);
+            arch_outer_cache_full_op(attr);
+            preempt_disable();
+            PROFILE_STOP(cache_outer_op);
+            *op_index = 2 * (op_last + 1);
+        }
+
+        for (; *op_index < 2 * (op_last + 1); (*op_index)++)
         {
+            word_t i = *op_index - (op_last + 1);
             word_t start = current->get_mr(i*2);
-            word_t region = current->get_mr(i*2 + 1);;
-            cacheattr_e attr = (cacheattr_e)(region >> (BITS_WORD-4));
-            word_t size = region & ((1UL << (BITS_WORD-4)) - 1);
-
-            // Check privilege
-            if (! is_kresourced_space(get_current_space())) {
-                current->set_error_code (EINVALID_SPACE);
-                retval = 0;
-                goto error_out_range;
+            word_t region = current->get_mr(i*2 + 1);
+            word_t size = RANGE_SIZE(region);
+            attr = RANGE_ATTR(region);
+
+            if (size == 0) {
+                continue;
             }
 
+            PROFILE_START(cache_outer_op);
             preempt_enable(range_flush);
             arch_outer_cache_range_op((addr_t)start, size, attr);
             preempt_disable();
+            PROFILE_STOP(cache_outer_op);
         }
 
         arch_outer_drain_write_buffer();
@@ -433,14 +605,42 @@ CONTINUATION_FUNCTION(range_flush_full)
 
     word_t i = TCB_SYSDATA_CACHE(current)->op_index;
     word_t region = current->get_mr(i*2 + 1);
-    cacheattr_e attr = (cacheattr_e)(region >> (BITS_WORD-4));
+    cacheattr_e attr = RANGE_ATTR(region);
 
+    PROFILE_START(cache_full_op);
     preempt_enable(range_flush_full);
     cache_t::flush_all_attribute(attr, &TCB_SYSDATA_CACHE(current)->op_offset);
     preempt_disable();
+    PROFILE_STOP(cache_full_op);
 
     TCB_SYSDATA_CACHE(current)->op_index ++;
     TCB_SYSDATA_CACHE(current)->op_offset = 0;
     /* Continue with remaining range flushes */
     ACTIVATE_CONTINUATION(range_flush);
 }
+
+/**
+ * @brief All ranges of the request share one attribute and together
+ *        cover more than a full flush costs, so flush the whole inner
+ *        cache once and go straight on to the outer cache.
+ */
+CONTINUATION_FUNCTION(range_flush_all)
+{
+    tcb_t *current = get_current_tcb();
+    word_t op_last = TCB_SYSDATA_CACHE(current)->ctrl.highest_item();
+    cacheattr_e attr;
+    word_t total;
+
+    (void)ranges_total(current, op_last, &total, &attr);
+
+    PROFILE_START(cache_full_op);
+    preempt_enable(range_flush_all);
+    cache_t::flush_all_attribute(attr, &TCB_SYSDATA_CACHE(current)->op_offset);
+    preempt_disable();
+    PROFILE_STOP(cache_full_op);
+
+    TCB_SYSDATA_CACHE(current)->op_index = op_last + 1;
+    TCB_SYSDATA_CACHE(current)->op_offset = 0;
+    /* Continue with the outer cache, if requested */
+    ACTIVATE_CONTINUATION(range_flush);
+}
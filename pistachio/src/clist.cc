@@ -143,12 +143,27 @@ again:
             okl4_atomic_barrier_smp();
             goto again;
         }
+        /*
+         * The entry is read without holding any lock, so it may have
+         * been removed (and the tcb reused) before we locked the tcb.
+         * Recheck it now that the tcb can no longer go away.
+         */
+        if (EXPECT_FALSE(this->entries[tid.get_index()].get_raw() !=
+                         entry.get_raw())) {
+            tcb->unlock_write();
+            goto again;
+        }
     } else {
         if (tcb == tcb_locked) {
             tcb->lock_read_already_held();
         } else if (EXPECT_FALSE(!tcb->try_lock_read())) {
             okl4_atomic_barrier_smp();
             goto again;
+        } else if (EXPECT_FALSE(this->entries[tid.get_index()].get_raw() !=
+                                entry.get_raw())) {
+            /* Entry changed under us, see above. */
+            tcb->unlock_read();
+            goto again;
         }
     }
 
@@ -218,6 +233,11 @@ again:
     } else if (EXPECT_FALSE(!tcb->try_lock_read())) {
         okl4_atomic_barrier_smp();
         goto again;
+    } else if (EXPECT_FALSE(this->entries[tid.get_index()].get_raw() !=
+                            entry.get_raw())) {
+        /* Entry was removed or replaced before the tcb was locked. */
+        tcb->unlock_read();
+        goto again;
     }
 
     TRACE_CLIST(" - return: 0x%lx\n", tcb);
@@ -63,11 +63,12 @@
 void
 endpoint_t::init(tcb_t * tcb)
 {
-    this->send_queue.init(tcb);
+    this->send_queue.init(tcb, true);
 
 #if defined(CONFIG_SCHEDULE_INHERITANCE)
 
-    this->recv_queue.init(tcb);
+    /* The IPC fastpaths manipulate the receive queue directly. */
+    this->recv_queue.init(tcb, false);
 
 #endif
 }
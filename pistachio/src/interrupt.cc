@@ -102,20 +102,14 @@ DECLARE_TRACEPOINT(INTERRUPT);
 DECLARE_TRACEPOINT(SYSCALL_INTERRUPT_CONTROL);
 
 /*
- * Deliver notify bits to a handler thread.
- * If cont is NON-NULL, only one interrupt descriptors is pending
- * and only one handler will be woken up.
+ * Add notify bits to a handler thread and wake it up if it is waiting
+ * for them.
  */
-extern "C"
-bool kernel_deliver_notify(tcb_h handler, word_t notifybits, continuation_t cont)
+static bool
+deliver_notify(tcb_t *handler_tcb, word_t notifybits, continuation_t cont)
 {
-    tcb_t *handler_tcb = (tcb_t*)handler;
-
     word_t bits = handler_tcb->add_notify_bits(notifybits);
 
-    TRACEPOINT_TB(INTERRUPT, printf("IRQ notify %T:%lx\n", handler_tcb, notifybits),
-            "irq %lx, %lx", (word_t)handler_tcb, notifybits);
-
 async_wakeup_check:
     if (EXPECT_TRUE( (bits & handler_tcb->get_notify_mask()) &&
                 ( handler_tcb->get_state().is_waiting_notify() ||
@@ -146,6 +140,244 @@ async_wakeup_check:
     return false;
 }
 
+/*
+ * Deliver notify bits to a handler thread.
+ * If cont is NON-NULL, only one interrupt descriptors is pending
+ * and only one handler will be woken up.
+ */
+extern "C"
+bool kernel_deliver_notify(tcb_h handler, word_t notifybits, continuation_t cont)
+{
+    tcb_t *handler_tcb = (tcb_t*)handler;
+
+    TRACEPOINT_TB(INTERRUPT, printf("IRQ notify %T:%lx\n", handler_tcb, notifybits),
+            "irq %lx, %lx", (word_t)handler_tcb, notifybits);
+
+#if defined(CONFIG_IRQ_COALESCING)
+    if (EXPECT_FALSE(handler_tcb->irq_coalesce.is_enabled()) &&
+            irq_coalesce_hold(handler_tcb, &notifybits)) {
+        return false;
+    }
+#endif
+
+    return deliver_notify(handler_tcb, notifybits, cont);
+}
+
+#if defined(CONFIG_IRQ_COALESCING)
+/* Handlers holding back interrupts, protected by irq_coalesce_lock. */
+static tcb_t * irq_coalesce_list = NULL;
+static spinlock_t irq_coalesce_lock;
+
+/*
+ * Remove a handler from the held list and return its held bits.
+ * The held events become the count reported to the handler.
+ * Must be called with irq_coalesce_lock held.
+ */
+static word_t
+irq_coalesce_release(tcb_t * handler)
+{
+    irq_coalesce_t * c = &handler->irq_coalesce;
+    tcb_t ** prev = &irq_coalesce_list;
+    word_t bits = c->held_bits;
+
+    while (*prev != handler) {
+        prev = &(*prev)->irq_coalesce.next_held;
+    }
+    *prev = c->next_held;
+
+    c->delivered_events += c->held_events;
+    c->held_bits = 0;
+    c->held_events = 0;
+    c->held_age = 0;
+    c->next_held = NULL;
+
+    return bits;
+}
+
+/*
+ * Account an interrupt to a coalescing handler. Returns true if the
+ * notify bits are held back. Otherwise the batch is complete and
+ * notifybits is updated with all bits accumulated for the handler.
+ */
+bool
+irq_coalesce_hold(tcb_t * handler, word_t * notifybits)
+{
+    irq_coalesce_t * c = &handler->irq_coalesce;
+    bool held = false;
+    bool first = false;
+
+    irq_coalesce_lock.lock();
+    if (EXPECT_TRUE(c->is_enabled())) {
+        c->held_bits |= *notifybits;
+        if (c->held_events++ == 0) {
+            c->next_held = irq_coalesce_list;
+            irq_coalesce_list = handler;
+            first = true;
+        }
+
+        if (c->held_events < c->max_events) {
+            held = true;
+        } else {
+            *notifybits = irq_coalesce_release(handler);
+        }
+    }
+    irq_coalesce_lock.unlock();
+
+#if defined(CONFIG_TICKLESS)
+    /* The timer may not be due before the new deadline. */
+    if (held && first) {
+        get_current_scheduler()->rearm_timer();
+    }
+#else
+    (void)first;
+#endif
+    return held;
+}
+
+/*
+ * Set a handler's coalescing policy. Anything held under the old
+ * policy is delivered straight away.
+ */
+word_t
+irq_coalesce_configure(tcb_t * handler, word_t max_events, word_t max_delay)
+{
+    irq_coalesce_t * c = &handler->irq_coalesce;
+    word_t bits = 0;
+    bool holding;
+
+    /* Without a delay held interrupts could wait forever. */
+    if (max_events > 1 && max_delay == 0) {
+        return EINVALID_PARAM;
+    }
+
+    irq_coalesce_lock.lock();
+    holding = c->is_holding();
+    if (holding) {
+        bits = irq_coalesce_release(handler);
+    }
+    c->max_events = max_events;
+    c->max_delay = max_delay;
+    irq_coalesce_lock.unlock();
+
+    if (holding) {
+        (void)deliver_notify(handler, bits, NULL);
+    }
+    return 0;
+}
+
+/*
+ * Return the number of interrupts delivered to a handler since the
+ * last call.
+ */
+word_t
+irq_coalesce_take_events(tcb_t * handler)
+{
+    irq_coalesce_t * c = &handler->irq_coalesce;
+    word_t events;
+
+    irq_coalesce_lock.lock();
+    events = c->delivered_events;
+    c->delivered_events = 0;
+    irq_coalesce_lock.unlock();
+
+    return events;
+}
+
+/*
+ * Drop a handler's held interrupts and policy, on thread deletion.
+ */
+void
+irq_coalesce_cancel(tcb_t * handler)
+{
+    irq_coalesce_lock.lock();
+    if (handler->irq_coalesce.is_holding()) {
+        (void)irq_coalesce_release(handler);
+    }
+    handler->irq_coalesce.init();
+    irq_coalesce_lock.unlock();
+}
+
+/*
+ * Advance the age of all held interrupts by elapsed microseconds.
+ */
+void
+irq_coalesce_age(word_t elapsed)
+{
+    irq_coalesce_lock.lock();
+    for (tcb_t * t = irq_coalesce_list; t != NULL;
+            t = t->irq_coalesce.next_held) {
+        irq_coalesce_t * c = &t->irq_coalesce;
+
+        if (c->held_age + elapsed < c->held_age) {
+            c->held_age = ~0UL;
+        } else {
+            c->held_age += elapsed;
+        }
+    }
+    irq_coalesce_lock.unlock();
+}
+
+/*
+ * Deliver the interrupts of every handler that has reached its delay.
+ * Returns true if any handler was woken up.
+ */
+bool
+irq_coalesce_flush(void)
+{
+    bool wakeup = false;
+
+    for (;;) {
+        tcb_t * t;
+        word_t bits = 0;
+
+        irq_coalesce_lock.lock();
+        for (t = irq_coalesce_list; t != NULL;
+                t = t->irq_coalesce.next_held) {
+            if (t->irq_coalesce.held_age >= t->irq_coalesce.max_delay) {
+                bits = irq_coalesce_release(t);
+                break;
+            }
+        }
+        irq_coalesce_lock.unlock();
+
+        if (t == NULL) {
+            break;
+        }
+        if (deliver_notify(t, bits, NULL)) {
+            wakeup = true;
+        }
+    }
+    return wakeup;
+}
+
+/*
+ * Return the microseconds until the next held interrupt is due, or 0
+ * if none are held.
+ */
+word_t
+irq_coalesce_next_expiry(void)
+{
+    word_t expiry = 0;
+
+    irq_coalesce_lock.lock();
+    for (tcb_t * t = irq_coalesce_list; t != NULL;
+            t = t->irq_coalesce.next_held) {
+        irq_coalesce_t * c = &t->irq_coalesce;
+        word_t left = 1;
+
+        if (c->held_age < c->max_delay) {
+            left = c->max_delay - c->held_age;
+        }
+        if (expiry == 0 || left < expiry) {
+            expiry = left;
+        }
+    }
+    irq_coalesce_lock.unlock();
+
+    return expiry;
+}
+#endif /* CONFIG_IRQ_COALESCING */
+
 INLINE void setup_notify_return(tcb_t *tcb)
 {
     word_t mask = tcb->get_notify_mask();
@@ -153,6 +385,10 @@ INLINE void setup_notify_return(tcb_t *tcb)
 
     tcb->set_tag(msg_tag_t::notify_tag());
     tcb->set_mr(1, bits & mask);
+#if defined(CONFIG_IRQ_COALESCING)
+    /* Number of interrupts behind the bits. */
+    tcb->set_mr(2, irq_coalesce_take_events(tcb));
+#endif
 }
 
 extern "C" CONTINUATION_FUNCTION(check_async_irq)
@@ -278,6 +514,17 @@ SYS_INTERRUPT_CONTROL(capid_t tid, irq_control_t control)
                     current, check_async_irq,
                     scheduler_t::sched_default);
         break; // For completeness; never reached
+#if defined(CONFIG_IRQ_COALESCING)
+    case irq_control_t::op_coalesce:
+        ret = irq_coalesce_configure(handler,
+                current->get_mr(0), current->get_mr(1));
+        if (EXPECT_FALSE(ret)) {
+            current->set_error_code(ret);
+            goto error_out_locked;
+        }
+        handler->unlock_read();
+        break;
+#endif
     default:
         current->set_error_code (EINVALID_PARAM);
         goto error_out_locked;
@@ -129,6 +129,16 @@ INLINE bool transfer_message(tcb_t * src, tcb_t * dst)
     // we set the sender space id here
     dst->set_sender_space(src->get_space_id());
 
+#if defined(CONFIG_IPC_WINDOWS)
+    /* A lender gets its buffer back when it receives the next message */
+    if (EXPECT_FALSE(dst->ipc_window.is_open() &&
+                     !dst->ipc_window.is_borrower())) {
+        LOCK_PRIVILEGED_SYSCALL();
+        close_ipc_window(dst);
+        UNLOCK_PRIVILEGED_SYSCALL();
+    }
+#endif
+
     /*
      * Any errors here will be reported as a message overflow error.
      * For the "exception" IPCs this is misleading as more than just overflow
@@ -142,10 +152,26 @@ INLINE bool transfer_message(tcb_t * src, tcb_t * dst)
         if (! src->copy_exception_mrs_to_frame(dst)) {
             goto error;
         }
-    } else if (EXPECT_TRUE(tag.get_untyped())){
-        if (EXPECT_FALSE(!src->copy_mrs(dst, 1, tag.get_untyped()))) {
+    } else {
+        if (EXPECT_TRUE(tag.get_untyped()) &&
+                EXPECT_FALSE(!src->copy_mrs(dst, 1, tag.get_untyped()))) {
             goto error;
         }
+#if defined(CONFIG_IPC_WINDOWS)
+        if (EXPECT_FALSE(tag.get_window())) {
+            bool opened;
+
+            if (tag.get_memcpy()) {
+                goto error;
+            }
+            LOCK_PRIVILEGED_SYSCALL();
+            opened = open_ipc_window(src, dst, tag.get_untyped() + 1);
+            UNLOCK_PRIVILEGED_SYSCALL();
+            if (!opened) {
+                goto error;
+            }
+        }
+#endif
     }
 
     dst->set_tag(tag);
@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2008 Open Kernel Labs, Inc. (Copyright Holder).
+ * All rights reserved.
+ *
+ * 1. Redistribution and use of OKL4 (Software) in source and binary
+ * forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ *     (a) Redistributions of source code must retain this clause 1
+ *         (including paragraphs (a), (b) and (c)), clause 2 and clause 3
+ *         (Licence Terms) and the above copyright notice.
+ *
+ *     (b) Redistributions in binary form must reproduce the above
+ *         copyright notice and the Licence Terms in the documentation and/or
+ *         other materials provided with the distribution.
+ *
+ *     (c) Redistributions in any form must be accompanied by information on
+ *         how to obtain complete source code for:
+ *        (i) the Software; and
+ *        (ii) all accompanying software that uses (or is intended to
+ *        use) the Software whether directly or indirectly.  Such source
+ *        code must:
+ *        (iii) either be included in the distribution or be available
+ *        for no more than the cost of distribution plus a nominal fee;
+ *        and
+ *        (iv) be licensed by each relevant holder of copyright under
+ *        either the Licence Terms (with an appropriate copyright notice)
+ *        or the terms of a licence which is approved by the Open Source
+ *        Initative.  For an executable file, "complete source code"
+ *        means the source code for all modules it contains and includes
+ *        associated build and other files reasonably required to produce
+ *        the executable.
+ *
+ * 2. THIS SOFTWARE IS PROVIDED ``AS IS'' AND, TO THE EXTENT PERMITTED BY
+ * LAW, ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED.  WHERE ANY WARRANTY IS
+ * IMPLIED AND IS PREVENTED BY LAW FROM BEING DISCLAIMED THEN TO THE
+ * EXTENT PERMISSIBLE BY LAW: (A) THE WARRANTY IS READ DOWN IN FAVOUR OF
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT) AND (B) ANY LIMITATIONS PERMITTED BY LAW (INCLUDING AS TO
+ * THE EXTENT OF THE WARRANTY AND THE REMEDIES AVAILABLE IN THE EVENT OF
+ * BREACH) ARE DEEMED PART OF THIS LICENCE IN A FORM MOST FAVOURABLE TO
+ * THE COPYRIGHT HOLDER (AND, IN THE CASE OF A PARTICIPANT, THAT
+ * PARTICIPANT). IN THE LICENCE TERMS, "PARTICIPANT" INCLUDES EVERY
+ * PERSON WHO HAS CONTRIBUTED TO THE SOFTWARE OR WHO HAS BEEN INVOLVED IN
+ * THE DISTRIBUTION OR DISSEMINATION OF THE SOFTWARE.
+ *
+ * 3. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR ANY OTHER PARTICIPANT BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Description:   zero-copy IPC windows
+ */
+
+#include <l4.h>
+#include <debug.h>
+#include <tcb.h>
+#include <space.h>
+#include <ipc.h>
+#include <ipc_window.h>
+#include <map.h>
+#include <linear_ptab.h>
+#include <kmem_resource.h>
+
+#if defined(CONFIG_IPC_WINDOWS)
+
+/*
+ * Map the pages backing 'size' bytes at 'from_addr' in 'from' at
+ * 'to_addr' in 'to' with access rights 'rwx'. Every page must be mapped
+ * in 'from' with at least these rights. Pages are mapped with the
+ * largest size that is aligned both virtually and physically.
+ */
+static bool
+map_window_pages(space_t * from, word_t from_addr, space_t * to,
+                 word_t to_addr, word_t size, word_t rwx,
+                 kmem_resource_t * kresource)
+{
+    word_t min_shift = page_shift(pgent_t::size_min);
+    word_t offset = 0;
+
+    while (offset < size)
+    {
+        pgent_t * pg;
+        pgent_t::pgsize_e pgsize;
+        addr_t vaddr = addr_offset((addr_t)from_addr, offset);
+        word_t perms, phys, shift;
+        phys_desc_t base;
+        fpage_t fpg;
+
+        if (!from->lookup_mapping(vaddr, &pg, &pgsize)) {
+            return false;
+        }
+
+        perms = (pg->is_readable(from, pgsize) << 2) |
+                (pg->is_writable(from, pgsize) << 1) |
+                (pg->is_executable(from, pgsize) << 0);
+        if ((perms & rwx) != rwx) {
+            return false;
+        }
+
+        phys = (word_t)pg->address(from, pgsize) +
+            ((word_t)vaddr & (page_size(pgsize) - 1));
+
+        for (shift = page_shift(pgsize); shift > min_shift; shift--) {
+            if (((((to_addr + offset) | phys) & ((1UL << shift) - 1)) == 0) &&
+                    ((1UL << shift) <= size - offset)) {
+                break;
+            }
+        }
+
+        fpg.set(to_addr + offset, shift, rwx & 4, rwx & 2, rwx & 1);
+        base.clear();
+        base.set_base(phys);
+        base.set_attributes((word_t)pg->get_attributes(from, pgsize));
+
+        if (!to->map_fpage(base, fpg, kresource)) {
+            return false;
+        }
+        offset += 1UL << shift;
+    }
+    return true;
+}
+
+/**
+ * Map the buffer named in message register 'mr' of the sender into the
+ * receive window of the receiver. On success the receiver's copy of
+ * the register holds the mapped window.
+ *
+ * Must be called with the privileged syscall lock held.
+ *
+ * @param src   sending thread, lends the buffer
+ * @param dst   receiving thread, borrows the buffer
+ * @param mr    message register holding the buffer fpage
+ *
+ * @return true if the window was opened
+ */
+bool
+open_ipc_window(tcb_t * src, tcb_t * dst, word_t mr)
+{
+    space_t * src_space = src->get_space();
+    space_t * dst_space = dst->get_space();
+    kmem_resource_t * kresource;
+    fpage_t source, window;
+    word_t rwx, size, src_addr, dst_addr;
+
+    if (EXPECT_FALSE(mr >= IPC_NUM_MR || src_space == dst_space)) {
+        return false;
+    }
+
+    source.raw = src->get_mr(mr);
+    window = dst->get_acceptor().get_window();
+    rwx = source.get_rwx();
+    size = source.get_size_log2();
+
+    /* The buffer must be page sized and fit into the offered window */
+    if (EXPECT_FALSE(source.is_nil_fpage() || source.is_complete_fpage() ||
+                     window.is_nil_fpage() || window.is_complete_fpage() ||
+                     rwx == 0 || size < page_shift(pgent_t::size_min) ||
+                     size > window.get_size_log2())) {
+        return false;
+    }
+
+    src_addr = (word_t)source.get_address();
+    dst_addr = (word_t)window.get_address();
+
+    window.set(dst_addr, size, rwx & 4, rwx & 2, rwx & 1);
+
+    if (EXPECT_FALSE(!src_space->is_user_area(source) ||
+                     !dst_space->is_user_area(window))) {
+        return false;
+    }
+
+    /* Page tables for the window are charged to the receiver if possible */
+    kresource = dst_space->get_kmem_resource();
+    if (kresource == NULL) {
+        kresource = src_space->get_kmem_resource();
+    }
+    if (EXPECT_FALSE(kresource == NULL)) {
+        return false;
+    }
+
+    /* A thread lends or borrows at most one window at a time */
+    close_ipc_window(src);
+    close_ipc_window(dst);
+
+    if (EXPECT_FALSE(!map_window_pages(src_space, src_addr, dst_space,
+                                       dst_addr, 1UL << size, rwx,
+                                       kresource))) {
+        dst_space->unmap_fpage(window, false, kresource);
+        return false;
+    }
+
+    /*
+     * Writable buffers are moved: the lender loses its mappings and
+     * gets them back from its pager once the window is closed.
+     */
+    if (rwx & 2) {
+        src_space->unmap_fpage(source, false, kresource);
+    }
+
+    dst->ipc_window.partner = src;
+    dst->ipc_window.window = window;
+    dst->ipc_window.source = source;
+    dst->ipc_window.kresource = kresource;
+
+    src->ipc_window.partner = dst;
+    src->ipc_window.window.raw = 0;
+    src->ipc_window.source = source;
+    src->ipc_window.kresource = NULL;
+    src_space->ipc_windows_lent++;
+
+    /* Keep both threads off the IPC fastpath while the window is open */
+    src->resource_bits += IPC_WINDOW;
+    dst->resource_bits += IPC_WINDOW;
+
+    dst->set_mr(mr, window.raw);
+    return true;
+}
+
+/**
+ * Close the window that a thread lends or borrows, if any, and unmap
+ * it from the borrower.
+ *
+ * Must be called with the privileged syscall lock held.
+ */
+void
+close_ipc_window(tcb_t * tcb)
+{
+    tcb_t * borrower, * lender;
+
+    if (EXPECT_TRUE(!tcb->ipc_window.is_open())) {
+        return;
+    }
+
+    if (tcb->ipc_window.is_borrower()) {
+        borrower = tcb;
+        lender = tcb->ipc_window.partner;
+    } else {
+        lender = tcb;
+        borrower = tcb->ipc_window.partner;
+    }
+
+    ASSERT(DEBUG, lender->ipc_window.partner == borrower);
+    ASSERT(DEBUG, borrower->ipc_window.partner == lender);
+
+    borrower->get_space()->unmap_fpage(borrower->ipc_window.window, false,
+                                       borrower->ipc_window.kresource);
+
+    borrower->ipc_window.partner = NULL;
+    borrower->ipc_window.window.raw = 0;
+    borrower->ipc_window.source.raw = 0;
+    borrower->ipc_window.kresource = NULL;
+    lender->ipc_window.partner = NULL;
+    lender->ipc_window.source.raw = 0;
+    lender->get_space()->ipc_windows_lent--;
+
+    borrower->resource_bits -= IPC_WINDOW;
+    lender->resource_bits -= IPC_WINDOW;
+}
+
+/*
+ * Address range covered by an fpage, the complete fpage covering all of
+ * the address space.
+ */
+static void
+fpage_range(fpage_t fpage, word_t * start, word_t * end)
+{
+    word_t size = fpage.get_size_log2();
+
+    if (fpage.is_complete_fpage() || size >= BITS_WORD) {
+        *start = 0;
+        *end = ~0UL;
+        return;
+    }
+    *start = (word_t)fpage.get_address() & ~((1UL << size) - 1);
+    *end = *start + (1UL << size) - 1;
+}
+
+/**
+ * Close every window lent by a thread of 'space' whose buffer overlaps
+ * 'fpage'. Called before 'fpage' is unmapped or remapped in 'space', so
+ * that no borrower keeps access to frames the lender has given up.
+ *
+ * Closing a window unmaps it from the borrower, which may close further
+ * windows, so the thread list is walked afresh after each one.
+ */
+void
+close_lent_ipc_windows(space_t * space, fpage_t fpage)
+{
+    word_t start, end, src_start, src_end;
+
+    fpage_range(fpage, &start, &end);
+
+    while (space->ipc_windows_lent != 0) {
+        tcb_t * lender = NULL;
+        tcb_t * walk;
+
+        spaces_list_lock.lock();
+        walk = space->get_thread_list();
+        if (walk != NULL) {
+            do {
+                if (walk->ipc_window.is_open() &&
+                        !walk->ipc_window.is_borrower()) {
+                    fpage_range(walk->ipc_window.source,
+                                &src_start, &src_end);
+                    if (src_start <= end && start <= src_end) {
+                        lender = walk;
+                        break;
+                    }
+                }
+                walk = walk->thread_list.next;
+            } while (walk != space->get_thread_list());
+        }
+        spaces_list_lock.unlock();
+
+        if (lender == NULL) {
+            break;
+        }
+        close_ipc_window(lender);
+    }
+}
+
+#endif /* CONFIG_IPC_WINDOWS */
@@ -87,6 +87,7 @@
 #include <kmem_resource.h>
 #include <space.h>
 #include <tcb.h>
+#include <mp.h>
 #include <kdb/tracepoints.h>
 
 DECLARE_TRACEPOINT (KMEM_ALLOC);
@@ -185,15 +186,195 @@ void kmem_resource_t::init(void *end)
     init_heap((void *)((word_t)this + KMEM_CHUNKSIZE), end);
     init_kmem_groups();
     init_small_alloc_pools();
+    init_magazines();
+}
+
+/* Execution unit whose magazines the current thread uses */
+static inline word_t
+current_unit(void)
+{
+#if defined(CONFIG_MUNITS)
+    return get_current_context().unit;
+#else
+    return 0;
+#endif
+}
+
+void kmem_resource_t::init_magazines(void)
+{
+    drains = 0;
+    drained = false;
+#if defined(CONFIG_KMEM_DEBUG)
+    /* Keep double free and poison checks exact: no caching */
+    magazines = NULL;
+#else
+    word_t i, num = CONFIG_NUM_UNITS * MAX_KMEM_SMALL_ALLOC_GROUP;
+
+    /* Without memory for the magazines, fall back to the bare pools */
+    magazines = (kmem_magazine_t *)heap.alloc(&kmem_groups[kmem_group_misc],
+            num * sizeof(kmem_magazine_t), true);
+    if (magazines == NULL) {
+        return;
+    }
+    for (i = 0; i < num; i++) {
+        magazines[i].lock.init();
+    }
+#endif
+}
+
+/*
+ * Return the cached objects of a magazine, except for the 'keep' most
+ * recently freed ones, to the pool. Called with both the resource and
+ * the magazine lock held. Returns the number of objects returned.
+ */
+word_t kmem_resource_t::flush_magazine(kmem_group_e group,
+        kmem_magazine_t * mag, word_t keep)
+{
+    word_t i, flush;
+
+    if (mag->rounds <= keep) {
+        return 0;
+    }
+    flush = mag->rounds - keep;
+    for (i = 0; i < flush; i++) {
+        small_alloc_pools[group].free(mag->objects[i]);
+    }
+    for (i = 0; i < keep; i++) {
+        mag->objects[i] = mag->objects[flush + i];
+    }
+    mag->rounds = keep;
+    return flush;
+}
+
+/*
+ * Empty the magazines of all units. Called with the resource lock held.
+ */
+void kmem_resource_t::drain_magazines(void)
+{
+    word_t unit, group, flushed = 0;
+
+    for (unit = 0; unit < CONFIG_NUM_UNITS; unit++) {
+        for (group = 0; group < MAX_KMEM_SMALL_ALLOC_GROUP; group++) {
+            kmem_magazine_t * mag = get_magazine(unit, (kmem_group_e)group);
+            mag->lock.lock();
+            flushed += flush_magazine((kmem_group_e)group, mag, 0);
+            mag->lock.unlock();
+        }
+    }
+    if (flushed) {
+        drains++;
+    }
+}
+
+/*
+ * Drain the magazines once per pressure episode. An episode ends when
+ * memory is freed to the resource under its lock. Called with the
+ * resource lock held. Returns false if there was nothing new to drain.
+ */
+bool kmem_resource_t::relieve_pressure(void)
+{
+    if (drained) {
+        return false;
+    }
+    drain_magazines();
+    drained = true;
+    return true;
+}
+
+/*
+ * Drain the magazines when the heap runs low. Called with the resource
+ * lock held.
+ */
+void kmem_resource_t::check_pressure(void)
+{
+    if (EXPECT_FALSE(magazines != NULL &&
+                heap.chunks_left() < KMEM_DRAIN_WATERMARK)) {
+        (void)relieve_pressure();
+    }
+}
+
+void * kmem_resource_t::magazine_alloc(kmem_group_e group, bool zeroed)
+{
+    kmem_magazine_t * mag = get_magazine(current_unit(), group);
+    small_alloc_t * pool = &small_alloc_pools[group];
+    void * ret = NULL;
+
+    mag->lock.lock();
+    if (EXPECT_TRUE(mag->rounds > 0)) {
+        ret = mag->objects[--mag->rounds];
+        mag->hits++;
+    } else {
+        mag->misses++;
+    }
+    mag->lock.unlock();
+
+    if (EXPECT_TRUE(ret != NULL)) {
+        if (zeroed) {
+            memset(ret, 0, pool->get_obj_size());
+        }
+        return ret;
+    }
+
+    lock.lock();
+    ret = pool->allocate(zeroed);
+    if (ret == NULL) {
+        /* Other units may be holding on to free objects */
+        if (relieve_pressure()) {
+            ret = pool->allocate(zeroed);
+        }
+    } else {
+        /*
+         * Refill half of the magazine while we hold the resource lock,
+         * but only from blocks the pool already owns and not when the
+         * heap is short of memory.
+         */
+        mag->lock.lock();
+        while (mag->rounds < KMEM_MAGAZINE_SIZE / 2 && pool->has_free() &&
+                heap.chunks_left() >= KMEM_DRAIN_WATERMARK) {
+            mag->objects[mag->rounds++] = pool->allocate(false);
+        }
+        mag->lock.unlock();
+    }
+    check_pressure();
+    lock.unlock();
+
+    return ret;
+}
+
+void kmem_resource_t::magazine_free(kmem_group_e group, void * address)
+{
+    kmem_magazine_t * mag = get_magazine(current_unit(), group);
+
+    mag->lock.lock();
+    if (EXPECT_TRUE(mag->rounds < KMEM_MAGAZINE_SIZE)) {
+        mag->objects[mag->rounds++] = address;
+        mag->lock.unlock();
+        return;
+    }
+    mag->lock.unlock();
+
+    /* Magazine is full, return the colder half to the pool */
+    lock.lock();
+    mag->lock.lock();
+    mag->flushes++;
+    flush_magazine(group, mag, KMEM_MAGAZINE_SIZE / 2);
+    mag->lock.unlock();
+    small_alloc_pools[group].free(address);
+    drained = false;
+    lock.unlock();
 }
 
 void * kmem_resource_t::alloc(kmem_group_e group, bool zeroed)
 {
     void * ret;
-    lock.lock();
     ASSERT(ALWAYS, is_small_alloc_group(group));
-    ret = small_alloc_pools[group].allocate(zeroed);
-    lock.unlock();
+    if (EXPECT_TRUE(magazines != NULL)) {
+        ret = magazine_alloc(group, zeroed);
+    } else {
+        lock.lock();
+        ret = small_alloc_pools[group].allocate(zeroed);
+        lock.unlock();
+    }
     TRACEPOINT_TB(KMEM_ALLOC,
                   printf("kmem_alloc_small(%x), ip: %p ==> %p\n",
                          (int)group, __return_address(), ret),
@@ -208,6 +389,11 @@ void * kmem_resource_t::alloc(kmem_group_e group, word_t size, bool zeroed)
     lock.lock();
     ASSERT(ALWAYS, !is_small_alloc_group(group));
     ret = heap.alloc(&kmem_groups[group], size, zeroed);
+    if (EXPECT_FALSE(ret == NULL && magazines != NULL) &&
+            relieve_pressure()) {
+        ret = heap.alloc(&kmem_groups[group], size, zeroed);
+    }
+    check_pressure();
     lock.unlock();
     TRACEPOINT_TB(KMEM_ALLOC,
                   printf("kmem_alloc(%lx), ip: %p ==> %p\n",
@@ -225,6 +411,12 @@ void * kmem_resource_t::alloc_aligned(
     lock.lock();
     ASSERT(ALWAYS, !is_small_alloc_group(group));
     ret = heap.alloc_aligned(&kmem_groups[group], size, alignment, mask, zeroed);
+    if (EXPECT_FALSE(ret == NULL && magazines != NULL) &&
+            relieve_pressure()) {
+        ret = heap.alloc_aligned(&kmem_groups[group], size, alignment, mask,
+                                 zeroed);
+    }
+    check_pressure();
     lock.unlock();
     TRACEPOINT_TB(KMEM_ALLOC,
                   printf("kmem_alloc_aligned(%lx), ip: %p ==> %p\n",
@@ -237,18 +429,27 @@ void * kmem_resource_t::alloc_aligned(
 
 void kmem_resource_t::free(kmem_group_e group, void * address, word_t size)
 {
-    lock.lock();
-    if (size == 0)
+    if (size == 0 && EXPECT_TRUE(magazines != NULL))
     {
         ASSERT(ALWAYS, is_small_alloc_group(group));
-        small_alloc_pools[group].free(address);
+        magazine_free(group, address);
     }
     else
     {
-        ASSERT(ALWAYS, !is_small_alloc_group(group));
-        heap.free(&kmem_groups[group], address, size);
+        lock.lock();
+        if (size == 0)
+        {
+            ASSERT(ALWAYS, is_small_alloc_group(group));
+            small_alloc_pools[group].free(address);
+        }
+        else
+        {
+            ASSERT(ALWAYS, !is_small_alloc_group(group));
+            heap.free(&kmem_groups[group], address, size);
+        }
+        drained = false;
+        lock.unlock();
     }
-    lock.unlock();
     TRACEPOINT_TB(KMEM_FREE,
                   printf ("kmem free (%p, %lx), ip: %p\n",
                           address, size,
@@ -80,7 +80,7 @@
  * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 /*
- * Description:   very simple kernel memory allocator
+ * Description:   buddy kernel memory allocator
  */
 #include <l4.h>
 #include <kmemory.h>
@@ -88,6 +88,7 @@
 #include <init.h>
 #include <sync.h>
 #include <kmem_resource.h>
+#include <kernel/arch/special.h>
 
 #ifdef CONFIG_ARCH_MIPS64
 #include INC_PLAT(cache.h)
@@ -111,22 +112,20 @@
 {                                                               \
     __asm__ __volatile__ ("" ::: "memory");                     \
     word_t num = 0;                                             \
-    word_t * ptr = kmem_free_list;                              \
-    while(ptr)                                                  \
+    for (word_t o = 0; o < KMEM_ORDERS; o++)                    \
     {                                                           \
-        ptr = (word_t*)(*ptr);                                  \
-        num++;                                                  \
+        kmem_block_t * ptr = free_lists[o];                     \
+        while(ptr)                                              \
+        {                                                       \
+            ptr = ptr->next;                                    \
+            num += 1UL << o;                                    \
+        }                                                       \
     }                                                           \
     if (num != free_chunks)                                     \
     {                                                           \
-        TRACEF("inconsistent kmem list: %d != %d (free_chunks)" \
+        TRACEF("inconsistent kmem lists: %d != %d (free_chunks)" \
                "\ncaller=%p\n",                                 \
             num, free_chunks, __return_address());              \
-        ptr = kmem_free_list;                                   \
-        while(ptr) {                                            \
-            printf("%p -> ", ptr);                              \
-            ptr = (word_t*)*ptr;                                \
-        }                                                       \
         enter_kdebug("broken kmem");                            \
     }                                                           \
 }
@@ -162,13 +161,25 @@ is_overlapping(word_t addr, word_t size, word_t addr2, word_t size2)
 }
 
 void kmem_t::check_free(void * addr, word_t size) {
-    word_t * ptr = kmem_free_list;
-    while(ptr) {
-        if (is_overlapping((word_t)addr, size, (word_t)ptr, KMEM_CHUNKSIZE)) {
-            TRACEF("addr(%p) was already freed\n", addr);
-            enter_kdebug("double free");
+    kmem_region_t * region = find_region((word_t)addr);
+    if (region == NULL) {
+        return;
+    }
+    /* Look for a free block covering any of the chunks */
+    for (word_t c = (word_t)addr; c < (word_t)addr + size; c += KMEM_CHUNKSIZE) {
+        for (word_t o = 0; o < KMEM_ORDERS; o++) {
+            word_t base = c & ~((KMEM_CHUNKSIZE << o) - 1);
+            if (!region->contains(base)) {
+                break;
+            }
+            u8_t entry = *region->map_entry(base);
+            if ((entry & KMEM_MAP_FREE) && base +
+                    (KMEM_CHUNKSIZE << (entry & ~KMEM_MAP_FREE)) > c) {
+                TRACEF("addr(%p) was already freed\n", addr);
+                enter_kdebug("double free");
+                return;
+            }
         }
-        ptr = (word_t*)(*ptr);
     }
 }
 #endif
@@ -183,19 +194,222 @@ void kmem_t::init(void * start, void * end)
                 ISIZE >= GB (1) ? 'G' : ISIZE >= MB (1) ? 'M' : 'K');
 
     /* initialize members */
-    kmem_free_list = NULL;
+    for (word_t o = 0; o < KMEM_ORDERS; o++)
+    {
+        free_lists[o] = NULL;
+        free_blocks[o] = 0;
+    }
+    free_orders = 0;
+    num_regions = 0;
     free_chunks = 0;
+    splits = 0;
+    merges = 0;
+    failed_allocs = 0;
 
     /* do the real work */
-    free(start, (word_t)end - (word_t)start);
+    add_region(start, end);
 }
 
-/* the stupid version */
-void kmem_t::free(void * address, word_t size)
+/*
+ * Add a range of memory to the heap. Memory inside a known region is
+ * simply freed; otherwise the range becomes a new region, and its first
+ * chunks hold the region's order map.
+ */
+void kmem_t::add_region(void * start, void * end)
+{
+    word_t s = ((word_t)start + KMEM_CHUNKSIZE - 1) & ~(KMEM_CHUNKSIZE - 1);
+    word_t e = (word_t)end & ~(KMEM_CHUNKSIZE - 1);
+
+    if (s >= e)
+        return;
+
+    kmem_region_t * region = find_region(s);
+    if (region != NULL)
+    {
+        free((void *)s, e - s);
+        return;
+    }
+
+    ASSERT(ALWAYS, num_regions < KMEM_MAX_REGIONS);
+
+    word_t map_size = (((e - s) / KMEM_CHUNKSIZE) + KMEM_CHUNKSIZE - 1) &
+        ~(KMEM_CHUNKSIZE - 1);
+    if (map_size >= e - s)
+        return;
+
+    region = &regions[num_regions++];
+    region->order_map = (u8_t *)s;
+    region->start = s + map_size;
+    region->end = e;
+    for (word_t i = 0; i < map_size; i++)
+        region->order_map[i] = 0;
+
+#if defined(CONFIG_KMEM_DEBUG)
+    poison_area((void *)region->start, e - region->start, KMEM_POISON_FREE);
+#endif
+    free_range(region, region->start, e - region->start);
+}
+
+kmem_region_t * kmem_t::find_region(word_t addr)
+{
+    for (word_t i = 0; i < num_regions; i++)
+    {
+        if (regions[i].contains(addr))
+            return &regions[i];
+    }
+    return NULL;
+}
+
+void kmem_t::enqueue_block(kmem_region_t * region, word_t addr, word_t order)
+{
+    kmem_block_t * block = (kmem_block_t *)addr;
+
+    block->prev = NULL;
+    block->next = free_lists[order];
+    if (block->next)
+        block->next->prev = block;
+    free_lists[order] = block;
+
+    free_orders |= 1UL << order;
+    free_blocks[order]++;
+    free_chunks += 1UL << order;
+    *region->map_entry(addr) = KMEM_MAP_FREE | order;
+}
+
+void kmem_t::dequeue_block(kmem_region_t * region, word_t addr, word_t order)
+{
+    kmem_block_t * block = (kmem_block_t *)addr;
+
+    if (block->prev)
+        block->prev->next = block->next;
+    else
+        free_lists[order] = block->next;
+    if (block->next)
+        block->next->prev = block->prev;
+
+    if (free_lists[order] == NULL)
+        free_orders &= ~(1UL << order);
+    free_blocks[order]--;
+    free_chunks -= 1UL << order;
+    *region->map_entry(addr) = 0;
+}
+
+/* Free a naturally aligned block, merging it with free buddies */
+void kmem_t::free_block(kmem_region_t * region, word_t addr, word_t order)
+{
+    while (order + 1 < KMEM_ORDERS)
+    {
+        word_t buddy = addr ^ (KMEM_CHUNKSIZE << order);
+
+        if (!region->contains(buddy) ||
+                *region->map_entry(buddy) != (KMEM_MAP_FREE | order))
+            break;
+
+        dequeue_block(region, buddy, order);
+        addr = min(addr, buddy);
+        order++;
+        merges++;
+    }
+    enqueue_block(region, addr, order);
+}
+
+/* Free an arbitrary chunk-aligned range as naturally aligned blocks */
+void kmem_t::free_range(kmem_region_t * region, word_t addr, word_t size)
+{
+    while (size)
+    {
+        word_t order = 0;
+
+        while (order + 1 < KMEM_ORDERS &&
+                (addr & ((KMEM_CHUNKSIZE << (order + 1)) - 1)) == 0 &&
+                (KMEM_CHUNKSIZE << (order + 1)) <= size)
+            order++;
+
+        free_block(region, addr, order);
+        addr += KMEM_CHUNKSIZE << order;
+        size -= KMEM_CHUNKSIZE << order;
+    }
+}
+
+/*
+ * Remove a free block from its list and split it down to the block of
+ * order 'want' that contains 'target'. The other halves are freed.
+ */
+word_t kmem_t::take_block(kmem_region_t * region, word_t block, word_t order,
+                          word_t target, word_t want)
+{
+    dequeue_block(region, block, order);
+
+    while (order > want)
+    {
+        order--;
+        word_t half = KMEM_CHUNKSIZE << order;
+
+        if (target >= block + half)
+        {
+            enqueue_block(region, block, order);
+            block += half;
+        }
+        else
+        {
+            enqueue_block(region, block + half, order);
+        }
+        splits++;
+    }
+    return block;
+}
+
+void * kmem_t::finish_alloc(word_t addr, word_t size, bool zeroed)
 {
-    word_t* p;
-    word_t* prev, *curr;
+    word_t * curr = (word_t *)addr;
+
+#if defined(CONFIG_KMEM_DEBUG)
+    for (word_t i = 0; i < size / KMEM_CHUNKSIZE; ++i) {
+        void * obj = (unsigned char *)curr + i * KMEM_CHUNKSIZE;
+        check_poisoned_area((unsigned char *)obj + sizeof(kmem_block_t), /* skip header */
+                            KMEM_CHUNKSIZE - sizeof(kmem_block_t),
+                            KMEM_POISON_FREE,
+                            obj);
+    }
+    if (!zeroed) {
+        poison_area(curr, size, KMEM_POISON_ALLOC);
+    }
+#endif
+    if (zeroed)
+    {
+#if defined(HAVE_FASTER_MEMZERO)
+        mem_zero(curr, size);
+#else
+        /* zero the page */
+        word_t *p = curr;
+        do {
+            *p++ = 0; *p++ = 0; *p++ = 0; *p++ = 0;
+        } while ((word_t)p < (word_t)curr + size);
+#endif
+    }
+
+    /* successful return */
+    ALLOC_TRACE("kmalloc: %x->%p (%d), caller: %p\n",
+                size, curr, free_chunks, __return_address());
+    KMEM_CHECK;
+
+    return curr;
+}
 
+/* Order of the smallest block holding 'size' bytes */
+static inline word_t
+kmem_size_order(word_t size)
+{
+    word_t chunks = size / KMEM_CHUNKSIZE;
+    word_t order = msb(chunks);
+
+    if (chunks & ((1UL << order) - 1))
+        order++;
+    return order;
+}
+
+void kmem_t::free(void * address, word_t size)
+{
     FREE_TRACE("kmem_free(%p, %x)\n", address, size);
 
     KMEM_CHECK;
@@ -203,222 +417,107 @@ void kmem_t::free(void * address, word_t size)
     size = max(size, (word_t)KMEM_CHUNKSIZE);
     ASSERT(NORMAL, (size % KMEM_CHUNKSIZE) == 0);
 
+    kmem_region_t * region = find_region((word_t)address);
+    ASSERT(ALWAYS, region != NULL);
+
 #if defined(CONFIG_KMEM_DEBUG)
     check_free(address, size);
     poison_area(address, size, KMEM_POISON_FREE);
 #endif
 
-    for (p = (word_t*)address;
-         p < ((word_t*)(((word_t)address) + size - KMEM_CHUNKSIZE));
-         p = (word_t*) *p)
-        *p = (word_t) p + KMEM_CHUNKSIZE; /* write next pointer */
-
-    /* find the place to insert */
-    for (prev = (word_t*) (void*)&kmem_free_list, curr = kmem_free_list;
-         curr && (address > curr);
-         prev = curr, curr = (word_t*) *curr);
-    /* and insert there */
-    FREE_TRACE("prev %p/%p, curr %p, p: %p, \n", prev, *prev, curr, p);
-    *prev = (word_t) address; *p = (word_t) curr;
-
-    /* update counter */
-    free_chunks += (size/KMEM_CHUNKSIZE);
+    free_range(region, (word_t)address, size);
+
     FREE_TRACE("kmem: free chunks=%x\n", free_chunks);
     KMEM_CHECK;
 }
 
-
-/* the stupid version */
 void * kmem_t::alloc(word_t size, bool zeroed)
 {
-    word_t*     prev;
-    word_t*     curr;
-    word_t*     tmp;
-    word_t      i;
-
-    ALLOC_TRACE("%s(%d) kfl: %p\n", __FUNCTION__, size, kmem_free_list);
+    ALLOC_TRACE("%s(%d) free chunks: %d\n", __FUNCTION__, size, free_chunks);
 
     KMEM_CHECK;
 
     /* round up to the next CHUNKSIZE */
     size = ((size - 1) & ~(KMEM_CHUNKSIZE-1)) + KMEM_CHUNKSIZE;
 
-    for (prev = (word_t*)(void*) &kmem_free_list, curr = kmem_free_list;
-         curr;
-         prev = curr, curr = (word_t*) *curr)
+    word_t order = kmem_size_order(size);
+    word_t avail = order < KMEM_ORDERS ?
+        free_orders & ~((1UL << order) - 1) : 0;
+
+    if (EXPECT_FALSE(avail == 0))
     {
-        ALLOC_TRACE("curr=%x\n", curr);
-        /* properly aligned ??? */
-        if (!((word_t) curr & (size - 1)))
-        {
-            ALLOC_TRACE("%s(%d):%d: curr=%x\n", __FUNCTION__,
-                        size, __LINE__, curr);
-
-            tmp = (word_t*) *curr;
-            for (i = 1; tmp && (i < (size / KMEM_CHUNKSIZE)); i++)
-            {
-                ALLOC_TRACE("%s():%d: i=%d, tmp=%x\n",
-                            __FUNCTION__, __LINE__, i, tmp);
-
-                if ((word_t) tmp != ((word_t) curr + KMEM_CHUNKSIZE*i))
-                {
-                    ALLOC_TRACE("skip: %x\n", curr);
-                    tmp = 0;
-                    break;
-                };
-                tmp = (word_t*) *tmp;
-            }
-            if (tmp)
-            {
-                word_t num_chunks = size/KMEM_CHUNKSIZE;
+        failed_allocs++;
+        return NULL;
+    }
 
-                /* dequeue */
-                *prev = (word_t) tmp;
+    /* smallest free block that is large enough */
+    word_t found = msb(avail & -avail);
+    word_t block = (word_t)free_lists[found];
+    kmem_region_t * region = find_region(block);
 
-#if defined(CONFIG_KMEM_DEBUG)
-                for(i = 0; i < num_chunks; ++i) {
-                    void * obj = (unsigned char *)curr + i * KMEM_CHUNKSIZE;
-                    check_poisoned_area((unsigned char *)obj + sizeof(word_t), /* skip link*/
-                                        KMEM_CHUNKSIZE - sizeof(word_t),
-                                        KMEM_POISON_FREE,
-                                        obj);
-                }
-                if (!zeroed) {
-                    poison_area(curr, size, KMEM_POISON_ALLOC);
-                }
-#endif
-                if (zeroed)
-                {
-#if defined(HAVE_FASTER_MEMZERO)
-                    mem_zero(curr, size);
-#else
-                    /* zero the page */
-                    word_t *p = curr;
-                    do {
-                        *p++ = 0; *p++ = 0; *p++ = 0; *p++ = 0;
-                    } while ((word_t)p < (word_t)curr + size);
-#endif
-                }
-
-                /* update counter */
-                free_chunks -= num_chunks;
+    word_t addr = take_block(region, block, found, block, order);
 
-                /* successful return */
-                ALLOC_TRACE("kmalloc: %x->%p (%d), kfl: %p, caller: %p\n",
-                            size, curr, free_chunks, kmem_free_list, __return_address());
-                KMEM_CHECK;
+    /* give back the unused end of the block */
+    if (size < (KMEM_CHUNKSIZE << order))
+        free_range(region, addr + size, (KMEM_CHUNKSIZE << order) - size);
 
-                return curr;
-            }
-        }
-    }
-#if 0
-    word_t * tmp1 = kmem_free_list;
-    while(tmp1) {
-        printf("%p -> ", tmp1);
-        tmp1 = (word_t*)*tmp1;
-    }
-#endif
-    return NULL;
+    return finish_alloc(addr, size, zeroed);
 }
 
 #define ALIGN(x)    (x & mask)
 
 #if defined(CONFIG_ARCH_MIPS) || (defined(CONFIG_ARM_VER) && (CONFIG_ARM_VER == 6))
-/* the stupid aligned version */
-    void * kmem_t::alloc_aligned(word_t size, word_t alignment, word_t mask, bool zeroed)
+/*
+ * Allocate a block whose address matches 'alignment' in the bits selected
+ * by 'mask' (e.g. a cache colour). A block larger than the mask can
+ * always be split to match; smaller blocks have to be searched.
+ */
+void * kmem_t::alloc_aligned(word_t size, word_t alignment, word_t mask, bool zeroed)
 {
-    word_t*     prev;
-    word_t*     curr;
-    word_t*     tmp;
-    word_t      i;
-
     word_t      align = ALIGN(alignment);
 
-    ALLOC_TRACE("%s(%d) kfl: %p\n", __FUNCTION__, size, kmem_free_list);
+    ALLOC_TRACE("%s(%d) free chunks: %d\n", __FUNCTION__, size, free_chunks);
 
     KMEM_CHECK;
 
     size = max(size, (word_t)KMEM_CHUNKSIZE);
     ASSERT(NORMAL, (size % KMEM_CHUNKSIZE) == 0);
 
-    for (prev = (word_t*) &kmem_free_list, curr = kmem_free_list;
-         curr;
-         prev = curr, curr = (word_t*) *curr)
+    word_t order = kmem_size_order(size);
+
+    /* the block must be naturally aligned to its size */
+    if (align & ((KMEM_CHUNKSIZE << order) - 1))
     {
-        ALLOC_TRACE("curr=%x\n", curr);
-        /* properly aligned ??? */
-        if ((ALIGN((word_t)curr) == align) && (!((word_t) curr & ((size)- 1))))
+        failed_allocs++;
+        return NULL;
+    }
+
+    for (word_t o = order; o < KMEM_ORDERS; o++)
+    {
+        word_t low = (KMEM_CHUNKSIZE << o) - 1;
+
+        for (kmem_block_t * curr = free_lists[o]; curr; curr = curr->next)
         {
-            ALLOC_TRACE("%s(%d):%d: curr=%x\n", __FUNCTION__,
-                        size, __LINE__, curr);
-
-            tmp = (word_t*) *curr;
-            for (i = 1; tmp && (i < (size / KMEM_CHUNKSIZE)); i++)
-            {
-                ALLOC_TRACE("%s():%d: i=%d, tmp=%x\n",
-                            __FUNCTION__, __LINE__, i, tmp);
-
-                if ((word_t) tmp != ((word_t) curr + KMEM_CHUNKSIZE*i))
-                {
-                    ALLOC_TRACE("skip: %x\n", curr);
-                    tmp = 0;
-                    break;
-                };
-                tmp = (word_t*) *tmp;
-            }
-            if (tmp)
-            {
-                word_t num_chunks = size/KMEM_CHUNKSIZE;
+            word_t block = (word_t)curr;
 
-                /* dequeue */
-                *prev = (word_t) tmp;
+            /* properly aligned ??? */
+            if (ALIGN(block & ~low) != (align & ~low))
+                continue;
 
-#if defined(CONFIG_KMEM_DEBUG)
-                for(i = 0; i < num_chunks; ++i) {
-                    void * obj = (unsigned char *)curr + i * KMEM_CHUNKSIZE;
-                    check_poisoned_area((unsigned char *)obj + sizeof(word_t), /* skip link*/
-                                        KMEM_CHUNKSIZE - sizeof(word_t),
-                                        KMEM_POISON_FREE,
-                                        obj);
-                }
-                if (!zeroed) {
-                    poison_area(curr, size, KMEM_POISON_ALLOC);
-                }
-#endif
-                if (zeroed)
-                {
-#if defined(HAVE_FASTER_MEMZERO)
-                    mem_zero(curr, size);
-#else
-                    /* zero the page */
-                    word_t *p = curr;
-                    do {
-                        *p++ = 0; *p++ = 0; *p++ = 0; *p++ = 0;
-                    } while ((word_t)p < (word_t)curr + size);
-#endif
-                }
-                /* update counter */
-                free_chunks -= num_chunks;
+            kmem_region_t * region = find_region(block);
+            word_t target = block | (align & low);
+            word_t addr = take_block(region, block, o, target, order);
 
-                /* successful return */
-                ALLOC_TRACE("kmalloc: %x->%p (%d), kfl: %p, caller: %p\n",
-                            size, curr, free_chunks, kmem_free_list, __return_address());
-                KMEM_CHECK;
+            /* give back the unused end of the block */
+            if (size < (KMEM_CHUNKSIZE << order))
+                free_range(region, addr + size,
+                           (KMEM_CHUNKSIZE << order) - size);
 
-                return curr;
-            }
+            return finish_alloc(addr, size, zeroed);
         }
     }
-#if 0
-    word_t * tmp1 = kmem_free_list;
-    while(tmp1) {
-        printf("%p -> ", tmp1);
-        tmp1 = (word_t*)*tmp1;
-    }
-#endif
 
+    failed_allocs++;
     return NULL;
 }
 #endif
-
@@ -97,6 +97,7 @@
 
 #include <kdb/tracepoints.h>
 #include <linear_ptab.h>
+#include <tlb_flush_batch.h>
 
 
 DECLARE_TRACEPOINT (FPAGE_MAP);
@@ -153,7 +154,7 @@ bool generic_space_t::map_fpage(phys_desc_t base, fpage_t dest_fp,
     pgent_t::pgsize_e pgsize, t_size;
     addr_t t_addr, p_addr;
     pgent_t * tpg;
-    bool flush = false;
+    tlb_flush_batch_t tlb;
 
 #ifdef CONFIG_PT_LEVEL_SKIP
     pgent_t::hw_pgsize_e hw_pgsize;
@@ -178,6 +179,13 @@ bool generic_space_t::map_fpage(phys_desc_t base, fpage_t dest_fp,
 
     t_addr = address (dest_fp, t_num);
 
+#if defined(CONFIG_IPC_WINDOWS)
+    /* Remapping part of a lent buffer revokes the window */
+    if (EXPECT_FALSE(((space_t *)this)->ipc_windows_lent != 0)) {
+        close_lent_ipc_windows((space_t *)this, dest_fp);
+    }
+#endif
+
     if (t_num > page_shift(pgent_t::size_max+1))
         t_num = page_shift(pgent_t::size_max+1);
 
@@ -206,6 +214,7 @@ bool generic_space_t::map_fpage(phys_desc_t base, fpage_t dest_fp,
 
     tpg = this->pgent(0)->next(this, t_size, page_table_index(t_size, t_addr));
 
+    tlb.init(this, get_current_space ());
     begin_update ();
 
     TRACEPOINT (FPAGE_MAP,
@@ -269,14 +278,12 @@ map_next_level:
                  * Delete the larger mapping.
                  */
                 /* We might have to flush some TLB entries */
-                this->flush_tlbent_local (get_current_space (), t_addr, page_shift (t_size));
+                tlb.add (t_addr, page_shift (t_size));
 
                 tpg->clear(this, t_size, false, t_addr);
                 TRACE_MAP("   - removed blocking superpage, tpg = %p, size %d, addr %p\n",
                         tpg, t_size, t_addr);
 
-                /* XXX flush remote cpus here */
-
                 /* restart with mapping removed */
                 continue;
             }
@@ -340,10 +347,7 @@ map_next_level:
                 else
                 {
                     /* We might have to flush some TLB entries */
-                    if (! this->does_tlbflush_pay (page_shift (t_size)))
-                    {
-                        this->flush_tlbent_local (get_current_space (), vaddr, page_shift (t_size));
-                    }
+                    tlb.add (vaddr, page_shift (t_size));
 
                     tpg->clear(this, t_size, false, vaddr);
                 }
@@ -368,12 +372,6 @@ map_next_level:
                 };
 
             }
-
-            /* We might have to flush the TLB after removing mappings. */
-            if (does_tlbflush_pay (page_shift (t_size)))
-            {
-                flush = true;
-            }
         }
         else if (EXPECT_FALSE(tpg->is_valid (this, t_size) &&
                     tpg->is_subtree (this, t_size)))
@@ -419,12 +417,9 @@ map_recurse_down:
                 dest_fp.is_write(), dest_fp.is_execute(), base.get_attributes());
 
             /* We might need to flush some tlb entries */
-            if (EXPECT_FALSE(valid && !flush))
+            if (EXPECT_FALSE(valid))
             {
-                if (!does_tlbflush_pay (page_shift (t_size)))
-                    flush_tlbent_local (get_current_space (), t_addr, page_shift (t_size));
-                else
-                    flush = true;
+                tlb.add (t_addr, page_shift (t_size));
             }
 
             tpg->set_entry (this,
@@ -436,11 +431,6 @@ map_recurse_down:
                     dest_fp.is_read(), dest_fp.is_write(),
                     dest_fp.is_execute(), false,
                     page_attributes);
-
-            if (EXPECT_FALSE(valid && !flush))
-            {
-                /* XXX flush remote cpus here */
-            }
         }
 
         /* Move on to the next map entry */
@@ -467,14 +457,14 @@ map_next_pgentry:
         }
     }
 
-    if (flush)
-        this->flush_tlb (get_current_space ());
+    tlb.flush ();
 
     end_update ();
     return true;
 
 map_fpage_fail:
 
+    tlb.flush ();
     end_update ();
     this->unmap_fpage (dest_fp, false, kresource);
     get_current_tcb ()->set_error_code (ENO_MEM);
@@ -495,7 +485,7 @@ void generic_space_t::unmap_fpage(fpage_t fpage, bool unmap_all, kmem_resource_t
     pgent_t * pg;
     addr_t vaddr;
     word_t num;
-    bool flush = false;
+    tlb_flush_batch_t tlb;
 
     pgent_t *r_pg[pgent_t::size_max];
     word_t r_num[pgent_t::size_max];
@@ -512,6 +502,13 @@ void generic_space_t::unmap_fpage(fpage_t fpage, bool unmap_all, kmem_resource_t
         return;
     }
 
+#if defined(CONFIG_IPC_WINDOWS)
+    /* Unmapping part of a lent buffer revokes the window */
+    if (EXPECT_FALSE(((space_t *)this)->ipc_windows_lent != 0)) {
+        close_lent_ipc_windows((space_t *)this, fpage);
+    }
+#endif
+
     /*
      * Some architectures may not support a complete virtual address
      * space.  Enforce unmaps to only cover the supported space.
@@ -531,6 +528,7 @@ void generic_space_t::unmap_fpage(fpage_t fpage, bool unmap_all, kmem_resource_t
     pg = this->pgent(0)->next(this, size, page_table_index(size, vaddr));
     //printf("[1] pg=%p, *pg=%lx\n", pg, *pg);
 
+    tlb.init(this, get_current_space ());
     begin_update ();
 
     while (num)
@@ -574,10 +572,11 @@ void generic_space_t::unmap_fpage(fpage_t fpage, bool unmap_all, kmem_resource_t
                  */
                 TRACE_UNMAP("   - remove superpage, pg = %p, size %d, addr %p\n",
                         pg, size, vaddr);
-                pg->clear(this, size, false, vaddr);
 
                 /* We might have to flush some TLB entries */
-                flush = true;
+                tlb.add (vaddr, page_shift (size));
+
+                pg->clear(this, size, false, vaddr);
 
                 /* restart with mapping removed */
                 continue;
@@ -599,7 +598,7 @@ void generic_space_t::unmap_fpage(fpage_t fpage, bool unmap_all, kmem_resource_t
                 TRACE_UNMAP("   - remove tree, pg = %p, size %d, addr %p\n",
                         pg, size, vaddr);
                 pg->remove_subtree (this, size, false, kresource);
-                flush = true;
+                tlb.add_space ();
                 goto unmap_next_pgentry;
             }
             else
@@ -619,17 +618,9 @@ void generic_space_t::unmap_fpage(fpage_t fpage, bool unmap_all, kmem_resource_t
         {
             TRACE_UNMAP("   - remove %p: vaddr = %p\n", pg, vaddr);
 
-            if (EXPECT_FALSE(!flush))
-            {
-                if (!does_tlbflush_pay (page_shift (size)))
-                    flush_tlbent_local (get_current_space (), vaddr, page_shift (size));
-                else
-                    flush = true;
-            }
+            tlb.add (vaddr, page_shift (size));
 
             pg->clear (this, size, true, vaddr);
-
-            /* XXX flush remote cpus here */
         }
 
 unmap_next_pgentry:
@@ -661,10 +652,7 @@ unmap_next_pgentry:
         }
     }
 
-    if (flush)
-    {
-        flush_tlb (get_current_space ());
-    }
+    tlb.flush ();
 
     end_update ();
 }
@@ -79,6 +79,66 @@
 
 DECLARE_TRACEPOINT (SYSCALL_MAP_CONTROL);
 
+
+/**
+ * Map or unmap a run of contiguous pages described by a single map item.
+ *
+ * The run is split into the largest naturally aligned power-of-two fpages
+ * that both the virtual and physical addresses allow.  map_fpage() then
+ * uses the largest hardware page size that fits each fpage, so suitably
+ * aligned parts of the run are mapped with large pages and each part of
+ * the run needs only one page table walk.
+ *
+ * @param space         space to modify
+ * @param fpg           first page of the run, carrying the access rights
+ * @param base          physical base and attributes of the first page
+ * @param run_size      size of the run in bytes
+ * @param map           true to map the run, false to unmap it
+ * @param kresource     kernel memory resource for page table allocation
+ *
+ * @return false if a mapping could not be created
+ */
+static bool
+map_control_run(space_t *space, fpage_t fpg, phys_desc_t base,
+                word_t run_size, bool map, kmem_resource_t *kresource)
+{
+    word_t vaddr = fpg.get_base();
+    word_t end = vaddr + run_size;
+    u64_t phys = base.get_base();
+
+    while (vaddr != end) {
+        word_t remaining = end - vaddr;
+        word_t align = map ? (vaddr | (word_t)phys) : vaddr;
+        word_t size_log2 = fpg.get_size_log2();
+        fpage_t chunk;
+
+        /* Grow the chunk while it stays aligned and inside the run. */
+        while (size_log2 + 1 < BITS_WORD &&
+               (align & ((1UL << (size_log2 + 1)) - 1)) == 0 &&
+               (1UL << (size_log2 + 1)) <= remaining) {
+            size_log2++;
+        }
+
+        chunk.raw = fpg.raw & 0x7;
+        chunk.x.size = size_log2;
+        chunk.x.base = vaddr >> 10;
+
+        if (map) {
+            base.set_base(phys);
+            if (EXPECT_FALSE(!space->map_fpage(base, chunk, kresource))) {
+                return false;
+            }
+        } else {
+            space->unmap_fpage(chunk, false, kresource);
+        }
+
+        vaddr += 1UL << size_log2;
+        phys += (u64_t)1 << size_log2;
+    }
+
+    return true;
+}
+
 SYS_MAP_CONTROL (spaceid_t space_id, word_t control)
 {
     LOCK_PRIVILEGED_SYSCALL();
@@ -211,6 +271,7 @@ SYS_MAP_CONTROL (spaceid_t space_id, word_t control)
             segment_desc_t seg;
             size_desc_t size;
             phys_segment_t *segment;
+            word_t run_size;
             bool valid_bit_set;
 
             seg.set_raw(current->get_mr(i * 3));
@@ -231,10 +292,27 @@ SYS_MAP_CONTROL (spaceid_t space_id, word_t control)
                        virt.get_base(),
                        size.get_page_size()));
 
-            /* We don't support multiple page batching yet */
-            if (size.get_num_pages() != 1) {
+            /*
+             * Items may describe a run of num_pages contiguous pages.
+             * The run is walked without a preemption point, so its
+             * length is bounded.  Reject runs that overflow the address
+             * space.
+             */
+            if (EXPECT_FALSE(size.get_num_pages() == 0 ||
+                             size.get_num_pages() > __L4_MAX_MAP_RUN_PAGES ||
+                             size.get_page_size() >= BITS_WORD ||
+                             size.get_num_pages() >
+                                 (~0UL >> size.get_page_size())))
+            {
+                get_current_tcb()->set_error_code(EINVALID_PARAM);
+                TRACE_MAP("bad run length\n");
+                goto error_out;
+            }
+            run_size = size.get_num_pages() << size.get_page_size();
+            if (EXPECT_FALSE(virt.get_base() + run_size - 1 < virt.get_base()))
+            {
                 get_current_tcb()->set_error_code(EINVALID_PARAM);
-                TRACE_MAP("no batching\n");
+                TRACE_MAP("run wraps\n");
                 goto error_out;
             }
 
@@ -256,7 +334,8 @@ SYS_MAP_CONTROL (spaceid_t space_id, word_t control)
 
             if (!valid_bit_set)
             {
-                space->unmap_fpage(fpg, false, kresource);
+                (void)map_control_run(space, fpg, base, run_size,
+                                      false, kresource);
             }
             else
             {
@@ -264,7 +343,7 @@ SYS_MAP_CONTROL (spaceid_t space_id, word_t control)
                 segment = curr_space->phys_segment_list->lookup_segment(seg.get_segment());
 //printf("map: %p seg: %d, offset: %lx, s=%d, a=%x\n", virt.get_base(), seg.get_segment(), seg.get_offset(), size.get_page_size(), virt.get_attributes());
                 if (EXPECT_FALSE(!segment || !segment->is_contained(seg.get_offset(),
-                                                        (1 << size.get_page_size())))) {
+                                                                    run_size))) {
                     get_current_tcb()->set_error_code(EINVALID_PARAM);
                     TRACE_MAP("not contained\n");
                     goto error_out;
@@ -285,7 +364,8 @@ SYS_MAP_CONTROL (spaceid_t space_id, word_t control)
 
                 base.set_base(segment->get_base() + seg.get_offset());
 
-                if (EXPECT_FALSE(!space->map_fpage(base, fpg, kresource)))
+                if (EXPECT_FALSE(!map_control_run(space, fpg, base, run_size,
+                                                  true, kresource)))
                 {
                     TRACE_MAP("map error\n");
                     /* Error code set in map_fpage */
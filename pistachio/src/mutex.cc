@@ -301,7 +301,7 @@ mutex_t::init(mutexid_t id)
     this->mutex_lock.init();
 
     /* Mutexes have no initial holder/donatee. */
-    this->sync_point.init(NULL);
+    this->sync_point.init(NULL, true);
 
     /* Add this mutex to the global list of mutexes. */
     this->enqueue_present();
@@ -95,6 +95,15 @@
 #include <smp.h>
 #include <config.h>
 
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+/* Per-unit queues are protected by their run_queue_t lock, which the
+ * scheduler acquires before operating on the queue. */
+#define ASSERT_QUEUE_LOCKED()
+#else
+#define ASSERT_QUEUE_LOCKED() \
+    SMT_ASSERT(ALWAYS, get_current_scheduler()->schedule_lock.is_locked(true))
+#endif
+
 /* Initialise the priority queue data structure. */
 void
 prio_queue_t::init(void)
@@ -115,7 +124,7 @@ prio_queue_t::init(void)
 void
 prio_queue_t::enqueue(tcb_t * tcb)
 {
-    SMT_ASSERT(ALWAYS, get_current_scheduler()->schedule_lock.is_locked(true));
+    ASSERT_QUEUE_LOCKED();
     SMT_ASSERT(ALWAYS, !tcb->is_grabbed_by_me());
     ASSERT(ALWAYS, tcb != get_idle_tcb());
     ASSERT(ALWAYS, !tcb->ready_list.is_queued());
@@ -135,7 +144,7 @@ prio_queue_t::enqueue(tcb_t * tcb)
 void
 prio_queue_t::dequeue(tcb_t * tcb)
 {
-    SMT_ASSERT(ALWAYS, get_current_scheduler()->schedule_lock.is_locked(true));
+    ASSERT_QUEUE_LOCKED();
     ASSERT(DEBUG, tcb);
     ASSERT(ALWAYS, tcb != get_idle_tcb());
     ASSERT(ALWAYS, tcb->ready_list.is_queued());
@@ -152,7 +161,7 @@ prio_queue_t::dequeue(tcb_t * tcb)
 void
 prio_queue_t::set_base_priority(tcb_t *tcb, prio_t new_priority)
 {
-    SMT_ASSERT(ALWAYS, get_current_scheduler()->schedule_lock.is_locked(true));
+    ASSERT_QUEUE_LOCKED();
 
     /* Recalculate effective priorities. */
     prio_t old_effective_prio = tcb->effective_prio;
@@ -174,7 +183,7 @@ void
 prio_queue_t::set_effective_priority(tcb_t * tcb, prio_t new_priority)
 {
     ASSERT(DEBUG, new_priority >= 0 && new_priority <= MAX_PRIO);
-    SMT_ASSERT(ALWAYS, get_current_scheduler()->schedule_lock.is_locked(true));
+    ASSERT_QUEUE_LOCKED();
 
     /* Thread is not on the priority queue. Just update its priority,
      * with no more to be done. */
@@ -190,3 +199,23 @@ prio_queue_t::set_effective_priority(tcb_t * tcb, prio_t new_priority)
     enqueue(tcb);
 }
 
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+void
+run_queue_t::init(word_t unit)
+{
+    queue.init();
+    queue_lock.init();
+    this->unit = unit;
+
+    stats.acquisitions = 0;
+    stats.steals = 0;
+    stats.stolen = 0;
+    stats.rebalances = 0;
+#if defined(CONFIG_L4_PROFILING)
+    stats.spin_cycles = 0;
+    stats.max_spin_cycles = 0;
+    stats.hold_cycles = 0;
+    stats.max_hold_cycles = 0;
+#endif
+}
+#endif
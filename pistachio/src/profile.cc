@@ -71,6 +71,8 @@
 #include <l4/arch/vregs.h>
 #include <arch/profile.h>
 #include <profile.h>
+#include <kernel/arch/special.h>
+#include <kernel/generic/lib.h>
 
 u64_t __profile_total_time;
 
@@ -93,7 +95,13 @@ static event_name event_string[MAX_EVENT_TYPE] =
     "L4_Schedule",
     "L4_ExchangeRegisters",
     "L4_Ipc",
-    "L4_ProcessorControl"
+    "L4_ProcessorControl",
+    "(unused)",
+    "L4_CapControl",
+    "L4_RemoteMemoryCopy",
+    "CacheControl(range)",
+    "CacheControl(full)",
+    "CacheControl(outer)"
 #if defined(ARCH_EVENT_STR) && defined(ARCH_NUM_EVENTS) && \
     defined(ARCH_EVENT_TYPE)
     ,
@@ -112,6 +120,125 @@ static profile_stats_t profile_stats[MAX_EVENT_TYPE];
 
 static int profile_enabled = 0;
 
+/*
+ * Latency histograms
+ */
+
+static word_t
+profile_hist_bucket(word_t sample)
+{
+    word_t e;
+
+    if (sample < PROFILE_HIST_SUB) {
+        return sample;
+    }
+    e = msb(sample);
+    return ((e - PROFILE_HIST_SUB_BITS + 1) << PROFILE_HIST_SUB_BITS) |
+        ((sample >> (e - PROFILE_HIST_SUB_BITS)) & (PROFILE_HIST_SUB - 1));
+}
+
+/* Smallest sample that falls into the given bucket. */
+static word_t
+profile_hist_lower(word_t bucket)
+{
+    word_t shift;
+
+    if (bucket < PROFILE_HIST_SUB) {
+        return bucket;
+    }
+    shift = (bucket >> PROFILE_HIST_SUB_BITS) - 1;
+    return (PROFILE_HIST_SUB | (bucket & (PROFILE_HIST_SUB - 1))) << shift;
+}
+
+static inline void
+profile_record(profile_stats_t *stats, u64_t cycles)
+{
+    word_t sample = (cycles >> 32) ? ~0UL : (word_t)cycles;
+
+    if (sample < stats->min) {
+        stats->min = sample;
+    }
+    if (sample > stats->max) {
+        stats->max = sample;
+    }
+    stats->hist[profile_hist_bucket(sample)]++;
+}
+
+/*
+ * Return the smallest sample of the bucket holding the given percentile
+ * of samples, clipped to the recorded minimum.
+ */
+static word_t
+profile_hist_percentile(profile_stats_t *stats, word_t percent)
+{
+    word_t total = 0, seen = 0, target;
+    word_t i;
+
+    for (i = 0; i < PROFILE_HIST_BUCKETS; i++) {
+        total += stats->hist[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    target = (word_t)(((u64_t)total * percent + 99) / 100);
+    for (i = 0; i < PROFILE_HIST_BUCKETS; i++) {
+        seen += stats->hist[i];
+        if (seen >= target) {
+            break;
+        }
+    }
+    return max(profile_hist_lower(i), stats->min);
+}
+
+static void
+profile_stats_clear(profile_stats_t *stats)
+{
+    word_t i;
+
+    stats->counter = 0;
+    stats->cycles = 0;
+    stats->errors = 0;
+    stats->switches = 0;
+    stats->min = ~0UL;
+    stats->max = 0;
+    for (i = 0; i < PROFILE_HIST_BUCKETS; i++) {
+        stats->hist[i] = 0;
+    }
+}
+
+#if defined(CONFIG_MUNITS)
+static void
+profile_stats_merge(profile_stats_t *to, profile_stats_t *from)
+{
+    word_t i;
+
+    to->counter += from->counter;
+    to->cycles += from->cycles;
+    to->errors += from->errors;
+    to->switches += from->switches;
+    to->min = min(to->min, from->min);
+    to->max = max(to->max, from->max);
+    for (i = 0; i < PROFILE_HIST_BUCKETS; i++) {
+        to->hist[i] += from->hist[i];
+    }
+}
+
+/* Sum the statistics of every unit into profile_stats_all. */
+static void
+profile_stats_collect(void)
+{
+    int i, j;
+
+    for (i = 0; i < MAX_EVENT_TYPE; i++) {
+        profile_stats_clear(&profile_stats_all[i]);
+        for (j = 0; j < CONFIG_NUM_UNITS; j++) {
+            profile_stats_merge(&profile_stats_all[i], &profile_stats[j][i]);
+        }
+    }
+}
+#endif
+
 /*
  * set/unset functions
  */
@@ -178,6 +305,7 @@ __profile_stop(tcb_t *tcb, u64_t timer, int e)
         read_stats(e).errors--;
     } else {
         read_stats(e).cycles += timer - read_stats(e).start;
+        profile_record(&read_stats(e), timer - read_stats(e).start);
     }
 }
 
@@ -334,19 +462,13 @@ profile_init(void)
     {
         register int j;
         for (j = 0; j < CONFIG_NUM_UNITS; j++) {
-            profile_stats[j][i].counter = 0;
-            profile_stats[j][i].cycles = 0;
-            profile_stats[j][i].errors = 0;
-            profile_stats[j][i].switches = 0;
+            profile_stats_clear(&profile_stats[j][i]);
         }
     }
 #else
     for (i = 0; i < MAX_EVENT_TYPE; i++)
     {
-        read_stats(i).counter = 0;
-        read_stats(i).cycles = 0;
-        read_stats(i).errors = 0;
-        read_stats(i).switches = 0;
+        profile_stats_clear(&read_stats(i));
     }
 #endif
 }
@@ -440,6 +562,49 @@ profile_print_profiling_time(void)
     }
 }
 
+static void
+profile_print_event(int e, profile_stats_t *stats)
+{
+    printf
+    (
+        "%24s \t %10.10llu \t %10.10llu \t %10.10llu \t %d \t %10.10llu"
+        " \t %10u \t %10u \t %10u\n",
+        event_string[e],
+        stats->counter,
+        stats->cycles,
+        stats->counter > 0 ? stats->cycles / stats->counter : 0,
+        stats->errors,
+        stats->switches,
+        stats->min != ~0UL ? stats->min : 0,
+        stats->max,
+        profile_hist_percentile(stats, 99)
+    );
+}
+
+/*
+ * Print one histogram on a single line, skipping empty buckets, in the
+ * form parsed by tools/profile-histogram. A unit of -1 is the sum over
+ * all units.
+ */
+static void
+profile_print_hist(int unit, int e, profile_stats_t *stats)
+{
+    word_t i;
+
+    /* Nothing recorded. */
+    if (stats->min == ~0UL) {
+        return;
+    }
+
+    printf("hist %d %s", unit, event_string[e]);
+    for (i = 0; i < PROFILE_HIST_BUCKETS; i++) {
+        if (stats->hist[i] != 0) {
+            printf(" %u:%u", profile_hist_lower(i), stats->hist[i]);
+        }
+    }
+    printf("\n");
+}
+
 void
 profile_print(void)
 {
@@ -457,54 +622,39 @@ profile_print(void)
 
     printf
     (
-        "%24s \t %10.10s \t %10.10s \t %10.10s \t %10.10s \t %10.10s\n",
-        "Event", "#", "Total", "Avg", "Err", "Switches"
+        "%24s \t %10.10s \t %10.10s \t %10.10s \t %10.10s \t %10.10s"
+        " \t %10.10s \t %10.10s \t %10.10s\n",
+        "Event", "#", "Total", "Avg", "Err", "Switches", "Min", "Max", "P99"
     );
 
 #if defined(CONFIG_MUNITS)
+    profile_stats_collect();
     for (i = 0; i < MAX_EVENT_TYPE; i++)
     {
-        profile_stats_all[i].counter = 0;
-        profile_stats_all[i].cycles = 0;
-        profile_stats_all[i].errors = 0;
-        profile_stats_all[i].switches = 0;
-        register int j;
-        for (j = 0; j < CONFIG_NUM_UNITS; j++)
-        {
-            profile_stats_all[i].counter += profile_stats[j][i].counter;
-            profile_stats_all[i].cycles += profile_stats[j][i].cycles;
-            profile_stats_all[i].errors += profile_stats[j][i].errors;
-            profile_stats_all[i].switches += profile_stats[j][i].switches;
-        }
-        printf
-        (
-            "%24s \t %10.10llu \t %10.10llu \t %10.10llu \t %d \t %10.10llu\n",
-            event_string[i],
-            profile_stats_all[i].counter,
-            profile_stats_all[i].cycles, // / profile_stats_all[i].counter,
-            profile_stats_all[i].counter > 0 ?
-                profile_stats_all[i].cycles / profile_stats_all[i].counter : 0,
-            profile_stats_all[i].errors,
-            profile_stats_all[i].switches
-        );
+        profile_print_event(i, &profile_stats_all[i]);
     }
 #else
     for (i = 0; i < MAX_EVENT_TYPE; i++)
     {
-        printf
-        (
-            "%24s \t %10.10llu \t %10.10llu \t %10.10llu \t %d \t %10.10llu\n",
-            event_string[i],
-            read_stats(i).counter,
-            read_stats(i).cycles, // / read_stats(i).counter,
-            read_stats(i).counter > 0 ?
-                read_stats(i).cycles / read_stats(i).counter : 0,
-            read_stats(i).errors,
-            read_stats(i).switches
-        );
+        profile_print_event(i, &read_stats(i));
     }
 #endif
     printf("\n");
+
+    printf("==== Latency histograms (unit event lower:count ...) ===\n");
+    for (i = 0; i < MAX_EVENT_TYPE; i++)
+    {
+#if defined(CONFIG_MUNITS)
+        register int j;
+        for (j = 0; j < CONFIG_NUM_UNITS; j++) {
+            profile_print_hist(j, i, &profile_stats[j][i]);
+        }
+        profile_print_hist(-1, i, &profile_stats_all[i]);
+#else
+        profile_print_hist(0, i, &read_stats(i));
+#endif
+    }
+    printf("\n");
 }
 
 void
@@ -547,31 +697,123 @@ profile_reset(void)
     profile_t_clear();
 }
 
-void
-profile_handler(word_t op)
+/*
+ * Find the statistics named by a read operation's argument. On
+ * multi-unit kernels, unit 0xff is the sum over all units.
+ */
+static profile_stats_t *
+profile_lookup_stats(word_t arg)
+{
+    word_t e = PROFILE_ARG_EVENT(arg);
+    word_t unit = PROFILE_ARG_UNIT(arg);
+
+    if (e >= MAX_EVENT_TYPE) {
+        return NULL;
+    }
+#if defined(CONFIG_MUNITS)
+    if (unit == 0xff) {
+        profile_stats_collect();
+        return &profile_stats_all[e];
+    }
+    if (unit >= CONFIG_NUM_UNITS) {
+        return NULL;
+    }
+    return &profile_stats[unit][e];
+#else
+    if (unit != 0) {
+        return NULL;
+    }
+    return &read_stats(e);
+#endif
+}
+
+/*
+ * Copy an event's counters into the caller's message registers:
+ * MR0/MR1 the number of events, MR2/MR3 the total cycles, MR4 the
+ * minimum, MR5 the maximum and MR6 the 99th percentile latency, and
+ * MR7 the number of thread switches. Returns the number of histogram
+ * buckets, or 0 if the event or unit is invalid.
+ */
+static word_t
+profile_read_stats(word_t arg)
+{
+    tcb_t *current = get_current_tcb();
+    profile_stats_t *stats = profile_lookup_stats(arg);
+
+    if (stats == NULL) {
+        return 0;
+    }
+
+    current->set_mr(0, (word_t)stats->counter);
+    current->set_mr(1, (word_t)(stats->counter >> 32));
+    current->set_mr(2, (word_t)stats->cycles);
+    current->set_mr(3, (word_t)(stats->cycles >> 32));
+    current->set_mr(4, stats->min != ~0UL ? stats->min : 0);
+    current->set_mr(5, stats->max);
+    current->set_mr(6, profile_hist_percentile(stats, 99));
+    current->set_mr(7, (word_t)stats->switches);
+
+    return PROFILE_HIST_BUCKETS;
+}
+
+/*
+ * Copy up to PROFILE_HIST_READ_BUCKETS histogram buckets, starting at
+ * the requested bucket, into the caller's message registers as pairs of
+ * the bucket's smallest sample and its count. Returns the number of
+ * buckets copied.
+ */
+static word_t
+profile_read_hist(word_t arg)
+{
+    tcb_t *current = get_current_tcb();
+    profile_stats_t *stats = profile_lookup_stats(arg);
+    word_t first = PROFILE_ARG_BUCKET(arg);
+    word_t i;
+
+    if (stats == NULL || first >= PROFILE_HIST_BUCKETS) {
+        return 0;
+    }
+
+    for (i = 0; i < PROFILE_HIST_READ_BUCKETS &&
+            first + i < PROFILE_HIST_BUCKETS; i++) {
+        current->set_mr(2 * i, profile_hist_lower(first + i));
+        current->set_mr(2 * i + 1, stats->hist[first + i]);
+    }
+    return i;
+}
+
+word_t
+profile_handler(word_t op, word_t arg)
 {
     switch (op)
     {
-    case 0x0: /* enable */
+    case profile_op_enable:
         profile_enable();
         break;
 
-    case 0x1: /* disable */
+    case profile_op_disable:
         profile_disable();
         break;
 
-    case 0x2: /* reset */
+    case profile_op_reset:
         profile_reset();
         break;
 
     /* XXX: Should we print something if not from KDB? */
-    case 0x3: /* print */
+    case profile_op_print:
         profile_print();
         break;
 
+    case profile_op_read_stats:
+        return profile_read_stats(arg);
+
+    case profile_op_read_hist:
+        return profile_read_hist(arg);
+
     default:
-        break;
+        return 0;
     }
+    return 1;
 }
 
 #endif /* CONFIG_L4_PROFILING */
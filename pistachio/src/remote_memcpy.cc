@@ -81,12 +81,31 @@ DECLARE_TRACEPOINT(SYSCALL_MEMORY_COPY);
  */
 #if defined(CONFIG_REMOTE_MEMORY_COPY) && \
     (defined(CONFIG_ARCH_IA32) || defined(CONFIG_ARCH_ARM) || defined(CONFIG_ARCH_MIPS))
-/** @todo FIXME: SMT/SMP safety - glee. */
-static word_t memcpy_buf[REMOTE_MEMCPY_BUFSIZE/sizeof(word_t)];
+/*
+ * Bounce buffers, one per execution unit. A chunk is copied into and out
+ * of the buffer without a preemption point in between, so the buffer of
+ * the current unit is never shared with another copy in progress.
+ */
+#if defined(CONFIG_MUNITS)
+#define MEMCPY_NUM_BUFS         CONFIG_NUM_UNITS
+#else
+#define MEMCPY_NUM_BUFS         1
+#endif
+static word_t memcpy_buf[MEMCPY_NUM_BUFS][REMOTE_MEMCPY_BUFSIZE/sizeof(word_t)];
 
 static void memcpy_frombounce(tcb_t *tcb, word_t *addr, word_t size);
 static void memcpy_tobounce(tcb_t *tcb, word_t *addr, word_t size);
 
+/* Bounce buffer of the execution unit we are running on */
+static inline word_t *
+current_bounce_buf(void)
+{
+#if defined(CONFIG_MUNITS)
+    return &memcpy_buf[get_current_context().unit][0];
+#else
+    return &memcpy_buf[0][0];
+#endif
+}
 
 /*
  * memory_copy_recover(): recover from invalid user memory access
@@ -115,10 +134,12 @@ static CONTINUATION_FUNCTION(memory_copy_recover)
 
     cont = TCB_SYSDATA_MEMCPY(current)->memory_copy_cont;
 
+    /* User memory is only accessed with the remote thread locked */
+    TCB_SYSDATA_MEMCPY(current)->remote_tcb->unlock_read();
+
     /* signal that a mapping was missing */
     current->set_error_code(ENO_MEM);
     /* bye bye ... */
-    UNLOCK_PRIVILEGED_SYSCALL();
     PROFILE_STOP(sys_remote_memcopy);
     return_memory_copy(0, fault - addr, cont);
 }
@@ -129,7 +150,7 @@ static CONTINUATION_FUNCTION(memory_copy_recover)
 static void memcpy_frombounce(tcb_t *tcb, word_t *addr, word_t size)
 {
     tcb_t *current;
-    word_t *dest = (word_t*)&memcpy_buf[0];
+    word_t *dest = current_bounce_buf();
     word_t i;
 
     current = get_current_tcb();
@@ -150,7 +171,7 @@ static void memcpy_frombounce(tcb_t *tcb, word_t *addr, word_t size)
 static void memcpy_tobounce(tcb_t *tcb, word_t *addr, word_t size)
 {
     tcb_t *current;
-    word_t *src = (word_t*)&memcpy_buf[0];
+    word_t *src = current_bounce_buf();
     word_t i;
 
     current = get_current_tcb();
@@ -165,6 +186,33 @@ static void memcpy_tobounce(tcb_t *tcb, word_t *addr, word_t size)
     current->clear_user_access();
 }
 
+/*
+ * Lock the remote thread and check that it is still blocked in its call
+ * to us. The lock keeps the thread and its address space from being
+ * deleted while we access its memory. It is dropped at every preemption
+ * point, so copies on different units do not serialise on a global lock.
+ */
+static bool
+memory_copy_lock_remote(tcb_t *current)
+{
+    tcb_t *remote_tcb;
+
+    remote_tcb = lookup_tcb_by_handle_locked(
+            TCB_SYSDATA_MEMCPY(current)->remote_handle);
+    if (EXPECT_FALSE(remote_tcb == NULL)) {
+        return false;
+    }
+
+    if (EXPECT_FALSE(remote_tcb != TCB_SYSDATA_MEMCPY(current)->remote_tcb ||
+                     !remote_tcb->get_state().is_waiting() ||
+                     !remote_tcb->is_partner_valid() ||
+                     remote_tcb->get_partner() != current)) {
+        remote_tcb->unlock_read();
+        return false;
+    }
+    return true;
+}
+
 static CONTINUATION_FUNCTION(memory_copy_loop)
 {
     tcb_t *current, *from_tcb, *to_tcb;
@@ -174,7 +222,6 @@ static CONTINUATION_FUNCTION(memory_copy_loop)
     word_t min_page_size = page_size(pgent_t::size_min);
     word_t min_page_mask = page_mask(pgent_t::size_min);
     continuation_t cont;
-    LOCK_PRIVILEGED_SYSCALL();
 
     current = get_current_tcb();
 
@@ -186,9 +233,19 @@ static CONTINUATION_FUNCTION(memory_copy_loop)
     remote_size = TCB_SYSDATA_MEMCPY(current)->remote_size;
     orig_src =  TCB_SYSDATA_MEMCPY(current)->orig_src;
     orig_dest = TCB_SYSDATA_MEMCPY(current)->orig_dest;
+    cont =      TCB_SYSDATA_MEMCPY(current)->memory_copy_cont;
+    orig_size = TCB_SYSDATA_MEMCPY(current)->orig_size;
 
     //printf("memcpy: from %p(%p, %lx), to %p(%p, %lx)\n", src, from_tcb, remote_size, dest, to_tcb, size);
     for (; remote_size > 0 && size > 0; /*null*/) {
+        /* The remote thread may have been aborted while we were preempted */
+        if (EXPECT_FALSE(!memory_copy_lock_remote(current))) {
+            current->get_space()->activate(current);
+            current->set_error_code(EINVALID_PARAM);
+            PROFILE_STOP(sys_remote_memcopy);
+            return_memory_copy(0, orig_size - size, cont);
+        }
+
         copy_size = min(remote_size, size);
         copy_size = min(REMOTE_MEMCPY_BUFSIZE, copy_size);
 
@@ -207,6 +264,8 @@ static CONTINUATION_FUNCTION(memory_copy_loop)
         TCB_SYSDATA_MEMCPY(current)->copy_start = orig_dest;
         memcpy_frombounce(to_tcb, (word_t *)dest, copy_size);
 
+        TCB_SYSDATA_MEMCPY(current)->remote_tcb->unlock_read();
+
         /*
          * Put these adjustments within the loop so we can turn 
          * the preemption point on easily.
@@ -224,19 +283,14 @@ static CONTINUATION_FUNCTION(memory_copy_loop)
         TCB_SYSDATA_MEMCPY(current)->dest = dest;
         TCB_SYSDATA_MEMCPY(current)->size = size;
         TCB_SYSDATA_MEMCPY(current)->remote_size = remote_size;
-        UNLOCK_PRIVILEGED_SYSCALL();
         preempt_enable(memory_copy_loop);
         preempt_disable();
-        LOCK_PRIVILEGED_SYSCALL();
     }
     /* switch back to current address space */
     if (to_tcb != current) {
         current->get_space()->activate(current);
     }
 
-    cont = TCB_SYSDATA_MEMCPY(current)->memory_copy_cont;
-
-    orig_size = TCB_SYSDATA_MEMCPY(current)->orig_size;
     /*
      * If there is still size remaining it means the copy has overflowed
      * the remote buffer.
@@ -244,12 +298,10 @@ static CONTINUATION_FUNCTION(memory_copy_loop)
     if (size) {
         current->set_error_code(EINVALID_PARAM);
         PROFILE_STOP(sys_remote_memcopy);
-        UNLOCK_PRIVILEGED_SYSCALL();
         return_memory_copy(0, orig_size - size, cont);
     }
 
     PROFILE_STOP(sys_remote_memcopy);
-    UNLOCK_PRIVILEGED_SYSCALL();
     return_memory_copy(1, orig_size, cont);
 }
 
@@ -264,7 +316,6 @@ SYS_MEMORY_COPY(capid_t remote, word_t local, word_t size,
     word_t remote_dir, remote_addr, remote_size, descidx;
     word_t src, dest;
 
-    LOCK_PRIVILEGED_SYSCALL();
     PROFILE_START(sys_remote_memcopy);
 
     TRACEPOINT (SYSCALL_MEMORY_COPY,
@@ -298,13 +349,10 @@ SYS_MEMORY_COPY(capid_t remote, word_t local, word_t size,
         goto error_out;
     }
     /*
-     * XXX 
-     *
-     * the lock should be held for the whole system call but the 
-     * preemption isn't very well-defined yet.  This needs to be fixed
-     * for SMT with preemption.
+     * The remote thread's read lock is held until its descriptor and
+     * space have been validated and copied into our sysdata; without it
+     * the thread could be deleted by another unit underneath us.
      */
-    remote_tcb->unlock_read();
 
     /*
      * Step 2: make sure that the direction specified in the memory
@@ -312,14 +360,14 @@ SYS_MEMORY_COPY(capid_t remote, word_t local, word_t size,
      */
     if (EXPECT_TRUE(!remote_tcb->get_tag().get_memcpy())) {
         current->set_error_code(EINVALID_PARAM);
-        goto error_out;
+        goto error_unlock;
     }
 
     descidx = remote_tcb->get_tag().get_untyped() + 1/*tag*/;
     /* Check for message overflow */
     if (EXPECT_FALSE((descidx + 2) >= IPC_NUM_MR)) {
         current->set_error_code(EINVALID_PARAM);
-        goto error_out;
+        goto error_unlock;
     }
 
     remote_addr = remote_tcb->get_mr(descidx);
@@ -328,14 +376,14 @@ SYS_MEMORY_COPY(capid_t remote, word_t local, word_t size,
 
     if (EXPECT_FALSE(remote_dir == direction)) {
         current->set_error_code(EINVALID_PARAM);
-        goto error_out;
+        goto error_unlock;
     }
 
 #define WORD_MASK (sizeof(word_t) - 1)
     if ((local & WORD_MASK) || (size & WORD_MASK) ||
         (remote_addr & WORD_MASK) || (remote_size & WORD_MASK)) {
         current->set_error_code(EINVALID_PARAM);
-        goto error_out;
+        goto error_unlock;
     }
 #undef WORD_MASK
 
@@ -349,7 +397,7 @@ SYS_MEMORY_COPY(capid_t remote, word_t local, word_t size,
         !remote_tcb->get_space()->is_user_area((addr_t)(remote_addr + 
         remote_size - 1))) {
         current->set_error_code(EINVALID_PARAM);
-        goto error_out;
+        goto error_unlock;
     }
 
     /*
@@ -371,7 +419,7 @@ SYS_MEMORY_COPY(capid_t remote, word_t local, word_t size,
         to_tcb = remote_tcb;
     } else {
         current->set_error_code(EINVALID_PARAM);
-        goto error_out;
+        goto error_unlock;
     }
 
     /*
@@ -389,14 +437,17 @@ SYS_MEMORY_COPY(capid_t remote, word_t local, word_t size,
     TCB_SYSDATA_MEMCPY(current)->orig_size = size;
     TCB_SYSDATA_MEMCPY(current)->remote_size = remote_size;
     TCB_SYSDATA_MEMCPY(current)->memory_copy_cont = cont;
+    TCB_SYSDATA_MEMCPY(current)->remote_tcb = remote_tcb;
+    TCB_SYSDATA_MEMCPY(current)->remote_handle = remote.get_raw();
 
-    UNLOCK_PRIVILEGED_SYSCALL();
+    remote_tcb->unlock_read();
     ACTIVATE_CONTINUATION(memory_copy_loop);
     /*NOTREACHED*/
 
+error_unlock:
+    remote_tcb->unlock_read();
 error_out:
     PROFILE_STOP(sys_remote_memcopy);
-    UNLOCK_PRIVILEGED_SYSCALL();
     return_memory_copy(0, 0, cont);
 }
 #else
@@ -215,6 +215,64 @@ scheduler_t::find_next_thread()
     ASSERT(ALWAYS, idle->is_grabbed_by_me());
     return idle;
 }
+#elif defined(CONFIG_PERCPU_RUNQUEUES)
+prio_t
+scheduler_t::get_highest_priority(void)
+{
+    prio_t prio;
+
+    (void)find_busiest_run_queue(get_current_context().unit, &prio);
+    return prio;
+}
+
+word_t
+scheduler_t::find_busiest_run_queue(word_t unit, prio_t * prio)
+{
+    word_t busiest = unit;
+    prio_t max_prio = run_queues[unit].peek_highest_priority();
+
+    /* Only take work from another unit if it is strictly more important
+     * than our own, to keep threads on their home unit where possible. */
+    for (word_t i = 0; i < CONFIG_NUM_UNITS; i++) {
+        if (i == unit) {
+            continue;
+        }
+        prio_t p = run_queues[i].peek_highest_priority();
+        if (p > max_prio) {
+            max_prio = p;
+            busiest = i;
+        }
+    }
+
+    *prio = max_prio;
+    return busiest;
+}
+
+void
+scheduler_t::rebalance_units(void)
+{
+    SMT_ASSERT(ALWAYS, schedule_lock.is_locked(true));
+
+    cpu_context_t context = get_current_context();
+    word_t target = lowest_unit & 0xffff;
+    prio_t queued;
+
+    /* The current unit will pick up work at its own next schedule. */
+    if (target == context.unit) {
+        return;
+    }
+
+    /* If any run queue holds a thread more important than what the
+     * lowest priority unit is running, have that unit steal it. */
+    (void)find_busiest_run_queue(target, &queued);
+    if (queued > priorities[target].prio) {
+        cpu_context_t dest = context;
+        dest.unit = target;
+        run_queues[target].stats.rebalances++;
+        request_reschedule(dest);
+    }
+}
+
 #else
 prio_t
 scheduler_t::get_highest_priority(void)
@@ -247,7 +305,13 @@ scheduler_t::set_effective_priority(tcb_t *tcb, prio_t prio)
     SMT_ASSERT(ALWAYS, schedule_lock.is_locked(true));
     ASSERT(DEBUG, prio >= 0 && prio <= MAX_PRIO);
 
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+    run_queue_t * rq = lock_run_queue(tcb);
+    rq->queue.set_effective_priority(tcb, prio);
+    rq->unlock();
+#else
     prio_queue.set_effective_priority(tcb, prio);
+#endif
 #ifdef CONFIG_MUNITS
     change_active_thread_priority(tcb);
 #endif
@@ -304,6 +368,85 @@ scheduler_t::schedule(tcb_t * current, continuation_t continuation,
 
     switch_to(next, next);
 
+#elif defined(CONFIG_PERCPU_RUNQUEUES)
+    word_t unit = get_current_context().unit;
+    bool current_runnable = current->get_state().is_runnable()
+        && !current->is_reserved();
+    tcb_t *next;
+
+    /* No longer violating the scheduler. */
+    scheduling_invariants_violated = false;
+
+    /* Find the next thread without holding the domain-wide schedule lock.
+     * Only the run queues we take the thread from are locked. */
+    while (1) {
+        prio_t max_prio;
+        word_t victim = find_busiest_run_queue(unit, &max_prio);
+
+        /* If the current thread has an equal priority, we can keep
+         * running it. */
+        if (current_runnable) {
+            if (current->effective_prio > max_prio ||
+                    (!(flags & sched_round_robin)
+                            && current->effective_prio == max_prio)) {
+                ACTIVATE_CONTINUATION(continuation);
+            }
+        }
+
+        if (max_prio < 0) {
+            next = get_idle_tcb();
+            (void)next->grab();
+            break;
+        }
+
+        lock_run_queues(unit, victim);
+
+        /* Recheck now that the queue is locked. */
+        if (run_queues[victim].get_highest_priority() != max_prio) {
+            unlock_run_queues(unit, victim);
+            continue;
+        }
+
+        next = run_queues[victim].queue.get(max_prio);
+
+        /* The thread may be in the process of being paused. */
+        if (!next->grab()) {
+            unlock_run_queues(unit, victim);
+            continue;
+        }
+        run_queues[victim].queue.dequeue(next);
+
+        /* Move stolen threads onto our own queue. */
+        if (victim != unit) {
+            next->runqueue_unit = unit;
+            run_queues[unit].stats.steals++;
+            run_queues[victim].stats.stolen++;
+        }
+        unlock_run_queues(unit, victim);
+        break;
+    }
+    ASSERT(ALWAYS, next->is_grabbed_by_me());
+
+    /* If we are pre-empting the thread and the thread has asked for
+     * pre-emption notification, inform the thread of this schedule. */
+    if (current_runnable && (flags & preempting_thread)) {
+        mark_thread_as_preempted(current);
+    }
+
+    /* Switch away from the current thread, enqueuing if necessary. */
+    switch_from(current, continuation);
+    schedule_lock.lock();
+    current->release();
+    if (current_runnable && current != get_idle_tcb()) {
+        enqueue(current);
+        smt_reschedule(current);
+    }
+
+    /* Activate the new thread. */
+    set_active_thread(next, next);
+    schedule_lock.unlock();
+    switch_to(next, next);
+
 #else
     schedule_lock.lock();
 
@@ -444,11 +587,17 @@ scheduler_t::handle_timer_interrupt(bool wakeup, word_t timer_length, continuati
     tcb_t * schedule = get_active_schedule();
     word_t current_timeslice;
 
+    timer_interrupts++;
+
 #if defined(CONFIG_KDB_BREAKIN)
     kdebug_check_breakin();
 #endif
 
-#if defined(CONFIG_KEEP_CURRENT_TIME)
+#if defined(CONFIG_TICKLESS)
+    /* The one-shot timer fired, or an interrupt asked for a wakeup.
+     * Charge the active schedule for the time actually used. */
+    timer_length = consume_elapsed_time();
+#elif defined(CONFIG_KEEP_CURRENT_TIME)
 #if defined(CONFIG_MUNITS) || defined(CONFIG_MDOMAINS)
     if (get_current_context().raw == 0)
 #endif
@@ -462,6 +611,19 @@ scheduler_t::handle_timer_interrupt(bool wakeup, word_t timer_length, continuati
     process_domain_timer_tick();
 #endif
 
+#if defined(CONFIG_IRQ_COALESCING)
+#if defined(CONFIG_MUNITS) || defined(CONFIG_MDOMAINS)
+    if (get_current_context().raw == 0)
+#endif
+    {
+        /* Release interrupts that have been held back long enough. */
+        irq_coalesce_age(timer_length);
+        if (irq_coalesce_flush()) {
+            wakeup = true;
+        }
+    }
+#endif
+
     /* If the idle thread is running, return. */
     if (EXPECT_FALSE(current == get_idle_tcb())) {
         goto reschedule;
@@ -483,14 +645,22 @@ scheduler_t::handle_timer_interrupt(bool wakeup, word_t timer_length, continuati
             if (EXPECT_TRUE(current == schedule)) {
                 /* Any other threads ready at this priority? */
                 if (!wakeup && !get_current_scheduler()->
-                        prio_queue.get(schedule->effective_prio)) {
+                        is_ready_at_priority(schedule->effective_prio)) {
                     /* Renew the schedule's timeslice. */
                     schedule->current_timeslice = schedule->timeslice_length;
+#if defined(CONFIG_TICKLESS)
+                    program_timer(schedule);
+#endif
                     ACTIVATE_CONTINUATION(continuation);
                 }
             }
 
             end_of_timeslice(schedule);
+#if defined(CONFIG_TICKLESS)
+            /* Rearm for the renewed timeslice in case the schedule
+             * keeps the current thread; a switch reprograms it. */
+            program_timer(schedule);
+#endif
             get_current_scheduler()->schedule(current, continuation,
                     scheduler_t::sched_round_robin |
                     scheduler_t::preempting_thread);
@@ -502,6 +672,10 @@ scheduler_t::handle_timer_interrupt(bool wakeup, word_t timer_length, continuati
     }
 
 reschedule:
+#if defined(CONFIG_TICKLESS)
+    /* The timer fired early, or only to track the counter: rearm it. */
+    program_timer(schedule);
+#endif
     if (wakeup) {
         /* Somthing is pending, requiring a wakeup */
         get_current_scheduler()->schedule(current, continuation,
@@ -512,6 +686,80 @@ reschedule:
     }
 }
 
+#if defined(CONFIG_TICKLESS)
+word_t
+scheduler_t::consume_elapsed_time(void)
+{
+    u64_t now = soc_get_system_time();
+    u64_t elapsed = now - last_charge_time;
+
+    last_charge_time = now;
+    current_time = now;
+
+    /* Saturate; no timeslice is this long. */
+    return elapsed > ~0UL ? ~0UL : (word_t)elapsed;
+}
+
+void
+scheduler_t::program_timer(tcb_t * schedule)
+{
+    word_t length = 0;
+
+    if (schedule != get_idle_tcb()) {
+        length = schedule->current_timeslice;
+    }
+#if defined(CONFIG_KDB_BREAKIN)
+    /* Keep polling the console for a break-in. */
+    if (length == 0) {
+        length = DEFAULT_TIMESLICE_LENGTH;
+    }
+#endif
+#if defined(CONFIG_IRQ_COALESCING)
+    /* Wake up in time to release held interrupts. */
+    word_t expiry = irq_coalesce_next_expiry();
+    if (expiry != 0 && (length == 0 || expiry < length)) {
+        length = expiry;
+    }
+#endif
+    soc_set_timer_oneshot(length);
+}
+
+void
+scheduler_t::switch_schedule_timer(tcb_t * next)
+{
+    tcb_t * prev = get_active_schedule();
+    word_t elapsed = consume_elapsed_time();
+
+#if defined(CONFIG_IRQ_COALESCING)
+    irq_coalesce_age(elapsed);
+#endif
+
+    /* Charge the outgoing schedule. Leave an overrun schedule with the
+     * smallest timeslice rather than zero, which means infinite. */
+    if (prev != NULL && prev != get_idle_tcb()
+            && prev->current_timeslice != 0) {
+        if (elapsed < prev->current_timeslice) {
+            prev->current_timeslice -= elapsed;
+        } else {
+            prev->current_timeslice = 1;
+        }
+    }
+
+    if (next != prev) {
+        program_timer(next);
+    }
+}
+
+void
+scheduler_t::rearm_timer(void)
+{
+    tcb_t * schedule = get_active_schedule();
+
+    switch_schedule_timer(schedule);
+    program_timer(schedule);
+}
+#endif
+
 #if defined (CONFIG_MUNITS)
 
 inline void
@@ -527,6 +775,13 @@ scheduler_t::process_domain_timer_tick()
      *     available to each thread (so we MUST execute this stage).
      */
 
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+    /* Move queued work towards idle or lower priority units. */
+    schedule_lock.lock();
+    rebalance_units();
+    schedule_lock.unlock();
+#endif
+
     for (j.unit=0; j.unit < CONFIG_NUM_UNITS; j.unit++)
     {
         // propogate timer tick
@@ -569,7 +824,7 @@ scheduler_t::hwthread_timer_tick(tcb_t *current, continuation_t continuation)
             /* If not running on a donated timeslice, optimize */
             if (EXPECT_TRUE(current == schedule)) {
                 /* Any other threads ready at this priority? */
-                if (!get_current_scheduler()->prio_queue.get(schedule->effective_prio)) {
+                if (!get_current_scheduler()->is_ready_at_priority(schedule->effective_prio)) {
                     /* Renew the schedule's timeslice. */
                     schedule->current_timeslice = schedule->timeslice_length;
                     ACTIVATE_CONTINUATION(continuation);
@@ -673,7 +928,10 @@ CONTINUATION_FUNCTION(idle_thread)
      * Disable timer tick when sleeping.
      * Platform code should reenable it on receiving a device interrupt
      */
-#if defined(CONFIG_MUNITS) && defined(CONFIG_CONTEXT_BITMASKS)
+#if defined(CONFIG_TICKLESS)
+    /* Switching to idle left the one-shot timer armed only to track the
+     * free-running counter, which it must keep doing. */
+#elif defined(CONFIG_MUNITS) && defined(CONFIG_CONTEXT_BITMASKS)
     get_current_scheduler()->schedule_lock.lock();
     bool all_units_sleeping = true;
     /*
@@ -1243,8 +1501,18 @@ scheduler_t::start(cpu_context_t context)
 void SECTION(SEC_INIT)
 scheduler_t::init(bool bootcpu)
 {
+#if defined(CONFIG_PERCPU_RUNQUEUES)
+    for (word_t i = 0; i < CONFIG_MAX_UNITS_PER_DOMAIN; i++) {
+        run_queues[i].init(i);
+    }
+#else
     prio_queue.init();
+#endif
     scheduling_invariants_violated = true;
+    timer_interrupts = 0;
+#if defined(CONFIG_TICKLESS)
+    last_charge_time = 0;
+#endif
 
 #ifdef CONFIG_MUNITS
     schedule_lock.init();
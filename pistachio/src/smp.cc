@@ -92,6 +92,8 @@
 #include <smp.h>
 #include <schedule.h>
 #include <queueing.h>
+#include <space.h>
+#include <kmem_resource.h>
 
 #if defined(CONFIG_MDOMAINS)
 
@@ -160,8 +162,138 @@ void sync_xcpu_request(cpuid_t dstcpu, xcpu_handler_t handler, tcb_t * tcb,
  * asynchronous XCPU request, an entry is allocated triggering a
  * remote handler with the corresponding parameters.  To free entries
  * quickly they are copied onto the current stack. Async requests are
- * receiver based and therefore require locking.  To avoid contention
- * a sender-receiver matrix could be used with n*(n-1) mailboxes. */
+ * receiver based; senders claim entries with atomic operations rather
+ * than a lock, and only the first request of a burst sends an IPI. */
+
+/**
+ * Take the oldest request out of the mailbox. Only called by the owner.
+ *
+ * @param entry  Where to copy the request to
+ *
+ * @return false if the mailbox is empty
+ */
+bool cpu_mb_t::take(cpu_mb_entry_t * entry)
+{
+    word_t idx = head % MAX_MAILBOX_ENTRIES;
+
+    if (get_sequence(idx) != head + 1) {
+        return false;
+    }
+    okl4_atomic_barrier_read_smp();
+
+    word_t depth = okl4_atomic_read(&tail) - head;
+    if (depth > stats.max_depth) {
+        stats.max_depth = depth;
+    }
+
+    *entry = entries[idx];
+    okl4_atomic_barrier_smp();
+    set_sequence(idx, head + MAX_MAILBOX_ENTRIES);
+    head++;
+
+#if defined(CONFIG_L4_PROFILING)
+    u64_t latency = profile_arch_read_timer() - entry->enter_time;
+    stats.latency_cycles += latency;
+    if (latency > stats.max_latency_cycles) {
+        stats.max_latency_cycles = latency;
+    }
+#endif
+    return true;
+}
+
+/**
+ * Double the size of the backlog, keeping the requests in it in order.
+ * Only called by the owner.
+ *
+ * @return false if no kernel memory is left
+ */
+bool cpu_mb_t::grow_backlog()
+{
+    cpu_mb_entry_t * old = backlog ? backlog : backlog_inline;
+    word_t old_size = backlog ? backlog_size : MAX_MAILBOX_ENTRIES;
+    word_t size = old_size * 2;
+
+    cpu_mb_entry_t * ring = (cpu_mb_entry_t *)
+        get_kernel_space()->get_kmem_resource()->alloc(kmem_group_misc,
+                size * sizeof(cpu_mb_entry_t), false);
+    if (ring == NULL) {
+        return false;
+    }
+
+    word_t count = backlog_tail - backlog_head;
+    for (word_t i = 0; i < count; i++) {
+        ring[i] = old[(backlog_head + i) % old_size];
+    }
+    if (backlog) {
+        shrink_backlog();
+    }
+    backlog = ring;
+    backlog_size = size;
+    backlog_head = 0;
+    backlog_tail = count;
+    return true;
+}
+
+/**
+ * Return a grown backlog to kernel memory. Only called by the owner
+ * once the backlog is empty, or by grow_backlog() after copying it.
+ */
+void cpu_mb_t::shrink_backlog()
+{
+    get_kernel_space()->get_kmem_resource()->free(kmem_group_misc,
+            backlog, backlog_size * sizeof(cpu_mb_entry_t));
+    backlog = NULL;
+    backlog_size = 0;
+}
+
+/**
+ * Move requests from the mailbox to the backlog, growing the backlog
+ * as needed. Only called by the owner while stalled on a full mailbox.
+ * Should kernel memory run out, the remaining requests stay in the
+ * mailbox and are moved on a later stall.
+ */
+void cpu_mb_t::defer()
+{
+    for (;;) {
+        word_t size = backlog ? backlog_size : MAX_MAILBOX_ENTRIES;
+        if (backlog_tail - backlog_head == size && !grow_backlog()) {
+            return;
+        }
+        cpu_mb_entry_t * ring = backlog ? backlog : backlog_inline;
+        size = backlog ? backlog_size : MAX_MAILBOX_ENTRIES;
+        if (!take(&ring[backlog_tail % size])) {
+            return;
+        }
+        backlog_tail++;
+        stats.deferred++;
+    }
+}
+
+/**
+ * Take the next request to handle, oldest first. Requests set aside by
+ * defer() are older than any still in the mailbox.
+ *
+ * @param entry  Where to copy the request to
+ *
+ * @return false if there is nothing to handle
+ */
+bool cpu_mb_t::next(cpu_mb_entry_t * entry)
+{
+    if (backlog_head != backlog_tail) {
+        if (backlog) {
+            *entry = backlog[backlog_head % backlog_size];
+        } else {
+            *entry = backlog_inline[backlog_head % MAX_MAILBOX_ENTRIES];
+        }
+        backlog_head++;
+        if (backlog && backlog_head == backlog_tail) {
+            shrink_backlog();
+            backlog_head = backlog_tail = 0;
+        }
+        return true;
+    }
+    return take(entry);
+}
 
 /**
  * The Control/Continuation function that invokes the actual mailbox walker
@@ -187,18 +319,18 @@ static CONTINUATION_FUNCTION(do_process_xcpu_mailbox)
  */
 void cpu_mb_t::walk_mailbox()
 {
-    lock.lock();
-    while(first_free != first_alloc)
+    cpu_mb_entry_t entry;
+
+    /* Requests entered from now on need a new IPI. Clear the flag
+     * before looking at the mailbox so that none are missed. */
+    okl4_atomic_set(&ipi_pending, 0);
+    okl4_atomic_barrier_smp();
+
+    while (next(&entry))
     {
-        cpu_mb_entry_t entry = entries[first_alloc];
-        entries[first_alloc].handler = NULL;
-        first_alloc = (first_alloc + 1) % MAX_MAILBOX_ENTRIES;
-        lock.unlock();
         ASSERT(ALWAYS, entry.handler);
         entry.handler(&entry, do_process_xcpu_mailbox);
-        lock.lock();
     }
-    lock.unlock();
     ACTIVATE_CONTINUATION(get_current_tcb()->xcpu_continuation);
 }
 
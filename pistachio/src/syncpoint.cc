@@ -67,13 +67,14 @@
 DECLARE_TRACEPOINT(DEADLOCK_DETECTED);
 
 void
-syncpoint_t::init(tcb_t * donatee)
+syncpoint_t::init(tcb_t * donatee, bool indexed)
 {
     scheduler_t * scheduler = get_current_scheduler();
 
     scheduler->scheduler_lock();
     this->donatee = donatee;
     this->blocked_head = NULL;
+    this->indexed = indexed;
     scheduler->scheduler_unlock();
 }
 
@@ -245,6 +246,103 @@ syncpoint_t::enqueue_tcb_sorted(tcb_t * tcb)
     }
 }
 
+/*
+ * The blocked list of an indexed syncpoint is split into bands of
+ * threads of equal priority. The first thread of each band is also
+ * linked on the 'blocked_band' ring, which is kept in descending
+ * priority order, so finding the insertion point for a new thread only
+ * needs to visit one thread per distinct priority. The remaining
+ * members of each band have a NULL 'blocked_band.next'.
+ *
+ * Bands are keyed on 'blocked_prio' rather than 'effective_prio', as
+ * priority propagation updates a thread's effective priority before
+ * requeueing it.
+ */
+void
+syncpoint_t::enqueue_tcb_indexed(tcb_t * tcb)
+{
+    SMT_ASSERT(ALWAYS, get_current_scheduler()->schedule_lock.is_locked(true));
+    ASSERT(DEBUG, tcb->blocked_band.next == NULL);
+
+    prio_t p = tcb->effective_prio;
+    tcb->blocked_prio = p;
+
+    /* If nobody else is in the list, start a new band. */
+    if (this->blocked_head == NULL) {
+        this->blocked_head = tcb;
+        tcb->blocked_list.next = tcb;
+        tcb->blocked_list.prev = tcb;
+        tcb->blocked_band.next = tcb;
+        tcb->blocked_band.prev = tcb;
+        return;
+    }
+
+    /* Find the first band of lower priority than us. */
+    tcb_t * head = this->blocked_head;
+    tcb_t * band = head;
+
+    while (p <= band->blocked_prio) {
+        band = band->blocked_band.next;
+        if (band == head) {
+            break;
+        }
+    }
+
+    /* We go on the end of the band before it. */
+    tcb->blocked_list.next = band;
+    tcb->blocked_list.prev = band->blocked_list.prev;
+    band->blocked_list.prev->blocked_list.next = tcb;
+    band->blocked_list.prev = tcb;
+
+    /* Join the previous band if it is at our priority. */
+    tcb_t * prev = band->blocked_band.prev;
+    if (prev->blocked_prio == p) {
+        return;
+    }
+
+    /* Otherwise we start a new band. */
+    tcb->blocked_band.next = band;
+    tcb->blocked_band.prev = prev;
+    prev->blocked_band.next = tcb;
+    band->blocked_band.prev = tcb;
+
+    if (p > head->blocked_prio) {
+        this->blocked_head = tcb;
+    }
+}
+
+void
+syncpoint_t::dequeue_tcb_indexed(tcb_t * tcb)
+{
+    SMT_ASSERT(ALWAYS, get_current_scheduler()->schedule_lock.is_locked(true));
+
+    /* Only the first thread of each band is on the band ring. */
+    if (tcb->blocked_band.next == NULL) {
+        return;
+    }
+
+    tcb_t * next = tcb->blocked_list.next;
+
+    if (next != tcb && next->blocked_band.next == NULL) {
+        /* The next thread in our band takes our place. */
+        if (tcb->blocked_band.next == tcb) {
+            next->blocked_band.next = next;
+            next->blocked_band.prev = next;
+        } else {
+            next->blocked_band.next = tcb->blocked_band.next;
+            next->blocked_band.prev = tcb->blocked_band.prev;
+            tcb->blocked_band.prev->blocked_band.next = next;
+            tcb->blocked_band.next->blocked_band.prev = next;
+        }
+    } else if (tcb->blocked_band.next != tcb) {
+        /* Band is now empty. */
+        tcb->blocked_band.prev->blocked_band.next = tcb->blocked_band.next;
+        tcb->blocked_band.next->blocked_band.prev = tcb->blocked_band.prev;
+    }
+
+    tcb->blocked_band.next = tcb->blocked_band.prev = NULL;
+}
+
 #if !(defined(HAVE_ENQUEUE_BLOCKED_FASTPATH) && defined(CONFIG_ENABLE_FASTPATHS))
 void
 syncpoint_t::enqueue_blocked(tcb_t * tcb)
@@ -254,7 +352,11 @@ syncpoint_t::enqueue_blocked(tcb_t * tcb)
     ASSERT(ALWAYS, tcb->get_waiting_for() == NULL);
     ASSERT(ALWAYS, tcb->blocked_list.next == NULL);
 
-    this->enqueue_tcb_sorted(tcb);
+    if (this->indexed) {
+        this->enqueue_tcb_indexed(tcb);
+    } else {
+        this->enqueue_tcb_sorted(tcb);
+    }
     tcb->set_waiting_for(this);
 }
 #endif
@@ -269,6 +371,9 @@ syncpoint_t::dequeue_blocked(tcb_t * tcb)
     ASSERT(ALWAYS, tcb->get_waiting_for() == this);
     ASSERT(ALWAYS, tcb->blocked_list.next != NULL);
 
+    if (this->indexed) {
+        this->dequeue_tcb_indexed(tcb);
+    }
     DEQUEUE_LIST(tcb_t, this->blocked_head, tcb, blocked_list);
     tcb->set_waiting_for(NULL);
 }
@@ -245,6 +245,7 @@ void tcb_t::init(void)
     /* Initialize queues */
     ready_list.next = NULL;
     blocked_list.next = NULL;
+    blocked_band.next = NULL;
 
     /* initialize thread resources */
     resources.init(this);
@@ -261,6 +262,10 @@ void tcb_t::init(void)
 
     PROFILE_TCB_INIT(this);
 
+#if defined(CONFIG_IRQ_COALESCING)
+    this->irq_coalesce.init();
+#endif
+
     /* IPC Control initialization */
     space_id = spaceid_t::kernelspace();
 
@@ -539,6 +544,16 @@ tcb_t::delete_tcb(kmem_resource_t *kresource)
 
     this->cancel_ipcs();
 
+#if defined(CONFIG_IPC_WINDOWS)
+    /* Return or unmap any lent or borrowed buffer. */
+    close_ipc_window(this);
+#endif
+
+#if defined(CONFIG_IRQ_COALESCING)
+    /* Drop any interrupts held back for this thread. */
+    irq_coalesce_cancel(this);
+#endif
+
     /* Unwind ourselves thread into an aborted state. */
     this->unwind(NULL);
 
@@ -69,20 +69,19 @@
 #include <arch/hwspace.h>
 #include <space.h>
 #include <memdesc.h>
+#include <mp.h>
 
 #if defined(CONFIG_TRACEBUFFER)
-#include <stdarg.h>     /* for va_list, ... comes with gcc */
 
 word_t tb_irq = ~0UL;
 bool tb_irq_masked = true;
 bool tb_irq_pending = false;
 
 trace_buffer_t * trace_buffer = NULL;
-spinlock_t trace_lock;
 
 SECTION(SEC_INIT) void init_tracebuffer()
 {
-    word_t buffer_first;
+    word_t ring_first, ring_size;
 
     trace_buffer = (trace_buffer_t*) get_current_kmem_resource()->alloc( kmem_group_trace, TBUFF_SIZE, true );
     ASSERT(ALWAYS, trace_buffer);
@@ -93,125 +92,111 @@ SECTION(SEC_INIT) void init_tracebuffer()
     trace_buffer->bufid     = TBUF_ID;
     trace_buffer->buffers   = TBUF_BUFFERS;
 
-    /* Calculate buffer size */
-    buffer_first = sizeof(trace_buffer_t) + 7 & (~7UL);
-    trace_buffer->buffer_size =
-        ((TBUFF_SIZE - buffer_first) / TBUF_BUFFERS) & (~7UL);
+    /* Calculate ring size */
+    ring_first = sizeof(trace_buffer_t) + 7 & (~7UL);
+    ring_size = ((TBUFF_SIZE - ring_first) / TBUF_BUFFERS) & (~7UL);
 
-    /* Setup buffer offsets + head pointers */
+    /* Setup ring offsets + pointers */
     for (int i = 0; i < TBUF_BUFFERS; i ++ )
     {
-        trace_buffer->buffer_head[i] = 0;
-        trace_buffer->buffer_offset[i] = buffer_first + (i * trace_buffer->buffer_size);
+        trace_ring_t * ring = &trace_buffer->ring[i];
+
+        ring->offset = ring_first + (i * ring_size);
+        ring->size = ring_size;
+        okl4_atomic_init(&ring->reserve, 0);
+        ring->head = 0;
+        ring->tail = 0;
+        ring->overflows = 0;
     }
 
-    /* Set active buffer = 0 and set rest to emtpy */
-    trace_buffer->active_buffer = 0;
-    trace_buffer->buffer_empty = ((1UL << TBUF_BUFFERS) - 1) &
-        (~(1UL << trace_buffer->active_buffer));
-
     /* By default, enable all traces */
     trace_buffer->log_mask = ~(0UL);
 
     TRACE_INIT("Initialized tracebuffer @ %p\n", virt_to_phys(trace_buffer));
 }
 
+/* Get the ring of the current execution unit */
+static inline trace_ring_t *
+tb_current_ring()
+{
+#if defined(CONFIG_MUNITS)
+    return &trace_buffer->ring[get_current_context().unit];
+#else
+    return &trace_buffer->ring[0];
+#endif
+}
+
 /*
- * flip to the next available tracebuffer + do virtual interrupt
- * note: tracebuffer lock is held here
+ * Reserve space for an entry in a ring. Returns the entry and sets 'end'
+ * to the ring position following it, or returns NULL if the ring is full.
+ * No lock is taken: the reservation is claimed with a compare-and-set on
+ * the ring's reserve pointer.
  */
-static word_t
-tb_switch_buffers()
+static trace_entry_t *
+tb_allocate(trace_ring_t * ring, word_t entry_size, word_t * end)
 {
-    word_t orig_buffer = trace_buffer->active_buffer;
-    word_t next_buffer = trace_buffer->active_buffer;
-    word_t empty_bitmask = trace_buffer->buffer_empty;
-    word_t nbufs = trace_buffer->buffers;
+    word_t head, tail, start, pad, space;
 
     do {
-        next_buffer++;
-        if (next_buffer >= nbufs)
-            next_buffer = 0;
-
-        if ((1UL << next_buffer) & empty_bitmask)
-        {
-            /* Set next active buffer, mark it as not empty */
-            //printf("switch buffer -> %d\n", next_buffer);
-            trace_buffer->active_buffer = next_buffer;
-            // Use circular buffers - don't mark the buffer as used
-            //trace_buffer->buffer_empty = empty_bitmask & (~(1UL << next_buffer));
-            trace_buffer->buffer_head[next_buffer] = 0;
-
-            return next_buffer;
+        head = okl4_atomic_read(&ring->reserve);
+        tail = ring->tail;
+
+        /* entries never straddle the end of the ring */
+        if (EXPECT_FALSE(ring->size - head < entry_size)) {
+            pad = ring->size - head;
+            start = 0;
+        } else {
+            pad = 0;
+            start = head;
         }
-    } while (next_buffer != orig_buffer);
-
-#if defined(CONFIG_DEBUG) && (CONFIG_ASSERT_LEVEL >= DEBUG)
-        //TRACEF( "tracebuffer overflow!\n");
-#endif
-    trace_buffer->active_buffer = next_buffer = ~(0UL);
-
-    return ~(0UL);
-}
 
-/* Alocate space in the tracebuffer */
-static word_t
-tb_allocate(word_t entry_size, word_t *buffer)
-{
-    word_t buf;
-    word_t entry;
-
-    /* try allocate space in the tracebuffer */
-    trace_lock.lock();
-    {
-        buf = trace_buffer->active_buffer;
+        /* one byte stays unused to tell a full ring from an empty one */
+        if (tail > head) {
+            space = tail - head - 1;
+        } else {
+            space = ring->size - (head - tail) - 1;
+        }
 
-        /* no active buffer? */
-        if (buf == ~(0UL))
-            goto alloc_error;
+        if (EXPECT_FALSE(pad + entry_size > space)) {
+            ring->overflows++;
+            return NULL;
+        }
 
-        word_t new_head = trace_buffer->buffer_head[buf] + entry_size;
+        *end = start + entry_size;
+    } while (!okl4_atomic_compare_and_set(&ring->reserve, head, *end));
 
-        /* test for enough space for this entry and buffer terminating entry */
-        if (EXPECT_FALSE(new_head >= trace_buffer->buffer_size))
-        {
-            buf = tb_switch_buffers();
-            if (buf == ~(0UL))
-                goto alloc_error;
-            new_head = trace_buffer->buffer_head[buf] + entry_size;
-        }
-        /* enough space, save current position and increment head */
-        entry = trace_buffer->buffer_head[buf];
-        trace_buffer->buffer_head[buf] = new_head;
+    /* mark the unused end of the ring if a reader could mistake it for
+     * an entry */
+    if (pad >= sizeof(trace_entry_t)) {
+        trace_entry_t * tbe = (trace_entry_t*)((word_t)trace_buffer +
+                ring->offset + head);
+        tbe->hdr.raw = 0;
     }
 
-    trace_lock.unlock();
-
-    *buffer = buf;
-    return entry;
+    return (trace_entry_t*)((word_t)trace_buffer + ring->offset + start);
+}
 
-alloc_error:
-    trace_lock.unlock();
-    return ~(0UL);
+/* Make entries up to 'end' visible to the reader */
+static inline void
+tb_commit(trace_ring_t * ring, word_t end)
+{
+    okl4_atomic_barrier_write_smp();
+    ring->head = end;
 }
 
 /* Log an event */
 void tb_log_event(word_t traceid)
 {
+    trace_ring_t * ring = tb_current_ring();
     word_t entry_size = sizeof(trace_entry_t);
-    word_t entry, buffer;
+    word_t end;
 
     /* try allocate space in the tracebuffer */
-    entry = tb_allocate(entry_size, &buffer);
-    //printf("event: (%d, %d, %d) %d\n", buffer, entry_size, entry, traceid);
+    trace_entry_t * tbe = tb_allocate(ring, entry_size, &end);
 
-    if (entry == ~(0UL))
+    if (tbe == NULL)
         return;
 
-    /* get the tracebuffer entry */
-    trace_entry_t * tbe = (trace_entry_t*)((word_t)trace_buffer +
-            trace_buffer->buffer_offset[buffer] + entry);
-
     /* Write out tracebuffer event entry */
     u64_t time = get_current_time();
     tbe->timestamp_lo = time & 0xffffffffULL;
@@ -224,32 +209,26 @@ void tb_log_event(word_t traceid)
     tbe->hdr.x.minor = 0;
 
     tbe->data[0] = traceid;
+
+    tb_commit(ring, end);
 }
 
 /* Log a full tracebuffer entry */
-void tb_log_trace(word_t data, const char *str, ...)
+void tb_log_record(word_t major, word_t traceid, word_t nargs,
+        word_t a, word_t b, word_t c, word_t d)
 {
-    va_list args;
-    word_t major = data >> 24;
-    word_t traceid = (data >> 8 & 0xffff);
-    int nargs = (data & 0xf);
+    trace_ring_t * ring = tb_current_ring();
 
     /* calc entry_size, works for nargs = 0 due to data[1] in trace_entry_t */
     word_t entry_size = sizeof(trace_entry_t) + (sizeof(word_t)*(nargs-1));
-    word_t entry, buffer;
+    word_t end;
 
     /* try allocate space in the tracebuffer */
-    entry = tb_allocate(entry_size, &buffer);
+    trace_entry_t * tbe = tb_allocate(ring, entry_size, &end);
 
-    //printf("entry: (%d, %d, %d) (%d, %d, %d)\n", buffer, entry_size, entry, major, traceid, nargs);
-
-    if (entry == ~(0UL))
+    if (tbe == NULL)
         return;
 
-    /* get the tracebuffer entry */
-    trace_entry_t * tbe = (trace_entry_t*)((word_t)trace_buffer +
-            trace_buffer->buffer_offset[buffer] + entry);
-
     /* Write out tracebuffer event entry */
     u64_t time = get_current_time();
     tbe->timestamp_lo = time & 0xffffffffULL;
@@ -261,12 +240,15 @@ void tb_log_trace(word_t data, const char *str, ...)
     tbe->hdr.x.major = major;
     tbe->hdr.x.minor = 0;
 
-    int i = 0;
-    va_start(args, str);
-    while (i < nargs) {
-        tbe->data[i++] = va_arg(args, word_t);;
+    switch (nargs) {
+    case 4: tbe->data[3] = d;
+    case 3: tbe->data[2] = c;
+    case 2: tbe->data[1] = b;
+    case 1: tbe->data[0] = a;
+    default: break;
     }
-    va_end(args);
+
+    tb_commit(ring, end);
 }
 
 /* Virtual tracebuffer interrupt handling */
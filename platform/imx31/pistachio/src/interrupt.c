@@ -171,6 +171,12 @@ soc_handle_interrupt(word_t ctx, word_t fiq)
                 :"=r" (PMNC)
                 );
 
+        /* Let the kernel's PC sampler take its overflow first. */
+        PMNC &= ~kernel_perf_sample_interrupt(ctx, PMNC);
+        if (!(PMNC & ((1UL << 10) | (1UL << 9) | (1UL << 8)))) {
+            ACTIVATE_CONTINUATION(cont);
+        }
+
         if (PMNC & (1UL << 10)) {
             /* CCNT overflow. */
             if (count_CCNT_overflow == ~0UL) {
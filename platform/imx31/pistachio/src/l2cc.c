@@ -248,6 +248,16 @@ void soc_cache_full_op(word_t attrib)
     }
 }
 
+int soc_cache_full_op_cheaper(word_t size)
+{
+    /* Range operations go line by line, so once a request covers at
+     * least the size of the cache a full operation is cheaper. */
+    word_t way_size = 1UL << (arm_l2_cache_get_index_size_log2() +
+                              L2_LINE_SIZE_LOG2);
+
+    return size >= way_size * arm_l2_cache_get_associativity();
+}
+
 void soc_cache_drain_write_buffer(void)
 {
     /* 
@@ -168,6 +168,11 @@ static const int TIMER_TICK_LENGTH = 5000;
 #define VERSATILE_TIMER_DIV16                   (1 << 2)        /* Divided by 16       */
 #define VERSATILE_TIMER_DIV256                  (2 << 2)        /* Divided by 256      */
 #define VERSATILE_TIMER_32BIT                   (1 << 1)        /* 32 bit counter      */
+#define VERSATILE_TIMER_ONESHOT                 (1 << 0)        /* One-shot mode       */
+
+/* Longest one-shot delay, so the free-running counter never wraps twice
+ * between two reads. */
+#define VERSATILE_TIMER_MAX_ONESHOT             0x80000000UL
 
 #if 0
 #if TIMER_TICK_LENGTH >= 0x100000
@@ -94,11 +94,56 @@ void handle_timer_interrupt(bool wakeup, continuation_t continuation)
      */
     timer0->clear = ~(0UL);
 
+#if defined(CONFIG_TICKLESS)
+    /* The kernel works out the elapsed time itself. */
+    kernel_scheduler_handle_timer_interrupt(wakeup, 0, continuation);
+#else
     kernel_scheduler_handle_timer_interrupt(wakeup,
                                             TIMER_TICK_LENGTH,
                                             continuation);
+#endif
+}
+
+#if defined(CONFIG_TICKLESS)
+/* Low word of the last counter read and the accumulated high word. */
+static u32_t system_time_last;
+static u64_t system_time_high;
+
+u64_t soc_get_system_time(void)
+{
+    volatile Timer_t    *timer1 = (Timer_t *)VERSATILE_TIMER1_VBASE;
+
+    /* Timer 1 counts down from 0xffffffff at 1MHz. */
+    u32_t now = ~(u32_t)timer1->val;
+
+    if (now < system_time_last) {
+        system_time_high += 1ULL << 32;
+    }
+    system_time_last = now;
+
+    return system_time_high + now;
 }
 
+void soc_set_timer_oneshot(word_t usecs)
+{
+    volatile Timer_t    *timer0 = (Timer_t *)VERSATILE_TIMER0_VBASE;
+
+    /* Even with nothing to wait for we need to see the free-running
+     * counter at least once per wrap. */
+    if (usecs == 0 || usecs > VERSATILE_TIMER_MAX_ONESHOT) {
+        usecs = VERSATILE_TIMER_MAX_ONESHOT;
+    }
+    (void)soc_get_system_time();
+
+    timer0->ctrl = 0;
+    timer0->clear = ~(0UL);
+    timer0->load = usecs * TICK_PER_uSEC;
+    timer0->ctrl = VERSATILE_TIMER_CTRL | VERSATILE_TIMER_32BIT |
+                   VERSATILE_TIMER_ONESHOT | VERSATILE_TIMER_IE;
+    TRACE_TIMER("Timer one-shot:%d us\n", usecs);
+}
+#endif
+
 void init_clocks(void)
 {
     volatile Timer_t    *timer0 = (Timer_t *)VERSATILE_TIMER0_VBASE;
@@ -123,9 +168,11 @@ void init_clocks(void)
     /* enable irq.*/
     soc_unmask_irq(VERSATILE_TIMER0_IRQ);
 
+#if !defined(CONFIG_TICKLESS)
     /* start timer - enable + clkdiv + periodic + int enable */
     timer0->ctrl = VERSATILE_TIMER_CTRL | VERSATILE_TIMER_MODE | VERSATILE_TIMER_IE;
     TRACE_TIMER("Timer ctrl val:0x%08x\n", timer0->ctrl);
+#endif
 
     /* Enable 1MHz free-running timer */
     timer1->ctrl = VERSATILE_TIMER_CTRL | VERSATILE_TIMER_32BIT;
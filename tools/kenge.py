@@ -1008,7 +1008,8 @@ class KengeEnvironment:
                                     ("CONFIG_ZONE", 1),
                                     ("CONFIG_MEM_PROTECTED", 1),
                                     ("CONFIG_MEMLOAD", 1),
-                                    ("CONFIG_REMOTE_MEMORY_COPY", 1)])
+                                    ("CONFIG_REMOTE_MEMORY_COPY", 1),
+                                    ("CONFIG_IPC_WINDOWS", 1)])
 
         self.machine.simulate_cache = self.args.get("ENABLE_CACHE_EMUL", True)
 
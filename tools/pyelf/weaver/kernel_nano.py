@@ -452,8 +452,10 @@ class NanoKernel(object):
         futex_hash_addr, futex_base_addr = \
                 self.allocate_memory(kernel_data, futex_base_addr,
                                 futex_hash_slots * 8)
+        # Pending signals: one (tag, count) pair per hash slot.
         futex_pending_tags_addr, futex_base_addr = \
-                self.allocate_memory(kernel_data, futex_base_addr, num_threads * 4)
+                self.allocate_memory(kernel_data, futex_base_addr,
+                                futex_hash_slots * 8)
 
         self.patches.extend(
                 [("tcbs", tcb_data_vaddr),
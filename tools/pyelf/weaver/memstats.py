@@ -100,6 +100,12 @@ iguana_stats_strings = (
     "SessionSize",
     "SessionNodeSize",
     "ThreadSize",
+    "SyncSyscalls",
+    "SyncBytes",
+    "SecurityCacheHits",
+    "SecurityCacheMisses",
+    "SlabPages",
+    "SlabReclaims",
 )
 
 